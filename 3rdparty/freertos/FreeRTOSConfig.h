@@ -130,10 +130,17 @@ configTOTAL_HEAP_SIZE is not defined. */
 #define configUSE_EVENT_GROUPS			0
 
 /* Run time stats gathering definitions. */
-#define configGENERATE_RUN_TIME_STATS	0
-#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() vConfigureTimerForRunTimeStats()
-/* Return the current timer counter value + the overflow counter. */
-#define portGET_RUN_TIME_COUNTER_VALUE() 	( ( ( uint32_t ) TA1R ) + ulRunTimeCounterOverflows )
+#ifdef USIP_HOST
+	/* The Posix port counts microseconds of the monotonic clock. */
+	#define configGENERATE_RUN_TIME_STATS	1
+	#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+	#define portGET_RUN_TIME_COUNTER_VALUE() ulPortGetRunTimeCounterValue()
+#else
+	#define configGENERATE_RUN_TIME_STATS	0
+	#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() vConfigureTimerForRunTimeStats()
+	/* Return the current timer counter value + the overflow counter. */
+	#define portGET_RUN_TIME_COUNTER_VALUE() 	( ( ( uint32_t ) TA1R ) + ulRunTimeCounterOverflows )
+#endif
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 			0
@@ -159,11 +166,33 @@ left at 1 with no impact on the code size. */
 #define INCLUDE_xTimerPendFunctionCall			1
 
 /* Include functions that format system and run-time stats into human readable
-tables. */
-#define configUSE_STATS_FORMATTING_FUNCTIONS	1
+tables.  They need a heap, which the target build drops along with them at link
+time.  The host build has no heap, so leaves them out and formats the output
+of uxTaskGetSystemState() itself. */
+#ifdef USIP_HOST
+	#define configUSE_STATS_FORMATTING_FUNCTIONS	0
+#else
+	#define configUSE_STATS_FORMATTING_FUNCTIONS	1
+#endif
 
 /* Assert call defined for debug builds. */
-#define configASSERT( x ) if( ( x ) == 0 ) { taskDISABLE_INTERRUPTS(); for( ;; ) { P1OUT ^= 1 << 5; __delay_cycles(80000UL); } }
+#ifdef USIP_HOST
+	/* On the host, report where and stop. */
+	void vAssertCalled( const char *pcFile, unsigned long ulLine );
+	#define configASSERT( x ) if( ( x ) == 0 ) { vAssertCalled( __FILE__, __LINE__ ); }
+#else
+	#define configASSERT( x ) if( ( x ) == 0 ) { taskDISABLE_INTERRUPTS(); for( ;; ) { P1OUT ^= 1 << 5; __delay_cycles(80000UL); } }
+#endif
+
+#ifdef USIP_HOST
+	/* Lets the host build note what each task did to the GPIO registers
+	before it gave up the processor, and count tasks held up by queues. */
+	void vApplicationTaskSwitchedOut( void );
+	void vApplicationQueueBlocked( void *pvQueue, long xSending );
+	#define traceTASK_SWITCHED_OUT() vApplicationTaskSwitchedOut()
+	#define traceBLOCKING_ON_QUEUE_SEND( pxQueue ) vApplicationQueueBlocked( pxQueue, 1 )
+	#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue ) vApplicationQueueBlocked( pxQueue, 0 )
+#endif
 
 /* The MSP430X port uses a callback function to configure its tick interrupt.
 This allows the application to choose the tick interrupt source.
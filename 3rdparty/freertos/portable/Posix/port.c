@@ -0,0 +1,355 @@
+/*-----------------------------------------------------------
+ * Implementation of functions defined in portable.h for running the kernel
+ * as a Linux process.
+ *
+ * Every task gets a thread, but only the thread of the task the kernel has
+ * chosen ever runs. The others wait on their own event, and a context switch
+ * wakes the next task's thread before the current one goes back to waiting.
+ *
+ * The tick is SIGALRM from an interval timer. Every thread but the running
+ * one keeps it blocked, so the signal always lands on the running task, and
+ * disabling interrupts blocks it there too. A tick that needs a context
+ * switch makes it from inside the signal handler, so tasks are preempted
+ * like they are on target.
+ *
+ * Code running in a task can be preempted anywhere, including inside the C
+ * library. Tasks that call functions which take locks, like printf or
+ * malloc, should do so in a critical section.
+ *----------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+/* Standard includes. */
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Tasks don't run with interrupts enabled until the scheduler starts. */
+#define portINITIAL_CRITICAL_NESTING	( ( UBaseType_t ) 10 )
+
+/* Something a thread can wait for. */
+typedef struct xEVENT
+{
+	pthread_mutex_t xMutex;
+	pthread_cond_t xCond;
+	bool xSet;
+} Event_t;
+
+/* The thread behind a task. Kept at the top of the task's stack. */
+typedef struct xTHREAD
+{
+	pthread_t xThread;
+	TaskFunction_t pxCode;
+	void *pvParameters;
+	/* Set when the task is next to run. */
+	Event_t xResume;
+	/* Set when the task has been deleted and the thread should exit. */
+	volatile bool xDying;
+} Thread_t;
+
+/* The critical section nesting of the running task.  Saved by each task
+across a context switch, like the MSP430X port saves it on the stack. */
+static volatile UBaseType_t uxCriticalNesting = portINITIAL_CRITICAL_NESTING;
+
+/* Set once a task ends the scheduler. */
+static Event_t xSchedulerEnded;
+
+/* Just SIGALRM, the tick.  Filled in before main() runs. */
+static sigset_t xTickSignal;
+
+/*-----------------------------------------------------------*/
+
+static void prvInitTickSignal( void ) __attribute__( ( constructor ) );
+static void prvEventInit( Event_t *pxEvent );
+static void prvEventDestroy( Event_t *pxEvent );
+static void prvEventSignal( Event_t *pxEvent );
+static void prvEventWait( Event_t *pxEvent );
+static Thread_t *prvCurrentThread( void );
+static void prvSwitchContext( void );
+static void prvTickHandler( int iSignal );
+static void *prvThreadStart( void *pvParameters );
+
+/*-----------------------------------------------------------*/
+
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+Thread_t *pxThread;
+sigset_t xAllSignals, xPreviousSignals;
+int iResult;
+
+	/* The thread runs on a stack of its own, so the top of the task's stack
+	is free to hold the thread's record. */
+	pxThread = ( Thread_t * ) ( ( ( uintptr_t ) ( pxTopOfStack + 1 ) - sizeof( Thread_t ) ) & ~( ( uintptr_t ) portBYTE_ALIGNMENT - 1 ) );
+	memset( pxThread, 0, sizeof( Thread_t ) );
+	pxThread->pxCode = pxCode;
+	pxThread->pvParameters = pvParameters;
+	prvEventInit( &pxThread->xResume );
+
+	/* The thread starts with every signal blocked, and waits until the task
+	first runs. */
+	sigfillset( &xAllSignals );
+	pthread_sigmask( SIG_SETMASK, &xAllSignals, &xPreviousSignals );
+	iResult = pthread_create( &pxThread->xThread, NULL, prvThreadStart, pxThread );
+	pthread_sigmask( SIG_SETMASK, &xPreviousSignals, NULL );
+	configASSERT( iResult == 0 );
+
+	return ( StackType_t * ) pxThread;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+struct sigaction xAction;
+struct itimerval xTimer;
+
+	prvEventInit( &xSchedulerEnded );
+
+	/* The thread that started the scheduler never takes the tick. */
+	pthread_sigmask( SIG_BLOCK, &xTickSignal, NULL );
+
+	memset( &xAction, 0, sizeof( xAction ) );
+	xAction.sa_handler = prvTickHandler;
+	sigfillset( &xAction.sa_mask );
+	xAction.sa_flags = SA_RESTART;
+	sigaction( SIGALRM, &xAction, NULL );
+
+	memset( &xTimer, 0, sizeof( xTimer ) );
+	xTimer.it_interval.tv_usec = 1000000L / configTICK_RATE_HZ;
+	xTimer.it_value = xTimer.it_interval;
+	setitimer( ITIMER_REAL, &xTimer, NULL );
+
+	/* Run the first task, and wait for one to end the scheduler. */
+	prvEventSignal( &prvCurrentThread()->xResume );
+	prvEventWait( &xSchedulerEnded );
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+struct itimerval xTimer;
+sigset_t xAllSignals;
+
+	memset( &xTimer, 0, sizeof( xTimer ) );
+	setitimer( ITIMER_REAL, &xTimer, NULL );
+
+	/* Hand control back to vTaskStartScheduler().  This task never runs
+	again. */
+	sigfillset( &xAllSignals );
+	pthread_sigmask( SIG_SETMASK, &xAllSignals, NULL );
+	prvEventSignal( &xSchedulerEnded );
+	for( ;; )
+	{
+		prvEventWait( &prvCurrentThread()->xResume );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+sigset_t xPreviousSignals;
+
+	/* No tick while the context switches. */
+	pthread_sigmask( SIG_BLOCK, &xTickSignal, &xPreviousSignals );
+	prvSwitchContext();
+	pthread_sigmask( SIG_SETMASK, &xPreviousSignals, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortCleanUpTCB( void *pxTCB )
+{
+Thread_t *pxThread = *( Thread_t ** ) pxTCB;
+
+	/* The thread is waiting to run again.  Let it exit, and wait for it to
+	finish with its record before the kernel reuses the stack. */
+	pxThread->xDying = true;
+	prvEventSignal( &pxThread->xResume );
+	pthread_join( pxThread->xThread, NULL );
+	prvEventDestroy( &pxThread->xResume );
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+	pthread_sigmask( SIG_BLOCK, &xTickSignal, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+	pthread_sigmask( SIG_UNBLOCK, &xTickSignal, NULL );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortSetInterruptMask( void )
+{
+sigset_t xPreviousSignals;
+
+	pthread_sigmask( SIG_BLOCK, &xTickSignal, &xPreviousSignals );
+	return ( UBaseType_t ) sigismember( &xPreviousSignals, SIGALRM );
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( UBaseType_t uxMask )
+{
+	if( uxMask == 0 )
+	{
+		vPortEnableInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	vPortDisableInterrupts();
+	uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	if( uxCriticalNesting > 0 )
+	{
+		uxCriticalNesting--;
+
+		if( uxCriticalNesting == 0 )
+		{
+			vPortEnableInterrupts();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+unsigned long ulPortGetRunTimeCounterValue( void )
+{
+static struct timespec xStart;
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	if( xStart.tv_sec == 0 && xStart.tv_nsec == 0 )
+	{
+		xStart = xNow;
+	}
+
+	return ( unsigned long ) ( ( xNow.tv_sec - xStart.tv_sec ) * 1000000L + ( xNow.tv_nsec - xStart.tv_nsec ) / 1000L );
+}
+/*-----------------------------------------------------------*/
+
+static void prvInitTickSignal( void )
+{
+	sigemptyset( &xTickSignal );
+	sigaddset( &xTickSignal, SIGALRM );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventInit( Event_t *pxEvent )
+{
+	pthread_mutex_init( &pxEvent->xMutex, NULL );
+	pthread_cond_init( &pxEvent->xCond, NULL );
+	pxEvent->xSet = false;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventDestroy( Event_t *pxEvent )
+{
+	pthread_cond_destroy( &pxEvent->xCond );
+	pthread_mutex_destroy( &pxEvent->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventSignal( Event_t *pxEvent )
+{
+	pthread_mutex_lock( &pxEvent->xMutex );
+	pxEvent->xSet = true;
+	pthread_cond_signal( &pxEvent->xCond );
+	pthread_mutex_unlock( &pxEvent->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventWait( Event_t *pxEvent )
+{
+	pthread_mutex_lock( &pxEvent->xMutex );
+	while( !pxEvent->xSet )
+	{
+		pthread_cond_wait( &pxEvent->xCond, &pxEvent->xMutex );
+	}
+	pxEvent->xSet = false;
+	pthread_mutex_unlock( &pxEvent->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+static Thread_t *prvCurrentThread( void )
+{
+	/* The first member of a TCB is its top of stack, which is where the
+	thread's record is. */
+	return *( Thread_t ** ) xTaskGetCurrentTaskHandle();
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwitchContext( void )
+{
+Thread_t *pxPrevious = prvCurrentThread();
+Thread_t *pxNext;
+UBaseType_t uxSavedNesting = uxCriticalNesting;
+
+	vTaskSwitchContext();
+	pxNext = prvCurrentThread();
+
+	if( pxNext != pxPrevious )
+	{
+		prvEventSignal( &pxNext->xResume );
+		prvEventWait( &pxPrevious->xResume );
+
+		if( pxPrevious->xDying )
+		{
+			pthread_exit( NULL );
+		}
+	}
+
+	uxCriticalNesting = uxSavedNesting;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTickHandler( int iSignal )
+{
+	( void ) iSignal;
+
+	/* The tick is blocked while this runs, as if interrupts were disabled. */
+	if( xTaskIncrementTick() != pdFALSE )
+	{
+		prvSwitchContext();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void *prvThreadStart( void *pvParameters )
+{
+Thread_t *pxThread = ( Thread_t * ) pvParameters;
+
+	prvEventWait( &pxThread->xResume );
+	if( pxThread->xDying )
+	{
+		return NULL;
+	}
+
+	/* Name the thread after its task, for debuggers and profilers. */
+	pthread_setname_np( pthread_self(), pcTaskGetName( NULL ) );
+
+	/* Tasks start with interrupts enabled. */
+	uxCriticalNesting = 0;
+	vPortEnableInterrupts();
+
+	pxThread->pxCode( pxThread->pvParameters );
+
+	/* Tasks must not return.  Delete one that does. */
+	vTaskDelete( NULL );
+	return NULL;
+}
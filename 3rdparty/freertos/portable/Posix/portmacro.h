@@ -0,0 +1,92 @@
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+/*-----------------------------------------------------------
+ * Port specific definitions for running the kernel as a Linux process.
+ *
+ * Every task runs on its own thread, and only the thread of the running
+ * task is ever allowed to run. The tick is SIGALRM from an interval timer,
+ * and interrupts are disabled by blocking it.
+ *-----------------------------------------------------------
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Type definitions. */
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		long
+#define portSHORT		short
+#define portSTACK_TYPE	uintptr_t
+#define portBASE_TYPE	long
+#define portPOINTER_SIZE_TYPE uintptr_t
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#if( configUSE_16_BIT_TICKS == 1 )
+	typedef uint16_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffff
+#else
+	typedef uint32_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffffffffUL
+	#define portTICK_TYPE_IS_ATOMIC 1
+#endif
+/*-----------------------------------------------------------*/
+
+/* Interrupt control. */
+void vPortDisableInterrupts( void );
+void vPortEnableInterrupts( void );
+UBaseType_t uxPortSetInterruptMask( void );
+void vPortClearInterruptMask( UBaseType_t uxMask );
+
+#define portDISABLE_INTERRUPTS()					vPortDisableInterrupts()
+#define portENABLE_INTERRUPTS()						vPortEnableInterrupts()
+#define portSET_INTERRUPT_MASK_FROM_ISR()			uxPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )		vPortClearInterruptMask( x )
+/*-----------------------------------------------------------*/
+
+/* Critical section control. */
+void vPortEnterCritical( void );
+void vPortExitCritical( void );
+
+#define portENTER_CRITICAL()	vPortEnterCritical()
+#define portEXIT_CRITICAL()		vPortExitCritical()
+/*-----------------------------------------------------------*/
+
+/* Task utilities. */
+void vPortYield( void );
+void vPortCleanUpTCB( void *pxTCB );
+
+#define portYIELD()					vPortYield()
+#define portYIELD_FROM_ISR( x )		if( x ) vPortYield()
+#define portEND_SWITCHING_ISR( x )	portYIELD_FROM_ISR( x )
+#define portCLEAN_UP_TCB( pxTCB )	vPortCleanUpTCB( pxTCB )
+/*-----------------------------------------------------------*/
+
+/* Run time stats, in microseconds of the monotonic clock. */
+unsigned long ulPortGetRunTimeCounterValue( void );
+/*-----------------------------------------------------------*/
+
+/* Architecture specifics. */
+#define portBYTE_ALIGNMENT			8
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portNOP()
+/*-----------------------------------------------------------*/
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
@@ -0,0 +1,363 @@
+#include "bench.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <vector>
+
+/******************************************************************************\
+ *  Allocation counting                                                       *
+\******************************************************************************/
+namespace {
+    uint64_t allocations = 0;
+
+    void * counted_allocate(size_t size) {
+        ++allocations;
+        void * p = malloc(size ? size : 1);
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+}
+
+void * operator new(size_t size) { return counted_allocate(size); }
+void * operator new[](size_t size) { return counted_allocate(size); }
+void operator delete(void * p) noexcept { free(p); }
+void operator delete[](void * p) noexcept { free(p); }
+void operator delete(void * p, size_t) noexcept { free(p); }
+void operator delete[](void * p, size_t) noexcept { free(p); }
+
+uint64_t bench::allocation_count() {
+    return allocations;
+}
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+namespace {
+    struct entry {
+        std::string name;
+        bench::function_t function;
+        bench::function_arg_t function_arg;
+        size_t arg;
+    };
+
+    /// A benchmark's name, from the name of its function
+    std::string benchmark_name(const char * function) {
+        const char * prefix = "bench_";
+        size_t length = strlen(prefix);
+        return strncmp(function, prefix, length) ? function : function + length;
+    }
+
+    std::vector<entry> & registry() {
+        static std::vector<entry> entries;
+        return entries;
+    }
+
+    struct result {
+        std::string name;
+        uint64_t iterations;
+        double ns_per_op;
+        /// Zero if the benchmark didn't give a size
+        double bytes_per_second;
+        double allocations_per_op;
+        /// Figures the benchmark reported, from the measured run
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    struct options {
+        const char * filter;
+        double min_time_s;
+        const char * save;
+        const char * compare;
+        double tolerance;
+        bool allocations_only;
+        bool list;
+    };
+
+    uint64_t now_ns() {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void usage(const char * name) {
+        fprintf(stderr,
+            "usage: %s [--filter TEXT] [--min-time S] [--save FILE] [--compare FILE]\n"
+            "       [--tolerance PERCENT] [--allocations-only] [--list]\n"
+            "\n"
+            "Runs the benchmarks whose names contain TEXT, each for at least S\n"
+            "seconds (default 0.2). --save writes the results as a JSON baseline;\n"
+            "--compare checks them against one, and fails if a benchmark got more\n"
+            "than PERCENT slower (default 10) or allocates more than it did.\n"
+            "--allocations-only compares allocation counts alone, in whole\n"
+            "allocations per operation, for runs too short to time.\n",
+            name);
+    }
+
+    bool parse_options(int argc, char ** argv, options * out) {
+        *out = { "", 0.2, nullptr, nullptr, 10, false, false };
+        for (int i = 1; i < argc; ++i) {
+            bool has_value = i + 1 < argc;
+            if (!strcmp(argv[i], "--filter") && has_value) {
+                out->filter = argv[++i];
+            }
+            else if (!strcmp(argv[i], "--min-time") && has_value) {
+                out->min_time_s = atof(argv[++i]);
+            }
+            else if (!strcmp(argv[i], "--save") && has_value) {
+                out->save = argv[++i];
+            }
+            else if (!strcmp(argv[i], "--compare") && has_value) {
+                out->compare = argv[++i];
+            }
+            else if (!strcmp(argv[i], "--tolerance") && has_value) {
+                out->tolerance = atof(argv[++i]);
+            }
+            else if (!strcmp(argv[i], "--allocations-only")) {
+                out->allocations_only = true;
+            }
+            else if (!strcmp(argv[i], "--list")) {
+                out->list = true;
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Run a benchmark with more iterations each time until a run takes at
+    /// least min_time_ns, and report that run
+    result measure(const entry & e, uint64_t min_time_ns) {
+        uint64_t iterations = 1;
+        for (;;) {
+            bench::state state(iterations);
+            if (e.function) {
+                e.function(state);
+            }
+            else {
+                e.function_arg(state, e.arg);
+            }
+
+            uint64_t elapsed = state.elapsed_ns();
+            if (elapsed >= min_time_ns || iterations >= 1000000000) {
+                double seconds = elapsed / 1e9;
+                return {
+                    e.name,
+                    iterations,
+                    double(elapsed) / iterations,
+                    state.bytes_per_op() && elapsed ? state.bytes_per_op() * iterations / seconds : 0,
+                    double(state.allocations()) / iterations,
+                    state.counters(),
+                };
+            }
+
+            // Aim a little past the minimum, growing at least twofold so
+            // calibration can't crawl and at most a hundredfold so a
+            // mismeasured short run can't blow up
+            double scale = elapsed ? 1.4 * min_time_ns / elapsed : 100;
+            scale = std::min(100.0, std::max(2.0, scale));
+            iterations = (uint64_t) (iterations * scale);
+        }
+    }
+
+    /// The number after "key": on a line, or -1 if the key isn't there
+    double json_number(const std::string & line, const char * key) {
+        std::string quoted = std::string("\"") + key + "\":";
+        size_t at = line.find(quoted);
+        return at == std::string::npos ? -1 : atof(line.c_str() + at + quoted.size());
+    }
+
+    /// The string after "key": on a line, or "" if the key isn't there
+    std::string json_string(const std::string & line, const char * key) {
+        std::string quoted = std::string("\"") + key + "\": \"";
+        size_t at = line.find(quoted);
+        if (at == std::string::npos) {
+            return "";
+        }
+        at += quoted.size();
+        return line.substr(at, line.find('"', at) - at);
+    }
+
+    /// Write results as a baseline. Each benchmark is an object on its own
+    /// line, which is all load_baseline relies on.
+    bool save_baseline(const char * path, const std::vector<result> & results) {
+        FILE * f = fopen(path, "w");
+        if (!f) {
+            perror(path);
+            return false;
+        }
+        fprintf(f, "{\n  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const result & r = results[i];
+            fprintf(f, "    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, "
+                "\"bytes_per_second\": %.0f, \"allocations_per_op\": %.4f }%s\n",
+                r.name.c_str(), (unsigned long long) r.iterations, r.ns_per_op,
+                r.bytes_per_second, r.allocations_per_op, i + 1 < results.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        return fclose(f) == 0;
+    }
+
+    /// Read a baseline written by save_baseline
+    bool load_baseline(const char * path, std::vector<result> * out) {
+        FILE * f = fopen(path, "r");
+        if (!f) {
+            perror(path);
+            return false;
+        }
+        char buffer[512];
+        while (fgets(buffer, sizeof(buffer), f)) {
+            std::string line(buffer);
+            std::string name = json_string(line, "name");
+            if (!name.empty()) {
+                out->push_back({
+                    name,
+                    (uint64_t) json_number(line, "iterations"),
+                    json_number(line, "ns_per_op"),
+                    json_number(line, "bytes_per_second"),
+                    json_number(line, "allocations_per_op"),
+                    {},
+                });
+            }
+        }
+        fclose(f);
+        return true;
+    }
+
+    const result * find(const std::vector<result> & results, const std::string & name) {
+        for (const auto & r : results) {
+            if (r.name == name) {
+                return &r;
+            }
+        }
+        return nullptr;
+    }
+}
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+bench::state::state(uint64_t iterations)
+    : _iterations(iterations), _remaining(iterations), _started_ns(0), _elapsed_ns(0),
+      _allocations_at_start(0), _allocations(0), _bytes_per_op(0), _running(false) {}
+
+bool bench::state::keep_running() {
+    if (!_running && _remaining == _iterations) {
+        resume();
+    }
+    if (_remaining == 0) {
+        if (_running) {
+            pause();
+        }
+        return false;
+    }
+    --_remaining;
+    return true;
+}
+
+void bench::state::pause() {
+    _elapsed_ns += now_ns() - _started_ns;
+    _allocations += allocation_count() - _allocations_at_start;
+    _running = false;
+}
+
+void bench::state::resume() {
+    _running = true;
+    _allocations_at_start = allocation_count();
+    _started_ns = now_ns();
+}
+
+bench::registration::registration(const char * name, function_t function) {
+    registry().push_back({ benchmark_name(name), function, nullptr, 0 });
+}
+
+bench::registration::registration(const char * name, function_arg_t function, std::initializer_list<size_t> args) {
+    for (size_t arg : args) {
+        registry().push_back({ benchmark_name(name) + "/" + std::to_string(arg), nullptr, function, arg });
+    }
+}
+
+int bench::run_all(int argc, char ** argv) {
+    options opts;
+    if (!parse_options(argc, argv, &opts)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<result> baseline;
+    if (opts.compare && !load_baseline(opts.compare, &baseline)) {
+        return 2;
+    }
+
+    if (opts.list) {
+        for (const auto & e : registry()) {
+            if (e.name.find(opts.filter) != std::string::npos) {
+                printf("%s\n", e.name.c_str());
+            }
+        }
+        return 0;
+    }
+
+    printf("%-40s %12s %12s %10s %10s", "benchmark", "iterations", "ns/op", "MB/s", "allocs/op");
+    printf(opts.compare ? " %10s\n" : "\n", "vs base");
+
+    std::vector<result> results;
+    int regressions = 0;
+    for (const auto & e : registry()) {
+        if (e.name.find(opts.filter) == std::string::npos) {
+            continue;
+        }
+
+        result r = measure(e, (uint64_t) (opts.min_time_s * 1e9));
+        results.push_back(r);
+        printf("%-40s %12llu %12.1f ", r.name.c_str(), (unsigned long long) r.iterations, r.ns_per_op);
+        if (r.bytes_per_second > 0) {
+            printf("%10.1f", r.bytes_per_second / 1e6);
+        }
+        else {
+            printf("%10s", "-");
+        }
+        printf(" %10.2f", r.allocations_per_op);
+
+        const result * base = opts.compare ? find(baseline, r.name) : nullptr;
+        if (base && opts.allocations_only) {
+            // A short run still carries the allocations the benchmark's
+            // buffers make warming up, so only a whole extra allocation
+            // per operation counts
+            bool regressed = std::lround(r.allocations_per_op) > std::lround(base->allocations_per_op);
+            printf(" %+10.2f%s", r.allocations_per_op - base->allocations_per_op, regressed ? "  REGRESSED" : "");
+            regressions += regressed;
+        }
+        else if (base && base->ns_per_op > 0) {
+            double change = 100.0 * (r.ns_per_op - base->ns_per_op) / base->ns_per_op;
+            // Allocation counts don't jitter, so any growth is a regression
+            bool regressed = change > opts.tolerance || r.allocations_per_op > base->allocations_per_op + 0.005;
+            printf(" %+9.1f%%%s", change, regressed ? "  REGRESSED" : "");
+            regressions += regressed;
+        }
+        else if (opts.compare) {
+            printf(" %10s", "new");
+        }
+        for (const auto & counter : r.counters) {
+            printf("  %s=%.4g", counter.first.c_str(), counter.second);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    if (opts.save && !save_baseline(opts.save, results)) {
+        return 2;
+    }
+    if (regressions) {
+        printf("\n%d benchmark%s regressed against %s\n", regressions, regressions == 1 ? "" : "s", opts.compare);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+#ifndef _BENCH_HPP_
+#define _BENCH_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// A small benchmark harness for the host build, run as `usip_bench`.
+///
+/// A benchmark is a function that runs the code under test once per trip
+/// round a loop controlled by its state:
+///
+///     void bench_thing(bench::state & state) {
+///         // setup
+///         while (state.keep_running()) {
+///             // the operation being timed
+///         }
+///         state.set_bytes_per_op(64);
+///     }
+///     BENCHMARK(bench_thing);
+///
+/// The runner calls it with more and more iterations until one call takes
+/// long enough to time, then reports time and heap allocations per
+/// operation, and bytes per second if the benchmark said how many bytes an
+/// operation handles. A benchmark can report figures of its own, like a
+/// compression ratio, as counters. Benchmarks are named after their
+/// function, less the `bench_` prefix that keeps them apart from the code
+/// they measure.
+namespace bench {
+    class state {
+        public:
+            explicit state(uint64_t iterations);
+
+            /// True until the loop has run its iterations. The clock starts
+            /// on the first call and stops on the last.
+            bool keep_running();
+
+            /// Stop the clock and the allocation count, for setup inside the
+            /// loop. Must be followed by resume().
+            void pause();
+
+            /// Start the clock and allocation count again after pause()
+            void resume();
+
+            /// The bytes one operation handles, for the throughput column
+            void set_bytes_per_op(uint64_t bytes) { _bytes_per_op = bytes; }
+
+            /// Report a figure alongside the timings, shown as name=value.
+            /// Call outside the loop.
+            void set_counter(const std::string & name, double value) { _counters.emplace_back(name, value); }
+
+            /// The number of iterations the loop runs
+            uint64_t iterations() const { return _iterations; }
+
+            /// Time spent in the loop, in nanoseconds, without pauses
+            uint64_t elapsed_ns() const { return _elapsed_ns; }
+
+            /// Heap allocations made in the loop, without pauses
+            uint64_t allocations() const { return _allocations; }
+
+            uint64_t bytes_per_op() const { return _bytes_per_op; }
+
+            const std::vector<std::pair<std::string, double>> & counters() const { return _counters; }
+
+        private:
+            uint64_t _iterations;
+            uint64_t _remaining;
+            uint64_t _started_ns;
+            uint64_t _elapsed_ns;
+            uint64_t _allocations_at_start;
+            uint64_t _allocations;
+            uint64_t _bytes_per_op;
+            std::vector<std::pair<std::string, double>> _counters;
+            bool _running;
+    };
+
+    typedef void (*function_t)(state & state);
+    typedef void (*function_arg_t)(state & state, size_t arg);
+
+    /// Registers a benchmark when constructed. Use through BENCHMARK.
+    struct registration {
+        registration(const char * name, function_t function);
+
+        /// Register the function once for each argument, named `name/arg`
+        registration(const char * name, function_arg_t function, std::initializer_list<size_t> args);
+    };
+
+    /// Heap allocations made through operator new since the program started
+    uint64_t allocation_count();
+
+    /// Keep the compiler from optimising away a result
+    template<class T> inline void do_not_optimize(const T & value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /// Run the benchmarks the command line picks, as usip_bench's main.
+    /// Returns the exit status: non-zero if the command line was bad, or a
+    /// benchmark regressed against the baseline it was compared with.
+    int run_all(int argc, char ** argv);
+}
+
+#define BENCH_CONCAT_(A, B) A ## B
+#define BENCH_CONCAT(A, B) BENCH_CONCAT_(A, B)
+
+/// Register a benchmark function
+#define BENCHMARK(FUNCTION) \
+    static bench::registration BENCH_CONCAT(bench_registration_, __LINE__)(#FUNCTION, FUNCTION)
+
+/// Register a benchmark function taking an argument, once for each value
+#define BENCHMARK_ARGS(FUNCTION, ...) \
+    static bench::registration BENCH_CONCAT(bench_registration_, __LINE__)(#FUNCTION, FUNCTION, { __VA_ARGS__ })
+
+#endif // _BENCH_HPP_
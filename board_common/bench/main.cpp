@@ -0,0 +1,13 @@
+// The mock UART and SPI channels are built on Catch's matchers, so Catch's
+// implementation has to be compiled in even though its runner isn't used
+#define CATCH_CONFIG_RUNNER
+// Catch's POSIX signal handler sizes a static array with SIGSTKSZ, which is no
+// longer a constant expression on recent glibc
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
+#include <catch/catch.hpp>
+
+#include "bench.hpp"
+
+int main(int argc, char ** argv) {
+    return bench::run_all(argc, argv);
+}
@@ -0,0 +1,55 @@
+#include "bench.hpp"
+#include "spi.h"
+
+#include <vector>
+
+namespace {
+    /// Bytes the mock records before the benchmark clears them, outside the
+    /// timed loop, so its logs stay in memory it already has
+    const size_t MOCK_LOG_LIMIT = 1 << 16;
+
+    void transfer(bench::state & state, spi_t & spi, size_t length) {
+        std::vector<uint8_t> send(length), receive(length);
+        for (size_t i = 0; i < length; ++i) {
+            send[i] = i;
+        }
+
+        while (state.keep_running()) {
+            if (spi._impl->mosi_bytes.size() + length > MOCK_LOG_LIMIT) {
+                state.pause();
+                spi._impl->mosi_bytes.clear();
+                spi._impl->miso_bytes.clear();
+                state.resume();
+            }
+            spi_transfer_bytes(&spi, send.data(), receive.data(), length);
+            bench::do_not_optimize(receive[length - 1]);
+        }
+        state.set_bytes_per_op(length);
+    }
+}
+
+/// Against the stub device, which costs next to nothing
+void bench_spi_transfer_bytes(bench::state & state, size_t length) {
+    spi_t spi;
+    spi_open(&spi);
+    transfer(state, spi, length);
+    spi_close(&spi);
+}
+BENCHMARK_ARGS(bench_spi_transfer_bytes, 1, 16, 64, 255);
+
+/// Against a device behind a callback with the bus clock kept, as the
+/// co-simulation connects boards
+void bench_spi_transfer_bytes_slave(bench::state & state, size_t length) {
+    spi_t spi;
+    spi_open(&spi);
+    uint8_t last = 0;
+    spi._impl->slave = [&last](uint8_t mosi) {
+        uint8_t miso = last;
+        last = mosi;
+        return miso;
+    };
+    spi._impl->clock_rate = 1000000;
+    transfer(state, spi, length);
+    spi_close(&spi);
+}
+BENCHMARK_ARGS(bench_spi_transfer_bytes_slave, 1, 16, 64, 255);
@@ -0,0 +1,46 @@
+#ifndef _BOARD_COMMON_CRITICAL_H_
+#define _BOARD_COMMON_CRITICAL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup critical Critical sections
+ *  Short sections of code that must not be interrupted by an interrupt
+ *  handler or another task. On target interrupts are masked; in the test
+ *  build a process wide lock is held instead, so code using these can be
+ *  exercised from several threads.
+ *
+ *  Sections nest: each critical_exit restores the state its matching
+ *  critical_enter saw.
+ *  @{
+ */
+
+/**
+ * The state to restore when a critical section ends
+ */
+typedef uint16_t critical_state_t;
+
+/**
+ * Start a critical section
+ *
+ * @return The state to pass to the matching critical_exit
+ */
+critical_state_t critical_enter(void);
+
+/**
+ * End a critical section
+ *
+ * @param state The state returned by the matching critical_enter
+ */
+void critical_exit(critical_state_t state);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _BOARD_COMMON_CRITICAL_H_
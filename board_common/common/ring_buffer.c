@@ -0,0 +1,117 @@
+#include "ring_buffer.h"
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+// The producer publishes `head` with release semantics after writing the
+// storage, and the consumer publishes `tail` with release semantics after
+// reading it. On the MSP430 these compile to plain 16-bit moves; on the host
+// they provide the ordering the threaded tests rely on.
+static inline uint16_t load_acquire(const volatile uint16_t * index) {
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_release(volatile uint16_t * index, uint16_t value) {
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+bool ring_buffer_init(ring_buffer_t * ring, uint8_t * storage, uint16_t capacity) {
+    bool is_power_of_two = (capacity != 0) && ((capacity & (capacity - 1)) == 0);
+    if (!is_power_of_two || capacity > 0x8000) {
+        return false;
+    }
+
+    ring->storage = storage;
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->tail = 0;
+
+    return true;
+}
+
+void ring_buffer_clear(ring_buffer_t * ring) {
+    store_release(&ring->tail, load_acquire(&ring->head));
+}
+
+bool ring_buffer_push(ring_buffer_t * ring, uint8_t byte) {
+    uint16_t head = ring->head;
+    uint16_t tail = load_acquire(&ring->tail);
+
+    if ((uint16_t)(head - tail) >= ring->capacity) {
+        return false;
+    }
+
+    ring->storage[head & (ring->capacity - 1)] = byte;
+    store_release(&ring->head, head + 1);
+
+    return true;
+}
+
+bool ring_buffer_pop(ring_buffer_t * ring, uint8_t * byte) {
+    uint16_t tail = ring->tail;
+    uint16_t head = load_acquire(&ring->head);
+
+    if (head == tail) {
+        return false;
+    }
+
+    *byte = ring->storage[tail & (ring->capacity - 1)];
+    store_release(&ring->tail, tail + 1);
+
+    return true;
+}
+
+size_t ring_buffer_push_bytes(ring_buffer_t * ring, const uint8_t * bytes, size_t n) {
+    uint16_t head = ring->head;
+    uint16_t tail = load_acquire(&ring->tail);
+    uint16_t mask = ring->capacity - 1;
+    uint16_t space = ring->capacity - (uint16_t)(head - tail);
+
+    if (n > space) {
+        n = space;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        ring->storage[(uint16_t)(head + i) & mask] = bytes[i];
+    }
+    store_release(&ring->head, head + (uint16_t)n);
+
+    return n;
+}
+
+size_t ring_buffer_pop_bytes(ring_buffer_t * ring, uint8_t * bytes, size_t n) {
+    uint16_t tail = ring->tail;
+    uint16_t head = load_acquire(&ring->head);
+    uint16_t mask = ring->capacity - 1;
+    uint16_t available = head - tail;
+
+    if (n > available) {
+        n = available;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        bytes[i] = ring->storage[(uint16_t)(tail + i) & mask];
+    }
+    store_release(&ring->tail, tail + (uint16_t)n);
+
+    return n;
+}
+
+uint16_t ring_buffer_size(const ring_buffer_t * ring) {
+    return load_acquire(&ring->head) - load_acquire(&ring->tail);
+}
+
+uint16_t ring_buffer_free(const ring_buffer_t * ring) {
+    return ring->capacity - ring_buffer_size(ring);
+}
+
+bool ring_buffer_is_empty(const ring_buffer_t * ring) {
+    return ring_buffer_size(ring) == 0;
+}
+
+bool ring_buffer_is_full(const ring_buffer_t * ring) {
+    return ring_buffer_size(ring) >= ring->capacity;
+}
@@ -0,0 +1,146 @@
+#ifndef _BOARD_COMMON_RING_BUFFER_H_
+#define _BOARD_COMMON_RING_BUFFER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup ring_buffer Single-producer/single-consumer byte ring
+ *  A lock-free byte FIFO that is safe to share between exactly one producer
+ *  and exactly one consumer, where either side may be an interrupt handler.
+ *  The producer only ever writes `head` and the consumer only ever writes
+ *  `tail`, so no critical section is required on either side.
+ *  @{
+ */
+
+/**
+ * The state of a ring buffer. The storage is owned by the caller and must
+ * outlive the ring.
+ */
+typedef struct ring_buffer {
+    /**
+     * Backing storage for the ring
+     */
+    uint8_t * storage;
+    /**
+     * Size of the backing storage in bytes. Always a power of two.
+     */
+    uint16_t capacity;
+    /**
+     * Free running count of bytes pushed. Only written by the producer.
+     */
+    volatile uint16_t head;
+    /**
+     * Free running count of bytes popped. Only written by the consumer.
+     */
+    volatile uint16_t tail;
+} ring_buffer_t;
+
+/**
+ * Initialize a ring buffer over caller-provided storage
+ *
+ * @param ring The ring to initialize
+ * @param storage The backing storage
+ * @param capacity The size of the storage. Must be a non-zero power of two no
+ *      larger than 32768.
+ *
+ * @return True if and only if the capacity is valid
+ */
+bool ring_buffer_init(ring_buffer_t * ring, uint8_t * storage, uint16_t capacity);
+
+/**
+ * Discard the contents of a ring buffer. Must not race with either side.
+ *
+ * @param ring The ring to clear
+ */
+void ring_buffer_clear(ring_buffer_t * ring);
+
+/**
+ * Push a byte in to the ring. Producer side only.
+ *
+ * @param ring The ring to push to
+ * @param byte The byte to push
+ *
+ * @return True if the byte was stored, false if the ring was full
+ */
+bool ring_buffer_push(ring_buffer_t * ring, uint8_t byte);
+
+/**
+ * Pop a byte out of the ring. Consumer side only.
+ *
+ * @param ring The ring to pop from
+ * @param byte Memory location to store the popped byte
+ *
+ * @return True if a byte was popped, false if the ring was empty
+ */
+bool ring_buffer_pop(ring_buffer_t * ring, uint8_t * byte);
+
+/**
+ * Push as many bytes as will fit in to the ring. Producer side only.
+ *
+ * @param ring The ring to push to
+ * @param bytes The bytes to push
+ * @param n The number of bytes available in `bytes`
+ *
+ * @return The number of bytes actually pushed
+ */
+size_t ring_buffer_push_bytes(ring_buffer_t * ring, const uint8_t * bytes, size_t n);
+
+/**
+ * Pop up to n bytes out of the ring. Consumer side only.
+ *
+ * @param ring The ring to pop from
+ * @param bytes The buffer to pop in to
+ * @param n The maximum number of bytes to pop
+ *
+ * @return The number of bytes actually popped
+ */
+size_t ring_buffer_pop_bytes(ring_buffer_t * ring, uint8_t * bytes, size_t n);
+
+/**
+ * Get the number of bytes waiting in the ring
+ *
+ * @param ring The ring to inspect
+ *
+ * @return The number of bytes that can be popped
+ */
+uint16_t ring_buffer_size(const ring_buffer_t * ring);
+
+/**
+ * Get the number of bytes that can be pushed before the ring is full
+ *
+ * @param ring The ring to inspect
+ *
+ * @return The free space in the ring
+ */
+uint16_t ring_buffer_free(const ring_buffer_t * ring);
+
+/**
+ * Check if the ring has no bytes waiting
+ *
+ * @param ring The ring to inspect
+ *
+ * @return True if and only if the ring is empty
+ */
+bool ring_buffer_is_empty(const ring_buffer_t * ring);
+
+/**
+ * Check if the ring has no space left
+ *
+ * @param ring The ring to inspect
+ *
+ * @return True if and only if the ring is full
+ */
+bool ring_buffer_is_full(const ring_buffer_t * ring);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _BOARD_COMMON_RING_BUFFER_H_
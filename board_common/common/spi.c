@@ -12,6 +12,9 @@ spi_error_t spi_receive_byte(spi_t * channel, uint8_t * byte) {
     return spi_transfer_byte(channel, 0, byte);
 }
 
+// Backends that can keep the bus busy across a whole block provide their own
+// bulk transfers. These byte-at-a-time versions serve everyone else.
+#ifndef SPI_NATIVE_BULK_TRANSFERS
 spi_error_t spi_send_bytes(spi_t * channel, uint8_t * send_bytes, size_t length) {
     spi_error_t err;
 
@@ -53,6 +56,54 @@ spi_error_t spi_transfer_bytes(spi_t * channel, uint8_t * send_bytes, uint8_t *
 
     return SPI_NO_ERROR;
 }
+#endif // SPI_NATIVE_BULK_TRANSFERS
+
+// Fill `out` with the fastest rate `source_rate` can divide down to without
+// exceeding `clock_rate`. Returns false if the prescaler would overflow.
+static bool spi_divide_clock(spi_clock_source_t source, uint32_t source_rate,
+                             uint32_t clock_rate, spi_clock_t * out) {
+    if (source_rate == 0 || clock_rate == 0) {
+        return false;
+    }
+
+    uint32_t prescaler = (source_rate + clock_rate - 1) / clock_rate;
+    if (prescaler == 0) {
+        prescaler = 1;
+    }
+    if (prescaler > UINT16_MAX) {
+        return false;
+    }
+
+    out->source = source;
+    out->prescaler = (uint16_t)prescaler;
+    out->rate = source_rate / prescaler;
+    return true;
+}
+
+bool spi_select_clock(const spi_config_t * config,
+                      uint32_t smclk_rate, uint32_t aclk_rate, spi_clock_t * out) {
+    spi_clock_t aclk;
+    spi_clock_t smclk;
+    bool aclk_ok = false;
+    bool smclk_ok = false;
+
+    if (config->clock_source != SPI_CLOCK_SOURCE_SMCLK) {
+        aclk_ok = spi_divide_clock(SPI_CLOCK_SOURCE_ACLK, aclk_rate, config->clock_rate, &aclk);
+    }
+    if (config->clock_source != SPI_CLOCK_SOURCE_ACLK) {
+        smclk_ok = spi_divide_clock(SPI_CLOCK_SOURCE_SMCLK, smclk_rate, config->clock_rate, &smclk);
+    }
+
+    if (smclk_ok && (!aclk_ok || smclk.rate > aclk.rate)) {
+        *out = smclk;
+        return true;
+    }
+    if (aclk_ok) {
+        *out = aclk;
+        return true;
+    }
+    return false;
+}
 
 #ifndef NDEBUG
 const char * spi_error_string(spi_error_t t) {
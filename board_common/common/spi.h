@@ -15,7 +15,8 @@ extern "C" {
 /// Macro for defining thing related to SPI errors
 #define SPI_ERROR_LIST(OP) \
     OP(NO_ERROR) \
-    OP(CHANNEL_CLOSED)
+    OP(CHANNEL_CLOSED) \
+    OP(OVERRUN)
 
 /// Enum representing possible error states for a SPI channel.
 typedef enum spi_error {
@@ -30,6 +31,95 @@ typedef enum spi_error {
 const char * spi_error_string(spi_error_t t);
 #endif
 
+/******************************************************************************\
+ *  Bus configuration                                                         *
+\******************************************************************************/
+/// The clocks a SPI block can derive its bit clock from
+typedef enum spi_clock_source {
+    /// Let spi_open pick whichever source gets closest to the requested rate
+    SPI_CLOCK_SOURCE_AUTO,
+    /// The sub-system master clock, usually the DCO
+    SPI_CLOCK_SOURCE_SMCLK,
+    /// The auxiliary clock, usually the 32 kHz crystal
+    SPI_CLOCK_SOURCE_ACLK
+} spi_clock_source_t;
+
+/// The four clock polarity and phase combinations, numbered as in most
+/// device data sheets
+typedef enum spi_mode {
+    /// Idle low, sample on the rising edge
+    SPI_MODE_0,
+    /// Idle low, sample on the falling edge
+    SPI_MODE_1,
+    /// Idle high, sample on the falling edge
+    SPI_MODE_2,
+    /// Idle high, sample on the rising edge
+    SPI_MODE_3
+} spi_mode_t;
+
+/// The order bits are shifted out of each byte
+typedef enum spi_bit_order {
+    SPI_MSB_FIRST,
+    SPI_LSB_FIRST
+} spi_bit_order_t;
+
+/// Whether the block drives a slave select line itself
+typedef enum spi_pins {
+    /// SIMO, SOMI and CLK only. Slave selects are GPIOs owned by the caller.
+    SPI_3PIN,
+    /// Also use the STE pin, active high
+    SPI_4PIN_ACTIVE_HIGH,
+    /// Also use the STE pin, active low
+    SPI_4PIN_ACTIVE_LOW
+} spi_pins_t;
+
+/// Everything needed to bring up a SPI bus
+typedef struct spi_config {
+    /// The fastest bit clock the slaves can take, in Hz. The bus never runs
+    /// faster than this.
+    uint32_t clock_rate;
+    /// Where the bit clock comes from
+    spi_clock_source_t clock_source;
+    /// Clock polarity and phase
+    spi_mode_t mode;
+    /// Bit order
+    spi_bit_order_t bit_order;
+    /// 3 or 4 pin operation
+    spi_pins_t pins;
+} spi_config_t;
+
+/// The bus every board opened before the configuration existed: mode 3 (CKPL
+/// high, capture on the second edge), MSB first, 3 pin, clocked from ACLK.
+/// Start from this rather than a zeroed config, which would mean mode 0.
+#define SPI_CONFIG_DEFAULT(CLOCK_RATE) \
+    { (CLOCK_RATE), SPI_CLOCK_SOURCE_ACLK, SPI_MODE_3, SPI_MSB_FIRST, SPI_3PIN }
+
+/// A clock source and prescaler chosen for a bus
+typedef struct spi_clock {
+    /// The source to use. Never SPI_CLOCK_SOURCE_AUTO.
+    spi_clock_source_t source;
+    /// The prescaler to program in to UCxxBRW
+    uint16_t prescaler;
+    /// The bit clock that results, in Hz
+    uint32_t rate;
+} spi_clock_t;
+
+/** Choose the clock source and prescaler that get closest to the requested
+ * rate without going over it.
+ *
+ * When both sources are allowed and reach the same rate ACLK wins, since it
+ * keeps running in the low power modes.
+ *
+ * @param config The bus configuration. Only clock_rate and clock_source are
+ *               used.
+ * @param smclk_rate The current SMCLK frequency in Hz
+ * @param aclk_rate The current ACLK frequency in Hz
+ * @param out The clock to fill
+ * @return False if no allowed source can go slow enough
+ */
+bool spi_select_clock(const spi_config_t * config,
+    uint32_t smclk_rate, uint32_t aclk_rate, spi_clock_t * out);
+
 /** Opaque type for the SPI state
  *
  */
@@ -88,7 +178,9 @@ spi_error_t spi_transfer_byte(spi_t * channel,
  * @param receive_bytes The address of the bytes to save to.
  * @param length The length of the bytes to send and receive.
  *
- * @return An error code. This should always be checked.
+ * @return An error code. This should always be checked. SPI_OVERRUN means a
+ *      received byte never arrived or was overwritten by the next one, and
+ *      receive_bytes is incomplete.
  */
 spi_error_t spi_transfer_bytes(spi_t * channel,
     uint8_t * send_bytes, uint8_t * receive_bytes, size_t length);
@@ -0,0 +1,82 @@
+#include "spi_block.h"
+#include "critical.h"
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+/**
+ * Wait for the byte being shifted in and read it
+ *
+ * @param port The block's registers
+ * @param block Passed through to the port
+ * @param byte The output byte
+ *
+ * @return SPI_OVERRUN if the byte didn't arrive within SPI_BLOCK_RX_POLLS,
+ *      or the one after it landed on top of it
+ */
+static spi_error_t spi_block_receive(const spi_block_port_t * port, void * block, uint8_t * byte);
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+spi_error_t spi_block_transfer(const spi_block_port_t * port, void * block,
+        const uint8_t * send_bytes, uint8_t * receive_bytes, size_t length) {
+    if (length == 0) {
+        return SPI_NO_ERROR;
+    }
+
+    // Prime the pipeline. TXBUF empties as soon as this byte moves in to the
+    // shift register, so the loop below queues byte i while byte i - 1 is
+    // still on the wire.
+    while (!port->tx_ready(block));
+    port->send(block, send_bytes ? send_bytes[0] : 0);
+
+    for (size_t i = 1; i < length; ++i) {
+        while (!port->tx_ready(block));
+        port->send(block, send_bytes ? send_bytes[i] : 0);
+
+        spi_error_t err = spi_block_receive(port, block, &receive_bytes[i - 1]);
+        if (err != SPI_NO_ERROR) {
+            return err;
+        }
+    }
+
+    return spi_block_receive(port, block, &receive_bytes[length - 1]);
+}
+
+void spi_block_send(const spi_block_port_t * port, void * block,
+        const uint8_t * send_bytes, size_t length) {
+    // Nobody wants the received bytes, so only keep TXBUF topped up
+    for (size_t i = 0; i < length; ++i) {
+        while (!port->tx_ready(block));
+        port->send(block, send_bytes[i]);
+    }
+
+    // Let the last byte finish, then clear the received byte and the overrun
+    // flag the ignored bytes raised
+    bool overrun;
+    while (port->busy(block));
+    port->receive(block, &overrun);
+}
+
+/******************************************************************************\
+ *  Private support function implementations                                  *
+\******************************************************************************/
+static spi_error_t spi_block_receive(const spi_block_port_t * port, void * block, uint8_t * byte) {
+    uint32_t polls = 0;
+    while (!port->rx_ready(block)) {
+        if (++polls == SPI_BLOCK_RX_POLLS) {
+            return SPI_OVERRUN;
+        }
+    }
+
+    // Reading RXBUF clears UCOE. If the next byte landed between sampling
+    // the flag and reading the byte, the overrun would go unseen, so the two
+    // reads can't be split.
+    bool overrun;
+    critical_state_t state = critical_enter();
+    *byte = port->receive(block, &overrun);
+    critical_exit(state);
+
+    return overrun ? SPI_OVERRUN : SPI_NO_ERROR;
+}
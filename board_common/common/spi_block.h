@@ -0,0 +1,99 @@
+#ifndef _BOARD_COMMON_SPI_BLOCK_H_
+#define _BOARD_COMMON_SPI_BLOCK_H_
+
+#include "spi.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup spi_block SPI block pipeline
+ *  The byte sequencing behind the native backends' bulk transfers. Each
+ *  backend describes its registers with a port, so the eUSCI and USCI blocks
+ *  share one implementation, and the test build runs it against a model of
+ *  the peripheral.
+ *
+ *  Byte i is queued in TXBUF while byte i - 1 is still shifting, so SCLK
+ *  doesn't stop between bytes. If an interrupt delays the read of byte i - 1
+ *  by more than a byte time, byte i lands on top of it. Rather than mask
+ *  interrupts for that whole window, the pipeline reads the overrun flag and
+ *  the received byte together in a critical section a few cycles long, and
+ *  reports SPI_OVERRUN if a byte was overwritten.
+ *  @{
+ */
+
+/**
+ * Polls of UCRXIFG before a transfer gives up on a byte. Each poll takes at
+ * least one MCLK cycle, so this is a whole byte at the largest prescaler. The
+ * polls don't count time spent in interrupts, so it only runs out if the
+ * byte was lost.
+ */
+#ifndef SPI_BLOCK_RX_POLLS
+#   define SPI_BLOCK_RX_POLLS (8UL * 0x10000UL)
+#endif
+
+/**
+ * Access to one block's registers
+ */
+typedef struct spi_block_port {
+    /**
+     * Check UCTXIFG, set when TXBUF can take another byte
+     */
+    bool (*tx_ready)(void * block);
+    /**
+     * Check UCRXIFG, set when RXBUF holds a byte that hasn't been read
+     */
+    bool (*rx_ready)(void * block);
+    /**
+     * Check UCBUSY, set while a byte is shifting
+     */
+    bool (*busy)(void * block);
+    /**
+     * Write a byte to TXBUF
+     */
+    void (*send)(void * block, uint8_t byte);
+    /**
+     * Read RXBUF, which clears UCRXIFG and UCOE. Sets overrun to UCOE as it
+     * was before the read. Called in a critical section.
+     */
+    uint8_t (*receive)(void * block, bool * overrun);
+} spi_block_port_t;
+
+/**
+ * Send and receive a block of bytes
+ *
+ * @param port The block's registers
+ * @param block Passed through to the port
+ * @param send_bytes The bytes to send, or NULL to send zeros
+ * @param receive_bytes Where to store the received bytes
+ * @param length The number of bytes
+ *
+ * @return SPI_OVERRUN if a received byte never arrived or was overwritten,
+ *      leaving receive_bytes incomplete
+ */
+spi_error_t spi_block_transfer(const spi_block_port_t * port, void * block,
+    const uint8_t * send_bytes, uint8_t * receive_bytes, size_t length);
+
+/**
+ * Send a block of bytes, ignoring what comes back. Returns once the last
+ * byte is out, with the received byte and overrun flag cleared.
+ *
+ * @param port The block's registers
+ * @param block Passed through to the port
+ * @param send_bytes The bytes to send
+ * @param length The number of bytes
+ */
+void spi_block_send(const spi_block_port_t * port, void * block,
+    const uint8_t * send_bytes, size_t length);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _BOARD_COMMON_SPI_BLOCK_H_
@@ -14,6 +14,17 @@ uart_error_t uart_write_bytes(uart_t * channel, const uint8_t * bytes, size_t n)
     return UART_NO_ERROR;
 }
 
+uart_error_t uart_write_iov(uart_t * channel, const uart_iovec_t * iov, size_t count) {
+    uart_error_t err;
+    for (size_t i = 0; i < count; ++i) {
+        err = uart_write_bytes(channel, iov[i].bytes, iov[i].length);
+        if (err != UART_NO_ERROR) {
+            return err;
+        }
+    }
+    return UART_NO_ERROR;
+}
+
 uart_error_t uart_write_string(uart_t * channel, const char * str) {
     uart_error_t err;
     while (*str) {
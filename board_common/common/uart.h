@@ -16,7 +16,10 @@ extern "C" {
 #define UART_ERROR_LIST(OP) \
     OP(NO_ERROR) \
     OP(CHANNEL_CLOSED) \
-    OP(SIGNAL_FAULT)
+    OP(SIGNAL_FAULT) \
+    OP(BUSY) \
+    OP(UNSUPPORTED) \
+    OP(TIMEOUT)
 
 /// Enum representing possible error states for a UART channel.
 typedef enum uart_error {
@@ -34,11 +37,33 @@ const char * uart_error_string(uart_error_t t);
 /******************************************************************************\
  *  Supported UART baud rates                                                 *
 \******************************************************************************/
+/// Macro list of the supported baud rates. ARG is passed through to every
+/// OP so the list can be expanded inside other lists.
+#define UART_BAUD_RATE_LIST(OP, ARG) \
+    OP(9600, ARG) \
+    OP(19200, ARG) \
+    OP(38400, ARG) \
+    OP(76800, ARG) \
+    OP(115200, ARG)
+
 typedef enum uart_baud_rate {
-    BAUD_9600,
-    BAUD_115200
+#   define ENUM_OP(B, _) BAUD_ ## B,
+    UART_BAUD_RATE_LIST(ENUM_OP, _)
+#   undef ENUM_OP
+    BAUD_count
 } uart_baud_rate_t;
 
+/******************************************************************************\
+ *  Scatter/gather buffers                                                    *
+\******************************************************************************/
+/// One piece of a buffer that is written out in several pieces
+typedef struct uart_iovec {
+    /// The bytes of this piece. May be NULL if length is zero.
+    const uint8_t * bytes;
+    /// The number of bytes in this piece
+    size_t length;
+} uart_iovec_t;
+
 /******************************************************************************\
  *  UART type                                                                 *
 \******************************************************************************/
@@ -55,6 +80,17 @@ typedef enum uart_baud_rate {
  */
 typedef struct uart uart_t;
 
+/** Completion callback for asynchronous writes.
+ *
+ * On target this is called from the DMA interrupt, so it must be short and
+ * may only use ISR-safe APIs (e.g. vTaskNotifyGiveFromISR).
+ *
+ * @param channel The channel passed to uart_write_bytes_async
+ * @param result The result of the transfer
+ * @param context The context pointer passed to uart_write_bytes_async
+ */
+typedef void (*uart_write_complete_t)(uart_t * channel, uart_error_t result, void * context);
+
 /**
  * Close a connection to a UART channel
  */
@@ -90,6 +126,122 @@ uart_error_t uart_write_byte(uart_t * channel, uint8_t byte);
  */
 uart_error_t uart_read_byte(uart_t * channel, uint8_t * output);
 
+/** Read whatever has already been received, without waiting for more
+ *
+ * Possible return values:
+ *  \li \verbatim UART_NO_ERROR \endverbatim when no error occurs, even if
+ *   nothing was read.
+ *  \li \verbatim UART_CHANEL_CLOSED \endverbatim if the channel is not open
+ *  \li \verbatim UART_SIGNAL_FAULT \endverbatim if the UART implementation
+ *   has detected a signal integrity error.
+ *
+ * @param channel The channel to read from
+ * @param bytes Pointer to a buffer in to which we should read
+ * @param n The most bytes to read
+ * @param read The output number of bytes read
+ *
+ * @return UART error enumeration representing the error, see docs.
+ */
+uart_error_t uart_read_available(uart_t * channel, uint8_t * bytes, size_t n, size_t * read);
+
+/** Read several bytes from a UART channel, giving up once the line has been
+ * quiet for a while
+ *
+ * Possible return values:
+ *  \li \verbatim UART_NO_ERROR \endverbatim when all n bytes were read.
+ *  \li \verbatim UART_CHANEL_CLOSED \endverbatim if the channel is not open
+ *  \li \verbatim UART_SIGNAL_FAULT \endverbatim if the UART implementation
+ *   has detected a signal integrity error.
+ *  \li \verbatim UART_TIMEOUT \endverbatim if no byte arrived for timeout_ms
+ *   before all n had been read.
+ *
+ * On target the time is counted by busy waiting on MCLK, so it is only
+ * approximate, and never shorter than asked for.
+ *
+ * @param channel The channel to read from
+ * @param bytes Pointer to a buffer in to which we should read
+ * @param n The number of bytes to read
+ * @param timeout_ms How long to wait for each byte, in milliseconds
+ * @param read The output number of bytes read, even if the read gave up
+ *
+ * @return UART error enumeration representing the error, see docs.
+ */
+uart_error_t uart_read_bytes_timeout(uart_t * channel, uint8_t * bytes, size_t n, uint16_t timeout_ms, size_t * read);
+
+/** Check if a channel can run at a baud rate with the clocks as they are
+ * configured now
+ *
+ * @param channel The channel to check
+ * @param baud_rate The baud rate to check
+ *
+ * @return True if and only if uart_set_baud_rate would accept the rate
+ */
+bool uart_baud_rate_supported(uart_t * channel, uart_baud_rate_t baud_rate);
+
+/** Change the baud rate of an open channel.
+ *
+ * Waits for everything already written to go out at the old rate and for
+ * the line to go idle, then switches. Bytes already received stay buffered.
+ *
+ * Possible return values:
+ *  \li \verbatim UART_NO_ERROR \endverbatim if the rate was changed.
+ *  \li \verbatim UART_CHANEL_CLOSED \endverbatim if the channel is not open
+ *  \li \verbatim UART_UNSUPPORTED \endverbatim if no clock can generate the
+ *   rate. The channel keeps its old rate.
+ *
+ * @param channel The channel to change
+ * @param baud_rate The new baud rate
+ *
+ * @return UART error enumeration representing the error, see docs.
+ */
+uart_error_t uart_set_baud_rate(uart_t * channel, uart_baud_rate_t baud_rate);
+
+/** Start writing a buffer to the UART channel without waiting for it.
+ *
+ * The buffer is handed to the DMA controller and must stay valid and
+ * unmodified until the completion callback runs. Synchronous writes issued
+ * while the transfer is in flight wait for it to finish first, so bytes are
+ * never interleaved.
+ *
+ * Possible return values:
+ *  \li \verbatim UART_NO_ERROR \endverbatim if the transfer was started.
+ *  \li \verbatim UART_CHANEL_CLOSED \endverbatim if the channel is not open
+ *  \li \verbatim UART_BUSY \endverbatim if an asynchronous write is already in
+ *   flight on this channel.
+ *
+ * @param channel The channel to write to
+ * @param bytes The buffer to write, at most 65535 bytes long
+ * @param n The number of bytes to write
+ * @param on_complete Called once the last byte has been handed to the UART.
+ *  May be NULL.
+ * @param context Passed through to on_complete
+ *
+ * @return UART error enumeration representing the error, see docs.
+ */
+uart_error_t uart_write_bytes_async(uart_t * channel, const uint8_t * bytes, size_t n,
+    uart_write_complete_t on_complete, void * context);
+
+/** Check if an asynchronous write is still in flight
+ *
+ * @param channel The channel to check
+ *
+ * @return True if and only if an asynchronous write has not completed
+ */
+bool uart_write_async_busy(uart_t * channel);
+
+/** Wait for an in-flight asynchronous write to finish.
+ *
+ * On target the caller blocks in the callbacks set by uart_set_async_waiter,
+ * so a task can wait on a notification while other tasks run. Without them
+ * the CPU sleeps in LPM0 until the write completes. Called with interrupts
+ * masked, it finishes the write by polling instead, and never unmasks them.
+ *
+ * @param channel The channel to wait on
+ *
+ * @return UART error enumeration representing the error, see docs.
+ */
+uart_error_t uart_wait_async(uart_t * channel);
+
 /** @} */
 
 /** @defgroup uart_common Common components
@@ -114,6 +266,20 @@ uart_error_t uart_read_byte(uart_t * channel, uint8_t * output);
  */
 uart_error_t uart_write_bytes(uart_t * channel, const uint8_t * bytes, size_t n);
 
+/** Write several buffers to the UART channel, one after another, as if they
+ * were one contiguous buffer
+ *
+ * Possible return values are the same as uart_write_bytes. Writing stops at
+ * the first error.
+ *
+ * @param channel The channel to write to
+ * @param iov The buffers to write out, in order
+ * @param count The number of buffers in iov
+ *
+ * @return UART error enumeration representing the error, see docs.
+ */
+uart_error_t uart_write_iov(uart_t * channel, const uart_iovec_t * iov, size_t count);
+
 /** Write a cstring to the UART channel
  *
  * @param channel The channel to write to
@@ -145,8 +311,10 @@ uart_error_t uart_read_bytes(uart_t * channel, uint8_t * bytes, size_t n);
 }
 #endif
 
-#ifdef USIP_NATIVE
+#if defined(USIP_NATIVE)
 #   include "uart_native.h"
+#elif defined(USIP_HOST)
+#   include "uart_host.h"
 #else
 #   include "uart_test.hpp"
 #endif
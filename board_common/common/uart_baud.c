@@ -0,0 +1,175 @@
+#include "uart_baud.h"
+
+#include <stddef.h>
+
+/******************************************************************************\
+ *  Divisor arithmetic                                                        *
+\******************************************************************************/
+// Everything here is an integer constant expression, so the tables below are
+// worked out by the compiler and live in flash. N = clock / baud throughout.
+
+/// A clock needs at least three cycles per bit to generate a baud rate
+#define UART_BAUD_VALID(CLOCK, BAUD) ((CLOCK) >= 3UL * (BAUD))
+
+/// frac(N) in units of 1/10000
+#define UART_BAUD_FRACTION(CLOCK, BAUD) \
+    ((uint32_t)(((CLOCK) % (BAUD)) * 10000UL / (BAUD)))
+
+/**
+ * eUSCI second modulation stage. Table 18-4 of the FR5xx/FR6xx family user's
+ * guide (SLAU367): use the entry with the largest fraction not above frac(N).
+ */
+#define UART_EUSCI_UCBRS(F) \
+    ((F) >= 9288 ? 0xFE : (F) >= 9170 ? 0xFD : (F) >= 9004 ? 0xFB : \
+     (F) >= 8751 ? 0xF7 : (F) >= 8572 ? 0xEF : (F) >= 8464 ? 0xDF : \
+     (F) >= 8333 ? 0xBF : (F) >= 8004 ? 0xEE : (F) >= 7861 ? 0xED : \
+     (F) >= 7503 ? 0xDD : (F) >= 7147 ? 0xBB : (F) >= 7001 ? 0xB7 : \
+     (F) >= 6667 ? 0xD6 : (F) >= 6432 ? 0xB6 : (F) >= 6254 ? 0xB5 : \
+     (F) >= 6003 ? 0xAD : (F) >= 5715 ? 0x6B : (F) >= 5002 ? 0xAA : \
+     (F) >= 4378 ? 0x55 : (F) >= 4286 ? 0x53 : (F) >= 4003 ? 0x92 : \
+     (F) >= 3753 ? 0x52 : (F) >= 3575 ? 0x4A : (F) >= 3335 ? 0x49 : \
+     (F) >= 3000 ? 0x25 : (F) >= 2503 ? 0x44 : (F) >= 2224 ? 0x22 : \
+     (F) >= 2147 ? 0x21 : (F) >= 1670 ? 0x11 : (F) >= 1430 ? 0x20 : \
+     (F) >= 1252 ? 0x10 : (F) >= 1001 ? 0x08 : (F) >= 835 ? 0x04 : \
+     (F) >= 715 ? 0x02 : (F) >= 529 ? 0x01 : 0x00)
+
+/// The eUSCI uses oversampling once N > 16
+#define UART_EUSCI_OS16(CLOCK, BAUD) ((CLOCK) > 16UL * (BAUD))
+
+/**
+ * eUSCI settings, following the "Baud-Rate Settings Quick Set Up" algorithm:
+ * UCBRx = INT(N / 16) and UCBRFx = INT(frac(N / 16) * 16) when oversampling,
+ * UCBRx = INT(N) otherwise, and UCBRSx from frac(N).
+ */
+#define UART_EUSCI_DIVISOR(CLOCK, BAUD) { \
+    .prescaler = !UART_BAUD_VALID(CLOCK, BAUD) ? 0 : \
+        UART_EUSCI_OS16(CLOCK, BAUD) ? (CLOCK) / (16UL * (BAUD)) : (CLOCK) / (BAUD), \
+    .first_modulation = !UART_BAUD_VALID(CLOCK, BAUD) ? 0 : \
+        UART_EUSCI_OS16(CLOCK, BAUD) ? ((CLOCK) / (BAUD)) % 16 : 0, \
+    .second_modulation = !UART_BAUD_VALID(CLOCK, BAUD) ? 0 : \
+        UART_EUSCI_UCBRS(UART_BAUD_FRACTION(CLOCK, BAUD)), \
+    .oversampling = UART_BAUD_VALID(CLOCK, BAUD) && UART_EUSCI_OS16(CLOCK, BAUD), \
+}
+
+/// round(N)
+#define UART_USCI_ROUND_N(CLOCK, BAUD) (((CLOCK) + (BAUD) / 2) / (BAUD))
+
+/// |N - round(N)| * BAUD, the clock cycles lost per bit when oversampling
+#define UART_USCI_RESIDUAL(CLOCK, BAUD) \
+    ((CLOCK) > UART_USCI_ROUND_N(CLOCK, BAUD) * (BAUD) ? \
+        (CLOCK) - UART_USCI_ROUND_N(CLOCK, BAUD) * (BAUD) : \
+        UART_USCI_ROUND_N(CLOCK, BAUD) * (BAUD) - (CLOCK))
+
+/**
+ * The USCI can oversample once N >= 16, but its oversampled bits are always
+ * round(N) clocks long, with no per-bit modulation to make up the fraction.
+ * Only oversample when that drifts by less than 1% of a bit per bit;
+ * otherwise low frequency mode spreads the fraction across the frame and is
+ * more accurate.
+ */
+#define UART_USCI_OS16(CLOCK, BAUD) \
+    ((CLOCK) >= 16UL * (BAUD) && 1000UL * UART_USCI_RESIDUAL(CLOCK, BAUD) <= (CLOCK))
+
+/// round(frac(N / 16) * 16), which may round up to 16
+#define UART_USCI_UCBRF(CLOCK, BAUD) \
+    ((((CLOCK) % (16UL * (BAUD))) + (BAUD) / 2) / (BAUD))
+
+/// round(frac(N) * 8), which may round up to 8
+#define UART_USCI_UCBRS(CLOCK, BAUD) \
+    ((((CLOCK) % (BAUD)) * 8UL + (BAUD) / 2) / (BAUD))
+
+/**
+ * USCI settings, following the F5xx/F6xx family user's guide (SLAU208):
+ * UCBRx = INT(N / 16) and UCBRFx = round(frac(N / 16) * 16) when
+ * oversampling, UCBRx = INT(N) and UCBRSx = round(frac(N) * 8) otherwise. A
+ * modulation that rounds up to a whole clock is carried in to UCBRx.
+ */
+#define UART_USCI_DIVISOR(CLOCK, BAUD) { \
+    .prescaler = !UART_BAUD_VALID(CLOCK, BAUD) ? 0 : \
+        UART_USCI_OS16(CLOCK, BAUD) ? \
+            (CLOCK) / (16UL * (BAUD)) + (UART_USCI_UCBRF(CLOCK, BAUD) == 16) : \
+            (CLOCK) / (BAUD) + (UART_USCI_UCBRS(CLOCK, BAUD) == 8), \
+    .first_modulation = !UART_BAUD_VALID(CLOCK, BAUD) ? 0 : \
+        UART_USCI_OS16(CLOCK, BAUD) ? UART_USCI_UCBRF(CLOCK, BAUD) % 16 : 0, \
+    .second_modulation = !UART_BAUD_VALID(CLOCK, BAUD) ? 0 : \
+        UART_USCI_OS16(CLOCK, BAUD) ? 0 : UART_USCI_UCBRS(CLOCK, BAUD) % 8, \
+    .oversampling = UART_BAUD_VALID(CLOCK, BAUD) && UART_USCI_OS16(CLOCK, BAUD), \
+}
+
+/******************************************************************************\
+ *  Tables                                                                    *
+\******************************************************************************/
+enum {
+#   define ENUM_OP(C, _) UART_CLOCK_ ## C,
+    UART_CLOCK_LIST(ENUM_OP, _)
+#   undef ENUM_OP
+    UART_CLOCK_count
+};
+
+static const uint32_t CLOCK_RATES[UART_CLOCK_count] = {
+#   define RATE_OP(C, _) C,
+    UART_CLOCK_LIST(RATE_OP, _)
+#   undef RATE_OP
+};
+
+static const uint32_t BAUD_RATES[BAUD_count] = {
+#   define RATE_OP(B, _) B,
+    UART_BAUD_RATE_LIST(RATE_OP, _)
+#   undef RATE_OP
+};
+
+#define EUSCI_CELL(B, C) UART_EUSCI_DIVISOR(C ## UL, B ## UL),
+#define EUSCI_ROW(C, _) { UART_BAUD_RATE_LIST(EUSCI_CELL, C) },
+static const uart_baud_divisor_t EUSCI_DIVISORS[UART_CLOCK_count][BAUD_count] = {
+    UART_CLOCK_LIST(EUSCI_ROW, _)
+};
+#undef EUSCI_ROW
+#undef EUSCI_CELL
+
+#define USCI_CELL(B, C) UART_USCI_DIVISOR(C ## UL, B ## UL),
+#define USCI_ROW(C, _) { UART_BAUD_RATE_LIST(USCI_CELL, C) },
+static const uart_baud_divisor_t USCI_DIVISORS[UART_CLOCK_count][BAUD_count] = {
+    UART_CLOCK_LIST(USCI_ROW, _)
+};
+#undef USCI_ROW
+#undef USCI_CELL
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+// Find the row for a clock, or UART_CLOCK_count if there isn't one
+static size_t uart_clock_index(uint32_t clock_rate) {
+    size_t i;
+    for (i = 0; i < UART_CLOCK_count; ++i) {
+        if (CLOCK_RATES[i] == clock_rate) {
+            break;
+        }
+    }
+    return i;
+}
+
+static const uart_baud_divisor_t * uart_baud_lookup(
+        const uart_baud_divisor_t table[UART_CLOCK_count][BAUD_count],
+        uint32_t clock_rate, uart_baud_rate_t baud_rate) {
+    size_t clock = uart_clock_index(clock_rate);
+    if (clock >= UART_CLOCK_count || baud_rate >= BAUD_count) {
+        return NULL;
+    }
+
+    const uart_baud_divisor_t * divisor = &table[clock][baud_rate];
+    return divisor->prescaler ? divisor : NULL;
+}
+
+uint32_t uart_baud_rate_bps(uart_baud_rate_t baud_rate) {
+    return baud_rate < BAUD_count ? BAUD_RATES[baud_rate] : 0;
+}
+
+const uart_baud_divisor_t * uart_eusci_baud_divisor(uint32_t clock_rate,
+        uart_baud_rate_t baud_rate) {
+    return uart_baud_lookup(EUSCI_DIVISORS, clock_rate, baud_rate);
+}
+
+const uart_baud_divisor_t * uart_usci_baud_divisor(uint32_t clock_rate,
+        uart_baud_rate_t baud_rate) {
+    return uart_baud_lookup(USCI_DIVISORS, clock_rate, baud_rate);
+}
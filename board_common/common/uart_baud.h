@@ -0,0 +1,87 @@
+#ifndef _BOARD_COMMON_UART_BAUD_H_
+#define _BOARD_COMMON_UART_BAUD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "uart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************\
+ *  Clocks the baud rate tables are built for                                 *
+\******************************************************************************/
+/// Macro list of the clock frequencies, in Hz, with precomputed divisors:
+/// the 32.768 kHz crystal on ACLK, the 1 MHz and 1.048576 MHz power up
+/// defaults of the FR and F5xx parts, and the 8 and 16 MHz DCO settings
+#define UART_CLOCK_LIST(OP, ARG) \
+    OP(32768, ARG) \
+    OP(1000000, ARG) \
+    OP(1048576, ARG) \
+    OP(8000000, ARG) \
+    OP(16000000, ARG)
+
+/******************************************************************************\
+ *  Divisor settings                                                          *
+\******************************************************************************/
+/**
+ * The baud rate generator settings for one clock and baud rate. The fields
+ * map directly on to the driverlib UART init parameters.
+ */
+typedef struct uart_baud_divisor {
+    /**
+     * UCBRx, the clock prescaler. Zero if the clock is too slow for the baud
+     * rate.
+     */
+    uint16_t prescaler;
+    /**
+     * UCBRFx, the first modulation stage. Only used when oversampling.
+     */
+    uint8_t first_modulation;
+    /**
+     * UCBRSx, the second modulation stage
+     */
+    uint8_t second_modulation;
+    /**
+     * UCOS16, whether to use oversampling mode
+     */
+    bool oversampling;
+} uart_baud_divisor_t;
+
+/** Get a baud rate in bits per second
+ *
+ * @param baud_rate The baud rate to convert
+ *
+ * @return The number of bits per second
+ */
+uint32_t uart_baud_rate_bps(uart_baud_rate_t baud_rate);
+
+/** Look up eUSCI_A baud rate settings
+ *
+ * @param clock_rate The frequency of the block's clock source in Hz
+ * @param baud_rate The baud rate to generate
+ *
+ * @return The settings, or NULL if the clock isn't in UART_CLOCK_LIST or is
+ *         too slow to generate the baud rate
+ */
+const uart_baud_divisor_t * uart_eusci_baud_divisor(uint32_t clock_rate,
+    uart_baud_rate_t baud_rate);
+
+/** Look up USCI_A baud rate settings
+ *
+ * @param clock_rate The frequency of the block's clock source in Hz
+ * @param baud_rate The baud rate to generate
+ *
+ * @return The settings, or NULL if the clock isn't in UART_CLOCK_LIST or is
+ *         too slow to generate the baud rate
+ */
+const uart_baud_divisor_t * uart_usci_baud_divisor(uint32_t clock_rate,
+    uart_baud_rate_t baud_rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _BOARD_COMMON_UART_BAUD_H_
@@ -0,0 +1,288 @@
+// cfmakeraw is a BSD extension
+#define _DEFAULT_SOURCE
+
+#include "uart_fd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+/**
+ * Find the termios speed for a rate
+ *
+ * @param bps The rate in bits per second
+ *
+ * @return The speed, or B0 if termios has none
+ */
+static speed_t uart_fd_speed(size_t bps);
+
+/**
+ * Wait for a descriptor to be writable
+ *
+ * @param fd The descriptor
+ * @param timeout_ms How long to wait
+ *
+ * @return True if and only if there is room to write
+ */
+static bool uart_fd_wait_writable(int fd, int timeout_ms);
+
+/**
+ * Check if a descriptor is on the same terminal as one of the process's
+ * standard streams
+ *
+ * @param fd The descriptor
+ *
+ * @return True if and only if raw mode would take over the user's terminal
+ */
+static bool uart_fd_is_own_terminal(int fd);
+
+/**
+ * Put back the flags and terminal settings a device changed
+ *
+ * @param device The device to restore
+ */
+static void uart_fd_restore(uart_fd_t * device);
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+bool uart_fd_open(uart_fd_t * device, int fd) {
+    device->fd = fd;
+    device->epoll = -1;
+    device->flags = -1;
+    device->terminal = false;
+    device->batched = 0;
+    if (fd < 0) {
+        return false;
+    }
+
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        return false;
+    }
+    device->flags = flags;
+
+    if (isatty(fd) && !uart_fd_is_own_terminal(fd) && tcgetattr(fd, &device->saved) == 0) {
+        struct termios tio = device->saved;
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        if (tcsetattr(fd, TCSANOW, &tio) == 0) {
+            device->terminal = true;
+        }
+    }
+
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll < 0) {
+        uart_fd_restore(device);
+        return false;
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    // Regular files and /dev/null can't be polled, but never make a read wait
+    // either, so they only need the descriptor
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0 && errno != EPERM) {
+        close(epoll);
+        uart_fd_restore(device);
+        return false;
+    }
+    device->epoll = epoll;
+    return true;
+}
+
+void uart_fd_close(uart_fd_t * device) {
+    if (device->epoll >= 0) {
+        uart_fd_flush(device);
+        close(device->epoll);
+        device->epoll = -1;
+    }
+    if (device->fd >= 0) {
+        uart_fd_restore(device);
+        close(device->fd);
+        device->fd = -1;
+    }
+}
+
+bool uart_fd_write(uart_fd_t * device, const uint8_t * bytes, size_t n) {
+    while (n > 0) {
+        if (device->batched == UART_FD_BATCH_LENGTH && !uart_fd_flush(device)) {
+            return false;
+        }
+        size_t room = UART_FD_BATCH_LENGTH - device->batched;
+        size_t count = n < room ? n : room;
+        memcpy(device->batch + device->batched, bytes, count);
+        device->batched += count;
+        bytes += count;
+        n -= count;
+    }
+    return true;
+}
+
+bool uart_fd_flush(uart_fd_t * device) {
+    size_t written = 0;
+    while (written < device->batched) {
+        ssize_t count = write(device->fd, device->batch + written, device->batched - written);
+        if (count > 0) {
+            written += count;
+            continue;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        // If the far end is behind, wait for room like a UART would
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+                uart_fd_wait_writable(device->fd, 1000)) {
+            continue;
+        }
+        memmove(device->batch, device->batch + written, device->batched - written);
+        device->batched -= written;
+        return false;
+    }
+    device->batched = 0;
+    return true;
+}
+
+bool uart_fd_drain(uart_fd_t * device) {
+    if (!uart_fd_flush(device)) {
+        return false;
+    }
+    return !device->terminal || tcdrain(device->fd) == 0;
+}
+
+long uart_fd_read(uart_fd_t * device, uint8_t * bytes, size_t n, int timeout_ms) {
+    // Whatever was asked for has to reach the far end before it can answer
+    if (!uart_fd_flush(device)) {
+        return -1;
+    }
+
+    for (;;) {
+        ssize_t count = read(device->fd, bytes, n);
+        if (count > 0) {
+            return count;
+        }
+        if (count == 0 && n > 0) {
+            // The other end hung up
+            return -1;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            return -1;
+        }
+        if (timeout_ms == 0 || n == 0) {
+            return 0;
+        }
+
+        struct epoll_event event;
+        int ready = epoll_wait(device->epoll, &event, 1, timeout_ms);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            return ready == 0 ? 0 : -1;
+        }
+        // Only wait once, so the timeout bounds the whole call
+        timeout_ms = 0;
+    }
+}
+
+bool uart_fd_read_exactly(uart_fd_t * device, uint8_t * bytes, size_t n, int timeout_ms) {
+    size_t done = 0;
+    while (done < n) {
+        long count = uart_fd_read(device, bytes + done, n - done, timeout_ms);
+        if (count <= 0) {
+            return false;
+        }
+        done += count;
+    }
+    return true;
+}
+
+bool uart_fd_supports(const uart_fd_t * device, size_t bps) {
+    return !device->terminal || uart_fd_speed(bps) != B0;
+}
+
+bool uart_fd_set_baud(uart_fd_t * device, size_t bps) {
+    if (!uart_fd_supports(device, bps)) {
+        return false;
+    }
+    if (!device->terminal) {
+        return uart_fd_flush(device);
+    }
+
+    struct termios tio;
+    if (!uart_fd_drain(device) || tcgetattr(device->fd, &tio) != 0) {
+        return false;
+    }
+    cfsetispeed(&tio, uart_fd_speed(bps));
+    cfsetospeed(&tio, uart_fd_speed(bps));
+    return tcsetattr(device->fd, TCSANOW, &tio) == 0;
+}
+
+/******************************************************************************\
+ *  Private support function implementations                                  *
+\******************************************************************************/
+static speed_t uart_fd_speed(size_t bps) {
+    switch (bps) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+#ifdef B76800
+        case 76800: return B76800;
+#endif
+        case 115200: return B115200;
+        default: return B0;
+    }
+}
+
+static bool uart_fd_wait_writable(int fd, int timeout_ms) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLOUT;
+    event.data.fd = fd;
+    int waiter = epoll_create1(EPOLL_CLOEXEC);
+    bool ready = waiter >= 0
+        && epoll_ctl(waiter, EPOLL_CTL_ADD, fd, &event) == 0
+        && epoll_wait(waiter, &event, 1, timeout_ms) == 1;
+    if (waiter >= 0) {
+        close(waiter);
+    }
+    return ready;
+}
+
+static bool uart_fd_is_own_terminal(int fd) {
+    struct stat device;
+    if (fstat(fd, &device) != 0) {
+        return false;
+    }
+    for (int stream = STDIN_FILENO; stream <= STDERR_FILENO; ++stream) {
+        struct stat standard;
+        if (isatty(stream) && fstat(stream, &standard) == 0 && standard.st_rdev == device.st_rdev) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void uart_fd_restore(uart_fd_t * device) {
+    if (device->terminal) {
+        // Let what was written go out under the raw settings first
+        tcsetattr(device->fd, TCSADRAIN, &device->saved);
+        device->terminal = false;
+    }
+    // The flags belong to the open file, which a dup of a standard stream
+    // shares with the rest of the process
+    if (device->flags >= 0) {
+        fcntl(device->fd, F_SETFL, device->flags);
+        device->flags = -1;
+    }
+}
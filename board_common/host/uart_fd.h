@@ -0,0 +1,171 @@
+#ifndef _BOARD_COMMON_HOST_UART_FD_H_
+#define _BOARD_COMMON_HOST_UART_FD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <termios.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup uart_fd Descriptor UART device
+ *  A UART backed by a file descriptor: a serial device, a pty or one end of
+ *  a socketpair, so host builds can talk to real or emulated devices. Both
+ *  the host UART backend and the test build's mock channels use it.
+ *
+ *  The descriptor is made non-blocking. Reads wait for data through epoll,
+ *  up to a timeout, and writes are gathered in to batches so a frame written
+ *  a byte at a time still goes out in one system call. A batch is flushed
+ *  when it fills, before every read and whenever the channel waits for the
+ *  line.
+ *
+ *  Terminals are put in raw mode and follow uart_fd_set_baud through
+ *  termios, and get their settings back when the device is closed. Anything
+ *  else, like a socket, has no baud rate and accepts every rate. So does the
+ *  terminal the process's own standard streams are on, which is left as the
+ *  user's shell set it up.
+ *  @{
+ */
+
+/// The most bytes gathered before a batch is flushed
+#define UART_FD_BATCH_LENGTH 512
+
+/**
+ * The state of a descriptor UART
+ */
+typedef struct uart_fd {
+    /**
+     * The descriptor bytes go through, or -1 if there is none
+     */
+    int fd;
+    /**
+     * Waits for the descriptor to be readable, or -1 if setting up failed
+     */
+    int epoll;
+    /**
+     * The descriptor's file status flags before it was taken over, put back
+     * when it is closed
+     */
+    int flags;
+    /**
+     * True if the descriptor is a terminal that follows the baud rate
+     */
+    bool terminal;
+    /**
+     * The terminal's settings before it was put in raw mode, put back when it
+     * is closed. Only meaningful if terminal is set.
+     */
+    struct termios saved;
+    /**
+     * Bytes written but not yet flushed
+     */
+    uint8_t batch[UART_FD_BATCH_LENGTH];
+    /**
+     * The number of bytes in batch
+     */
+    size_t batched;
+} uart_fd_t;
+
+/**
+ * Take over a descriptor. It is closed by uart_fd_close, even if this fails,
+ * but its flags and terminal settings are put back before a failure returns.
+ *
+ * @param device The output device
+ * @param fd The descriptor to use
+ *
+ * @return True if and only if the descriptor was set up
+ */
+bool uart_fd_open(uart_fd_t * device, int fd);
+
+/**
+ * Flush anything batched and close the descriptor
+ *
+ * @param device The device to close
+ */
+void uart_fd_close(uart_fd_t * device);
+
+/**
+ * Queue bytes to write
+ *
+ * @param device The device to write to
+ * @param bytes The bytes to write
+ * @param n The number of bytes to write
+ *
+ * @return False if a flush failed
+ */
+bool uart_fd_write(uart_fd_t * device, const uint8_t * bytes, size_t n);
+
+/**
+ * Write out everything queued
+ *
+ * @param device The device to flush
+ *
+ * @return False if the descriptor failed
+ */
+bool uart_fd_flush(uart_fd_t * device);
+
+/**
+ * Wait for everything written to leave the device
+ *
+ * @param device The device to drain
+ *
+ * @return False if the descriptor failed
+ */
+bool uart_fd_drain(uart_fd_t * device);
+
+/**
+ * Read up to n bytes, waiting at most timeout_ms for the first
+ *
+ * @param device The device to read from
+ * @param bytes The output bytes
+ * @param n The most bytes to read
+ * @param timeout_ms How long to wait, or 0 to only take what has arrived
+ *
+ * @return The number of bytes read, or -1 if the descriptor failed or was
+ *      closed at the other end
+ */
+long uart_fd_read(uart_fd_t * device, uint8_t * bytes, size_t n, int timeout_ms);
+
+/**
+ * Read exactly n bytes, waiting at most timeout_ms each time the line goes
+ * quiet
+ *
+ * @param device The device to read from
+ * @param bytes The output bytes
+ * @param n The number of bytes to read
+ * @param timeout_ms How long to wait each time
+ *
+ * @return True if and only if they all arrived
+ */
+bool uart_fd_read_exactly(uart_fd_t * device, uint8_t * bytes, size_t n, int timeout_ms);
+
+/**
+ * Check if the device can run at a rate
+ *
+ * @param device The device to check
+ * @param bps The rate in bits per second
+ *
+ * @return True if and only if uart_fd_set_baud would accept the rate
+ */
+bool uart_fd_supports(const uart_fd_t * device, size_t bps);
+
+/**
+ * Switch the device to a rate, once everything written has left at the old
+ * one
+ *
+ * @param device The device to switch
+ * @param bps The rate in bits per second
+ *
+ * @return True if and only if the device switched
+ */
+bool uart_fd_set_baud(uart_fd_t * device, size_t bps);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _BOARD_COMMON_HOST_UART_FD_H_
@@ -0,0 +1,128 @@
+#include "uart.h"
+#include "uart_baud.h"
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+bool uart_open_fd(uart_t * out, int fd, size_t baud_rate) {
+    out->open = false;
+    out->read_timeout_ms = UART_HOST_READ_TIMEOUT_MS;
+    if (!uart_fd_open(&out->device, fd) || !uart_fd_set_baud(&out->device, baud_rate)) {
+        uart_fd_close(&out->device);
+        return false;
+    }
+    out->open = true;
+    return true;
+}
+
+void uart_close(uart_t * out) {
+    if (out->open) {
+        uart_fd_close(&out->device);
+        out->open = false;
+    }
+}
+
+uart_error_t uart_write_byte(uart_t * channel, uint8_t byte) {
+    if (!channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    if (!uart_fd_write(&channel->device, &byte, 1) ||
+            (byte == '\n' && !uart_fd_flush(&channel->device))) {
+        return UART_SIGNAL_FAULT;
+    }
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_read_byte(uart_t * channel, uint8_t * output) {
+    return uart_read_bytes(channel, output, 1);
+}
+
+uart_error_t uart_read_bytes(uart_t * channel, uint8_t * bytes, size_t n) {
+    if (!channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    if (!uart_fd_read_exactly(&channel->device, bytes, n, channel->read_timeout_ms)) {
+        return UART_SIGNAL_FAULT;
+    }
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_read_bytes_timeout(uart_t * channel, uint8_t * bytes, size_t n, uint16_t timeout_ms, size_t * read) {
+    *read = 0;
+    if (!channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    while (*read < n) {
+        long count = uart_fd_read(&channel->device, bytes + *read, n - *read, timeout_ms);
+        if (count < 0) {
+            return UART_SIGNAL_FAULT;
+        }
+        if (count == 0) {
+            return UART_TIMEOUT;
+        }
+        *read += count;
+    }
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_read_available(uart_t * channel, uint8_t * bytes, size_t n, size_t * read) {
+    *read = 0;
+    if (!channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    long count = uart_fd_read(&channel->device, bytes, n, 0);
+    if (count < 0) {
+        return UART_SIGNAL_FAULT;
+    }
+    *read = count;
+    return UART_NO_ERROR;
+}
+
+bool uart_baud_rate_supported(uart_t * channel, uart_baud_rate_t baud_rate) {
+    if (baud_rate >= BAUD_count) {
+        return false;
+    }
+    return !channel->open || uart_fd_supports(&channel->device, uart_baud_rate_bps(baud_rate));
+}
+
+uart_error_t uart_set_baud_rate(uart_t * channel, uart_baud_rate_t baud_rate) {
+    if (!channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    if (!uart_baud_rate_supported(channel, baud_rate)) {
+        return UART_UNSUPPORTED;
+    }
+    if (!uart_fd_set_baud(&channel->device, uart_baud_rate_bps(baud_rate))) {
+        return UART_SIGNAL_FAULT;
+    }
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_write_bytes_async(uart_t * channel, const uint8_t * bytes, size_t n,
+        uart_write_complete_t on_complete, void * context) {
+    if (!channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    // There's no DMA to hand the buffer to, so the write is over by the time
+    // this returns
+    uart_error_t err = UART_NO_ERROR;
+    if (!uart_fd_write(&channel->device, bytes, n) || !uart_fd_flush(&channel->device)) {
+        err = UART_SIGNAL_FAULT;
+    }
+    if (on_complete) {
+        on_complete(channel, err, context);
+    }
+    return UART_NO_ERROR;
+}
+
+bool uart_write_async_busy(uart_t * channel) {
+    (void) channel;
+    return false;
+}
+
+uart_error_t uart_wait_async(uart_t * channel) {
+    if (!channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    return uart_fd_drain(&channel->device) ? UART_NO_ERROR : UART_SIGNAL_FAULT;
+}
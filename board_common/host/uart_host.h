@@ -0,0 +1,61 @@
+#ifndef _BOARD_COMMON_HOST_UART_H_
+#define _BOARD_COMMON_HOST_UART_H_
+
+#include "uart_fd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * How long a blocking read waits for the line before giving up, in
+ * milliseconds
+ */
+#ifndef UART_HOST_READ_TIMEOUT_MS
+#   define UART_HOST_READ_TIMEOUT_MS 1000
+#endif
+
+/**
+ * A UART channel on a file descriptor, for firmware built to run as a host
+ * process. It is a uart_fd device, the same one the test build's mock
+ * channels use to talk to real or emulated devices. Everything goes through
+ * system calls, which are safe to preempt, so tasks under the Posix FreeRTOS
+ * port can use a channel without a critical section.
+ *
+ * Writes are batched, and the batch goes out at the end of every line as
+ * well as whenever uart_fd would flush it, so text shows up as it is
+ * written.
+ */
+typedef struct uart {
+    /**
+     * The descriptor the bytes go through
+     */
+    uart_fd_t device;
+    /**
+     * True if the channel is open
+     */
+    bool open;
+    /**
+     * How long a blocking read waits for the line before giving up
+     */
+    int read_timeout_ms;
+} uart_t;
+
+/**
+ * Open a channel on a file descriptor
+ *
+ * @param out The UART structure to fill
+ * @param fd The descriptor to use, such as a pty or a dup of standard output.
+ *      The channel takes over fd, and closes it when it is closed or fails
+ *      to open.
+ * @param baud_rate The baud rate at which we will run, in bits per second
+ * @return False if fd can't be used, or is a terminal that can't run at the
+ *      baud rate
+ */
+bool uart_open_fd(uart_t * out, int fd, size_t baud_rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _BOARD_COMMON_HOST_UART_H_
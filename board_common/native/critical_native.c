@@ -0,0 +1,20 @@
+#include "critical.h"
+
+#include <msp430.h>
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+critical_state_t critical_enter(void) {
+    critical_state_t state = __get_SR_register() & GIE;
+    __disable_interrupt();
+    // The instruction after DINT can still be interrupted
+    __no_operation();
+    return state;
+}
+
+void critical_exit(critical_state_t state) {
+    if (state & GIE) {
+        __enable_interrupt();
+    }
+}
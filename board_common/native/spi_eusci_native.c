@@ -1,4 +1,5 @@
 #include "spi.h"
+#include "spi_block.h"
 
 #include <assert.h>
 
@@ -47,7 +48,8 @@ static bool is_eusci_a_block(uint16_t base_address) {
         );
 }
 
-static bool eusci_a_spi_open(eusci_t eusci, uint16_t base_address, uint32_t clock_rate, spi_t * out) {
+static bool eusci_a_spi_open(eusci_t eusci, uint16_t base_address, const spi_config_t * config,
+                             const spi_clock_t * clock, spi_t * out) {
     // Check if the SPI bus is already enabled
     bool is_in_reset_state = HWREG16(base_address + OFS_UCAxCTLW0) & UCSWRST;
     if (!is_in_reset_state) {
@@ -56,26 +58,59 @@ static bool eusci_a_spi_open(eusci_t eusci, uint16_t base_address, uint32_t cloc
 
     // Configure the SPI master block
     EUSCI_A_SPI_initMasterParam param = {0};
-    param.selectClockSource = EUSCI_A_SPI_CLOCKSOURCE_ACLK;
-    param.clockSourceFrequency = CS_getACLK();
-    param.desiredSpiClock = clock_rate;
-    param.msbFirst = EUSCI_A_SPI_MSB_FIRST;
-    param.clockPhase = EUSCI_A_SPI_PHASE_DATA_CHANGED_ONFIRST_CAPTURED_ON_NEXT;
-    param.clockPolarity = EUSCI_A_SPI_CLOCKPOLARITY_INACTIVITY_HIGH;
-    param.spiMode = EUSCI_A_SPI_3PIN;
+    if (clock->source == SPI_CLOCK_SOURCE_SMCLK) {
+        param.selectClockSource = EUSCI_A_SPI_CLOCKSOURCE_SMCLK;
+        param.clockSourceFrequency = CS_getSMCLK();
+    }
+    else {
+        param.selectClockSource = EUSCI_A_SPI_CLOCKSOURCE_ACLK;
+        param.clockSourceFrequency = CS_getACLK();
+    }
+    param.desiredSpiClock = clock->rate;
+    param.msbFirst = config->bit_order == SPI_LSB_FIRST ?
+        EUSCI_A_SPI_LSB_FIRST : EUSCI_A_SPI_MSB_FIRST;
+    // UCCKPH set means capture on the first edge, which is CPHA = 0
+    param.clockPhase = (config->mode == SPI_MODE_0 || config->mode == SPI_MODE_2) ?
+        EUSCI_A_SPI_PHASE_DATA_CAPTURED_ONFIRST_CHANGED_ON_NEXT :
+        EUSCI_A_SPI_PHASE_DATA_CHANGED_ONFIRST_CAPTURED_ON_NEXT;
+    param.clockPolarity = (config->mode == SPI_MODE_2 || config->mode == SPI_MODE_3) ?
+        EUSCI_A_SPI_CLOCKPOLARITY_INACTIVITY_HIGH :
+        EUSCI_A_SPI_CLOCKPOLARITY_INACTIVITY_LOW;
+    switch (config->pins) {
+        case SPI_4PIN_ACTIVE_HIGH:
+            param.spiMode = EUSCI_A_SPI_4PIN_UCxSTE_ACTIVE_HIGH;
+            break;
+        case SPI_4PIN_ACTIVE_LOW:
+            param.spiMode = EUSCI_A_SPI_4PIN_UCxSTE_ACTIVE_LOW;
+            break;
+        default:
+            param.spiMode = EUSCI_A_SPI_3PIN;
+            break;
+    }
 
     // Initialize the SPI master block
     EUSCI_A_SPI_initMaster(base_address, &param);
+    // Driverlib rounds its divider down, which can overshoot the requested
+    // rate, so program the prescaler we chose
+    HWREG16(base_address + OFS_UCAxBRW) = clock->prescaler;
+    if (config->pins != SPI_3PIN) {
+        // Drive STE as the slave select rather than watching it for bus
+        // conflicts
+        EUSCI_A_SPI_select4PinFunctionality(base_address,
+            EUSCI_A_SPI_ENABLE_SIGNAL_FOR_4WIRE_SLAVE);
+    }
 
     // Enable the SPI block
     EUSCI_A_SPI_enable(base_address);
 
     out->eusci = eusci;
+    out->clock_rate = clock->rate;
 
     return true;
 }
 
-static bool eusci_b_spi_open(eusci_t eusci, uint16_t base_address, uint32_t clock_rate, spi_t * out) {
+static bool eusci_b_spi_open(eusci_t eusci, uint16_t base_address, const spi_config_t * config,
+                             const spi_clock_t * clock, spi_t * out) {
     // Check if the SPI bus is already enabled
     bool is_in_reset_state = HWREG16(base_address + OFS_UCBxCTLW0) & UCSWRST;
     if (!is_in_reset_state) {
@@ -84,33 +119,70 @@ static bool eusci_b_spi_open(eusci_t eusci, uint16_t base_address, uint32_t cloc
 
     // Configure the SPI master block
     EUSCI_B_SPI_initMasterParam param = {0};
-    param.selectClockSource = EUSCI_B_SPI_CLOCKSOURCE_ACLK;
-    param.clockSourceFrequency = CS_getACLK();
-    param.desiredSpiClock = clock_rate;
-    param.msbFirst = EUSCI_B_SPI_MSB_FIRST;
-    param.clockPhase = EUSCI_B_SPI_PHASE_DATA_CHANGED_ONFIRST_CAPTURED_ON_NEXT;
-    param.clockPolarity = EUSCI_B_SPI_CLOCKPOLARITY_INACTIVITY_HIGH;
-    param.spiMode = EUSCI_B_SPI_3PIN;
+    if (clock->source == SPI_CLOCK_SOURCE_SMCLK) {
+        param.selectClockSource = EUSCI_B_SPI_CLOCKSOURCE_SMCLK;
+        param.clockSourceFrequency = CS_getSMCLK();
+    }
+    else {
+        param.selectClockSource = EUSCI_B_SPI_CLOCKSOURCE_ACLK;
+        param.clockSourceFrequency = CS_getACLK();
+    }
+    param.desiredSpiClock = clock->rate;
+    param.msbFirst = config->bit_order == SPI_LSB_FIRST ?
+        EUSCI_B_SPI_LSB_FIRST : EUSCI_B_SPI_MSB_FIRST;
+    // UCCKPH set means capture on the first edge, which is CPHA = 0
+    param.clockPhase = (config->mode == SPI_MODE_0 || config->mode == SPI_MODE_2) ?
+        EUSCI_B_SPI_PHASE_DATA_CAPTURED_ONFIRST_CHANGED_ON_NEXT :
+        EUSCI_B_SPI_PHASE_DATA_CHANGED_ONFIRST_CAPTURED_ON_NEXT;
+    param.clockPolarity = (config->mode == SPI_MODE_2 || config->mode == SPI_MODE_3) ?
+        EUSCI_B_SPI_CLOCKPOLARITY_INACTIVITY_HIGH :
+        EUSCI_B_SPI_CLOCKPOLARITY_INACTIVITY_LOW;
+    switch (config->pins) {
+        case SPI_4PIN_ACTIVE_HIGH:
+            param.spiMode = EUSCI_B_SPI_4PIN_UCxSTE_ACTIVE_HIGH;
+            break;
+        case SPI_4PIN_ACTIVE_LOW:
+            param.spiMode = EUSCI_B_SPI_4PIN_UCxSTE_ACTIVE_LOW;
+            break;
+        default:
+            param.spiMode = EUSCI_B_SPI_3PIN;
+            break;
+    }
 
     // Initialize the SPI master block
     EUSCI_B_SPI_initMaster(base_address, &param);
+    // Driverlib rounds its divider down, which can overshoot the requested
+    // rate, so program the prescaler we chose
+    HWREG16(base_address + OFS_UCBxBRW) = clock->prescaler;
+    if (config->pins != SPI_3PIN) {
+        // Drive STE as the slave select rather than watching it for bus
+        // conflicts
+        EUSCI_B_SPI_select4PinFunctionality(base_address,
+            EUSCI_B_SPI_ENABLE_SIGNAL_FOR_4WIRE_SLAVE);
+    }
 
     // Enable the SPI block
     EUSCI_B_SPI_enable(base_address);
 
     out->eusci = eusci;
+    out->clock_rate = clock->rate;
 
     return true;
 }
 
-bool spi_open(eusci_t eusci, uint32_t clock_rate, spi_t * out) {
+bool spi_open(eusci_t eusci, const spi_config_t * config, spi_t * out) {
     uint16_t base_address = BASE_ADDRESSES[eusci];
 
+    spi_clock_t clock;
+    if (!spi_select_clock(config, CS_getSMCLK(), CS_getACLK(), &clock)) {
+        return false;
+    }
+
     if (is_eusci_a_block(base_address)) {
-        return eusci_a_spi_open(eusci, base_address, clock_rate, out);
+        return eusci_a_spi_open(eusci, base_address, config, &clock, out);
     }
     else {
-        return eusci_b_spi_open(eusci, base_address, clock_rate, out);
+        return eusci_b_spi_open(eusci, base_address, config, &clock, out);
     }
 }
 
@@ -181,3 +253,114 @@ spi_error_t spi_transfer_byte(spi_t * channel, uint8_t send_byte, uint8_t * rece
         return eusci_b_spi_transfer_byte(base_address, send_byte, receive_byte);
     }
 }
+
+/******************************************************************************\
+ *  Bulk transfers                                                            *
+\******************************************************************************/
+
+/**
+ * The registers a block transfer touches. A and B blocks lay these out
+ * differently, so we resolve them once per block instead of once per byte.
+ */
+typedef struct spi_block_registers {
+    volatile uint16_t * ifg;
+    volatile uint16_t * statw;
+    volatile uint16_t * txbuf;
+    volatile uint16_t * rxbuf;
+} spi_block_registers_t;
+
+// Look up the channel's registers and check it is open
+static spi_error_t spi_block_begin(spi_t * channel, spi_block_registers_t * registers) {
+    uint16_t base_address = BASE_ADDRESSES[channel->eusci];
+
+    if (is_eusci_a_block(base_address)) {
+        if (HWREG16(base_address + OFS_UCAxCTLW0) & UCSWRST) {
+            return SPI_CHANNEL_CLOSED;
+        }
+        registers->ifg = &HWREG16(base_address + OFS_UCAxIFG);
+        registers->statw = &HWREG16(base_address + OFS_UCAxSTATW);
+        registers->txbuf = &HWREG16(base_address + OFS_UCAxTXBUF);
+        registers->rxbuf = &HWREG16(base_address + OFS_UCAxRXBUF);
+    }
+    else {
+        if (HWREG16(base_address + OFS_UCBxCTLW0) & UCSWRST) {
+            return SPI_CHANNEL_CLOSED;
+        }
+        registers->ifg = &HWREG16(base_address + OFS_UCBxIFG);
+        registers->statw = &HWREG16(base_address + OFS_UCBxSTATW);
+        registers->txbuf = &HWREG16(base_address + OFS_UCBxTXBUF);
+        registers->rxbuf = &HWREG16(base_address + OFS_UCBxRXBUF);
+    }
+
+    // Wait out anything a previous single byte transfer left shifting, then
+    // drop its received byte so UCRXIFG only tracks this block
+    while (*registers->statw & UCBUSY);
+    (void)*registers->rxbuf;
+
+    return SPI_NO_ERROR;
+}
+
+/******************************************************************************\
+ *  Block pipeline port                                                       *
+\******************************************************************************/
+static bool spi_block_tx_ready(void * block) {
+    return *((spi_block_registers_t *) block)->ifg & UCTXIFG;
+}
+
+static bool spi_block_rx_ready(void * block) {
+    return *((spi_block_registers_t *) block)->ifg & UCRXIFG;
+}
+
+static bool spi_block_busy(void * block) {
+    return *((spi_block_registers_t *) block)->statw & UCBUSY;
+}
+
+static void spi_block_send_byte(void * block, uint8_t byte) {
+    *((spi_block_registers_t *) block)->txbuf = byte;
+}
+
+static uint8_t spi_block_receive_byte(void * block, bool * overrun) {
+    spi_block_registers_t * r = (spi_block_registers_t *) block;
+    *overrun = (*r->statw & UCOE) != 0;
+    return *r->rxbuf;
+}
+
+static const spi_block_port_t SPI_BLOCK_PORT = {
+    spi_block_tx_ready,
+    spi_block_rx_ready,
+    spi_block_busy,
+    spi_block_send_byte,
+    spi_block_receive_byte,
+};
+
+spi_error_t spi_transfer_bytes(spi_t * channel, uint8_t * send_bytes, uint8_t * receive_bytes, size_t length) {
+    spi_block_registers_t r;
+    spi_error_t err = spi_block_begin(channel, &r);
+    if (err != SPI_NO_ERROR) {
+        return err;
+    }
+
+    return spi_block_transfer(&SPI_BLOCK_PORT, &r, send_bytes, receive_bytes, length);
+}
+
+spi_error_t spi_send_bytes(spi_t * channel, uint8_t * send_bytes, size_t length) {
+    spi_block_registers_t r;
+    spi_error_t err = spi_block_begin(channel, &r);
+    if (err != SPI_NO_ERROR) {
+        return err;
+    }
+
+    spi_block_send(&SPI_BLOCK_PORT, &r, send_bytes, length);
+    return SPI_NO_ERROR;
+}
+
+spi_error_t spi_receive_bytes(spi_t * channel, uint8_t * receive_bytes, size_t length) {
+    spi_block_registers_t r;
+    spi_error_t err = spi_block_begin(channel, &r);
+    if (err != SPI_NO_ERROR) {
+        return err;
+    }
+
+    // Same pipeline as spi_transfer_bytes, clocking out zeros
+    return spi_block_transfer(&SPI_BLOCK_PORT, &r, NULL, receive_bytes, length);
+}
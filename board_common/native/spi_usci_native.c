@@ -1,31 +1,32 @@
 #include "spi.h"
+#include "spi_block.h"
 
 #include <assert.h>
 
 static uint16_t BASE_ADDRESSES[USCI_count] = {
 #ifdef USCI_A0_BASE
-    USCI_A0,
+    USCI_A0_BASE,
 #endif
 #ifdef USCI_A1_BASE
-    USCI_A1,
+    USCI_A1_BASE,
 #endif
 #ifdef USCI_A2_BASE
-    USCI_A2,
+    USCI_A2_BASE,
 #endif
 #ifdef USCI_A3_BASE
-    USCI_A3,
+    USCI_A3_BASE,
 #endif
 #ifdef USCI_B0_BASE
-    USCI_B0,
+    USCI_B0_BASE,
 #endif
 #ifdef USCI_B1_BASE
-    USCI_B1,
+    USCI_B1_BASE,
 #endif
 #ifdef USCI_B2_BASE
-    USCI_B2,
+    USCI_B2_BASE,
 #endif
 #ifdef USCI_B3_BASE
-    USCI_B3,
+    USCI_B3_BASE,
 #endif
 };
 
@@ -47,7 +48,8 @@ static bool is_usci_a_block(uint16_t base_address) {
         );
 }
 
-static bool usci_a_spi_open(usci_t usci, uint16_t base_address, uint32_t clock_rate, spi_t * out) {
+static bool usci_a_spi_open(usci_t usci, uint16_t base_address, const spi_config_t * config,
+                            const spi_clock_t * clock, spi_t * out) {
     // Check if the SPI bus is already enabled
     bool is_in_reset_state = HWREG16(base_address + OFS_UCAxCTL1) & UCSWRST;
     if (!is_in_reset_state) {
@@ -56,25 +58,50 @@ static bool usci_a_spi_open(usci_t usci, uint16_t base_address, uint32_t clock_r
 
     // Configure the SPI master block
     USCI_A_SPI_initMasterParam param = {0};
-    param.selectClockSource = USCI_A_SPI_CLOCKSOURCE_ACLK;
-    param.clockSourceFrequency = UCS_getACLK();
-    param.desiredSpiClock = clock_rate;
-    param.msbFirst = USCI_A_SPI_MSB_FIRST;
-    param.clockPhase = USCI_A_SPI_PHASE_DATA_CHANGED_ONFIRST_CAPTURED_ON_NEXT;
-    param.clockPolarity = USCI_A_SPI_CLOCKPOLARITY_INACTIVITY_HIGH;
+    if (clock->source == SPI_CLOCK_SOURCE_SMCLK) {
+        param.selectClockSource = USCI_A_SPI_CLOCKSOURCE_SMCLK;
+        param.clockSourceFrequency = UCS_getSMCLK();
+    }
+    else {
+        param.selectClockSource = USCI_A_SPI_CLOCKSOURCE_ACLK;
+        param.clockSourceFrequency = UCS_getACLK();
+    }
+    param.desiredSpiClock = clock->rate;
+    param.msbFirst = config->bit_order == SPI_LSB_FIRST ?
+        USCI_A_SPI_LSB_FIRST : USCI_A_SPI_MSB_FIRST;
+    // UCCKPH set means capture on the first edge, which is CPHA = 0
+    param.clockPhase = (config->mode == SPI_MODE_0 || config->mode == SPI_MODE_2) ?
+        USCI_A_SPI_PHASE_DATA_CAPTURED_ONFIRST_CHANGED_ON_NEXT :
+        USCI_A_SPI_PHASE_DATA_CHANGED_ONFIRST_CAPTURED_ON_NEXT;
+    param.clockPolarity = (config->mode == SPI_MODE_2 || config->mode == SPI_MODE_3) ?
+        USCI_A_SPI_CLOCKPOLARITY_INACTIVITY_HIGH :
+        USCI_A_SPI_CLOCKPOLARITY_INACTIVITY_LOW;
 
     // Initialize the SPI master block
     USCI_A_SPI_initMaster(base_address, &param);
+    // Driverlib rounds its divider down, which can overshoot the requested
+    // rate, so program the prescaler we chose
+    HWREG16(base_address + OFS_UCAxBRW) = clock->prescaler;
+    // Driverlib only knows 3 pin mode. In master mode the USCI can only use
+    // STE to detect bus conflicts, not to drive a slave select.
+    if (config->pins == SPI_4PIN_ACTIVE_HIGH) {
+        HWREG8(base_address + OFS_UCAxCTL0) |= UCMODE_1;
+    }
+    else if (config->pins == SPI_4PIN_ACTIVE_LOW) {
+        HWREG8(base_address + OFS_UCAxCTL0) |= UCMODE_2;
+    }
 
     // Enable the SPI block
     USCI_A_SPI_enable(base_address);
 
     out->usci = usci;
+    out->clock_rate = clock->rate;
 
     return true;
 }
 
-static bool usci_b_spi_open(usci_t usci, uint16_t base_address, uint32_t clock_rate, spi_t * out) {
+static bool usci_b_spi_open(usci_t usci, uint16_t base_address, const spi_config_t * config,
+                            const spi_clock_t * clock, spi_t * out) {
     // Check if the SPI bus is already enabled
     bool is_in_reset_state = HWREG16(base_address + OFS_UCBxCTL1) & UCSWRST;
     if (!is_in_reset_state) {
@@ -83,32 +110,61 @@ static bool usci_b_spi_open(usci_t usci, uint16_t base_address, uint32_t clock_r
 
     // Configure the SPI master block
     USCI_B_SPI_initMasterParam param = {0};
-    param.selectClockSource = USCI_B_SPI_CLOCKSOURCE_ACLK;
-    param.clockSourceFrequency = UCS_getACLK();
-    param.desiredSpiClock = clock_rate;
-    param.msbFirst = USCI_B_SPI_MSB_FIRST;
-    param.clockPhase = USCI_B_SPI_PHASE_DATA_CHANGED_ONFIRST_CAPTURED_ON_NEXT;
-    param.clockPolarity = USCI_B_SPI_CLOCKPOLARITY_INACTIVITY_HIGH;
+    if (clock->source == SPI_CLOCK_SOURCE_SMCLK) {
+        param.selectClockSource = USCI_B_SPI_CLOCKSOURCE_SMCLK;
+        param.clockSourceFrequency = UCS_getSMCLK();
+    }
+    else {
+        param.selectClockSource = USCI_B_SPI_CLOCKSOURCE_ACLK;
+        param.clockSourceFrequency = UCS_getACLK();
+    }
+    param.desiredSpiClock = clock->rate;
+    param.msbFirst = config->bit_order == SPI_LSB_FIRST ?
+        USCI_B_SPI_LSB_FIRST : USCI_B_SPI_MSB_FIRST;
+    // UCCKPH set means capture on the first edge, which is CPHA = 0
+    param.clockPhase = (config->mode == SPI_MODE_0 || config->mode == SPI_MODE_2) ?
+        USCI_B_SPI_PHASE_DATA_CAPTURED_ONFIRST_CHANGED_ON_NEXT :
+        USCI_B_SPI_PHASE_DATA_CHANGED_ONFIRST_CAPTURED_ON_NEXT;
+    param.clockPolarity = (config->mode == SPI_MODE_2 || config->mode == SPI_MODE_3) ?
+        USCI_B_SPI_CLOCKPOLARITY_INACTIVITY_HIGH :
+        USCI_B_SPI_CLOCKPOLARITY_INACTIVITY_LOW;
 
     // Initialize the SPI master block
     USCI_B_SPI_initMaster(base_address, &param);
+    // Driverlib rounds its divider down, which can overshoot the requested
+    // rate, so program the prescaler we chose
+    HWREG16(base_address + OFS_UCBxBRW) = clock->prescaler;
+    // Driverlib only knows 3 pin mode. In master mode the USCI can only use
+    // STE to detect bus conflicts, not to drive a slave select.
+    if (config->pins == SPI_4PIN_ACTIVE_HIGH) {
+        HWREG8(base_address + OFS_UCBxCTL0) |= UCMODE_1;
+    }
+    else if (config->pins == SPI_4PIN_ACTIVE_LOW) {
+        HWREG8(base_address + OFS_UCBxCTL0) |= UCMODE_2;
+    }
 
     // Enable the SPI block
     USCI_B_SPI_enable(base_address);
 
     out->usci = usci;
+    out->clock_rate = clock->rate;
 
     return true;
 }
 
-bool spi_open(usci_t usci, uint32_t clock_rate, spi_t * out) {
+bool spi_open(usci_t usci, const spi_config_t * config, spi_t * out) {
     uint16_t base_address = BASE_ADDRESSES[usci];
 
+    spi_clock_t clock;
+    if (!spi_select_clock(config, UCS_getSMCLK(), UCS_getACLK(), &clock)) {
+        return false;
+    }
+
     if (is_usci_a_block(base_address)) {
-        return usci_a_spi_open(usci, base_address, clock_rate, out);
+        return usci_a_spi_open(usci, base_address, config, &clock, out);
     }
     else {
-        return usci_b_spi_open(usci, base_address, clock_rate, out);
+        return usci_b_spi_open(usci, base_address, config, &clock, out);
     }
 }
 
@@ -179,3 +235,114 @@ spi_error_t spi_transfer_byte(spi_t * channel, uint8_t send_byte, uint8_t * rece
         return usci_b_spi_transfer_byte(base_address, send_byte, receive_byte);
     }
 }
+
+/******************************************************************************\
+ *  Bulk transfers                                                            *
+\******************************************************************************/
+
+/**
+ * The registers a block transfer touches, resolved once per block instead of
+ * once per byte
+ */
+typedef struct spi_block_registers {
+    volatile uint8_t * ifg;
+    volatile uint8_t * stat;
+    volatile uint8_t * txbuf;
+    volatile uint8_t * rxbuf;
+} spi_block_registers_t;
+
+// Look up the channel's registers and check it is open
+static spi_error_t spi_block_begin(spi_t * channel, spi_block_registers_t * registers) {
+    uint16_t base_address = BASE_ADDRESSES[channel->usci];
+
+    if (is_usci_a_block(base_address)) {
+        if (HWREG8(base_address + OFS_UCAxCTL1) & UCSWRST) {
+            return SPI_CHANNEL_CLOSED;
+        }
+        registers->ifg = &HWREG8(base_address + OFS_UCAxIFG);
+        registers->stat = &HWREG8(base_address + OFS_UCAxSTAT);
+        registers->txbuf = &HWREG8(base_address + OFS_UCAxTXBUF);
+        registers->rxbuf = &HWREG8(base_address + OFS_UCAxRXBUF);
+    }
+    else {
+        if (HWREG8(base_address + OFS_UCBxCTL1) & UCSWRST) {
+            return SPI_CHANNEL_CLOSED;
+        }
+        registers->ifg = &HWREG8(base_address + OFS_UCBxIFG);
+        registers->stat = &HWREG8(base_address + OFS_UCBxSTAT);
+        registers->txbuf = &HWREG8(base_address + OFS_UCBxTXBUF);
+        registers->rxbuf = &HWREG8(base_address + OFS_UCBxRXBUF);
+    }
+
+    // Wait out anything a previous single byte transfer left shifting, then
+    // drop its received byte so UCRXIFG only tracks this block
+    while (*registers->stat & UCBUSY);
+    (void)*registers->rxbuf;
+
+    return SPI_NO_ERROR;
+}
+
+/******************************************************************************\
+ *  Block pipeline port                                                       *
+\******************************************************************************/
+static bool spi_block_tx_ready(void * block) {
+    return *((spi_block_registers_t *) block)->ifg & UCTXIFG;
+}
+
+static bool spi_block_rx_ready(void * block) {
+    return *((spi_block_registers_t *) block)->ifg & UCRXIFG;
+}
+
+static bool spi_block_busy(void * block) {
+    return *((spi_block_registers_t *) block)->stat & UCBUSY;
+}
+
+static void spi_block_send_byte(void * block, uint8_t byte) {
+    *((spi_block_registers_t *) block)->txbuf = byte;
+}
+
+static uint8_t spi_block_receive_byte(void * block, bool * overrun) {
+    spi_block_registers_t * r = (spi_block_registers_t *) block;
+    *overrun = (*r->stat & UCOE) != 0;
+    return *r->rxbuf;
+}
+
+static const spi_block_port_t SPI_BLOCK_PORT = {
+    spi_block_tx_ready,
+    spi_block_rx_ready,
+    spi_block_busy,
+    spi_block_send_byte,
+    spi_block_receive_byte,
+};
+
+spi_error_t spi_transfer_bytes(spi_t * channel, uint8_t * send_bytes, uint8_t * receive_bytes, size_t length) {
+    spi_block_registers_t r;
+    spi_error_t err = spi_block_begin(channel, &r);
+    if (err != SPI_NO_ERROR) {
+        return err;
+    }
+
+    return spi_block_transfer(&SPI_BLOCK_PORT, &r, send_bytes, receive_bytes, length);
+}
+
+spi_error_t spi_send_bytes(spi_t * channel, uint8_t * send_bytes, size_t length) {
+    spi_block_registers_t r;
+    spi_error_t err = spi_block_begin(channel, &r);
+    if (err != SPI_NO_ERROR) {
+        return err;
+    }
+
+    spi_block_send(&SPI_BLOCK_PORT, &r, send_bytes, length);
+    return SPI_NO_ERROR;
+}
+
+spi_error_t spi_receive_bytes(spi_t * channel, uint8_t * receive_bytes, size_t length) {
+    spi_block_registers_t r;
+    spi_error_t err = spi_block_begin(channel, &r);
+    if (err != SPI_NO_ERROR) {
+        return err;
+    }
+
+    // Same pipeline as spi_transfer_bytes, clocking out zeros
+    return spi_block_transfer(&SPI_BLOCK_PORT, &r, NULL, receive_bytes, length);
+}
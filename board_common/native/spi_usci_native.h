@@ -7,22 +7,41 @@
 extern "C" {
 #endif
 
+/**
+ * This backend pipelines spi_send_bytes, spi_receive_bytes and
+ * spi_transfer_bytes itself rather than using the per-byte versions in spi.c.
+ *
+ * The pipeline only runs on target; the host build tests the per-byte
+ * versions against the mock. Changes to it need checking on a board with a
+ * logic analyser on the bus and an interrupt source busy, e.g. the UART
+ * receiving at 115200, to see SCLK stay continuous and no byte slip.
+ */
+#define SPI_NATIVE_BULK_TRANSFERS
+
 typedef struct spi {
     /**
      * The USCI module we are going to use
      */
     usci_t usci;
+    /**
+     * The bit clock the bus actually runs at, in Hz
+     */
+    uint32_t clock_rate;
 } spi_t;
 
 /**
  * Open a connection to an SPI channel
  *
  * @param usci The USCI channel to use
- * @param clock_rate The clock rate at which we will run
+ * @param config How to run the bus. The clock source and prescaler are
+ *               chosen to get as close to config->clock_rate as possible
+ *               without going over, and the result is stored in
+ *               out->clock_rate.
  * @param out The SPI structure to fill
- *
+ * @return False if the block is already open or no clock source can reach
+ *         the requested rate
  */
-bool spi_open(usci_t usci, uint32_t clock_rate, spi_t * out);
+bool spi_open(usci_t usci, const spi_config_t * config, spi_t * out);
 
 #ifdef __cplusplus
 }
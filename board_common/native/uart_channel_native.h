@@ -0,0 +1,165 @@
+#ifndef _BOARD_COMMON_NATIVE_UART_CHANNEL_H_
+#define _BOARD_COMMON_NATIVE_UART_CHANNEL_H_
+
+#include "ring_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Size of the per-channel receive ring in bytes. Must be a power of two.
+ * 64 bytes is about 5.5 ms of traffic at 115200 baud.
+ */
+#ifndef UART_RX_BUFFER_SIZE
+#   define UART_RX_BUFFER_SIZE 64
+#endif
+
+/**
+ * Fill level of the receive ring at which the receive callback runs. The
+ * reader then has the rest of the ring's worth of time to drain it.
+ */
+#ifndef UART_RX_WAKE_LEVEL
+#   define UART_RX_WAKE_LEVEL (UART_RX_BUFFER_SIZE / 2)
+#endif
+
+/**
+ * MCLK cycles between polls of the receive ring while
+ * uart_read_bytes_timeout waits
+ */
+#ifndef UART_POLL_CYCLES
+#   define UART_POLL_CYCLES 100
+#endif
+
+/**
+ * Size of the per-channel transmit ring in bytes. Must be a power of two.
+ */
+#ifndef UART_TX_BUFFER_SIZE
+#   define UART_TX_BUFFER_SIZE 64
+#endif
+
+/**
+ * Callback run from the receive interrupt once the receive ring holds at
+ * least UART_RX_WAKE_LEVEL bytes, and again for every byte after that until
+ * the ring is drained below it. It may only use ISR-safe APIs. It is the last
+ * thing the interrupt does, so it may end with portYIELD_FROM_ISR.
+ *
+ * @param channel The channel passed to uart_set_receive_callback
+ * @param context The context pointer passed to uart_set_receive_callback
+ */
+typedef void (*uart_receive_ready_t)(uart_t * channel, void * context);
+
+/**
+ * Callbacks that block the caller of uart_wait_async until an asynchronous
+ * write finishes, so a task can wait on a notification or semaphore instead
+ * of putting the whole CPU in LPM0 behind the scheduler's back.
+ *
+ * The wait callback runs in uart_wait_async with interrupts enabled, and
+ * may return early; the write is checked again each time it returns. The
+ * wake callback runs from the interrupt that finishes the write. It may only
+ * use ISR-safe APIs. It is the last thing the interrupt does, so it may end
+ * with portYIELD_FROM_ISR.
+ *
+ * @param channel The channel passed to uart_set_async_waiter
+ * @param context The context pointer passed to uart_set_async_waiter
+ */
+typedef void (*uart_async_wait_t)(uart_t * channel, void * context);
+
+/**
+ * Per-channel state shared between the UART interrupt handler and the tasks
+ * using the channel. There is exactly one of these for each UART capable
+ * block, so that copies of a `uart_t` all refer to the same buffers.
+ */
+typedef struct uart_channel {
+    /**
+     * Bytes received by the ISR, waiting to be read. The ISR is the producer.
+     */
+    ring_buffer_t rx;
+    /**
+     * Bytes waiting to be sent by the ISR. The ISR is the consumer.
+     */
+    ring_buffer_t tx;
+    /**
+     * Backing storage for `rx`
+     */
+    uint8_t rx_storage[UART_RX_BUFFER_SIZE];
+    /**
+     * Backing storage for `tx`
+     */
+    uint8_t tx_storage[UART_TX_BUFFER_SIZE];
+    /**
+     * Number of received bytes dropped because the receive ring was full
+     */
+    volatile uint16_t rx_overruns;
+    /**
+     * Set by the ISR when a byte was dropped or received with an error, and
+     * cleared when the next read reports the fault
+     */
+    volatile bool rx_fault;
+    /**
+     * True while the channel is open
+     */
+    volatile bool open;
+    /**
+     * Receive callback, or NULL for none
+     */
+    uart_receive_ready_t on_receive;
+    /**
+     * Context for `on_receive`
+     */
+    void * on_receive_context;
+    /**
+     * The channel handle passed to uart_set_receive_callback, reported back
+     * to `on_receive`
+     */
+    uart_t * receive_owner;
+    /**
+     * True while a DMA transfer started by uart_write_bytes_async is running
+     */
+    volatile bool tx_dma_busy;
+    /**
+     * Completion callback of the running DMA transfer
+     */
+    uart_write_complete_t on_complete;
+    /**
+     * Context for `on_complete`
+     */
+    void * on_complete_context;
+    /**
+     * The channel handle passed to uart_write_bytes_async, reported back to
+     * `on_complete`
+     */
+    uart_t * async_owner;
+    /**
+     * Blocks uart_wait_async, or NULL to sleep in LPM0 instead
+     */
+    uart_async_wait_t async_wait;
+    /**
+     * Wakes whoever `async_wait` blocked, or NULL for none
+     */
+    uart_async_wait_t async_wake;
+    /**
+     * Context for `async_wait` and `async_wake`
+     */
+    void * async_wait_context;
+    /**
+     * The channel handle passed to uart_set_async_waiter, reported back to
+     * `async_wait` and `async_wake`
+     */
+    uart_t * wait_owner;
+    /**
+     * Next byte of an asynchronous write on a block with no DMA trigger,
+     * where the transmit ISR sends the buffer instead
+     */
+    const uint8_t * volatile async_bytes;
+    /**
+     * Bytes of `async_bytes` still to send
+     */
+    volatile uint16_t async_remaining;
+} uart_channel_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _BOARD_COMMON_NATIVE_UART_CHANNEL_H_
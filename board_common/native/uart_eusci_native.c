@@ -1,4 +1,6 @@
 #include "uart.h"
+#include "uart_baud.h"
+#include "critical.h"
 
 #include <assert.h>
 
@@ -29,96 +31,539 @@ static uint16_t BASE_ADDRESSES[EUSCI_count] = {
 #endif
 };
 
-volatile int read_byte = 0;
+// Only the A blocks can act as UARTs, and they are always enumerated first
+#ifdef EUSCI_B0_BASE
+#   define UART_CHANNEL_COUNT EUSCI_B0
+#else
+#   define UART_CHANNEL_COUNT EUSCI_count
+#endif
 
-__attribute__((interrupt(USCI_A0_VECTOR)))
-void USCI_A0_ISR(void) {
-    switch (__even_in_range(UCA0IV, 18)) {
+/// Ring buffers and status for each of the UART capable blocks
+static uart_channel_t CHANNELS[UART_CHANNEL_COUNT];
+
+/**
+ * The DMA channel and trigger used for asynchronous transmission on each
+ * UART capable block. Trigger numbers follow the MSP430FR599x data sheet,
+ * where channels 0-2 see UCA0/UCA1 and channels 3-5 see UCA2/UCA3 on the
+ * same trigger inputs.
+ */
+typedef struct uart_dma {
+    uint8_t channel;
+    uint8_t trigger;
+} uart_dma_t;
+
+static const uart_dma_t DMA_CHANNELS[UART_CHANNEL_COUNT] = {
+#ifdef EUSCI_A0_BASE
+    { DMA_CHANNEL_0, DMA_TRIGGERSOURCE_15 },
+#endif
+#ifdef EUSCI_A1_BASE
+    { DMA_CHANNEL_1, DMA_TRIGGERSOURCE_17 },
+#endif
+#ifdef EUSCI_A2_BASE
+    { DMA_CHANNEL_3, DMA_TRIGGERSOURCE_15 },
+#endif
+#ifdef EUSCI_A3_BASE
+    { DMA_CHANNEL_4, DMA_TRIGGERSOURCE_17 },
+#endif
+};
+
+/******************************************************************************\
+ *  Interrupt handlers                                                        *
+\******************************************************************************/
+/**
+ * Shared body of the EUSCI A interrupt handlers. Received bytes are pushed in
+ * to the channel's receive ring and the transmit ring is drained one byte per
+ * UCTXIFG. The transmit interrupt is disabled once the ring runs dry, and
+ * re-enabled by the next write.
+ *
+ * @param eusci The block that raised the interrupt
+ */
+static inline void uart_handle_interrupt(eusci_t eusci) {
+    uint16_t base_address = BASE_ADDRESSES[eusci];
+    uart_channel_t * channel = &CHANNELS[eusci];
+    uint8_t byte;
+
+    switch (__even_in_range(HWREG16(base_address + OFS_UCAxIV), USCI_UART_UCTXCPTIFG)) {
         case USCI_NONE: break;
-        case USCI_UART_UCRXIFG:
-            P4OUT = 1 << 6;
-            read_byte = EUSCI_A_UART_receiveData(EUSCI_A0_BASE);
+        case USCI_UART_UCRXIFG: {
+            // The error flags are cleared by reading the receive buffer, so
+            // sample them first
+            bool has_error = EUSCI_A_UART_queryStatusFlags(base_address,
+                EUSCI_A_UART_RECEIVE_ERROR);
+            byte = EUSCI_A_UART_receiveData(base_address);
+            if (has_error) {
+                channel->rx_fault = true;
+            }
+            else if (!ring_buffer_push(&channel->rx, byte)) {
+                channel->rx_overruns++;
+                channel->rx_fault = true;
+            }
+            else {
+                // Byte stored
+            }
+            // Last, so the callback may switch tasks on the way out
+            if (channel->on_receive &&
+                    ring_buffer_size(&channel->rx) >= UART_RX_WAKE_LEVEL) {
+                channel->on_receive(channel->receive_owner,
+                    channel->on_receive_context);
+            }
+            break;
+        }
+        case USCI_UART_UCTXIFG:
+            if (ring_buffer_pop(&channel->tx, &byte)) {
+                EUSCI_A_UART_transmitData(base_address, byte);
+            }
+            else {
+                EUSCI_A_UART_disableInterrupt(base_address,
+                    EUSCI_A_UART_TRANSMIT_INTERRUPT);
+            }
             break;
-        case USCI_UART_UCTXIFG: break;
         case USCI_UART_UCSTTIFG: break;
         case USCI_UART_UCTXCPTIFG: break;
+        default: break;
     }
 }
 
+#ifdef EUSCI_A0_BASE
+__attribute__((interrupt(USCI_A0_VECTOR)))
+void USCI_A0_ISR(void) {
+    uart_handle_interrupt(EUSCI_A0);
+}
+#endif
+
+#ifdef EUSCI_A1_BASE
 __attribute__((interrupt(USCI_A1_VECTOR)))
 void USCI_A1_ISR(void) {
-    switch (__even_in_range(UCA1IV, 18)) {
-        case USCI_NONE: break;
-        case USCI_UART_UCRXIFG:
-            read_byte = EUSCI_A_UART_receiveData(EUSCI_A1_BASE);
+    uart_handle_interrupt(EUSCI_A1);
+}
+#endif
+
+#ifdef EUSCI_A2_BASE
+__attribute__((interrupt(USCI_A2_VECTOR)))
+void USCI_A2_ISR(void) {
+    uart_handle_interrupt(EUSCI_A2);
+}
+#endif
+
+#ifdef EUSCI_A3_BASE
+__attribute__((interrupt(USCI_A3_VECTOR)))
+void USCI_A3_ISR(void) {
+    uart_handle_interrupt(EUSCI_A3);
+}
+#endif
+
+/**
+ * Finish an asynchronous transfer from the DMA interrupt
+ *
+ * @param eusci The block whose transfer finished
+ */
+static inline void uart_handle_dma_complete(eusci_t eusci) {
+    uart_channel_t * channel = &CHANNELS[eusci];
+
+    DMA_disableInterrupt(DMA_CHANNELS[eusci].channel);
+    channel->tx_dma_busy = false;
+
+    if (channel->on_complete) {
+        channel->on_complete(channel->async_owner, UART_NO_ERROR,
+            channel->on_complete_context);
+    }
+}
+
+__attribute__((interrupt(DMA_VECTOR)))
+void DMA_ISR(void) {
+    uint16_t vector = __even_in_range(DMAIV, 16);
+
+    // Wake anyone sleeping in uart_wait_async. This goes first so the wake
+    // callback can be the last thing the interrupt does.
+    __bic_SR_register_on_exit(LPM0_bits);
+
+    // DMAIV reports channel n as 2 * (n + 1), and DMA_CHANNEL_n is n << 4.
+    // Reading it clears one channel's flag, so one channel is handled per
+    // interrupt.
+    for (eusci_t eusci = 0; eusci < UART_CHANNEL_COUNT; ++eusci) {
+        uint16_t channel_vector = ((DMA_CHANNELS[eusci].channel >> 4) + 1) << 1;
+        if (vector == channel_vector) {
+            uart_channel_t * channel = &CHANNELS[eusci];
+            uart_handle_dma_complete(eusci);
+            if (channel->async_wake) {
+                channel->async_wake(channel->wait_owner, channel->async_wait_context);
+            }
             break;
-        case USCI_UART_UCTXIFG: break;
-        case USCI_UART_UCSTTIFG: break;
-        case USCI_UART_UCTXCPTIFG: break;
+        }
     }
 }
 
+/******************************************************************************\
+ *  UART interface implementation                                             *
+\******************************************************************************/
+/**
+ * Pick the clock and divisor for a baud rate. ACLK is preferred so the UART
+ * keeps running in LPM3, falling back to SMCLK for rates the 32 kHz crystal
+ * can't reach.
+ *
+ * @param baud_rate The baud rate to generate
+ * @param clock_source Set to the EUSCI_A_UART_CLOCKSOURCE_* to use
+ *
+ * @return The divisor, or NULL if neither clock can generate the rate
+ */
+static const uart_baud_divisor_t * uart_select_divisor(uart_baud_rate_t baud_rate,
+                                                       uint16_t * clock_source) {
+    const uart_baud_divisor_t * divisor;
+
+    if ((divisor = uart_eusci_baud_divisor(CS_getACLK(), baud_rate))) {
+        *clock_source = EUSCI_A_UART_CLOCKSOURCE_ACLK;
+    }
+    else if ((divisor = uart_eusci_baud_divisor(CS_getSMCLK(), baud_rate))) {
+        *clock_source = EUSCI_A_UART_CLOCKSOURCE_SMCLK;
+    }
+    return divisor;
+}
+
 bool uart_open(eusci_t on, uart_baud_rate_t baud_rate, uart_t * out) {
     EUSCI_A_UART_initParam param = {0};
 
     assert(on < EUSCI_count);
-#ifdef EUSCI_B0_BASE
-    assert(on < EUSCI_B0);
-#endif
-
-    // XXX: Assumes the clock source is running at 32.768 Khz
-    // In low frequency mode, the source is the ACLK
-    // In high frequency mode, the source is the SMCLK
-    // Computed using
-    // http://software-dl.ti.com/msp430/msp430_public_sw/mcu/msp430/MSP430BaudRateConverter/index.html
-    switch (baud_rate) {
-        case BAUD_9600:
-            param.clockPrescalar = 3;
-            param.firstModReg = 0;
-            param.secondModReg = 146;
-            param.overSampling = 0;
-            break;
-        case BAUD_115200:
-            assert(false);
-        default:
-            assert(false);
+    assert(on < UART_CHANNEL_COUNT);
+
+    uint16_t clock_source;
+    const uart_baud_divisor_t * divisor = uart_select_divisor(baud_rate, &clock_source);
+    if (!divisor) {
+        return false;
     }
 
-    param.selectClockSource = EUSCI_A_UART_CLOCKSOURCE_ACLK;
+    param.selectClockSource = clock_source;
+    param.clockPrescalar = divisor->prescaler;
+    param.firstModReg = divisor->first_modulation;
+    param.secondModReg = divisor->second_modulation;
+    param.overSampling = divisor->oversampling ?
+        EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION :
+        EUSCI_A_UART_LOW_FREQUENCY_BAUDRATE_GENERATION;
     param.parity = EUSCI_A_UART_NO_PARITY;
     param.msborLsbFirst = EUSCI_A_UART_LSB_FIRST;
     param.numberofStopBits = EUSCI_A_UART_ONE_STOP_BIT;
     param.uartMode = EUSCI_A_UART_MODE;
 
     uint16_t base_address = BASE_ADDRESSES[on];
+    uart_channel_t * channel = &CHANNELS[on];
 
     EUSCI_A_UART_disable(base_address);
 
+    ring_buffer_init(&channel->rx, channel->rx_storage, UART_RX_BUFFER_SIZE);
+    ring_buffer_init(&channel->tx, channel->tx_storage, UART_TX_BUFFER_SIZE);
+    channel->rx_overruns = 0;
+    channel->rx_fault = false;
+    channel->tx_dma_busy = false;
+    channel->on_complete = NULL;
+    channel->on_receive = NULL;
+    channel->async_wait = NULL;
+    channel->async_wake = NULL;
+
     EUSCI_A_UART_init(base_address, &param);
 
     EUSCI_A_UART_enable(base_address);
     EUSCI_A_UART_resetDormant(base_address);
 
-    // XXX: TODO: rewrite transmit/recieve using interrupts
-    EUSCI_A_UART_enableInterrupt(base_address, EUSCI_A_UART_RECEIVE_INTERRUPT); // Enable interrupt
+    // Reception is always interrupt driven. Transmission is enabled on demand
+    // by uart_write_byte.
+    EUSCI_A_UART_clearInterrupt(base_address, EUSCI_A_UART_RECEIVE_INTERRUPT_FLAG);
+    EUSCI_A_UART_enableInterrupt(base_address, EUSCI_A_UART_RECEIVE_INTERRUPT);
+
+    channel->open = true;
 
     out->eusci = on;
+    out->channel = channel;
 
     return true;
 }
 
+void uart_close(uart_t * out) {
+    if (!out->channel) {
+        return;
+    }
+
+    uint16_t base_address = BASE_ADDRESSES[out->eusci];
+
+    // Let anything already queued go out before shutting down
+    while (out->channel->tx_dma_busy);
+    while (!ring_buffer_is_empty(&out->channel->tx));
+
+    EUSCI_A_UART_disableInterrupt(base_address,
+        EUSCI_A_UART_RECEIVE_INTERRUPT | EUSCI_A_UART_TRANSMIT_INTERRUPT);
+    EUSCI_A_UART_disable(base_address);
+
+    out->channel->open = false;
+    out->channel = NULL;
+}
+
 uart_error_t uart_write_byte(uart_t * channel, uint8_t byte) {
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
     // XXX: TODO: should acquire/check that the current thread has acquired a
     // lock on the EUSCI module
-    EUSCI_A_UART_transmitData(BASE_ADDRESSES[channel->eusci], byte);
+    // Queue behind any asynchronous transfer so the streams never interleave
+    while (channel->channel->tx_dma_busy);
+
+    // Only wait if the ISR is behind by a whole ring
+    while (!ring_buffer_push(&channel->channel->tx, byte));
+
+    // Kicks the ISR immediately if the transmit buffer is already empty
+    EUSCI_A_UART_enableInterrupt(BASE_ADDRESSES[channel->eusci],
+        EUSCI_A_UART_TRANSMIT_INTERRUPT);
 
-    if (read_byte) {
-        for (int i = 0; i < 32; ++i) {
-            P4OUT ^= 1 << 6;
-            __delay_cycles(800000UL);
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_read_byte(uart_t * channel, uint8_t * output) {
+    return uart_read_bytes(channel, output, 1);
+}
+
+uart_error_t uart_read_bytes(uart_t * channel, uint8_t * bytes, size_t n) {
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    uart_channel_t * state = channel->channel;
+    while (n > 0) {
+        if (state->rx_fault) {
+            state->rx_fault = false;
+            return UART_SIGNAL_FAULT;
+        }
+
+        size_t popped = ring_buffer_pop_bytes(&state->rx, bytes, n);
+        bytes += popped;
+        n -= popped;
+    }
+
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_read_bytes_timeout(uart_t * channel, uint8_t * bytes, size_t n, uint16_t timeout_ms, size_t * read) {
+    *read = 0;
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    // Time is counted in polls. The time spent copying bytes out isn't, so
+    // the wait runs slightly long rather than short.
+    uart_channel_t * state = channel->channel;
+    const uint32_t polls = (uint32_t) timeout_ms * (CS_getMCLK() / (1000UL * UART_POLL_CYCLES));
+    uint32_t polls_left = polls;
+    while (*read < n) {
+        if (state->rx_fault) {
+            state->rx_fault = false;
+            return UART_SIGNAL_FAULT;
+        }
+
+        size_t popped = ring_buffer_pop_bytes(&state->rx, bytes + *read, n - *read);
+        if (popped > 0) {
+            *read += popped;
+            polls_left = polls;
+        }
+        else if (polls_left == 0) {
+            return UART_TIMEOUT;
+        }
+        else {
+            --polls_left;
+            __delay_cycles(UART_POLL_CYCLES);
+        }
+    }
+
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_read_available(uart_t * channel, uint8_t * bytes, size_t n, size_t * read) {
+    *read = 0;
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    uart_channel_t * state = channel->channel;
+    if (state->rx_fault) {
+        state->rx_fault = false;
+        return UART_SIGNAL_FAULT;
+    }
+
+    *read = ring_buffer_pop_bytes(&state->rx, bytes, n);
+    return UART_NO_ERROR;
+}
+
+void uart_set_receive_callback(uart_t * channel, uart_receive_ready_t on_receive, void * context) {
+    if (!channel->channel) {
+        return;
+    }
+
+    uart_channel_t * state = channel->channel;
+    uint16_t base_address = BASE_ADDRESSES[channel->eusci];
+
+    // Hold off the ISR while the three fields disagree. A byte that arrives
+    // meanwhile waits in RXBUF.
+    EUSCI_A_UART_disableInterrupt(base_address, EUSCI_A_UART_RECEIVE_INTERRUPT);
+    state->on_receive = on_receive;
+    state->on_receive_context = context;
+    state->receive_owner = channel;
+    EUSCI_A_UART_enableInterrupt(base_address, EUSCI_A_UART_RECEIVE_INTERRUPT);
+}
+
+void uart_set_async_waiter(uart_t * channel, uart_async_wait_t wait, uart_async_wait_t wake, void * context) {
+    if (!channel->channel) {
+        return;
+    }
+
+    uart_channel_t * state = channel->channel;
+
+    // The DMA interrupt reads these, so it mustn't see them half set
+    critical_state_t interrupts = critical_enter();
+    state->async_wait = wait;
+    state->async_wake = wake;
+    state->async_wait_context = context;
+    state->wait_owner = channel;
+    critical_exit(interrupts);
+}
+
+bool uart_baud_rate_supported(uart_t * channel, uart_baud_rate_t baud_rate) {
+    uint16_t clock_source;
+    return uart_select_divisor(baud_rate, &clock_source) != NULL;
+}
+
+uart_error_t uart_set_baud_rate(uart_t * channel, uart_baud_rate_t baud_rate) {
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    uint16_t clock_source;
+    const uart_baud_divisor_t * divisor = uart_select_divisor(baud_rate, &clock_source);
+    if (!divisor) {
+        return UART_UNSUPPORTED;
+    }
+
+    uart_channel_t * state = channel->channel;
+    uint16_t base_address = BASE_ADDRESSES[channel->eusci];
+
+    // Everything queued goes out at the old rate, and the line has to be
+    // idle in both directions so no byte is cut in half
+    while (state->tx_dma_busy);
+    while (!ring_buffer_is_empty(&state->tx));
+    while (HWREG16(base_address + OFS_UCAxSTATW) & UCBUSY);
+
+    // Holding the block in reset clears its interrupt enables. The rings
+    // are left alone, so bytes received before the switch are still there.
+    HWREG16(base_address + OFS_UCAxCTLW0) |= UCSWRST;
+    HWREG16(base_address + OFS_UCAxCTLW0) =
+        (HWREG16(base_address + OFS_UCAxCTLW0) & ~UCSSEL_3) | clock_source;
+    HWREG16(base_address + OFS_UCAxBRW) = divisor->prescaler;
+    HWREG16(base_address + OFS_UCAxMCTLW) =
+        ((uint16_t)divisor->second_modulation << 8) |
+        ((uint16_t)divisor->first_modulation << 4) |
+        (divisor->oversampling ? UCOS16 : 0);
+    HWREG16(base_address + OFS_UCAxCTLW0) &= ~UCSWRST;
+    EUSCI_A_UART_enableInterrupt(base_address, EUSCI_A_UART_RECEIVE_INTERRUPT);
+
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_write_bytes_async(uart_t * channel, const uint8_t * bytes, size_t n,
+        uart_write_complete_t on_complete, void * context) {
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    uart_channel_t * state = channel->channel;
+    if (state->tx_dma_busy) {
+        return UART_BUSY;
+    }
+
+    assert(n <= 0xFFFF);
+
+    uint16_t base_address = BASE_ADDRESSES[channel->eusci];
+    const uart_dma_t * dma = &DMA_CHANNELS[channel->eusci];
+
+    // The ISR owns TXBUF until the ring has drained and it has turned the
+    // transmit interrupt back off
+    while (!ring_buffer_is_empty(&state->tx));
+    while (HWREG16(base_address + OFS_UCAxIE) & UCTXIE);
+
+    if (n <= 1) {
+        if (n == 1) {
+            EUSCI_A_UART_transmitData(base_address, bytes[0]);
+        }
+        if (on_complete) {
+            on_complete(channel, UART_NO_ERROR, context);
+        }
+        return UART_NO_ERROR;
+    }
+
+    state->on_complete = on_complete;
+    state->on_complete_context = context;
+    state->async_owner = channel;
+    state->tx_dma_busy = true;
+
+    // UCTXIFG is already high while the transmitter is idle, so the DMA would
+    // never see a rising edge. Instead the DMA moves bytes 1..n-1 and the first
+    // byte is written by hand below; each time TXBUF empties the flag rises
+    // and triggers the next transfer.
+    DMA_initParam param = {0};
+    param.channelSelect = dma->channel;
+    param.transferModeSelect = DMA_TRANSFER_SINGLE;
+    param.transferSize = (uint16_t)(n - 1);
+    param.triggerSourceSelect = dma->trigger;
+    param.transferUnitSelect = DMA_SIZE_SRCBYTE_DSTBYTE;
+    param.triggerTypeSelect = DMA_TRIGGER_RISINGEDGE;
+    DMA_init(&param);
+
+    DMA_setSrcAddress(dma->channel, (uint32_t)(uintptr_t)(bytes + 1),
+        DMA_DIRECTION_INCREMENT);
+    DMA_setDstAddress(dma->channel,
+        EUSCI_A_UART_getTransmitBufferAddress(base_address),
+        DMA_DIRECTION_UNCHANGED);
+
+    DMA_clearInterrupt(dma->channel);
+    DMA_enableInterrupt(dma->channel);
+    DMA_enableTransfers(dma->channel);
+
+    EUSCI_A_UART_transmitData(base_address, bytes[0]);
+
+    return UART_NO_ERROR;
+}
+
+bool uart_write_async_busy(uart_t * channel) {
+    return channel->channel && channel->channel->tx_dma_busy;
+}
+
+uart_error_t uart_wait_async(uart_t * channel) {
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    uart_channel_t * state = channel->channel;
+    uint8_t dma_channel = DMA_CHANNELS[channel->eusci].channel;
+
+    critical_state_t interrupts = critical_enter();
+    while (state->tx_dma_busy) {
+        if (!(interrupts & GIE)) {
+            // The caller masked interrupts, so the DMA interrupt can't run.
+            // The DMA still moves the bytes, so finish the write here once it
+            // has.
+            if (DMA_getInterruptStatus(dma_channel) == DMA_INT_ACTIVE) {
+                DMA_clearInterrupt(dma_channel);
+                uart_handle_dma_complete(channel->eusci);
+            }
+        }
+        else if (state->async_wait) {
+            critical_exit(interrupts);
+            state->async_wait(state->wait_owner, state->async_wait_context);
+            interrupts = critical_enter();
+        }
+        else {
+            // Interrupts stay off between the check and the sleep so the
+            // completion can't slip in between them. Entering LPM0 turns
+            // them on atomically.
+            __bis_SR_register(LPM0_bits | GIE);
+            __disable_interrupt();
         }
-        read_byte = 0;
     }
+    critical_exit(interrupts);
 
     return UART_NO_ERROR;
 }
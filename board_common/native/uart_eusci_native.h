@@ -2,6 +2,7 @@
 #define _BOARD_COMMON_NATIVE_UART_H_
 
 #include "eusci_native.h"
+#include "uart_channel_native.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,6 +13,10 @@ typedef struct uart {
      * Which EUSCI module this UART is connected to
      */
     eusci_t eusci;
+    /**
+     * The buffers for this EUSCI module, or NULL if the channel is closed
+     */
+    uart_channel_t * channel;
 } uart_t;
 
 /**
@@ -20,10 +25,35 @@ typedef struct uart {
  * @param eusci The EUSCI channel to use
  * @param baud_rate The baud rate at which we will run
  * @param out The UART structure to fill
- *
+ * @return False if neither ACLK nor SMCLK runs at a rate in
+ *         UART_CLOCK_LIST that can generate the baud rate
  */
 bool uart_open(eusci_t eusci, uart_baud_rate_t baud_rate, uart_t * out);
 
+/**
+ * Set the callback run from the receive interrupt when the receive ring
+ * starts to fill, so a task can block between reads instead of polling.
+ * Replaces any callback set before. Opening the channel clears it.
+ *
+ * @param channel The channel to watch
+ * @param on_receive The callback, or NULL to stop calling one
+ * @param context Passed through to on_receive
+ */
+void uart_set_receive_callback(uart_t * channel, uart_receive_ready_t on_receive, void * context);
+
+/**
+ * Set the callbacks uart_wait_async blocks and is woken with, so a task can
+ * wait for an asynchronous write under a scheduler. Without them it sleeps
+ * in LPM0. Replaces any callbacks set before. Opening the channel clears
+ * them.
+ *
+ * @param channel The channel to wait on
+ * @param wait Blocks the caller until wake runs, or NULL to use LPM0
+ * @param wake Wakes the caller from the interrupt that finishes the write
+ * @param context Passed through to wait and wake
+ */
+void uart_set_async_waiter(uart_t * channel, uart_async_wait_t wait, uart_async_wait_t wake, void * context);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,25 +1,638 @@
-#include "uart_usci_native.h"
+#include "uart.h"
+#include "uart_baud.h"
+#include "critical.h"
 
 #include <assert.h>
 
-bool uart_open(usci_t on, unsigned int baud_rate, uart_t * out) {
-    USCI_A_UART_initParam param;
+static uint16_t BASE_ADDRESSES[USCI_count] = {
+#ifdef USCI_A0_BASE
+    USCI_A0_BASE,
+#endif
+#ifdef USCI_A1_BASE
+    USCI_A1_BASE,
+#endif
+#ifdef USCI_A2_BASE
+    USCI_A2_BASE,
+#endif
+#ifdef USCI_A3_BASE
+    USCI_A3_BASE,
+#endif
+#ifdef USCI_B0_BASE
+    USCI_B0_BASE,
+#endif
+#ifdef USCI_B1_BASE
+    USCI_B1_BASE,
+#endif
+#ifdef USCI_B2_BASE
+    USCI_B2_BASE,
+#endif
+#ifdef USCI_B3_BASE
+    USCI_B3_BASE,
+#endif
+};
 
-    assert(on < USCI_count);
+// Only the A blocks can act as UARTs, and they are always enumerated first
 #ifdef USCI_B0_BASE
-    assert(on < USCI_B0);
+#   define UART_CHANNEL_COUNT USCI_B0
+#else
+#   define UART_CHANNEL_COUNT USCI_count
+#endif
+
+/// Ring buffers and status for each of the UART capable blocks
+static uart_channel_t CHANNELS[UART_CHANNEL_COUNT];
+
+/// Marks a block that has no DMA trigger for its transmit flag
+#define UART_NO_DMA 0xFF
+
+/**
+ * The DMA channel and trigger used for asynchronous transmission on each
+ * UART capable block. Trigger numbers follow the MSP430F543xA data sheet,
+ * which only routes UCA0TXIFG and UCA1TXIFG to the DMA controller. UCA2 and
+ * UCA3 fall back to sending the buffer from the transmit ISR.
+ */
+typedef struct uart_dma {
+    uint8_t channel;
+    uint8_t trigger;
+} uart_dma_t;
+
+static const uart_dma_t DMA_CHANNELS[UART_CHANNEL_COUNT] = {
+#ifdef USCI_A0_BASE
+    { DMA_CHANNEL_0, DMA_TRIGGERSOURCE_17 },
+#endif
+#ifdef USCI_A1_BASE
+    { DMA_CHANNEL_1, DMA_TRIGGERSOURCE_21 },
+#endif
+#ifdef USCI_A2_BASE
+    { UART_NO_DMA, 0 },
+#endif
+#ifdef USCI_A3_BASE
+    { UART_NO_DMA, 0 },
+#endif
+};
+
+/**
+ * Report a finished asynchronous write. Called from interrupt context.
+ *
+ * @param channel The channel whose transfer finished
+ */
+static inline void uart_finish_async(uart_channel_t * channel) {
+    channel->tx_dma_busy = false;
+
+    if (channel->on_complete) {
+        channel->on_complete(channel->async_owner, UART_NO_ERROR,
+            channel->on_complete_context);
+    }
+}
+
+/**
+ * Wake whoever is blocked in uart_wait_async. Must be the last thing the
+ * interrupt does.
+ *
+ * @param channel The channel whose transfer finished
+ */
+static inline void uart_wake_async(uart_channel_t * channel) {
+    if (channel->async_wake) {
+        channel->async_wake(channel->wait_owner, channel->async_wait_context);
+    }
+}
+
+/**
+ * Send the next byte of an asynchronous write on a block without DMA
+ *
+ * @param base_address The block's registers
+ * @param channel The channel writing
+ *
+ * @return True if that was the last byte
+ */
+static inline bool uart_send_async_byte(uint16_t base_address, uart_channel_t * channel) {
+    USCI_A_UART_transmitData(base_address, *channel->async_bytes++);
+    if (--channel->async_remaining > 0) {
+        return false;
+    }
+    USCI_A_UART_disableInterrupt(base_address, USCI_A_UART_TRANSMIT_INTERRUPT);
+    uart_finish_async(channel);
+    return true;
+}
+
+/******************************************************************************\
+ *  Interrupt handlers                                                        *
+\******************************************************************************/
+/**
+ * Shared body of the USCI A interrupt handlers. Received bytes are pushed in
+ * to the channel's receive ring and the transmit ring is drained one byte per
+ * UCTXIFG. The transmit interrupt is disabled once the ring runs dry, and
+ * re-enabled by the next write.
+ *
+ * @param usci The block that raised the interrupt
+ */
+static inline void uart_handle_interrupt(usci_t usci) {
+    uint16_t base_address = BASE_ADDRESSES[usci];
+    uart_channel_t * channel = &CHANNELS[usci];
+    uint8_t byte;
+
+    switch (__even_in_range(HWREG16(base_address + OFS_UCAxIV), USCI_UCTXIFG)) {
+        case USCI_NONE: break;
+        case USCI_UCRXIFG: {
+            // The error flags are cleared by reading the receive buffer, so
+            // sample them first
+            bool has_error = USCI_A_UART_queryStatusFlags(base_address,
+                USCI_A_UART_RECEIVE_ERROR);
+            byte = USCI_A_UART_receiveData(base_address);
+            if (has_error) {
+                channel->rx_fault = true;
+            }
+            else if (!ring_buffer_push(&channel->rx, byte)) {
+                channel->rx_overruns++;
+                channel->rx_fault = true;
+            }
+            else {
+                // Byte stored
+            }
+            // Last, so the callback may switch tasks on the way out
+            if (channel->on_receive &&
+                    ring_buffer_size(&channel->rx) >= UART_RX_WAKE_LEVEL) {
+                channel->on_receive(channel->receive_owner,
+                    channel->on_receive_context);
+            }
+            break;
+        }
+        case USCI_UCTXIFG:
+            if (channel->async_remaining > 0) {
+                // An asynchronous write on a block without DMA. Waking the
+                // waiter is last, so it may switch tasks on the way out.
+                if (uart_send_async_byte(base_address, channel)) {
+                    uart_wake_async(channel);
+                }
+            }
+            else if (ring_buffer_pop(&channel->tx, &byte)) {
+                USCI_A_UART_transmitData(base_address, byte);
+            }
+            else {
+                USCI_A_UART_disableInterrupt(base_address,
+                    USCI_A_UART_TRANSMIT_INTERRUPT);
+            }
+            break;
+        default: break;
+    }
+}
+
+#ifdef USCI_A0_BASE
+__attribute__((interrupt(USCI_A0_VECTOR)))
+void USCI_A0_ISR(void) {
+    uart_handle_interrupt(USCI_A0);
+}
 #endif
 
-    // XXX: TODO: finish the implementation of this function
-    assert(false);
+#ifdef USCI_A1_BASE
+__attribute__((interrupt(USCI_A1_VECTOR)))
+void USCI_A1_ISR(void) {
+    uart_handle_interrupt(USCI_A1);
 }
+#endif
+
+#ifdef USCI_A2_BASE
+__attribute__((interrupt(USCI_A2_VECTOR)))
+void USCI_A2_ISR(void) {
+    // A2 and A3 finish asynchronous writes here rather than in the DMA ISR,
+    // so they wake anyone sleeping in uart_wait_async. This goes first so a
+    // callback can be the last thing the interrupt does.
+    __bic_SR_register_on_exit(LPM0_bits);
+    uart_handle_interrupt(USCI_A2);
+}
+#endif
+
+#ifdef USCI_A3_BASE
+__attribute__((interrupt(USCI_A3_VECTOR)))
+void USCI_A3_ISR(void) {
+    __bic_SR_register_on_exit(LPM0_bits);
+    uart_handle_interrupt(USCI_A3);
+}
+#endif
+
+__attribute__((interrupt(DMA_VECTOR)))
+void DMA_ISR(void) {
+    uint16_t vector = __even_in_range(DMAIV, 16);
 
-void uart_write_byte(uart_t * out, uint8_t byte) {
-    // XXX: TODO: this function
-    assert(false);
+    // Wake anyone sleeping in uart_wait_async. This goes first so the wake
+    // callback can be the last thing the interrupt does.
+    __bic_SR_register_on_exit(LPM0_bits);
+
+    // DMAIV reports channel n as 2 * (n + 1), and DMA_CHANNEL_n is n << 4.
+    // Reading it clears one channel's flag, so one channel is handled per
+    // interrupt.
+    for (usci_t usci = 0; usci < UART_CHANNEL_COUNT; ++usci) {
+        uint8_t dma_channel = DMA_CHANNELS[usci].channel;
+        if (dma_channel == UART_NO_DMA) {
+            continue;
+        }
+        uint16_t channel_vector = ((dma_channel >> 4) + 1) << 1;
+        if (vector == channel_vector) {
+            DMA_disableInterrupt(dma_channel);
+            uart_finish_async(&CHANNELS[usci]);
+            uart_wake_async(&CHANNELS[usci]);
+            break;
+        }
+    }
+}
+
+/******************************************************************************\
+ *  UART interface implementation                                             *
+\******************************************************************************/
+/**
+ * Pick the clock and divisor for a baud rate. ACLK is preferred so the UART
+ * keeps running in LPM3, falling back to SMCLK for rates the 32 kHz clock
+ * can't reach.
+ *
+ * @param baud_rate The baud rate to generate
+ * @param clock_source Set to the USCI_A_UART_CLOCKSOURCE_* to use
+ *
+ * @return The divisor, or NULL if neither clock can generate the rate
+ */
+static const uart_baud_divisor_t * uart_select_divisor(uart_baud_rate_t baud_rate,
+                                                       uint16_t * clock_source) {
+    const uart_baud_divisor_t * divisor;
+
+    if ((divisor = uart_usci_baud_divisor(UCS_getACLK(), baud_rate))) {
+        *clock_source = USCI_A_UART_CLOCKSOURCE_ACLK;
+    }
+    else if ((divisor = uart_usci_baud_divisor(UCS_getSMCLK(), baud_rate))) {
+        *clock_source = USCI_A_UART_CLOCKSOURCE_SMCLK;
+    }
+    return divisor;
+}
+
+bool uart_open(usci_t on, uart_baud_rate_t baud_rate, uart_t * out) {
+    USCI_A_UART_initParam param = {0};
+
+    assert(on < USCI_count);
+    assert(on < UART_CHANNEL_COUNT);
+
+    uint16_t clock_source;
+    const uart_baud_divisor_t * divisor = uart_select_divisor(baud_rate, &clock_source);
+    if (!divisor) {
+        return false;
+    }
+
+    param.selectClockSource = clock_source;
+    param.clockPrescalar = divisor->prescaler;
+    param.firstModReg = divisor->first_modulation;
+    param.secondModReg = divisor->second_modulation;
+    param.overSampling = divisor->oversampling ?
+        USCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION :
+        USCI_A_UART_LOW_FREQUENCY_BAUDRATE_GENERATION;
+
+    param.parity = USCI_A_UART_NO_PARITY;
+    param.msborLsbFirst = USCI_A_UART_LSB_FIRST;
+    param.numberofStopBits = USCI_A_UART_ONE_STOP_BIT;
+    param.uartMode = USCI_A_UART_MODE;
+
+    uint16_t base_address = BASE_ADDRESSES[on];
+    uart_channel_t * channel = &CHANNELS[on];
+
+    USCI_A_UART_disable(base_address);
+
+    ring_buffer_init(&channel->rx, channel->rx_storage, UART_RX_BUFFER_SIZE);
+    ring_buffer_init(&channel->tx, channel->tx_storage, UART_TX_BUFFER_SIZE);
+    channel->rx_overruns = 0;
+    channel->rx_fault = false;
+    channel->tx_dma_busy = false;
+    channel->on_complete = NULL;
+    channel->on_receive = NULL;
+    channel->async_wait = NULL;
+    channel->async_wake = NULL;
+    channel->async_bytes = NULL;
+    channel->async_remaining = 0;
+
+    if (!USCI_A_UART_init(base_address, &param)) {
+        return false;
+    }
+
+    USCI_A_UART_enable(base_address);
+    USCI_A_UART_resetDormant(base_address);
+
+    // Reception is always interrupt driven. Transmission is enabled on demand
+    // by uart_write_byte. Enabling the block clears the interrupt enables, so
+    // this has to come after USCI_A_UART_enable.
+    USCI_A_UART_clearInterrupt(base_address, USCI_A_UART_RECEIVE_INTERRUPT_FLAG);
+    USCI_A_UART_enableInterrupt(base_address, USCI_A_UART_RECEIVE_INTERRUPT);
+
+    channel->open = true;
+
+    out->usci = on;
+    out->channel = channel;
+
+    return true;
 }
 
 void uart_close(uart_t * out) {
-    // XXX: TODO: this function
-    assert(false);
+    if (!out->channel) {
+        return;
+    }
+
+    uint16_t base_address = BASE_ADDRESSES[out->usci];
+
+    // Let anything already queued go out before shutting down
+    while (out->channel->tx_dma_busy);
+    while (!ring_buffer_is_empty(&out->channel->tx));
+
+    USCI_A_UART_disableInterrupt(base_address,
+        USCI_A_UART_RECEIVE_INTERRUPT | USCI_A_UART_TRANSMIT_INTERRUPT);
+    USCI_A_UART_disable(base_address);
+
+    out->channel->open = false;
+    out->channel = NULL;
+}
+
+uart_error_t uart_write_byte(uart_t * channel, uint8_t byte) {
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    // XXX: TODO: should acquire/check that the current thread has acquired a
+    // lock on the USCI module
+    // Queue behind any asynchronous transfer so the streams never interleave
+    while (channel->channel->tx_dma_busy);
+
+    // Only wait if the ISR is behind by a whole ring
+    while (!ring_buffer_push(&channel->channel->tx, byte));
+
+    // Kicks the ISR immediately if the transmit buffer is already empty
+    USCI_A_UART_enableInterrupt(BASE_ADDRESSES[channel->usci],
+        USCI_A_UART_TRANSMIT_INTERRUPT);
+
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_read_byte(uart_t * channel, uint8_t * output) {
+    return uart_read_bytes(channel, output, 1);
+}
+
+uart_error_t uart_read_bytes(uart_t * channel, uint8_t * bytes, size_t n) {
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    uart_channel_t * state = channel->channel;
+    while (n > 0) {
+        if (state->rx_fault) {
+            state->rx_fault = false;
+            return UART_SIGNAL_FAULT;
+        }
+
+        size_t popped = ring_buffer_pop_bytes(&state->rx, bytes, n);
+        bytes += popped;
+        n -= popped;
+    }
+
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_read_bytes_timeout(uart_t * channel, uint8_t * bytes, size_t n, uint16_t timeout_ms, size_t * read) {
+    *read = 0;
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    // Time is counted in polls. The time spent copying bytes out isn't, so
+    // the wait runs slightly long rather than short.
+    uart_channel_t * state = channel->channel;
+    const uint32_t polls = (uint32_t) timeout_ms * (UCS_getMCLK() / (1000UL * UART_POLL_CYCLES));
+    uint32_t polls_left = polls;
+    while (*read < n) {
+        if (state->rx_fault) {
+            state->rx_fault = false;
+            return UART_SIGNAL_FAULT;
+        }
+
+        size_t popped = ring_buffer_pop_bytes(&state->rx, bytes + *read, n - *read);
+        if (popped > 0) {
+            *read += popped;
+            polls_left = polls;
+        }
+        else if (polls_left == 0) {
+            return UART_TIMEOUT;
+        }
+        else {
+            --polls_left;
+            __delay_cycles(UART_POLL_CYCLES);
+        }
+    }
+
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_read_available(uart_t * channel, uint8_t * bytes, size_t n, size_t * read) {
+    *read = 0;
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    uart_channel_t * state = channel->channel;
+    if (state->rx_fault) {
+        state->rx_fault = false;
+        return UART_SIGNAL_FAULT;
+    }
+
+    *read = ring_buffer_pop_bytes(&state->rx, bytes, n);
+    return UART_NO_ERROR;
+}
+
+void uart_set_receive_callback(uart_t * channel, uart_receive_ready_t on_receive, void * context) {
+    if (!channel->channel) {
+        return;
+    }
+
+    uart_channel_t * state = channel->channel;
+    uint16_t base_address = BASE_ADDRESSES[channel->usci];
+
+    // Hold off the ISR while the three fields disagree. A byte that arrives
+    // meanwhile waits in RXBUF.
+    USCI_A_UART_disableInterrupt(base_address, USCI_A_UART_RECEIVE_INTERRUPT);
+    state->on_receive = on_receive;
+    state->on_receive_context = context;
+    state->receive_owner = channel;
+    USCI_A_UART_enableInterrupt(base_address, USCI_A_UART_RECEIVE_INTERRUPT);
+}
+
+void uart_set_async_waiter(uart_t * channel, uart_async_wait_t wait, uart_async_wait_t wake, void * context) {
+    if (!channel->channel) {
+        return;
+    }
+
+    uart_channel_t * state = channel->channel;
+
+    // The completion interrupts read these, so they mustn't see them half
+    // set
+    critical_state_t interrupts = critical_enter();
+    state->async_wait = wait;
+    state->async_wake = wake;
+    state->async_wait_context = context;
+    state->wait_owner = channel;
+    critical_exit(interrupts);
+}
+
+bool uart_baud_rate_supported(uart_t * channel, uart_baud_rate_t baud_rate) {
+    uint16_t clock_source;
+    return uart_select_divisor(baud_rate, &clock_source) != NULL;
+}
+
+uart_error_t uart_set_baud_rate(uart_t * channel, uart_baud_rate_t baud_rate) {
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    uint16_t clock_source;
+    const uart_baud_divisor_t * divisor = uart_select_divisor(baud_rate, &clock_source);
+    if (!divisor) {
+        return UART_UNSUPPORTED;
+    }
+
+    uart_channel_t * state = channel->channel;
+    uint16_t base_address = BASE_ADDRESSES[channel->usci];
+
+    // Everything queued goes out at the old rate, and the line has to be
+    // idle in both directions so no byte is cut in half
+    while (state->tx_dma_busy);
+    while (!ring_buffer_is_empty(&state->tx));
+    while (HWREG8(base_address + OFS_UCAxSTAT) & UCBUSY);
+
+    // Holding the block in reset clears its interrupt enables. The rings
+    // are left alone, so bytes received before the switch are still there.
+    HWREG8(base_address + OFS_UCAxCTL1) |= UCSWRST;
+    HWREG8(base_address + OFS_UCAxCTL1) =
+        (HWREG8(base_address + OFS_UCAxCTL1) & ~UCSSEL_3) | clock_source;
+    HWREG16(base_address + OFS_UCAxBRW) = divisor->prescaler;
+    HWREG8(base_address + OFS_UCAxMCTL) =
+        (divisor->first_modulation << 4) |
+        (divisor->second_modulation << 1) |
+        (divisor->oversampling ? UCOS16 : 0);
+    HWREG8(base_address + OFS_UCAxCTL1) &= ~UCSWRST;
+    USCI_A_UART_enableInterrupt(base_address, USCI_A_UART_RECEIVE_INTERRUPT);
+
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_write_bytes_async(uart_t * channel, const uint8_t * bytes, size_t n,
+        uart_write_complete_t on_complete, void * context) {
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    uart_channel_t * state = channel->channel;
+    if (state->tx_dma_busy) {
+        return UART_BUSY;
+    }
+
+    assert(n <= 0xFFFF);
+
+    uint16_t base_address = BASE_ADDRESSES[channel->usci];
+    const uart_dma_t * dma = &DMA_CHANNELS[channel->usci];
+
+    // The ISR owns TXBUF until the ring has drained and it has turned the
+    // transmit interrupt back off
+    while (!ring_buffer_is_empty(&state->tx));
+    while (HWREG8(base_address + OFS_UCAxIE) & UCTXIE);
+
+    if (n <= 1) {
+        if (n == 1) {
+            USCI_A_UART_transmitData(base_address, bytes[0]);
+        }
+        if (on_complete) {
+            on_complete(channel, UART_NO_ERROR, context);
+        }
+        return UART_NO_ERROR;
+    }
+
+    state->on_complete = on_complete;
+    state->on_complete_context = context;
+    state->async_owner = channel;
+    state->tx_dma_busy = true;
+
+    if (dma->channel == UART_NO_DMA) {
+        // Let the transmit ISR walk the buffer. UCTXIFG is already set while
+        // the transmitter is idle, so enabling the interrupt starts it.
+        state->async_bytes = bytes;
+        state->async_remaining = (uint16_t)n;
+        USCI_A_UART_enableInterrupt(base_address, USCI_A_UART_TRANSMIT_INTERRUPT);
+        return UART_NO_ERROR;
+    }
+
+    // UCTXIFG is already high while the transmitter is idle, so the DMA would
+    // never see a rising edge. Instead the DMA moves bytes 1..n-1 and the first
+    // byte is written by hand below; each time TXBUF empties the flag rises
+    // and triggers the next transfer.
+    DMA_initParam param = {0};
+    param.channelSelect = dma->channel;
+    param.transferModeSelect = DMA_TRANSFER_SINGLE;
+    param.transferSize = (uint16_t)(n - 1);
+    param.triggerSourceSelect = dma->trigger;
+    param.transferUnitSelect = DMA_SIZE_SRCBYTE_DSTBYTE;
+    param.triggerTypeSelect = DMA_TRIGGER_RISINGEDGE;
+    DMA_init(&param);
+
+    DMA_setSrcAddress(dma->channel, (uint32_t)(uintptr_t)(bytes + 1),
+        DMA_DIRECTION_INCREMENT);
+    DMA_setDstAddress(dma->channel,
+        USCI_A_UART_getTransmitBufferAddressForDMA(base_address),
+        DMA_DIRECTION_UNCHANGED);
+
+    DMA_clearInterrupt(dma->channel);
+    DMA_enableInterrupt(dma->channel);
+    DMA_enableTransfers(dma->channel);
+
+    USCI_A_UART_transmitData(base_address, bytes[0]);
+
+    return UART_NO_ERROR;
+}
+
+bool uart_write_async_busy(uart_t * channel) {
+    return channel->channel && channel->channel->tx_dma_busy;
+}
+
+uart_error_t uart_wait_async(uart_t * channel) {
+    if (!channel->channel || !channel->channel->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+
+    uart_channel_t * state = channel->channel;
+    uint16_t base_address = BASE_ADDRESSES[channel->usci];
+    uint8_t dma_channel = DMA_CHANNELS[channel->usci].channel;
+
+    critical_state_t interrupts = critical_enter();
+    while (state->tx_dma_busy) {
+        if (!(interrupts & GIE)) {
+            // The caller masked interrupts, so the completion interrupt can't
+            // run. Finish the write here instead: the DMA still moves the
+            // bytes, and a block without one is fed a byte at a time.
+            if (dma_channel != UART_NO_DMA) {
+                if (DMA_getInterruptStatus(dma_channel) == DMA_INT_ACTIVE) {
+                    DMA_clearInterrupt(dma_channel);
+                    DMA_disableInterrupt(dma_channel);
+                    uart_finish_async(state);
+                }
+            }
+            else if (USCI_A_UART_getInterruptStatus(base_address,
+                    USCI_A_UART_TRANSMIT_INTERRUPT_FLAG)) {
+                uart_send_async_byte(base_address, state);
+            }
+            else {
+                // Still sending the last byte
+            }
+        }
+        else if (state->async_wait) {
+            critical_exit(interrupts);
+            state->async_wait(state->wait_owner, state->async_wait_context);
+            interrupts = critical_enter();
+        }
+        else {
+            // Interrupts stay off between the check and the sleep so the
+            // completion can't slip in between them. Entering LPM0 turns
+            // them on atomically.
+            __bis_SR_register(LPM0_bits | GIE);
+            __disable_interrupt();
+        }
+    }
+    critical_exit(interrupts);
+
+    return UART_NO_ERROR;
 }
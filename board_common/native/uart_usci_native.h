@@ -2,6 +2,7 @@
 #define _BOARD_COMMON_USCI_UART_H_
 
 #include "usci_native.h"
+#include "uart_channel_native.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,17 +13,53 @@ typedef struct uart {
      * The USCI module we are going to use
      */
     usci_t usci;
+    /**
+     * The buffers for this USCI module, or NULL if the channel is closed
+     */
+    uart_channel_t * channel;
 } uart_t;
 
 /**
  * Open a connection to a UART channel
  *
- * @param usci The USCI channel to use
+ * The divisors come from the tables in uart_baud.h, so the block runs from
+ * ACLK or SMCLK only when the UCS reports one of them at exactly a rate in
+ * UART_CLOCK_LIST. ACLK is tried first. With the F5xx power-up clocks, the
+ * 32.768 kHz ACLK gives 9600 baud and the 1.048576 MHz SMCLK gives every
+ * faster rate. An FLL tuned to a rate outside the list needs an entry added
+ * to UART_CLOCK_LIST first.
+ *
+ * @param usci The USCI channel to use. Only the A blocks can act as UARTs.
  * @param baud_rate The baud rate at which we will run
  * @param out The UART structure to fill
+ * @return False if neither ACLK nor SMCLK runs at a rate in
+ *         UART_CLOCK_LIST that can generate the baud rate
+ */
+bool uart_open(usci_t usci, uart_baud_rate_t baud_rate, uart_t * out);
+
+/**
+ * Set the callback run from the receive interrupt when the receive ring
+ * starts to fill, so a task can block between reads instead of polling.
+ * Replaces any callback set before. Opening the channel clears it.
+ *
+ * @param channel The channel to watch
+ * @param on_receive The callback, or NULL to stop calling one
+ * @param context Passed through to on_receive
+ */
+void uart_set_receive_callback(uart_t * channel, uart_receive_ready_t on_receive, void * context);
+
+/**
+ * Set the callbacks uart_wait_async blocks and is woken with, so a task can
+ * wait for an asynchronous write under a scheduler. Without them it sleeps
+ * in LPM0. Replaces any callbacks set before. Opening the channel clears
+ * them.
  *
+ * @param channel The channel to wait on
+ * @param wait Blocks the caller until wake runs, or NULL to use LPM0
+ * @param wake Wakes the caller from the interrupt that finishes the write
+ * @param context Passed through to wait and wake
  */
-bool uart_open(usci_t usci, unsigned int baud_rate, uart_t * out);
+void uart_set_async_waiter(uart_t * channel, uart_async_wait_t wait, uart_async_wait_t wake, void * context);
 
 #ifdef __cplusplus
 }
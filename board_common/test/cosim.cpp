@@ -0,0 +1,160 @@
+#include "cosim.hpp"
+
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+    /// Writes whatever it reads straight back
+    struct echo_board : cosim_board {
+        uart_t uart;
+
+        echo_board() { uart_open(&uart, 9600); }
+        ~echo_board() { uart_close(&uart); }
+
+        void step(uint64_t now_ns) override {
+            uint8_t bytes[16];
+            size_t read;
+            REQUIRE(uart_read_available(&uart, bytes, sizeof(bytes), &read) == UART_NO_ERROR);
+            REQUIRE(uart_write_bytes(&uart, bytes, read) == UART_NO_ERROR);
+            (void) now_ns;
+        }
+
+        uint64_t next_event_ns() const override { return UINT64_MAX; }
+    };
+
+    /// Sends a message at a set time and notes when each byte comes back
+    struct ping_board : cosim_board {
+        uart_t uart;
+        std::vector<uint8_t> message;
+        uint64_t send_ns;
+        bool sent = false;
+        std::vector<uint8_t> received;
+        std::vector<uint64_t> received_ns;
+
+        ping_board(const std::vector<uint8_t> & message, uint64_t send_ns) : message(message), send_ns(send_ns) {
+            uart_open(&uart, 9600);
+        }
+        ~ping_board() { uart_close(&uart); }
+
+        void step(uint64_t now_ns) override {
+            if (!sent && now_ns >= send_ns) {
+                REQUIRE(uart_write_bytes(&uart, message.data(), message.size()) == UART_NO_ERROR);
+                sent = true;
+            }
+            uint8_t byte;
+            size_t read;
+            while (uart_read_available(&uart, &byte, 1, &read) == UART_NO_ERROR && read == 1) {
+                received.push_back(byte);
+                received_ns.push_back(now_ns);
+            }
+        }
+
+        uint64_t next_event_ns() const override { return sent ? UINT64_MAX : send_ns; }
+    };
+}
+
+TEST_CASE("Virtual wires carry bytes one after another", "[cosim]") {
+    virtual_wire wire(1000);
+    const uint8_t bytes[] = { 1, 2, 3 };
+    wire.send(bytes, 3, 500);
+    REQUIRE(wire.next_arrival_ns() == 1500);
+
+    // Queued behind what's already on the wire
+    wire.send(bytes, 1, 600);
+    REQUIRE(wire.receive(2499) == std::vector<uint8_t>({ 1 }));
+    REQUIRE(wire.receive(3500) == std::vector<uint8_t>({ 2, 3 }));
+    REQUIRE(wire.next_arrival_ns() == 4500);
+    REQUIRE(wire.receive(10000) == std::vector<uint8_t>({ 1 }));
+    REQUIRE(wire.next_arrival_ns() == UINT64_MAX);
+    REQUIRE(wire.stats().bytes == 4);
+}
+
+TEST_CASE("Virtual wires inject faults repeatably", "[cosim]") {
+    link_faults faults;
+    faults.drop = 0.1;
+    faults.flip = 0.2;
+    faults.seed = 7;
+    std::vector<uint8_t> bytes(10000, 0x00);
+
+    virtual_wire first(1, faults);
+    first.send(bytes.data(), bytes.size(), 0);
+    std::vector<uint8_t> received = first.receive(UINT64_MAX);
+
+    REQUIRE(first.stats().dropped + received.size() == bytes.size());
+    REQUIRE(first.stats().dropped > 800);
+    REQUIRE(first.stats().dropped < 1200);
+    size_t corrupted = std::count_if(received.begin(), received.end(), [](uint8_t b) { return b != 0; });
+    REQUIRE(corrupted == first.stats().corrupted);
+    REQUIRE(corrupted > 1600);
+    REQUIRE(corrupted < 2000);
+
+    virtual_wire second(1, faults);
+    second.send(bytes.data(), bytes.size(), 0);
+    REQUIRE(second.receive(UINT64_MAX) == received);
+}
+
+TEST_CASE("Co-simulated boards talk over virtual UARTs", "[cosim]") {
+    const std::vector<uint8_t> message = { 'p', 'i', 'n', 'g' };
+    ping_board ping(message, 1000000);
+    echo_board echo;
+    cosim sim;
+    sim.add(&ping);
+    sim.add(&echo);
+    sim.connect(&ping.uart, &echo.uart, 9600);
+    const uint64_t byte_time = sim.wire_to_b(0).byte_time_ns();
+    REQUIRE(byte_time == 10 * 1000000000ull / 9600);
+
+    sim.run_until(2000000);
+    REQUIRE(ping.received.empty());
+    sim.run_until(10000000);
+    REQUIRE(ping.received == message);
+
+    // Each byte is echoed as it arrives, so the last comes back one byte
+    // time after the last went out
+    REQUIRE(ping.received_ns.front() == 1000000 + 2 * byte_time);
+    REQUIRE(ping.received_ns.back() == 1000000 + (message.size() + 1) * byte_time);
+    REQUIRE(sim.now_ns() == 10000000);
+    REQUIRE(sim.wire_to_b(0).stats().bytes == message.size());
+    REQUIRE(sim.wire_to_a(0).stats().bytes == message.size());
+}
+
+TEST_CASE("Co-simulated SPI devices answer the master", "[cosim]") {
+    spi_t spi;
+    spi_open(&spi);
+    std::vector<uint8_t> seen;
+    cosim sim;
+    link_faults faults;
+
+    SECTION("Byte for byte, keeping time") {
+        sim.connect(&spi, [&seen](uint8_t mosi) { seen.push_back(mosi); return (uint8_t) ~mosi; }, 1000000);
+        uint8_t send[] = { 0x01, 0x02 };
+        uint8_t receive[2];
+        REQUIRE(spi_transfer_bytes(&spi, send, receive, 2) == SPI_NO_ERROR);
+        REQUIRE(seen == std::vector<uint8_t>({ 0x01, 0x02 }));
+        REQUIRE(receive[0] == 0xFE);
+        REQUIRE(receive[1] == 0xFD);
+        REQUIRE(spi._impl->busy_ns == 16000);
+    }
+
+    SECTION("Dropped bytes read as an idle line") {
+        faults.drop = 1;
+        sim.connect(&spi, [](uint8_t) { return (uint8_t) 0x00; }, 1000000, faults);
+        uint8_t byte;
+        REQUIRE(spi_receive_byte(&spi, &byte) == SPI_NO_ERROR);
+        REQUIRE(byte == 0xFF);
+        REQUIRE(sim.spi_stats(0).dropped == 1);
+    }
+
+    SECTION("Corrupted bytes have one bit flipped") {
+        faults.flip = 1;
+        sim.connect(&spi, [](uint8_t) { return (uint8_t) 0x00; }, 1000000, faults);
+        uint8_t byte;
+        REQUIRE(spi_receive_byte(&spi, &byte) == SPI_NO_ERROR);
+        REQUIRE(__builtin_popcount(byte) == 1);
+        REQUIRE(sim.spi_stats(0).corrupted == 1);
+    }
+
+    spi_close(&spi);
+}
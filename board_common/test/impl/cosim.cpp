@@ -0,0 +1,136 @@
+#include "cosim.hpp"
+
+#include <algorithm>
+
+namespace {
+    /// Flip or drop a byte as the faults say. False if it's dropped.
+    bool inject_faults(const link_faults & faults, std::mt19937 & rng, uint8_t & byte, link_stats & stats) {
+        ++stats.bytes;
+        if (faults.drop > 0 && std::bernoulli_distribution(faults.drop)(rng)) {
+            ++stats.dropped;
+            return false;
+        }
+        if (faults.flip > 0 && std::bernoulli_distribution(faults.flip)(rng)) {
+            byte ^= 1 << std::uniform_int_distribution<int>(0, 7)(rng);
+            ++stats.corrupted;
+        }
+        return true;
+    }
+
+    /// The same faults, drawn from a different sequence
+    link_faults reseeded(const link_faults & faults, uint32_t offset) {
+        link_faults other = faults;
+        other.seed += offset;
+        return other;
+    }
+}
+
+/******************************************************************************\
+ *  Virtual wires                                                             *
+\******************************************************************************/
+virtual_wire::virtual_wire(uint64_t byte_time_ns, const link_faults & faults) :
+    _byte_time_ns(byte_time_ns), _faults(faults), _rng(faults.seed), _free_ns(0), _stats() {}
+
+void virtual_wire::send(const uint8_t * bytes, size_t n, uint64_t now_ns) {
+    _free_ns = std::max(_free_ns, now_ns);
+    for (size_t i = 0; i < n; ++i) {
+        // A dropped byte still takes its time on the wire
+        _free_ns += _byte_time_ns;
+        uint8_t byte = bytes[i];
+        if (inject_faults(_faults, _rng, byte, _stats)) {
+            _bytes.push_back({ _free_ns, byte });
+        }
+    }
+}
+
+std::vector<uint8_t> virtual_wire::receive(uint64_t now_ns) {
+    std::vector<uint8_t> arrived;
+    while (!_bytes.empty() && _bytes.front().arrival_ns <= now_ns) {
+        arrived.push_back(_bytes.front().byte);
+        _bytes.pop_front();
+    }
+    return arrived;
+}
+
+uint64_t virtual_wire::next_arrival_ns() const {
+    return _bytes.empty() ? UINT64_MAX : _bytes.front().arrival_ns;
+}
+
+/******************************************************************************\
+ *  The simulation                                                            *
+\******************************************************************************/
+cosim::uart_connection::uart_connection(uart_t * a, uart_t * b, uint64_t byte_time_ns, const link_faults & faults) :
+    // Each direction gets its own faults
+    a(a), b(b), a_to_b(byte_time_ns, faults), b_to_a(byte_time_ns, reseeded(faults, 1)),
+    a_sent(a->_impl->output.size()), b_sent(b->_impl->output.size()) {}
+
+cosim::spi_connection::spi_connection(std::function<uint8_t(uint8_t)> slave, const link_faults & faults) :
+    slave(slave), faults(faults), rng(faults.seed), stats() {}
+
+uint8_t cosim::spi_connection::transfer(uint8_t mosi) {
+    uint8_t miso = slave(mosi);
+    return inject_faults(faults, rng, miso, stats) ? miso : 0xFF;
+}
+
+void cosim::add(cosim_board * board) {
+    _boards.push_back(board);
+}
+
+void cosim::connect(uart_t * a, uart_t * b, size_t baud_rate, const link_faults & faults) {
+    // A start bit, 8 data bits and a stop bit
+    _uarts.emplace_back(new uart_connection(a, b, 10 * 1000000000ull / baud_rate, faults));
+}
+
+void cosim::connect(spi_t * master, std::function<uint8_t(uint8_t)> slave, uint32_t clock_rate,
+        const link_faults & faults) {
+    _spis.emplace_back(new spi_connection(slave, faults));
+    spi_connection * connection = _spis.back().get();
+    master->_impl->slave = [connection](uint8_t mosi) { return connection->transfer(mosi); };
+    master->_impl->clock_rate = clock_rate;
+}
+
+void cosim::run_until(uint64_t end_ns) {
+    for (;;) {
+        uint64_t next = next_event_ns();
+        if (next > end_ns) {
+            break;
+        }
+        _now_ns = next;
+        _stepped = true;
+
+        for (auto & c : _uarts) {
+            std::vector<uint8_t> to_b = c->a_to_b.receive(_now_ns);
+            c->b->_impl->push_bytes(to_b.begin(), to_b.end());
+            std::vector<uint8_t> to_a = c->b_to_a.receive(_now_ns);
+            c->a->_impl->push_bytes(to_a.begin(), to_a.end());
+        }
+
+        for (cosim_board * board : _boards) {
+            board->step(_now_ns);
+        }
+
+        for (auto & c : _uarts) {
+            std::vector<uint8_t> & a_output = c->a->_impl->output;
+            c->a_to_b.send(a_output.data() + c->a_sent, a_output.size() - c->a_sent, _now_ns);
+            c->a_sent = a_output.size();
+            std::vector<uint8_t> & b_output = c->b->_impl->output;
+            c->b_to_a.send(b_output.data() + c->b_sent, b_output.size() - c->b_sent, _now_ns);
+            c->b_sent = b_output.size();
+        }
+    }
+    _now_ns = std::max(_now_ns, end_ns);
+}
+
+uint64_t cosim::next_event_ns() const {
+    uint64_t next = UINT64_MAX;
+    for (const cosim_board * board : _boards) {
+        next = std::min(next, board->next_event_ns());
+    }
+    for (const auto & c : _uarts) {
+        next = std::min(next, c->a_to_b.next_arrival_ns());
+        next = std::min(next, c->b_to_a.next_arrival_ns());
+    }
+    // Everything due now has already had its turn
+    uint64_t earliest = _stepped ? _now_ns + 1 : _now_ns;
+    return std::max(next, earliest);
+}
@@ -0,0 +1,164 @@
+#ifndef _TEST_COSIM_HPP_
+#define _TEST_COSIM_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "spi.h"
+#include "uart.h"
+
+/// Faults a virtual link injects, each drawn independently per byte
+struct link_faults {
+    /// The chance a byte never arrives, from 0 to 1
+    double drop;
+    /// The chance a byte arrives with one bit flipped, from 0 to 1
+    double flip;
+    /// Seeds the faults, so runs can be repeated
+    uint32_t seed;
+
+    link_faults() : drop(0), flip(0), seed(1) {}
+};
+
+/// Counters describing what a virtual link has carried
+struct link_stats {
+    /// Bytes sent in to the link
+    uint64_t bytes;
+    /// Bytes the link dropped
+    uint64_t dropped;
+    /// Bytes the link corrupted
+    uint64_t corrupted;
+};
+
+/// One direction of a serial line between two boards. Bytes go out one
+/// after another, each taking a fixed time on the wire, and arrive once
+/// they have crossed it.
+class virtual_wire {
+    public:
+        virtual_wire(uint64_t byte_time_ns, const link_faults & faults = link_faults());
+
+        /// Put bytes on the wire. They start once the wire is free of
+        /// everything sent before them.
+        void send(const uint8_t * bytes, size_t n, uint64_t now_ns);
+
+        /// Take every byte that has arrived by now, oldest first
+        std::vector<uint8_t> receive(uint64_t now_ns);
+
+        /// When the next byte arrives, or UINT64_MAX if the wire is empty
+        uint64_t next_arrival_ns() const;
+
+        /// The time one byte takes on the wire
+        uint64_t byte_time_ns() const { return _byte_time_ns; }
+
+        const link_stats & stats() const { return _stats; }
+
+    private:
+        struct in_flight {
+            uint64_t arrival_ns;
+            uint8_t byte;
+        };
+
+        uint64_t _byte_time_ns;
+        link_faults _faults;
+        std::mt19937 _rng;
+        std::deque<in_flight> _bytes;
+        uint64_t _free_ns;
+        link_stats _stats;
+};
+
+/// A board taking part in a co-simulation. Everything a board does happens
+/// in step, which must never block.
+class cosim_board {
+    public:
+        virtual ~cosim_board() {}
+
+        /// Do whatever is due by now
+        virtual void step(uint64_t now_ns) = 0;
+
+        /// When the board next has something to do of its own accord, or
+        /// UINT64_MAX if it is only waiting on its links
+        virtual uint64_t next_event_ns() const = 0;
+};
+
+/// Runs boards together against one virtual clock.
+///
+/// The boards share a thread and take turns, so a run is deterministic:
+/// the same boards, links and seeds always give the same result, however
+/// loaded the host is. Time jumps from one event to the next, where an
+/// event is a board asking to run or a byte arriving on a link, and every
+/// board steps at each event. Bytes a board writes to a connected mock
+/// UART go on the wire at the time of the step that wrote them.
+class cosim {
+    public:
+        cosim() : _now_ns(0), _stepped(false) {}
+
+        /// Take part in the simulation. The board must outlive it.
+        void add(cosim_board * board);
+
+        /// Wire two mock UARTs together, with a wire each way. Both must
+        /// outlive the simulation.
+        void connect(uart_t * a, uart_t * b, size_t baud_rate, const link_faults & faults = link_faults());
+
+        /// Put a device on a mock SPI bus, with the bus clocked at
+        /// clock_rate. Faults hit the bytes the device shifts back, and a
+        /// dropped byte reads as 0xFF, as if nothing drove the line.
+        void connect(spi_t * master, std::function<uint8_t(uint8_t)> slave, uint32_t clock_rate,
+            const link_faults & faults = link_faults());
+
+        /// Run every event up to and including end_ns
+        void run_until(uint64_t end_ns);
+
+        /// Run for a while from now
+        void run_for(uint64_t ns) { run_until(_now_ns + ns); }
+
+        uint64_t now_ns() const { return _now_ns; }
+
+        /// The wire from a to b of the nth UART connection
+        const virtual_wire & wire_to_b(size_t n) const { return _uarts[n]->a_to_b; }
+
+        /// The wire from b to a of the nth UART connection
+        const virtual_wire & wire_to_a(size_t n) const { return _uarts[n]->b_to_a; }
+
+        /// The faults on the nth SPI bus
+        const link_stats & spi_stats(size_t n) const { return _spis[n]->stats; }
+
+    private:
+        struct uart_connection {
+            uart_t * a;
+            uart_t * b;
+            virtual_wire a_to_b;
+            virtual_wire b_to_a;
+            /// How much of each output has gone on the wire
+            size_t a_sent;
+            size_t b_sent;
+
+            uart_connection(uart_t * a, uart_t * b, uint64_t byte_time_ns, const link_faults & faults);
+        };
+
+        struct spi_connection {
+            std::function<uint8_t(uint8_t)> slave;
+            link_faults faults;
+            std::mt19937 rng;
+            link_stats stats;
+
+            spi_connection(std::function<uint8_t(uint8_t)> slave, const link_faults & faults);
+
+            uint8_t transfer(uint8_t mosi);
+        };
+
+        uint64_t _now_ns;
+        bool _stepped;
+        std::vector<cosim_board *> _boards;
+        std::vector<std::unique_ptr<uart_connection>> _uarts;
+        std::vector<std::unique_ptr<spi_connection>> _spis;
+
+        /// The time of the next event, never before now
+        uint64_t next_event_ns() const;
+};
+
+#endif // _TEST_COSIM_HPP_
@@ -0,0 +1,23 @@
+#include "critical.h"
+
+#include <mutex>
+
+namespace {
+    /// Stands in for the interrupt mask. Recursive so sections can nest.
+    std::recursive_mutex & critical_lock() {
+        static std::recursive_mutex lock;
+        return lock;
+    }
+}
+
+/******************************************************************************\
+ *  Critical section implementation                                           *
+\******************************************************************************/
+critical_state_t critical_enter(void) {
+    critical_lock().lock();
+    return 0;
+}
+
+void critical_exit(critical_state_t) {
+    critical_lock().unlock();
+}
@@ -0,0 +1,87 @@
+#include "dma_test.hpp"
+
+/******************************************************************************\
+ *  mock_dma_engine implementation                                            *
+\******************************************************************************/
+int mock_dma_engine::start(const uint8_t * source, size_t length, sink_t sink, complete_t on_complete) {
+    transfer t = { source, length, sink, on_complete, true };
+
+    for (size_t i = 0; i < _channels.size(); ++i) {
+        if (!_channels[i].active) {
+            _channels[i] = t;
+            return (int)i;
+        }
+    }
+
+    _channels.push_back(t);
+    return (int)(_channels.size() - 1);
+}
+
+bool mock_dma_engine::busy(int channel) const {
+    return channel >= 0 &&
+        (size_t)channel < _channels.size() &&
+        _channels[channel].active;
+}
+
+void mock_dma_engine::cancel(int channel) {
+    if (busy(channel)) {
+        _channels[channel].active = false;
+    }
+}
+
+bool mock_dma_engine::trigger(transfer & t) {
+    if (!t.active) {
+        return false;
+    }
+
+    if (t.remaining > 0) {
+        t.sink(*t.source++);
+        --t.remaining;
+    }
+
+    if (t.remaining == 0) {
+        // Mark idle before the callback so it can start the next transfer,
+        // as a real DMA ISR would
+        t.active = false;
+        if (t.on_complete) {
+            t.on_complete();
+        }
+    }
+
+    return true;
+}
+
+size_t mock_dma_engine::step(size_t triggers) {
+    size_t moved = 0;
+
+    for (size_t n = 0; n < triggers; ++n) {
+        for (size_t i = 0; i < _channels.size(); ++i) {
+            if (trigger(_channels[i])) {
+                ++moved;
+            }
+        }
+    }
+
+    return moved;
+}
+
+void mock_dma_engine::run(int channel) {
+    while (busy(channel)) {
+        trigger(_channels[channel]);
+    }
+}
+
+void mock_dma_engine::run_all() {
+    for (size_t i = 0; i < _channels.size(); ++i) {
+        run((int)i);
+    }
+}
+
+void mock_dma_engine::reset() {
+    _channels.clear();
+}
+
+mock_dma_engine & mock_dma() {
+    static mock_dma_engine engine;
+    return engine;
+}
@@ -0,0 +1,62 @@
+#ifndef _TEST_DMA_HPP_
+#define _TEST_DMA_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+/// A stand-in for the MSP430 DMA controller.
+///
+/// Transfers move one byte per trigger from a source buffer in to a sink,
+/// exactly like a single-transfer DMA channel triggered by UCTXIFG. Nothing
+/// moves until the test triggers the engine, so tests can observe a transfer
+/// while it is in flight and decide exactly when it completes.
+class mock_dma_engine {
+    public:
+        /// Receives each byte the engine moves
+        typedef std::function<void(uint8_t)> sink_t;
+        /// Called once the last byte of a transfer has moved
+        typedef std::function<void()> complete_t;
+
+        /// Start a transfer. Returns the channel it was assigned.
+        int start(const uint8_t * source, size_t length, sink_t sink, complete_t on_complete);
+
+        /// True if the channel has a transfer that has not completed
+        bool busy(int channel) const;
+
+        /// Abandon a transfer without calling its completion
+        void cancel(int channel);
+
+        /// Fire up to `triggers` triggers on every busy channel. Returns the
+        /// number of triggers that landed on a busy channel.
+        size_t step(size_t triggers = 1);
+
+        /// Trigger a single channel until its transfer completes
+        void run(int channel);
+
+        /// Trigger every channel until all transfers complete
+        void run_all();
+
+        /// Drop every channel
+        void reset();
+
+    private:
+        struct transfer {
+            const uint8_t * source;
+            size_t remaining;
+            sink_t sink;
+            complete_t on_complete;
+            bool active;
+        };
+
+        std::vector<transfer> _channels;
+
+        bool trigger(transfer & t);
+};
+
+/// The engine shared by every mock peripheral
+mock_dma_engine & mock_dma();
+
+#endif // _TEST_DMA_HPP_
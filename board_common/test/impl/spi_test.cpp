@@ -14,13 +14,20 @@ spi_error_t spi_transfer_byte(spi_t * channel, uint8_t send_byte, uint8_t * rece
   if (!channel->_impl || !channel->_impl->open) {
     return SPI_CHANNEL_CLOSED;
   }
-  *receive_byte = send_byte + 1;
-  //This is just an example SPI device where the returned value is
-  //always one greater than the given value. This doesn't actually
-  //make sense since SPI is sychrnonous, but whatever. It's an
-  //exmaple.
+  if (channel->_impl->slave) {
+    *receive_byte = channel->_impl->slave(send_byte);
+  } else {
+    *receive_byte = send_byte + 1;
+    //This is just an example SPI device where the returned value is
+    //always one greater than the given value. This doesn't actually
+    //make sense since SPI is sychrnonous, but whatever. It's an
+    //exmaple.
+  }
+  if (channel->_impl->clock_rate != 0) {
+    channel->_impl->busy_ns += 8 * 1000000000ull / channel->_impl->clock_rate;
+  }
   channel->_impl->mosi_bytes.push_back(send_byte);
-  channel->_impl->miso_bytes.push_back(send_byte + 1);
+  channel->_impl->miso_bytes.push_back(*receive_byte);
 
   return SPI_NO_ERROR;
 }
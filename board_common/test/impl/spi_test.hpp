@@ -17,16 +17,25 @@ extern "C" {
 }
 
 #include <catch/catch.hpp>
+#include <functional>
 #include <vector>
 
 struct spi_impl {
   std::vector<uint8_t> miso_bytes;
   std::vector<uint8_t> mosi_bytes;
   bool open;
+  /// The device on the far end of the bus, given each byte the master
+  /// shifts out and returning the byte shifted back. If empty, the stub
+  /// device answers each byte with one more than it.
+  std::function<uint8_t(uint8_t)> slave;
+  /// The bit clock, in Hz, or 0 to not keep time
+  uint32_t clock_rate;
+  /// Time the bus has spent shifting bytes, in nanoseconds
+  uint64_t busy_ns;
 
   void send_byte();
 
-  spi_impl() : open(false) {}
+  spi_impl() : open(false), clock_rate(0), busy_ns(0) {}
 };
 
 /** Open the given SPI channel so that it can be used.
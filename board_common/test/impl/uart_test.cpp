@@ -1,14 +1,92 @@
 #include "uart_test.hpp"
+#include "uart_baud.h"
+#include "dma_test.hpp"
+
+#include <algorithm>
 
 /******************************************************************************\
  *  UART structure implementation                                             *
 \******************************************************************************/
 void uart_impl::push_byte(const uint8_t b) {
-    input.insert(input.begin(), b);
+    input.push(b);
 }
 
 void uart_impl::push_bytes(std::initializer_list<uint8_t> data) {
-    input.insert(input.begin(), data);
+    input.push(data.begin(), data.end());
+}
+
+uint64_t uart_impl::byte_time_ns() const {
+    // A start bit, 8 data bits and a stop bit
+    return baud_rate == 0 ? 0 : 10 * 1000000000ull / baud_rate;
+}
+
+void uart_impl::advance(uint64_t ns) {
+    now_ns += ns;
+}
+
+void uart_impl::transmit(uint8_t b, bool blocking) {
+    uint64_t start = std::max(now_ns, tx_free_ns);
+    tx_free_ns = start + byte_time_ns();
+    if (blocking) {
+        now_ns = tx_free_ns;
+    }
+    timing.tx_busy_ns += byte_time_ns();
+    ++timing.bytes_written;
+    output.push_back(b);
+}
+
+uint8_t uart_impl::receive() {
+    // The reply can't start before the request has gone out
+    uint64_t start = std::max(std::max(now_ns, rx_free_ns), tx_free_ns);
+    rx_free_ns = start + byte_time_ns();
+    now_ns = rx_free_ns;
+    timing.rx_busy_ns += byte_time_ns();
+    ++timing.bytes_read;
+    return input.pop();
+}
+
+double uart_impl::bytes_per_second() const {
+    if (now_ns == 0) {
+        return 0;
+    }
+    return (timing.bytes_written + timing.bytes_read) * 1e9 / now_ns;
+}
+
+/******************************************************************************\
+ *  mock_fifo implementation                                                  *
+\******************************************************************************/
+void mock_fifo::push(uint8_t b) {
+    if (_size == _ring.size()) {
+        // Unroll the ring in to one twice the size
+        std::vector<uint8_t> grown(_ring.size() * 2);
+        for (size_t i = 0; i < _size; ++i) {
+            grown[i] = _ring[(_head + i) & (_ring.size() - 1)];
+        }
+        _ring.swap(grown);
+        _head = 0;
+    }
+    _ring[(_head + _size) & (_ring.size() - 1)] = b;
+    ++_size;
+}
+
+uint8_t mock_fifo::pop() {
+    uint8_t b = _ring[_head];
+    _head = (_head + 1) & (_ring.size() - 1);
+    --_size;
+    return b;
+}
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+namespace {
+    /// Record a read that started at the given virtual time
+    void note_read(uart_impl * impl, uint64_t start) {
+        uint64_t wait = impl->now_ns - start;
+        ++impl->timing.reads;
+        impl->timing.read_wait_ns += wait;
+        impl->timing.max_read_wait_ns = std::max(impl->timing.max_read_wait_ns, wait);
+    }
 }
 
 /******************************************************************************\
@@ -39,11 +117,36 @@ std::ostream & operator<<(std::ostream & o, const uart_error_t & err) {
 bool uart_open(uart_t * out, size_t baud_rate) {
     out->_impl = new uart_impl();
     out->_impl->open = true;
+    out->_impl->baud_rate = baud_rate;
+
+    return true;
+}
+
+bool uart_open_fd(uart_t * out, int fd, size_t baud_rate) {
+    uart_fd_t * device = new uart_fd_t;
+    if (!uart_fd_open(device, fd) || !uart_fd_set_baud(device, baud_rate)) {
+        uart_fd_close(device);
+        delete device;
+        out->_impl = nullptr;
+        return false;
+    }
+
+    out->_impl = new uart_impl();
+    out->_impl->open = true;
+    out->_impl->baud_rate = baud_rate;
+    out->_impl->device = device;
 
     return true;
 }
 
 void uart_close(uart_t * out) {
+    if (out->_impl) {
+        mock_dma().cancel(out->_impl->dma_channel);
+        if (out->_impl->device) {
+            uart_fd_close(out->_impl->device);
+            delete out->_impl->device;
+        }
+    }
     delete out->_impl;
     out->_impl = nullptr;
 }
@@ -52,36 +155,202 @@ uart_error_t uart_write_byte(uart_t * channel, uint8_t byte) {
     if (!channel->_impl || !channel->_impl->open) {
         return UART_CHANNEL_CLOSED;
     }
-    channel->_impl->output.push_back(byte);
+    if (channel->_impl->device) {
+        ++channel->_impl->timing.bytes_written;
+        return uart_fd_write(channel->_impl->device, &byte, 1) ? UART_NO_ERROR : UART_SIGNAL_FAULT;
+    }
+    // A real write would wait for the DMA to finish first
+    mock_dma().run(channel->_impl->dma_channel);
+    channel->_impl->transmit(byte, true);
 
     return UART_NO_ERROR;
 }
 
 uart_error_t uart_read_byte(uart_t * channel, uint8_t * output) {
+    return uart_read_bytes(channel, output, 1);
+}
+
+uart_error_t uart_read_bytes(uart_t * channel, uint8_t * bytes, size_t n) {
     if (!channel->_impl || !channel->_impl->open) {
         return UART_CHANNEL_CLOSED;
     }
-    if (channel->_impl->input.size() == 0) {
+    if (channel->_impl->device) {
+        if (!uart_fd_read_exactly(channel->_impl->device, bytes, n, channel->_impl->read_timeout_ms)) {
+            return UART_SIGNAL_FAULT;
+        }
+        channel->_impl->timing.bytes_read += n;
+        ++channel->_impl->timing.reads;
+        return UART_NO_ERROR;
+    }
+    if (channel->_impl->input.size() < n) {
         return UART_SIGNAL_FAULT;
     }
-    *output = channel->_impl->input.back();
-    channel->_impl->input.pop_back();
+    uint64_t start = channel->_impl->now_ns;
+    for (size_t i = 0; i < n; ++i, ++bytes) {
+        *bytes = channel->_impl->receive();
+    }
+    if (n > 0) {
+        note_read(channel->_impl, start);
+    }
 
     return UART_NO_ERROR;
 }
 
+uart_error_t uart_read_bytes_timeout(uart_t * channel, uint8_t * bytes, size_t n, uint16_t timeout_ms, size_t * read) {
+    *read = 0;
+    if (!channel->_impl || !channel->_impl->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    if (channel->_impl->device) {
+        while (*read < n) {
+            long count = uart_fd_read(channel->_impl->device, bytes + *read, n - *read, timeout_ms);
+            if (count < 0) {
+                return UART_SIGNAL_FAULT;
+            }
+            if (count == 0) {
+                return UART_TIMEOUT;
+            }
+            *read += count;
+            channel->_impl->timing.bytes_read += count;
+            ++channel->_impl->timing.reads;
+        }
+        return UART_NO_ERROR;
+    }
+    uint64_t start = channel->_impl->now_ns;
+    while (*read < n && !channel->_impl->input.empty()) {
+        *bytes++ = channel->_impl->receive();
+        ++*read;
+    }
+    if (*read > 0) {
+        note_read(channel->_impl, start);
+    }
+    if (*read < n) {
+        // Nothing more is coming, so the whole timeout passes
+        channel->_impl->advance(timeout_ms * 1000000ull);
+        return UART_TIMEOUT;
+    }
 
-uart_error_t uart_read_bytes(uart_t * channel, uint8_t * bytes, size_t n) {
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_read_available(uart_t * channel, uint8_t * bytes, size_t n, size_t * read) {
+    *read = 0;
     if (!channel->_impl || !channel->_impl->open) {
         return UART_CHANNEL_CLOSED;
     }
-    if (channel->_impl->input.size() < n) {
+    if (channel->_impl->device) {
+        long count = uart_fd_read(channel->_impl->device, bytes, n, 0);
+        if (count < 0) {
+            return UART_SIGNAL_FAULT;
+        }
+        *read = count;
+        channel->_impl->timing.bytes_read += count;
+        channel->_impl->timing.reads += count > 0;
+        return UART_NO_ERROR;
+    }
+    uint64_t start = channel->_impl->now_ns;
+    while (*read < n && !channel->_impl->input.empty()) {
+        *bytes++ = channel->_impl->receive();
+        ++*read;
+    }
+    if (*read > 0) {
+        note_read(channel->_impl, start);
+    }
+
+    return UART_NO_ERROR;
+}
+
+bool uart_baud_rate_supported(uart_t * channel, uart_baud_rate_t baud_rate) {
+    if (baud_rate >= BAUD_count) {
+        return false;
+    }
+    return !channel->_impl || !channel->_impl->device ||
+        uart_fd_supports(channel->_impl->device, uart_baud_rate_bps(baud_rate));
+}
+
+uart_error_t uart_set_baud_rate(uart_t * channel, uart_baud_rate_t baud_rate) {
+    if (!channel->_impl || !channel->_impl->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    if (!uart_baud_rate_supported(channel, baud_rate)) {
+        return UART_UNSUPPORTED;
+    }
+    if (channel->_impl->device && !uart_fd_set_baud(channel->_impl->device, uart_baud_rate_bps(baud_rate))) {
         return UART_SIGNAL_FAULT;
     }
-    for (auto i = 0; i < n; ++i, ++bytes) {
-        *bytes = channel->_impl->input.back();
-        channel->_impl->input.pop_back();
+    // Like the target, finish the asynchronous write at the old rate
+    mock_dma().run(channel->_impl->dma_channel);
+    channel->_impl->now_ns = std::max(channel->_impl->now_ns, channel->_impl->tx_free_ns);
+
+    channel->_impl->baud_rate = uart_baud_rate_bps(baud_rate);
+    channel->_impl->baud_changes.push_back(channel->_impl->baud_rate);
+    channel->_impl->baud_change_offsets.push_back(channel->_impl->output.size());
+
+    return UART_NO_ERROR;
+}
+
+uart_error_t uart_write_bytes_async(uart_t * channel, const uint8_t * bytes, size_t n,
+        uart_write_complete_t on_complete, void * context) {
+    if (!channel->_impl || !channel->_impl->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    if (mock_dma().busy(channel->_impl->dma_channel)) {
+        return UART_BUSY;
+    }
+
+    // A descriptor takes the whole buffer at once, so the write is done
+    // before this returns
+    if (channel->_impl->device) {
+        uart_error_t err = UART_NO_ERROR;
+        if (!uart_fd_write(channel->_impl->device, bytes, n) || !uart_fd_flush(channel->_impl->device)) {
+            err = UART_SIGNAL_FAULT;
+        }
+        channel->_impl->timing.bytes_written += n;
+        if (on_complete) {
+            on_complete(channel, err, context);
+        }
+        return UART_NO_ERROR;
+    }
+
+    // Matches the target, which never arms the DMA for an empty buffer
+    if (n == 0) {
+        if (on_complete) {
+            on_complete(channel, UART_NO_ERROR, context);
+        }
+        return UART_NO_ERROR;
+    }
+
+    uart_impl * impl = channel->_impl;
+    impl->dma_channel = mock_dma().start(bytes, n,
+        [impl](uint8_t b) {
+            impl->transmit(b, false);
+        },
+        [impl, channel, on_complete, context]() {
+            // The engine hands the slot to the next transfer, which may
+            // belong to another channel. Let go of it before the callback,
+            // which may start this channel's next write.
+            impl->dma_channel = -1;
+            if (on_complete) {
+                on_complete(channel, UART_NO_ERROR, context);
+            }
+        });
+
+    return UART_NO_ERROR;
+}
+
+bool uart_write_async_busy(uart_t * channel) {
+    return channel->_impl && mock_dma().busy(channel->_impl->dma_channel);
+}
+
+uart_error_t uart_wait_async(uart_t * channel) {
+    if (!channel->_impl || !channel->_impl->open) {
+        return UART_CHANNEL_CLOSED;
+    }
+    if (channel->_impl->device) {
+        return uart_fd_drain(channel->_impl->device) ? UART_NO_ERROR : UART_SIGNAL_FAULT;
     }
+    mock_dma().run(channel->_impl->dma_channel);
+    channel->_impl->now_ns = std::max(channel->_impl->now_ns, channel->_impl->tx_free_ns);
 
     return UART_NO_ERROR;
 }
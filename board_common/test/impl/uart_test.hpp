@@ -19,29 +19,133 @@ extern "C" {
 #include <catch/catch.hpp>
 #include <vector>
 
+#include "uart_fd.h"
+
+/// A first-in first-out queue of bytes kept in a ring, so pushing and
+/// popping cost the same however much is queued. The ring doubles in size
+/// when it fills.
+class mock_fifo {
+    public:
+        mock_fifo() : _ring(16), _head(0), _size(0) {}
+
+        /// Queue a byte at the back
+        void push(uint8_t b);
+
+        /// Take the byte at the front. The queue must not be empty.
+        uint8_t pop();
+
+        /// Queue a range of bytes at the back, in order
+        template<class InputIt> void push(InputIt first, InputIt last) {
+            for (; first != last; ++first) {
+                push(*first);
+            }
+        }
+
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+        void clear() { _head = 0; _size = 0; }
+
+    private:
+        /// Always a power of two long
+        std::vector<uint8_t> _ring;
+        size_t _head;
+        size_t _size;
+};
+
+/// How the mock link has been used, in virtual time
+struct uart_timing {
+    /// Bytes written to the link
+    uint64_t bytes_written;
+    /// Bytes read from the link
+    uint64_t bytes_read;
+    /// Time the transmitter spent sending, in nanoseconds
+    uint64_t tx_busy_ns;
+    /// Time the receiver spent receiving, in nanoseconds
+    uint64_t rx_busy_ns;
+    /// Calls to the read functions that returned bytes
+    uint64_t reads;
+    /// Total time spent waiting in reads, in nanoseconds
+    uint64_t read_wait_ns;
+    /// The longest wait of any single read, in nanoseconds
+    uint64_t max_read_wait_ns;
+};
+
 /// Implementation of the UART structure for testing infrastructure
+///
+/// The mock keeps a virtual clock for the link. Every byte takes 10 bit
+/// times at the baud rate in effect when it crosses the wire: a start bit,
+/// 8 data bits and a stop bit. Blocking writes and reads move the clock to
+/// when their last byte has crossed, and asynchronous writes only occupy the
+/// transmitter until they are waited on. Queued input is taken to be sent
+/// by the far end as soon as it is read, but never before the receiver is
+/// free, so the clock measures link time rather than host time.
 struct uart_impl {
     /// Bytes that have been pushed in to the output by the uart client functions
     std::vector<uint8_t> output;
-    /// Bytes waiting to be read in
-    std::vector<uint8_t> input;
+    /// Bytes waiting to be read in, oldest first
+    mock_fifo input;
     /// True if we've opened
     bool open;
+    /// The baud rate the channel runs at, in bits per second
+    size_t baud_rate;
+    /// Every rate passed to uart_set_baud_rate, oldest first
+    std::vector<size_t> baud_changes;
+    /// The length of `output` at each entry of `baud_changes`
+    std::vector<size_t> baud_change_offsets;
+    /// The mock DMA channel of the asynchronous write in flight, or -1
+    int dma_channel;
+    /// The virtual time, in nanoseconds since the channel was opened
+    uint64_t now_ns;
+    /// When the transmitter finishes the last byte written
+    uint64_t tx_free_ns;
+    /// When the receiver finishes the last byte read
+    uint64_t rx_free_ns;
+    /// Throughput and latency counters
+    uart_timing timing;
+    /// The descriptor the channel talks through, or NULL to use the mock
+    /// buffers above. The virtual clock doesn't run for a descriptor.
+    uart_fd_t * device;
+    /// How long a blocking read waits on a descriptor before giving up
+    int read_timeout_ms;
 
-    /// Push a byte for consumption upon the next call to read_byte
+    /// Push a byte for consumption after everything already queued
     void push_byte(const uint8_t b);
 
+    /// Push bytes for consumption, in order, after everything already queued
     template<class InputIt> void push_bytes(InputIt first, InputIt last) {
-        input.insert(input.begin(), first, last);
+        input.push(first, last);
     }
 
     void push_bytes(std::initializer_list<uint8_t> data);
 
-    uart_impl() : open(false) {}
+    /// The time one byte takes on the wire at the current baud rate
+    uint64_t byte_time_ns() const;
+
+    /// Let virtual time pass, as if the caller slept
+    void advance(uint64_t ns);
+
+    /// Write a byte, charging the transmitter for it. If blocking, the clock
+    /// moves on to when it has been sent.
+    void transmit(uint8_t b, bool blocking);
+
+    /// Read a byte, moving the clock on to when it has been received. The
+    /// input must not be empty.
+    uint8_t receive();
+
+    /// Bytes moved in both directions per second of link time since the
+    /// channel opened
+    double bytes_per_second() const;
+
+    uart_impl() : open(false), baud_rate(0), dma_channel(-1), now_ns(0), tx_free_ns(0), rx_free_ns(0), timing(),
+        device(nullptr), read_timeout_ms(1000) {}
 };
 
 bool uart_open(uart_t * out, size_t baud_rate);
 
+/// Open a channel on a file descriptor instead of the mock buffers. The
+/// channel takes over fd, and closes it when it is closed or fails to open.
+bool uart_open_fd(uart_t * out, int fd, size_t baud_rate);
+
 /******************************************************************************\
  *  Pretty printers                                                           *
 \******************************************************************************/
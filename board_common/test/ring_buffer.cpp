@@ -0,0 +1,172 @@
+#include <catch/catch.hpp>
+
+#include "ring_buffer.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Ring buffers reject capacities that are not powers of two", "[ring_buffer]") {
+    ring_buffer_t ring;
+    uint8_t storage[64];
+
+    REQUIRE_FALSE(ring_buffer_init(&ring, storage, 0));
+    REQUIRE_FALSE(ring_buffer_init(&ring, storage, 48));
+    REQUIRE(ring_buffer_init(&ring, storage, 64));
+}
+
+TEST_CASE("Ring buffers are first-in first-out", "[ring_buffer]") {
+    ring_buffer_t ring;
+    uint8_t storage[4];
+    uint8_t byte = 0;
+
+    REQUIRE(ring_buffer_init(&ring, storage, sizeof(storage)));
+    REQUIRE(ring_buffer_is_empty(&ring));
+    REQUIRE_FALSE(ring_buffer_pop(&ring, &byte));
+
+    SECTION("Single bytes") {
+        REQUIRE(ring_buffer_push(&ring, 1));
+        REQUIRE(ring_buffer_push(&ring, 2));
+        REQUIRE(ring_buffer_push(&ring, 3));
+        REQUIRE(ring_buffer_push(&ring, 4));
+        REQUIRE(ring_buffer_is_full(&ring));
+        REQUIRE_FALSE(ring_buffer_push(&ring, 5));
+
+        REQUIRE(ring_buffer_pop(&ring, &byte));
+        REQUIRE(byte == 1);
+        REQUIRE(ring_buffer_push(&ring, 5));
+
+        for (uint8_t expected = 2; expected <= 5; ++expected) {
+            REQUIRE(ring_buffer_pop(&ring, &byte));
+            REQUIRE(byte == expected);
+        }
+        REQUIRE(ring_buffer_is_empty(&ring));
+    }
+
+    SECTION("Bulk transfers wrap and truncate") {
+        uint8_t in[] = { 10, 11, 12, 13, 14, 15 };
+        uint8_t out[6] = { 0 };
+
+        REQUIRE(ring_buffer_push_bytes(&ring, in, 3) == 3);
+        REQUIRE(ring_buffer_pop_bytes(&ring, out, 2) == 2);
+        REQUIRE(ring_buffer_size(&ring) == 1);
+        REQUIRE(ring_buffer_free(&ring) == 3);
+
+        // Only three more fit, and they wrap around the end of the storage
+        REQUIRE(ring_buffer_push_bytes(&ring, in + 3, 3) == 3);
+        REQUIRE(ring_buffer_push_bytes(&ring, in, 1) == 0);
+        REQUIRE(ring_buffer_pop_bytes(&ring, out + 2, 6) == 4);
+        REQUIRE(std::vector<uint8_t>(out, out + 6) == std::vector<uint8_t>(in, in + 6));
+    }
+
+    SECTION("Clear discards waiting bytes") {
+        REQUIRE(ring_buffer_push(&ring, 1));
+        ring_buffer_clear(&ring);
+        REQUIRE(ring_buffer_is_empty(&ring));
+        REQUIRE(ring_buffer_free(&ring) == 4);
+    }
+}
+
+TEST_CASE("Ring buffers survive the free running indices wrapping", "[ring_buffer]") {
+    ring_buffer_t ring;
+    uint8_t storage[8];
+    uint8_t byte = 0;
+
+    REQUIRE(ring_buffer_init(&ring, storage, sizeof(storage)));
+    ring.head = 0xFFFE;
+    ring.tail = 0xFFFE;
+
+    for (uint8_t i = 0; i < 8; ++i) {
+        REQUIRE(ring_buffer_push(&ring, i));
+    }
+    REQUIRE(ring_buffer_is_full(&ring));
+    for (uint8_t i = 0; i < 8; ++i) {
+        REQUIRE(ring_buffer_pop(&ring, &byte));
+        REQUIRE(byte == i);
+    }
+    REQUIRE(ring_buffer_is_empty(&ring));
+}
+
+TEST_CASE("Ring buffers never drop or reorder bytes between threads", "[ring_buffer][threads]") {
+    const size_t total = 1 << 20;
+    ring_buffer_t ring;
+    uint8_t storage[64];
+
+    REQUIRE(ring_buffer_init(&ring, storage, sizeof(storage)));
+
+    // The producer stands in for the receive ISR, so it pushes single bytes,
+    // while the consumer drains in bursts like uart_read_bytes
+    std::thread producer([&ring, total]() {
+        for (size_t i = 0; i < total; ++i) {
+            while (!ring_buffer_push(&ring, (uint8_t)(i * 7))) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    size_t received = 0;
+    size_t mismatches = 0;
+    uint8_t burst[23];
+    while (received < total) {
+        size_t n = ring_buffer_pop_bytes(&ring, burst, sizeof(burst));
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < n; ++i, ++received) {
+            if (burst[i] != (uint8_t)(received * 7)) {
+                ++mismatches;
+            }
+        }
+    }
+    producer.join();
+
+    REQUIRE(mismatches == 0);
+    REQUIRE(ring_buffer_is_empty(&ring));
+}
+
+TEST_CASE("Ring buffer bulk pushes are safe against a single byte consumer", "[ring_buffer][threads]") {
+    const size_t total = 1 << 20;
+    ring_buffer_t ring;
+    uint8_t storage[32];
+
+    REQUIRE(ring_buffer_init(&ring, storage, sizeof(storage)));
+
+    // The mirror image of the above: a task queueing frames for the transmit
+    // ISR
+    std::thread producer([&ring, total]() {
+        uint8_t burst[13];
+        size_t sent = 0;
+        while (sent < total) {
+            size_t n = std::min(sizeof(burst), total - sent);
+            for (size_t i = 0; i < n; ++i) {
+                burst[i] = (uint8_t)((sent + i) ^ 0x5A);
+            }
+            size_t pushed = 0;
+            while (pushed < n) {
+                size_t count = ring_buffer_push_bytes(&ring, burst + pushed, n - pushed);
+                if (count == 0) {
+                    std::this_thread::yield();
+                }
+                pushed += count;
+            }
+            sent += n;
+        }
+    });
+
+    size_t mismatches = 0;
+    uint8_t byte;
+    for (size_t received = 0; received < total; ) {
+        if (ring_buffer_pop(&ring, &byte)) {
+            if (byte != (uint8_t)(received ^ 0x5A)) {
+                ++mismatches;
+            }
+            ++received;
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    REQUIRE(mismatches == 0);
+}
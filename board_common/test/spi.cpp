@@ -86,3 +86,103 @@ TEST_CASE("Test error on multi-byte function.", "[spi]") {
 
   REQUIRE(spi_receive_bytes(&t, receive, 3) == SPI_CHANNEL_CLOSED);
 }
+
+TEST_CASE("Test SPI zero length blocks.", "[spi]") {
+  spi_t t;
+  uint8_t send[1] = { 0x42 };
+  uint8_t receive[1] = { 0 };
+
+  spi_open(&t);
+  REQUIRE(spi_transfer_bytes(&t, send, receive, 0) == SPI_NO_ERROR);
+  REQUIRE(spi_send_bytes(&t, send, 0) == SPI_NO_ERROR);
+  REQUIRE(spi_receive_bytes(&t, receive, 0) == SPI_NO_ERROR);
+  REQUIRE(receive[0] == 0);
+  REQUIRE_THAT(t, HasMasterOutSlaveInBytes({}));
+  spi_close(&t);
+}
+
+TEST_CASE("Test SPI transfers of a full flash page.", "[spi]") {
+  spi_t t;
+  std::vector<uint8_t> send(256);
+  std::vector<uint8_t> receive(256);
+  std::vector<uint8_t> expected(256);
+
+  for (size_t i = 0; i < send.size(); ++i) {
+    send[i] = (uint8_t)(i * 3);
+    expected[i] = (uint8_t)(send[i] + 1);
+  }
+
+  spi_open(&t);
+  REQUIRE(spi_transfer_bytes(&t, send.data(), receive.data(), send.size()) == SPI_NO_ERROR);
+  REQUIRE(receive == expected);
+  REQUIRE_THAT(t, HasMasterOutSlaveInBytes(send));
+  REQUIRE_THAT(t, HasMasterInSlaveOutBytes(expected));
+
+  REQUIRE(spi_receive_bytes(&t, receive.data(), receive.size()) == SPI_NO_ERROR);
+  REQUIRE(receive == std::vector<uint8_t>(256, 0x01));
+  spi_close(&t);
+}
+
+TEST_CASE("Test SPI clock selection.", "[spi]") {
+  spi_config_t config = SPI_CONFIG_DEFAULT(0);
+  config.clock_source = SPI_CLOCK_SOURCE_AUTO;
+  spi_clock_t clock;
+  const uint32_t smclk = 8000000;
+  const uint32_t aclk = 32768;
+
+  SECTION("Fast buses run from SMCLK") {
+    config.clock_rate = 4000000;
+    REQUIRE(spi_select_clock(&config, smclk, aclk, &clock));
+    REQUIRE(clock.source == SPI_CLOCK_SOURCE_SMCLK);
+    REQUIRE(clock.prescaler == 2);
+    REQUIRE(clock.rate == 4000000);
+  }
+
+  SECTION("The achieved rate never exceeds the requested one") {
+    config.clock_rate = 3000000;
+    REQUIRE(spi_select_clock(&config, smclk, aclk, &clock));
+    REQUIRE(clock.prescaler == 3);
+    REQUIRE(clock.rate == 2666666);
+  }
+
+  SECTION("ACLK wins a tie") {
+    config.clock_rate = 1000;
+    config.clock_source = SPI_CLOCK_SOURCE_AUTO;
+    REQUIRE(spi_select_clock(&config, 32768, aclk, &clock));
+    REQUIRE(clock.source == SPI_CLOCK_SOURCE_ACLK);
+    REQUIRE(clock.prescaler == 33);
+  }
+
+  SECTION("A forced source is honoured") {
+    config.clock_rate = 4000000;
+    config.clock_source = SPI_CLOCK_SOURCE_ACLK;
+    REQUIRE(spi_select_clock(&config, smclk, aclk, &clock));
+    REQUIRE(clock.source == SPI_CLOCK_SOURCE_ACLK);
+    REQUIRE(clock.prescaler == 1);
+    REQUIRE(clock.rate == aclk);
+  }
+
+  SECTION("Rates too slow for the prescaler are rejected") {
+    config.clock_rate = 100;
+    config.clock_source = SPI_CLOCK_SOURCE_SMCLK;
+    REQUIRE_FALSE(spi_select_clock(&config, smclk, aclk, &clock));
+
+    config.clock_source = SPI_CLOCK_SOURCE_AUTO;
+    REQUIRE(spi_select_clock(&config, smclk, aclk, &clock));
+    REQUIRE(clock.source == SPI_CLOCK_SOURCE_ACLK);
+  }
+
+  SECTION("A zero rate is rejected") {
+    config.clock_rate = 0;
+    REQUIRE_FALSE(spi_select_clock(&config, smclk, aclk, &clock));
+  }
+}
+
+TEST_CASE("The default SPI configuration is the original bus.", "[spi]") {
+  spi_config_t config = SPI_CONFIG_DEFAULT(1000000);
+  REQUIRE(config.clock_rate == 1000000);
+  REQUIRE(config.clock_source == SPI_CLOCK_SOURCE_ACLK);
+  REQUIRE(config.mode == SPI_MODE_3);
+  REQUIRE(config.bit_order == SPI_MSB_FIRST);
+  REQUIRE(config.pins == SPI_3PIN);
+}
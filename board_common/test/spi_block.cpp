@@ -0,0 +1,211 @@
+#include <catch/catch.hpp>
+
+#include "spi_block.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+    /// A model of a double buffered SPI master: TXBUF feeds a shift register,
+    /// and each byte shifted out brings one back in to RXBUF. Every register
+    /// access takes one cycle, and a byte takes byte_cycles to shift. The far
+    /// end answers each byte with its complement.
+    struct spi_model {
+        uint64_t now = 0;
+        uint64_t byte_cycles;
+
+        bool tx_full = false;
+        uint8_t txbuf = 0;
+        uint64_t tx_written_at = 0;
+
+        bool shifting = false;
+        uint8_t shift = 0;
+        uint64_t shift_done = 0;
+        uint64_t free_at = 0;
+
+        bool rx_full = false;
+        uint8_t rxbuf = 0;
+        bool overrun = false;
+
+        /// Bytes sent, in order
+        std::vector<uint8_t> mosi;
+        /// Cycles SCLK sat idle between one byte and the next
+        std::vector<uint64_t> gaps;
+
+        /// After this many bytes are queued, an interrupt takes stall_cycles
+        size_t stall_after = SIZE_MAX;
+        uint64_t stall_cycles = 0;
+
+        explicit spi_model(uint64_t byte_cycles) : byte_cycles(byte_cycles) {}
+
+        /// Run the hardware up to now
+        void settle() {
+            for (;;) {
+                if (shifting && shift_done <= now) {
+                    overrun |= rx_full;
+                    rxbuf = ~shift;
+                    rx_full = true;
+                    shifting = false;
+                    free_at = shift_done;
+                }
+                else if (!shifting && tx_full) {
+                    uint64_t start = std::max(free_at, tx_written_at);
+                    if (!mosi.empty()) {
+                        gaps.push_back(start - free_at);
+                    }
+                    shift = txbuf;
+                    mosi.push_back(txbuf);
+                    tx_full = false;
+                    shifting = true;
+                    shift_done = start + byte_cycles;
+                }
+                else {
+                    break;
+                }
+            }
+        }
+
+        /// One register access
+        void tick() {
+            ++now;
+            settle();
+        }
+    };
+
+    spi_model & model(void * block) {
+        return *static_cast<spi_model *>(block);
+    }
+
+    bool model_tx_ready(void * block) {
+        model(block).tick();
+        return !model(block).tx_full;
+    }
+
+    bool model_rx_ready(void * block) {
+        model(block).tick();
+        return model(block).rx_full;
+    }
+
+    bool model_busy(void * block) {
+        model(block).tick();
+        return model(block).shifting || model(block).tx_full;
+    }
+
+    void model_send(void * block, uint8_t byte) {
+        spi_model & m = model(block);
+        m.tick();
+        m.txbuf = byte;
+        m.tx_full = true;
+        m.tx_written_at = m.now;
+        m.settle();
+        if (m.mosi.size() + m.tx_full == m.stall_after) {
+            m.now += m.stall_cycles;
+            m.settle();
+        }
+    }
+
+    uint8_t model_receive(void * block, bool * overrun) {
+        spi_model & m = model(block);
+        m.tick();
+        *overrun = m.overrun;
+        m.overrun = false;
+        m.rx_full = false;
+        return m.rxbuf;
+    }
+
+    const spi_block_port_t MODEL_PORT = {
+        model_tx_ready,
+        model_rx_ready,
+        model_busy,
+        model_send,
+        model_receive,
+    };
+
+    std::vector<uint8_t> complement(const std::vector<uint8_t> & bytes) {
+        std::vector<uint8_t> out;
+        for (uint8_t b : bytes) {
+            out.push_back(~b);
+        }
+        return out;
+    }
+}
+
+TEST_CASE("SPI block transfers keep the bus busy", "[spi][spi_block]") {
+    spi_model m(32);
+    std::vector<uint8_t> send = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+    std::vector<uint8_t> receive(send.size());
+
+    REQUIRE(spi_block_transfer(&MODEL_PORT, &m, send.data(), receive.data(), send.size()) == SPI_NO_ERROR);
+    REQUIRE(m.mosi == send);
+    REQUIRE(receive == complement(send));
+
+    // Each byte was queued while the one before it was shifting
+    REQUIRE(m.gaps == std::vector<uint64_t>(send.size() - 1, 0));
+}
+
+TEST_CASE("SPI block transfers clock out zeros with nothing to send", "[spi][spi_block]") {
+    spi_model m(32);
+    std::vector<uint8_t> receive(3);
+
+    REQUIRE(spi_block_transfer(&MODEL_PORT, &m, NULL, receive.data(), receive.size()) == SPI_NO_ERROR);
+    REQUIRE(m.mosi == std::vector<uint8_t>({ 0, 0, 0 }));
+    REQUIRE(receive == std::vector<uint8_t>({ 0xff, 0xff, 0xff }));
+}
+
+TEST_CASE("SPI block transfers of nothing touch nothing", "[spi][spi_block]") {
+    spi_model m(32);
+
+    REQUIRE(spi_block_transfer(&MODEL_PORT, &m, NULL, NULL, 0) == SPI_NO_ERROR);
+    REQUIRE(m.now == 0);
+}
+
+TEST_CASE("SPI block transfers survive interrupts between bytes", "[spi][spi_block]") {
+    spi_model m(32);
+    std::vector<uint8_t> send = { 0x10, 0x20, 0x30, 0x40, 0x50 };
+    std::vector<uint8_t> receive(send.size());
+
+    SECTION("An interrupt shorter than a byte") {
+        m.stall_after = 3;
+        m.stall_cycles = 20;
+        REQUIRE(spi_block_transfer(&MODEL_PORT, &m, send.data(), receive.data(), send.size()) == SPI_NO_ERROR);
+        REQUIRE(receive == complement(send));
+    }
+
+    SECTION("An interrupt before the next byte is queued") {
+        m.stall_after = 1;
+        m.stall_cycles = 1000;
+        REQUIRE(spi_block_transfer(&MODEL_PORT, &m, send.data(), receive.data(), send.size()) == SPI_NO_ERROR);
+        REQUIRE(receive == complement(send));
+    }
+}
+
+TEST_CASE("SPI block transfers report bytes an interrupt let through", "[spi][spi_block]") {
+    spi_model m(32);
+    std::vector<uint8_t> send = { 0x10, 0x20, 0x30, 0x40, 0x50 };
+    std::vector<uint8_t> receive(send.size(), 0xAA);
+
+    // Byte 2 lands on top of byte 1 while an interrupt holds up the read
+    m.stall_after = 3;
+    m.stall_cycles = 100;
+    REQUIRE(spi_block_transfer(&MODEL_PORT, &m, send.data(), receive.data(), send.size()) == SPI_OVERRUN);
+    REQUIRE(receive[0] == (uint8_t) ~send[0]);
+}
+
+TEST_CASE("SPI block transfers give up on bytes that never arrive", "[spi][spi_block]") {
+    spi_model m(SPI_BLOCK_RX_POLLS * 4);
+    uint8_t send = 0x42;
+    uint8_t receive;
+
+    REQUIRE(spi_block_transfer(&MODEL_PORT, &m, &send, &receive, 1) == SPI_OVERRUN);
+}
+
+TEST_CASE("SPI block sends leave the receiver clear", "[spi][spi_block]") {
+    spi_model m(32);
+    std::vector<uint8_t> send = { 0x01, 0x02, 0x03, 0x04 };
+
+    spi_block_send(&MODEL_PORT, &m, send.data(), send.size());
+    REQUIRE(m.mosi == send);
+    REQUIRE_FALSE(m.shifting);
+    REQUIRE_FALSE(m.rx_full);
+    REQUIRE_FALSE(m.overrun);
+}
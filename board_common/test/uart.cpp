@@ -1,6 +1,7 @@
 #include <catch/catch.hpp>
 
 #include "uart.h"
+#include "dma_test.hpp"
 
 TEST_CASE("Test UART implementation can push bytes", "[uart]") {
     uart_t t;
@@ -15,3 +16,294 @@ TEST_CASE("Test UART implementation can push bytes", "[uart]") {
 
     uart_close(&t);
 }
+
+TEST_CASE("Test UART implementation can gather buffers", "[uart]") {
+    uart_t t;
+    uint8_t header[2] = { 0x48, 0x65 };
+    uint8_t payload[3] = { 0x01, 0x02, 0x03 };
+    uint8_t checksum[2] = { 0xAA, 0xBB };
+
+    uart_open(&t, 9600);
+
+    uart_iovec_t iov[] = {
+        { header, sizeof(header) },
+        { NULL, 0 },
+        { payload, sizeof(payload) },
+        { checksum, sizeof(checksum) },
+    };
+    REQUIRE(uart_write_iov(&t, iov, 4) == UART_NO_ERROR);
+    REQUIRE(t._impl->output == std::vector<uint8_t>({ 0x48, 0x65, 0x01, 0x02, 0x03, 0xAA, 0xBB }));
+
+    REQUIRE(uart_write_iov(&t, iov, 0) == UART_NO_ERROR);
+    REQUIRE(t._impl->output.size() == 7);
+
+    uart_close(&t);
+    REQUIRE(uart_write_iov(&t, iov, 4) == UART_CHANNEL_CLOSED);
+}
+
+TEST_CASE("Test UART implementation can read without waiting", "[uart]") {
+    uart_t t;
+    uint8_t buffer[4];
+    size_t read;
+
+    uart_open(&t, 9600);
+    t._impl->push_bytes({ 0x01, 0x02, 0x03 });
+
+    REQUIRE(uart_read_available(&t, buffer, 2, &read) == UART_NO_ERROR);
+    REQUIRE(read == 2);
+    REQUIRE(buffer[0] == 0x01);
+    REQUIRE(buffer[1] == 0x02);
+
+    REQUIRE(uart_read_available(&t, buffer, 4, &read) == UART_NO_ERROR);
+    REQUIRE(read == 1);
+    REQUIRE(buffer[0] == 0x03);
+
+    REQUIRE(uart_read_available(&t, buffer, 4, &read) == UART_NO_ERROR);
+    REQUIRE(read == 0);
+
+    uart_close(&t);
+    REQUIRE(uart_read_available(&t, buffer, 4, &read) == UART_CHANNEL_CLOSED);
+}
+
+TEST_CASE("Test UART implementation gives up on reads the line leaves unfinished", "[uart]") {
+    uart_t t;
+    uint8_t buffer[4];
+    size_t read;
+
+    uart_open(&t, 9600);
+    t._impl->push_bytes({ 0x01, 0x02, 0x03 });
+
+    REQUIRE(uart_read_bytes_timeout(&t, buffer, 2, 100, &read) == UART_NO_ERROR);
+    REQUIRE(read == 2);
+    REQUIRE(buffer[1] == 0x02);
+
+    // The byte that did arrive is kept, and the whole timeout passes
+    uint64_t start = t._impl->now_ns;
+    REQUIRE(uart_read_bytes_timeout(&t, buffer, 4, 100, &read) == UART_TIMEOUT);
+    REQUIRE(read == 1);
+    REQUIRE(buffer[0] == 0x03);
+    REQUIRE(t._impl->now_ns - start >= 100000000ull);
+
+    uart_close(&t);
+    REQUIRE(uart_read_bytes_timeout(&t, buffer, 4, 100, &read) == UART_CHANNEL_CLOSED);
+}
+
+namespace {
+    struct completion {
+        int calls;
+        uart_t * channel;
+        uart_error_t result;
+    };
+
+    void record_completion(uart_t * channel, uart_error_t result, void * context) {
+        completion * c = static_cast<completion *>(context);
+        c->calls++;
+        c->channel = channel;
+        c->result = result;
+    }
+}
+
+TEST_CASE("Test UART asynchronous writes complete through the DMA", "[uart][dma]") {
+    uart_t t;
+    uint8_t frame[] = { 0x48, 0x65, 0x10, 0x03, 0x00, 0x02, 0x15, 0x4b, 0xAA, 0xBB };
+    completion c = { 0, nullptr, UART_count };
+
+    mock_dma().reset();
+    uart_open(&t, 9600);
+
+    REQUIRE(uart_write_bytes_async(&t, frame, sizeof(frame), record_completion, &c) == UART_NO_ERROR);
+
+    SECTION("Nothing moves until the DMA is triggered") {
+        REQUIRE(uart_write_async_busy(&t));
+        REQUIRE(c.calls == 0);
+        REQUIRE(t._impl->output.empty());
+
+        mock_dma().step(4);
+        REQUIRE_THAT(t, HasWrittenBytes({ 0x48, 0x65, 0x10, 0x03 }));
+        REQUIRE(c.calls == 0);
+
+        mock_dma().run_all();
+        REQUIRE_FALSE(uart_write_async_busy(&t));
+        REQUIRE(c.calls == 1);
+        REQUIRE(c.channel == &t);
+        REQUIRE(c.result == UART_NO_ERROR);
+        REQUIRE_THAT(t, HasWrittenBytes(std::vector<uint8_t>(frame, frame + sizeof(frame))));
+    }
+
+    SECTION("A second asynchronous write is refused while one is in flight") {
+        REQUIRE(uart_write_bytes_async(&t, frame, 2, record_completion, &c) == UART_BUSY);
+        REQUIRE(uart_wait_async(&t) == UART_NO_ERROR);
+        REQUIRE(c.calls == 1);
+        REQUIRE(uart_write_bytes_async(&t, frame, 2, record_completion, &c) == UART_NO_ERROR);
+        REQUIRE(uart_wait_async(&t) == UART_NO_ERROR);
+        REQUIRE(c.calls == 2);
+        REQUIRE_THAT(t, HasWrittenBytes({ 0x15, 0x4b, 0xAA, 0xBB, 0x48, 0x65 }));
+    }
+
+    SECTION("Synchronous writes queue behind the transfer") {
+        REQUIRE(uart_write_byte(&t, 0x01) == UART_NO_ERROR);
+        REQUIRE(c.calls == 1);
+        REQUIRE_THAT(t, HasWrittenBytes({ 0xAA, 0xBB, 0x01 }));
+    }
+
+    uart_close(&t);
+}
+
+TEST_CASE("Test UART asynchronous writes let go of their DMA channel", "[uart][dma]") {
+    uart_t first;
+    uart_t second;
+    uint8_t data[] = { 1, 2, 3 };
+    completion c = { 0, nullptr, UART_count };
+
+    mock_dma().reset();
+    uart_open(&first, 9600);
+    uart_open(&second, 9600);
+
+    REQUIRE(uart_write_bytes_async(&first, data, 3, record_completion, &c) == UART_NO_ERROR);
+    int slot = first._impl->dma_channel;
+    REQUIRE(uart_wait_async(&first) == UART_NO_ERROR);
+    REQUIRE(first._impl->dma_channel == -1);
+
+    // The second channel's transfer takes the slot the first one used
+    REQUIRE(uart_write_bytes_async(&second, data, 3, record_completion, &c) == UART_NO_ERROR);
+    REQUIRE(second._impl->dma_channel == slot);
+
+    SECTION("The first channel isn't busy with the second's transfer") {
+        REQUIRE_FALSE(uart_write_async_busy(&first));
+        REQUIRE(uart_write_bytes_async(&first, data, 1, record_completion, &c) == UART_NO_ERROR);
+        REQUIRE(uart_wait_async(&first) == UART_NO_ERROR);
+    }
+
+    SECTION("The first channel doesn't run the second's transfer") {
+        REQUIRE(uart_write_byte(&first, 9) == UART_NO_ERROR);
+        REQUIRE(uart_wait_async(&first) == UART_NO_ERROR);
+        REQUIRE(uart_write_async_busy(&second));
+        REQUIRE(second._impl->output.empty());
+    }
+
+    SECTION("Closing the first channel leaves the second's transfer alone") {
+        uart_close(&first);
+        REQUIRE(uart_write_async_busy(&second));
+        mock_dma().run_all();
+        REQUIRE(second._impl->output == std::vector<uint8_t>({ 1, 2, 3 }));
+    }
+
+    uart_close(&first);
+    uart_close(&second);
+}
+
+TEST_CASE("Test UART asynchronous writes on a closed channel", "[uart][dma]") {
+    uart_t t = { nullptr };
+    uint8_t data[] = { 1, 2, 3 };
+    completion c = { 0, nullptr, UART_count };
+
+    REQUIRE(uart_write_bytes_async(&t, data, 3, record_completion, &c) == UART_CHANNEL_CLOSED);
+    REQUIRE(uart_wait_async(&t) == UART_CHANNEL_CLOSED);
+    REQUIRE_FALSE(uart_write_async_busy(&t));
+    REQUIRE(c.calls == 0);
+}
+
+TEST_CASE("Test UART asynchronous writes of nothing complete immediately", "[uart][dma]") {
+    uart_t t;
+    completion c = { 0, nullptr, UART_count };
+
+    mock_dma().reset();
+    uart_open(&t, 9600);
+
+    REQUIRE(uart_write_bytes_async(&t, nullptr, 0, record_completion, &c) == UART_NO_ERROR);
+    REQUIRE(c.calls == 1);
+    REQUIRE(t._impl->output.empty());
+
+    uart_close(&t);
+}
+
+TEST_CASE("Test UART input is read in the order it was pushed", "[uart]") {
+    uart_t t;
+    uart_open(&t, 9600);
+
+    // Enough to wrap and grow the ring several times
+    std::vector<uint8_t> bytes(100000);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = i * 7;
+    }
+    t._impl->push_byte(bytes[0]);
+    t._impl->push_bytes(bytes.begin() + 1, bytes.begin() + 10);
+    t._impl->push_bytes(bytes.begin() + 10, bytes.end());
+    REQUIRE(t._impl->input.size() == bytes.size());
+
+    std::vector<uint8_t> read(bytes.size());
+    uint8_t byte;
+    REQUIRE(uart_read_byte(&t, &byte) == UART_NO_ERROR);
+    read[0] = byte;
+    REQUIRE(uart_read_bytes(&t, read.data() + 1, 4999) == UART_NO_ERROR);
+    for (size_t offset = 5000; offset < read.size(); offset += 1000) {
+        // Interleave pushes with reads so the ring wraps around
+        t._impl->push_bytes({ 0xAB, 0xCD });
+        size_t n;
+        REQUIRE(uart_read_available(&t, read.data() + offset, 1000, &n) == UART_NO_ERROR);
+        REQUIRE(n == 1000);
+    }
+    REQUIRE(read == bytes);
+
+    std::vector<uint8_t> tail(200);
+    size_t n;
+    REQUIRE(uart_read_available(&t, tail.data(), tail.size(), &n) == UART_NO_ERROR);
+    REQUIRE(n == 190);
+    REQUIRE(tail[0] == 0xAB);
+    REQUIRE(tail[1] == 0xCD);
+    REQUIRE(uart_read_byte(&t, &byte) == UART_SIGNAL_FAULT);
+
+    uart_close(&t);
+}
+
+TEST_CASE("Test UART charges virtual time for the wire", "[uart]") {
+    uart_t t;
+    uint8_t data[10] = {};
+    // 10 bits per byte at 9600 bits per second
+    const uint64_t byte_ns = 1041666;
+
+    mock_dma().reset();
+    uart_open(&t, 9600);
+    REQUIRE(t._impl->byte_time_ns() == byte_ns);
+
+    SECTION("Blocking writes wait for the wire") {
+        REQUIRE(uart_write_bytes(&t, data, 10) == UART_NO_ERROR);
+        REQUIRE(t._impl->now_ns == 10 * byte_ns);
+        REQUIRE(t._impl->timing.bytes_written == 10);
+        REQUIRE(t._impl->timing.tx_busy_ns == 10 * byte_ns);
+    }
+
+    SECTION("Asynchronous writes only cost time when waited on") {
+        REQUIRE(uart_write_bytes_async(&t, data, 10, nullptr, nullptr) == UART_NO_ERROR);
+        mock_dma().run_all();
+        REQUIRE(t._impl->now_ns == 0);
+        t._impl->advance(4 * byte_ns);
+        REQUIRE(uart_wait_async(&t) == UART_NO_ERROR);
+        REQUIRE(t._impl->now_ns == 10 * byte_ns);
+    }
+
+    SECTION("Replies start once the request has gone out") {
+        t._impl->push_bytes({ 1, 2, 3, 4 });
+        REQUIRE(uart_write_bytes(&t, data, 2) == UART_NO_ERROR);
+        REQUIRE(uart_read_bytes(&t, data, 4) == UART_NO_ERROR);
+        REQUIRE(t._impl->now_ns == 6 * byte_ns);
+        REQUIRE(t._impl->timing.reads == 1);
+        REQUIRE(t._impl->timing.read_wait_ns == 4 * byte_ns);
+
+        // The far end was idle while this side slept, so nothing is waited for
+        t._impl->advance(100 * byte_ns);
+        size_t n;
+        REQUIRE(uart_read_available(&t, data, 4, &n) == UART_NO_ERROR);
+        REQUIRE(n == 0);
+        REQUIRE(t._impl->timing.reads == 1);
+        REQUIRE(t._impl->bytes_per_second() == Approx(6 * 1e9 / (106 * byte_ns)));
+    }
+
+    SECTION("Bytes are charged at the rate in effect") {
+        REQUIRE(uart_set_baud_rate(&t, BAUD_115200) == UART_NO_ERROR);
+        REQUIRE(uart_write_bytes(&t, data, 10) == UART_NO_ERROR);
+        REQUIRE(t._impl->now_ns == 10 * (10 * 1000000000ull / 115200));
+    }
+
+    uart_close(&t);
+}
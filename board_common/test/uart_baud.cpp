@@ -0,0 +1,206 @@
+#include <catch/catch.hpp>
+
+#include "uart_baud.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+    const std::vector<uint32_t> CLOCKS = {
+#       define CLOCK_OP(C, _) C,
+        UART_CLOCK_LIST(CLOCK_OP, _)
+#       undef CLOCK_OP
+    };
+
+    const std::vector<uart_baud_rate_t> BAUDS = {
+#       define BAUD_OP(B, _) BAUD_ ## B,
+        UART_BAUD_RATE_LIST(BAUD_OP, _)
+#       undef BAUD_OP
+    };
+
+    /// Fraction to UCBRSx table from the eUSCI family user's guide
+    const std::vector<std::pair<double, uint8_t>> EUSCI_UCBRS = {
+        { 0.0000, 0x00 }, { 0.0529, 0x01 }, { 0.0715, 0x02 }, { 0.0835, 0x04 },
+        { 0.1001, 0x08 }, { 0.1252, 0x10 }, { 0.1430, 0x20 }, { 0.1670, 0x11 },
+        { 0.2147, 0x21 }, { 0.2224, 0x22 }, { 0.2503, 0x44 }, { 0.3000, 0x25 },
+        { 0.3335, 0x49 }, { 0.3575, 0x4A }, { 0.3753, 0x52 }, { 0.4003, 0x92 },
+        { 0.4286, 0x53 }, { 0.4378, 0x55 }, { 0.5002, 0xAA }, { 0.5715, 0x6B },
+        { 0.6003, 0xAD }, { 0.6254, 0xB5 }, { 0.6432, 0xB6 }, { 0.6667, 0xD6 },
+        { 0.7001, 0xB7 }, { 0.7147, 0xBB }, { 0.7503, 0xDD }, { 0.7861, 0xED },
+        { 0.8004, 0xEE }, { 0.8333, 0xBF }, { 0.8464, 0xDF }, { 0.8572, 0xEF },
+        { 0.8751, 0xF7 }, { 0.9004, 0xFB }, { 0.9170, 0xFD }, { 0.9288, 0xFE },
+    };
+
+    /// USCI UCBRSx modulation patterns, start bit first
+    const uint8_t USCI_UCBRS_PATTERNS[8] = {
+        0x00, 0x02, 0x22, 0x2A, 0xAA, 0xAE, 0xEE, 0xFE
+    };
+
+    /// The TI algorithm, done in floating point
+    uart_baud_divisor_t eusci_reference(double clock, double baud) {
+        double n = clock / baud;
+        double fraction = n - std::floor(n);
+        uart_baud_divisor_t d = {0, 0, 0, false};
+
+        if (n > 16) {
+            d.oversampling = true;
+            d.prescaler = (uint16_t)std::floor(n / 16);
+            d.first_modulation = (uint8_t)std::floor((n / 16 - std::floor(n / 16)) * 16);
+        }
+        else {
+            d.prescaler = (uint16_t)std::floor(n);
+        }
+        for (const auto & entry : EUSCI_UCBRS) {
+            // The table is only given to four places
+            if (std::floor(fraction * 10000) / 10000 >= entry.first) {
+                d.second_modulation = entry.second;
+            }
+        }
+        return d;
+    }
+
+    /// Clock cycles the eUSCI spends transmitting bit i of a frame. The
+    /// UCBRSx pattern is applied MSB first, starting with the start bit.
+    unsigned eusci_bit_cycles(const uart_baud_divisor_t & d, unsigned i) {
+        unsigned m = (d.second_modulation >> (7 - i % 8)) & 1;
+        if (d.oversampling) {
+            return 16u * d.prescaler + d.first_modulation + m;
+        }
+        return d.prescaler + m;
+    }
+
+    /// Clock cycles the USCI spends transmitting bit i of a frame
+    unsigned usci_bit_cycles(const uart_baud_divisor_t & d, unsigned i) {
+        if (d.oversampling) {
+            return 16u * d.prescaler + d.first_modulation;
+        }
+        return d.prescaler + ((USCI_UCBRS_PATTERNS[d.second_modulation] >> (i % 8)) & 1);
+    }
+
+    /// Worst transmit bit error over a start bit, 8 data bits and a stop
+    /// bit, in percent of a bit, as defined in the family user's guides
+    template<typename F>
+    double worst_tx_error(double clock, double baud, F bit_cycles) {
+        double worst = 0;
+        double elapsed = 0;
+        for (unsigned i = 0; i < 10; ++i) {
+            elapsed += bit_cycles(i);
+            double error = (elapsed * baud / clock - (i + 1)) * 100;
+            worst = std::max(worst, std::fabs(error));
+        }
+        return worst;
+    }
+
+    /// The error budget for a given number of clocks per bit. The user's
+    /// guide algorithms round the modulation, so a frame can drift by up to
+    /// one and a half clock cycles, plus 1% of a bit for the coarser USCI
+    /// oversampling. With only a few clocks per bit a cycle is a large
+    /// fraction of a bit, and the guides accept around 20% at 32 kHz / 9600,
+    /// so cap it at 25%.
+    double error_budget(double n) {
+        return std::min(25.0, 150.0 / n + 1.0);
+    }
+}
+
+TEST_CASE("Baud rates convert to bits per second", "[uart][baud]") {
+    REQUIRE(uart_baud_rate_bps(BAUD_9600) == 9600);
+    REQUIRE(uart_baud_rate_bps(BAUD_76800) == 76800);
+    REQUIRE(uart_baud_rate_bps(BAUD_115200) == 115200);
+    REQUIRE(uart_baud_rate_bps(BAUD_count) == 0);
+}
+
+TEST_CASE("Unknown clocks and clocks that are too slow have no divisor", "[uart][baud]") {
+    REQUIRE(uart_eusci_baud_divisor(12345, BAUD_9600) == NULL);
+    REQUIRE(uart_usci_baud_divisor(12345, BAUD_9600) == NULL);
+    REQUIRE(uart_eusci_baud_divisor(32768, BAUD_19200) == NULL);
+    REQUIRE(uart_usci_baud_divisor(32768, BAUD_115200) == NULL);
+    REQUIRE(uart_eusci_baud_divisor(32768, BAUD_count) == NULL);
+}
+
+TEST_CASE("eUSCI divisors match the TI algorithm and known settings", "[uart][baud]") {
+    const uart_baud_divisor_t * d;
+
+    // The settings the dev board used before the tables existed
+    d = uart_eusci_baud_divisor(32768, BAUD_9600);
+    REQUIRE(d != NULL);
+    REQUIRE(d->prescaler == 3);
+    REQUIRE(d->second_modulation == 0x92);
+    REQUIRE_FALSE(d->oversampling);
+
+    // User's guide example: 8 MHz, 115200 baud
+    d = uart_eusci_baud_divisor(8000000, BAUD_115200);
+    REQUIRE(d != NULL);
+    REQUIRE(d->oversampling);
+    REQUIRE(d->prescaler == 4);
+    REQUIRE(d->first_modulation == 5);
+    REQUIRE(d->second_modulation == 0x55);
+
+    for (uint32_t clock : CLOCKS) {
+        for (uart_baud_rate_t baud : BAUDS) {
+            double bps = uart_baud_rate_bps(baud);
+            d = uart_eusci_baud_divisor(clock, baud);
+            INFO("clock " << clock << " baud " << bps);
+            if (clock < 3 * bps) {
+                REQUIRE(d == NULL);
+                continue;
+            }
+            REQUIRE(d != NULL);
+
+            uart_baud_divisor_t expected = eusci_reference(clock, bps);
+            REQUIRE(d->prescaler == expected.prescaler);
+            REQUIRE((int)d->first_modulation == (int)expected.first_modulation);
+            REQUIRE((int)d->second_modulation == (int)expected.second_modulation);
+            REQUIRE(d->oversampling == expected.oversampling);
+
+            double error = worst_tx_error(clock, bps,
+                [d](unsigned i) { return eusci_bit_cycles(*d, i); });
+            INFO("worst TX error " << error << "%");
+            REQUIRE(error < error_budget(clock / bps));
+        }
+    }
+}
+
+TEST_CASE("USCI divisors stay within the bit error budget", "[uart][baud]") {
+    const uart_baud_divisor_t * d;
+
+    // The settings the data board used before the tables existed
+    d = uart_usci_baud_divisor(1048576, BAUD_9600);
+    REQUIRE(d != NULL);
+    REQUIRE_FALSE(d->oversampling);
+    REQUIRE(d->prescaler == 109);
+    REQUIRE(d->second_modulation == 2);
+
+    d = uart_usci_baud_divisor(1048576, BAUD_115200);
+    REQUIRE(d != NULL);
+    REQUIRE_FALSE(d->oversampling);
+    REQUIRE(d->prescaler == 9);
+    REQUIRE(d->second_modulation == 1);
+
+    // Oversampling is only used where it loses next to nothing
+    d = uart_usci_baud_divisor(16000000, BAUD_115200);
+    REQUIRE(d != NULL);
+    REQUIRE(d->oversampling);
+    REQUIRE(d->prescaler == 8);
+    REQUIRE(d->first_modulation == 11);
+
+    for (uint32_t clock : CLOCKS) {
+        for (uart_baud_rate_t baud : BAUDS) {
+            double bps = uart_baud_rate_bps(baud);
+            d = uart_usci_baud_divisor(clock, baud);
+            INFO("clock " << clock << " baud " << bps);
+            if (clock < 3 * bps) {
+                REQUIRE(d == NULL);
+                continue;
+            }
+            REQUIRE(d != NULL);
+            REQUIRE(d->first_modulation < 16);
+            REQUIRE(d->second_modulation < 8);
+
+            double error = worst_tx_error(clock, bps,
+                [d](unsigned i) { return usci_bit_cycles(*d, i); });
+            INFO("worst TX error " << error << "%");
+            REQUIRE(error < error_budget(clock / bps));
+        }
+    }
+}
@@ -0,0 +1,242 @@
+#include <catch/catch.hpp>
+
+#include "uart.h"
+#include "uart_fd.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace {
+    /// A channel on one end of a socketpair, with the other end to play
+    /// the device
+    struct socket_fixture {
+        uart_t uart;
+        int peer;
+
+        socket_fixture() {
+            int fds[2];
+            REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+            REQUIRE(uart_open_fd(&uart, fds[0], 9600));
+            uart._impl->read_timeout_ms = 20;
+            peer = fds[1];
+        }
+
+        ~socket_fixture() {
+            uart_close(&uart);
+            if (peer >= 0) {
+                close(peer);
+            }
+        }
+
+        void send(const std::vector<uint8_t> & bytes) {
+            REQUIRE(write(peer, bytes.data(), bytes.size()) == (ssize_t) bytes.size());
+        }
+
+        /// Everything the channel has sent so far
+        std::vector<uint8_t> received() {
+            std::vector<uint8_t> bytes;
+            uint8_t chunk[256];
+            int flags = fcntl(peer, F_GETFL);
+            fcntl(peer, F_SETFL, flags | O_NONBLOCK);
+            ssize_t n;
+            while ((n = read(peer, chunk, sizeof(chunk))) > 0) {
+                bytes.insert(bytes.end(), chunk, chunk + n);
+            }
+            fcntl(peer, F_SETFL, flags);
+            return bytes;
+        }
+    };
+}
+
+TEST_CASE("Descriptor UARTs move bytes both ways", "[uart][posix]") {
+    socket_fixture f;
+    uint8_t bytes[4];
+
+    SECTION("Writes are batched until the channel reads or waits") {
+        REQUIRE(uart_write_bytes(&f.uart, (const uint8_t *) "\x01\x02\x03", 3) == UART_NO_ERROR);
+        REQUIRE(f.received().empty());
+        REQUIRE(uart_wait_async(&f.uart) == UART_NO_ERROR);
+        REQUIRE(f.received() == std::vector<uint8_t>({ 1, 2, 3 }));
+    }
+
+    SECTION("A read flushes the request first") {
+        f.send({ 0xAA, 0xBB });
+        REQUIRE(uart_write_byte(&f.uart, 0x10) == UART_NO_ERROR);
+        REQUIRE(uart_read_bytes(&f.uart, bytes, 2) == UART_NO_ERROR);
+        REQUIRE(bytes[0] == 0xAA);
+        REQUIRE(bytes[1] == 0xBB);
+        REQUIRE(f.received() == std::vector<uint8_t>({ 0x10 }));
+    }
+
+    SECTION("Batches larger than the batch length go out whole") {
+        std::vector<uint8_t> data(UART_FD_BATCH_LENGTH * 3 + 7);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = i;
+        }
+        REQUIRE(uart_write_bytes(&f.uart, data.data(), data.size()) == UART_NO_ERROR);
+        REQUIRE(uart_wait_async(&f.uart) == UART_NO_ERROR);
+        REQUIRE(f.received() == data);
+        REQUIRE(f.uart._impl->timing.bytes_written == data.size());
+    }
+
+    SECTION("Asynchronous writes complete before they return") {
+        int calls = 0;
+        REQUIRE(uart_write_bytes_async(&f.uart, (const uint8_t *) "\x05\x06", 2,
+            [](uart_t *, uart_error_t result, void * context) {
+                REQUIRE(result == UART_NO_ERROR);
+                ++*static_cast<int *>(context);
+            }, &calls) == UART_NO_ERROR);
+        REQUIRE(calls == 1);
+        REQUIRE_FALSE(uart_write_async_busy(&f.uart));
+        REQUIRE(f.received() == std::vector<uint8_t>({ 5, 6 }));
+    }
+
+    SECTION("Reading what is available never waits") {
+        size_t read;
+        REQUIRE(uart_read_available(&f.uart, bytes, 4, &read) == UART_NO_ERROR);
+        REQUIRE(read == 0);
+        f.send({ 1, 2, 3, 4, 5 });
+        REQUIRE(uart_read_available(&f.uart, bytes, 4, &read) == UART_NO_ERROR);
+        REQUIRE(read == 4);
+        REQUIRE(uart_read_byte(&f.uart, bytes) == UART_NO_ERROR);
+        REQUIRE(bytes[0] == 5);
+    }
+
+    SECTION("A read times out when nothing comes") {
+        f.send({ 1 });
+        REQUIRE(uart_read_bytes(&f.uart, bytes, 2) == UART_SIGNAL_FAULT);
+    }
+
+    SECTION("A read fails once the other end hangs up") {
+        close(f.peer);
+        f.peer = -1;
+        REQUIRE(uart_read_byte(&f.uart, bytes) == UART_SIGNAL_FAULT);
+    }
+
+    SECTION("Sockets have no baud rate to set") {
+        for (int baud = 0; baud < BAUD_count; ++baud) {
+            REQUIRE(uart_baud_rate_supported(&f.uart, (uart_baud_rate_t) baud));
+        }
+        REQUIRE(uart_set_baud_rate(&f.uart, BAUD_115200) == UART_NO_ERROR);
+        REQUIRE(f.uart._impl->baud_rate == 115200);
+    }
+}
+
+TEST_CASE("Descriptor UARTs follow the baud rate on terminals", "[uart][posix]") {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        WARN("No pseudo-terminals to test with");
+        return;
+    }
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    REQUIRE(slave >= 0);
+    // Stays open after the channel closes the slave, to see what it left
+    int watcher = open(ptsname(master), O_RDWR | O_NOCTTY);
+    REQUIRE(watcher >= 0);
+    struct termios original;
+    REQUIRE(tcgetattr(watcher, &original) == 0);
+
+    uart_t uart;
+    REQUIRE(uart_open_fd(&uart, slave, 9600));
+    REQUIRE(uart._impl->device->terminal);
+
+    struct termios tio;
+    REQUIRE(tcgetattr(slave, &tio) == 0);
+    REQUIRE(cfgetospeed(&tio) == B9600);
+    // Raw, so bytes go through untouched
+    REQUIRE((tio.c_lflag & ICANON) == 0);
+
+    REQUIRE(uart_set_baud_rate(&uart, BAUD_115200) == UART_NO_ERROR);
+    REQUIRE(tcgetattr(slave, &tio) == 0);
+    REQUIRE(cfgetospeed(&tio) == B115200);
+    REQUIRE(cfgetispeed(&tio) == B115200);
+
+#ifndef B76800
+    REQUIRE_FALSE(uart_baud_rate_supported(&uart, BAUD_76800));
+    REQUIRE(uart_set_baud_rate(&uart, BAUD_76800) == UART_UNSUPPORTED);
+    REQUIRE(uart._impl->baud_rate == 115200);
+#endif
+
+    const uint8_t data[] = { 0x00, 0x0a, 0x0d, 0x03, 0xff };
+    REQUIRE(uart_write_bytes(&uart, data, sizeof(data)) == UART_NO_ERROR);
+    REQUIRE(uart_wait_async(&uart) == UART_NO_ERROR);
+    uint8_t echoed[sizeof(data)];
+    size_t got = 0;
+    while (got < sizeof(data)) {
+        ssize_t n = read(master, echoed + got, sizeof(data) - got);
+        REQUIRE(n > 0);
+        got += n;
+    }
+    REQUIRE(std::vector<uint8_t>(echoed, echoed + got) == std::vector<uint8_t>(data, data + sizeof(data)));
+
+    uart_close(&uart);
+
+    // The terminal gets its settings back
+    REQUIRE(tcgetattr(watcher, &tio) == 0);
+    REQUIRE(tio.c_iflag == original.c_iflag);
+    REQUIRE(tio.c_oflag == original.c_oflag);
+    REQUIRE(tio.c_lflag == original.c_lflag);
+    REQUIRE(cfgetospeed(&tio) == cfgetospeed(&original));
+
+    close(watcher);
+    close(master);
+}
+
+TEST_CASE("Descriptor UARTs leave the process's own terminal alone", "[uart][posix]") {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        WARN("No pseudo-terminals to test with");
+        return;
+    }
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    REQUIRE(slave >= 0);
+    struct termios original;
+    REQUIRE(tcgetattr(slave, &original) == 0);
+
+    // Put standard error on the terminal, as if the user ran us from it
+    int saved_stderr = dup(STDERR_FILENO);
+    REQUIRE(dup2(slave, STDERR_FILENO) == STDERR_FILENO);
+
+    uart_t uart;
+    bool opened = uart_open_fd(&uart, dup(STDERR_FILENO), 9600);
+    bool terminal = opened && uart._impl->device->terminal;
+    struct termios tio;
+    int got = tcgetattr(slave, &tio);
+    if (opened) {
+        uart_close(&uart);
+    }
+
+    dup2(saved_stderr, STDERR_FILENO);
+    close(saved_stderr);
+
+    REQUIRE(opened);
+    REQUIRE_FALSE(terminal);
+    REQUIRE(got == 0);
+    REQUIRE(tio.c_lflag == original.c_lflag);
+    REQUIRE(tio.c_oflag == original.c_oflag);
+
+    close(slave);
+    close(master);
+}
+
+TEST_CASE("Descriptors that can't be used are refused", "[uart][posix]") {
+    uart_t uart;
+    REQUIRE_FALSE(uart_open_fd(&uart, -1, 9600));
+    REQUIRE(uart._impl == nullptr);
+    REQUIRE(uart_write_byte(&uart, 1) == UART_CHANNEL_CLOSED);
+}
+
+TEST_CASE("Descriptors that can't be polled still take writes", "[uart][posix]") {
+    uart_t uart;
+    REQUIRE(uart_open_fd(&uart, open("/dev/null", O_RDWR), 9600));
+    REQUIRE(uart_write_bytes(&uart, (const uint8_t *) "log\n", 4) == UART_NO_ERROR);
+    REQUIRE(uart_wait_async(&uart) == UART_NO_ERROR);
+    uint8_t byte;
+    REQUIRE(uart_read_byte(&uart, &byte) == UART_SIGNAL_FAULT);
+    uart_close(&uart);
+}
@@ -0,0 +1,56 @@
+#include "bench.hpp"
+#include "scenario_test.hpp"
+
+namespace {
+    /// The virtual time each run covers
+    const uint64_t RUN_NS = 20000 * SCENARIO_MS;
+
+    /// Run the sensor to ground scenario, timing the host. The figures that
+    /// matter for the link come from the virtual clock: samples reaching the
+    /// ground a second, their mean and worst latency, and payload bytes
+    /// reaching the ground a second.
+    void run(bench::state & state, const scenario_config & config) {
+        size_t arrivals = 0;
+        double mean_latency_ns = 0;
+        uint64_t max_latency_ns = 0;
+        uint64_t ground_bytes = 0;
+        while (state.keep_running()) {
+            scenario s(config);
+            s.sim.run_until(RUN_NS);
+            arrivals = s.arrivals.size();
+            mean_latency_ns = s.mean_latency_ns();
+            max_latency_ns = s.max_latency_ns();
+            ground_bytes = s.ground_bytes;
+        }
+
+        double seconds = RUN_NS / 1e9;
+        state.set_counter("samples/s", arrivals / seconds);
+        state.set_counter("mean_ms", mean_latency_ns / SCENARIO_MS);
+        state.set_counter("max_ms", (double) max_latency_ns / SCENARIO_MS);
+        state.set_counter("ground_B/s", ground_bytes / seconds);
+    }
+}
+
+/// With the serial line to the radio at the given rate
+void bench_cosim_uart(bench::state & state, size_t baud) {
+    scenario_config config;
+    config.uart_baud = baud;
+    run(state, config);
+}
+BENCHMARK_ARGS(bench_cosim_uart, 9600, 38400, 115200);
+
+/// With the radio on the air at the given rate
+void bench_cosim_rf(bench::state & state, size_t baud) {
+    scenario_config config;
+    config.rf.baud = baud;
+    run(state, config);
+}
+BENCHMARK_ARGS(bench_cosim_rf, 1200, 9600, 19200);
+
+/// With the downlink batching records for the given number of milliseconds
+void bench_cosim_downlink_latency(bench::state & state, size_t latency_ms) {
+    scenario_config config;
+    config.downlink_latency_ms = latency_ms;
+    run(state, config);
+}
+BENCHMARK_ARGS(bench_cosim_downlink_latency, 20, 100);
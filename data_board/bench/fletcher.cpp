@@ -0,0 +1,20 @@
+#include "bench.hpp"
+#include "fletcher.h"
+
+#include <vector>
+
+/// The Fletcher checksum over a frame's header and payload. The kernel
+/// takes four bytes a trip, so the short lengths cover its tail.
+void bench_fletcher_checksum(bench::state & state, size_t length) {
+    std::vector<uint8_t> data(length, 0xA5);
+    uint8_t output[2];
+    while (state.keep_running()) {
+        fletcher_ctx_t ctx;
+        fletcher_init(&ctx);
+        fletcher_update(&ctx, data.data(), data.size());
+        fletcher_final(&ctx, output);
+        bench::do_not_optimize(output);
+    }
+    state.set_bytes_per_op(length);
+}
+BENCHMARK_ARGS(bench_fletcher_checksum, 0, 1, 3, 4, 16, 64, 255);
@@ -0,0 +1,186 @@
+#include "bench.hpp"
+#include "fletcher.h"
+#include "lithium.h"
+#include "lithium_internal.h"
+#include "lithium_test.hpp"
+#include "uart.h"
+#include "uart_baud.h"
+
+#include <vector>
+
+namespace {
+    typedef std::vector<uint8_t> bytes_t;
+
+    /// Frames the mock UART holds before the benchmark empties it, outside
+    /// the timed loop
+    const size_t MOCK_LOG_LIMIT = 1 << 16;
+
+    /// A TRANSMIT_DATA packet with a payload of the given length
+    lithium_packet_t transmit_packet(size_t length) {
+        lithium_packet_t packet;
+        packet.type = LITHIUM_I_MESSAGE;
+        packet.command = LITHIUM_COMMAND_TRANSMIT_DATA;
+        packet.payload_length = length;
+        for (size_t i = 0; i < length; ++i) {
+            packet.payload[i] = i * 7;
+        }
+        return packet;
+    }
+
+    /// The bytes the radio would see for a packet
+    bytes_t encode(lithium_packet_t packet) {
+        uart_t uart;
+        uart_open(&uart, 9600);
+        lithium_t radio;
+        lithium_open(&radio, &uart);
+        lithium_send_packet(&radio, &packet);
+        bytes_t frame = radio.uart._impl->output;
+        lithium_close(&radio);
+        return frame;
+    }
+
+    /// The rate running at a number of bits per second
+    uart_baud_rate_t baud_rate(size_t bps) {
+        for (int rate = 0; rate < BAUD_count; ++rate) {
+            if (uart_baud_rate_bps((uart_baud_rate_t) rate) == bps) {
+                return (uart_baud_rate_t) rate;
+            }
+        }
+        return BAUD_count;
+    }
+}
+
+/******************************************************************************\
+ *  Encoding                                                                  *
+\******************************************************************************/
+void bench_encode_header(bench::state & state) {
+    uint8_t header[HEADER_LENGTH];
+    uint16_t length = 0;
+    while (state.keep_running()) {
+        fletcher_ctx_t ctx;
+        encode_header(LITHIUM_I_MESSAGE, LITHIUM_COMMAND_TRANSMIT_DATA, length++ & 0xFF, header, &ctx);
+        bench::do_not_optimize(header);
+        bench::do_not_optimize(ctx);
+    }
+    state.set_bytes_per_op(HEADER_LENGTH);
+}
+BENCHMARK(bench_encode_header);
+
+/// A whole frame encoded and written to the mock UART: the header, the
+/// checksum carried on over the payload, and the gathered write
+void bench_lithium_send_packet(bench::state & state, size_t length) {
+    uart_t uart;
+    uart_open(&uart, 9600);
+    lithium_t radio;
+    lithium_open(&radio, &uart);
+    lithium_packet_t packet = transmit_packet(length);
+
+    while (state.keep_running()) {
+        if (radio.uart._impl->output.size() > MOCK_LOG_LIMIT) {
+            state.pause();
+            radio.uart._impl->output.clear();
+            state.resume();
+        }
+        lithium_send_packet(&radio, &packet);
+    }
+    state.set_bytes_per_op(HEADER_LENGTH + length + (length ? CHECKSUM_LENGTH : 0));
+    lithium_close(&radio);
+}
+BENCHMARK_ARGS(bench_lithium_send_packet, 0, 16, 64, 255);
+
+/******************************************************************************\
+ *  Decoding                                                                  *
+\******************************************************************************/
+void bench_lithium_parse_header(bench::state & state) {
+    bytes_t frame = encode(transmit_packet(64));
+    lithium_packet_t packet;
+    uint16_t remaining;
+    while (state.keep_running()) {
+        lithium_parse_header(frame.data(), HEADER_LENGTH, &packet, &remaining);
+        bench::do_not_optimize(remaining);
+    }
+    state.set_bytes_per_op(HEADER_LENGTH);
+}
+BENCHMARK(bench_lithium_parse_header);
+
+void bench_lithium_parse_body(bench::state & state, size_t length) {
+    bytes_t frame = encode(transmit_packet(length));
+    lithium_packet_t packet;
+    uint16_t remaining;
+    // The body is parsed against the length from the header
+    lithium_parse_header(frame.data(), HEADER_LENGTH, &packet, &remaining);
+    while (state.keep_running()) {
+        lithium_parse_body(frame.data(), frame.size(), &packet);
+        bench::do_not_optimize(packet.payload_length);
+    }
+    state.set_bytes_per_op(frame.size());
+}
+BENCHMARK_ARGS(bench_lithium_parse_body, 16, 64, 255);
+
+/// Frames read back through the decoder from the mock UART, which is
+/// refilled a batch at a time outside the timed loop
+void bench_lithium_receive_packet(bench::state & state, size_t length) {
+    uart_t uart;
+    uart_open(&uart, 9600);
+    lithium_t radio;
+    lithium_open(&radio, &uart);
+    bytes_t frame = encode(transmit_packet(length));
+    const size_t batch = MOCK_LOG_LIMIT / frame.size();
+    lithium_packet_t packet;
+
+    while (state.keep_running()) {
+        if (radio.uart._impl->input.empty()) {
+            state.pause();
+            for (size_t i = 0; i < batch; ++i) {
+                radio.uart._impl->push_bytes(frame.begin(), frame.end());
+            }
+            state.resume();
+        }
+        lithium_receive_packet(&radio, &packet);
+        bench::do_not_optimize(packet.payload_length);
+    }
+    state.set_bytes_per_op(frame.size());
+    lithium_close(&radio);
+}
+BENCHMARK_ARGS(bench_lithium_receive_packet, 0, 16, 64, 255);
+
+/******************************************************************************\
+ *  Link sessions                                                             *
+\******************************************************************************/
+/// A downlink session at the given interface rate: full payloads, each
+/// acknowledged by the radio. Besides the host time, reports the link time
+/// per frame, the link's throughput and the mean wait for a read on the
+/// mock UART's virtual clock.
+void bench_lithium_acked_transmit(bench::state & state, size_t bps) {
+    mock_radio radio;
+    uart_set_baud_rate(&radio.radio.uart, baud_rate(bps));
+    const bytes_t ack = lithium_o_message(LITHIUM_COMMAND_TRANSMIT_DATA, ACK_LENGTH);
+    const size_t batch = MOCK_LOG_LIMIT / ack.size();
+    uint8_t payload[LITHIUM_MAX_PAYLOAD_LENGTH] = {};
+    uint8_t sequence = 0;
+    lithium_packet_t packet;
+
+    while (state.keep_running()) {
+        if (radio.radio.uart._impl->input.empty() || radio.written().size() > MOCK_LOG_LIMIT) {
+            state.pause();
+            if (radio.radio.uart._impl->input.empty()) {
+                for (size_t i = 0; i < batch; ++i) {
+                    radio.reply(ack);
+                }
+            }
+            radio.written().clear();
+            state.resume();
+        }
+        payload[0] = sequence++;
+        lithium_send_transmit(&radio.radio, payload, sizeof(payload));
+        lithium_receive_packet(&radio.radio, &packet);
+        bench::do_not_optimize(packet.payload_length);
+    }
+    state.set_bytes_per_op(HEADER_LENGTH + sizeof(payload) + CHECKSUM_LENGTH);
+
+    const uart_impl & impl = *radio.radio.uart._impl;
+    state.set_counter("link_ms", impl.now_ns / 1e6 / state.iterations());
+    state.set_counter("link_B/s", impl.bytes_per_second());
+    state.set_counter("read_wait_ms", impl.timing.reads ? impl.timing.read_wait_ns / 1e6 / impl.timing.reads : 0);
+}
+BENCHMARK_ARGS(bench_lithium_acked_transmit, 9600, 115200);
@@ -0,0 +1,86 @@
+#include "bench.hpp"
+#include "lzss.h"
+#include "telemetry_test.hpp"
+
+#include <random>
+#include <vector>
+
+namespace {
+    typedef std::vector<uint8_t> bytes_t;
+
+    bytes_t random_bytes(size_t length, unsigned seed) {
+        std::mt19937 rng(seed);
+        bytes_t bytes(length);
+        for (auto & byte : bytes) {
+            byte = rng();
+        }
+        return bytes;
+    }
+
+    /// Compress a payload's worth of input, reporting the frame's length
+    /// over the input's
+    void encode(bench::state & state, const bytes_t & input) {
+        lzss_t lzss;
+        uint8_t frame[LZSS_MAX_INPUT + 1];
+        uint16_t frame_length = 0;
+        while (state.keep_running()) {
+            frame_length = lzss_encode(&lzss, input.data(), input.size(), frame);
+            bench::do_not_optimize(frame_length);
+        }
+        state.set_bytes_per_op(input.size());
+        state.set_counter("ratio", double(frame_length) / input.size());
+    }
+
+    void decode(bench::state & state, const bytes_t & input) {
+        lzss_t lzss;
+        uint8_t frame[LZSS_MAX_INPUT + 1];
+        uint16_t frame_length = lzss_encode(&lzss, input.data(), input.size(), frame);
+        uint8_t output[LZSS_MAX_INPUT];
+        uint16_t output_length;
+        while (state.keep_running()) {
+            lzss_decode(frame, frame_length, output, sizeof(output), &output_length);
+            bench::do_not_optimize(output_length);
+        }
+        state.set_bytes_per_op(input.size());
+    }
+}
+
+/******************************************************************************\
+ *  Compression                                                               *
+\******************************************************************************/
+/// The records the downlink sends, which compress well
+void bench_lzss_encode_telemetry(bench::state & state) {
+    encode(state, telemetry_records(LZSS_MAX_INPUT, 6));
+}
+BENCHMARK(bench_lzss_encode_telemetry);
+
+/// Nothing to match, so every position is searched in full and the frame
+/// goes raw
+void bench_lzss_encode_random(bench::state & state) {
+    encode(state, random_bytes(LZSS_MAX_INPUT, 7));
+}
+BENCHMARK(bench_lzss_encode_random);
+
+/// One long run of overlapping matches
+void bench_lzss_encode_zeros(bench::state & state) {
+    encode(state, bytes_t(LZSS_MAX_INPUT, 0));
+}
+BENCHMARK(bench_lzss_encode_zeros);
+
+/******************************************************************************\
+ *  Decompression                                                             *
+\******************************************************************************/
+void bench_lzss_decode_telemetry(bench::state & state) {
+    decode(state, telemetry_records(LZSS_MAX_INPUT, 6));
+}
+BENCHMARK(bench_lzss_decode_telemetry);
+
+void bench_lzss_decode_random(bench::state & state) {
+    decode(state, random_bytes(LZSS_MAX_INPUT, 7));
+}
+BENCHMARK(bench_lzss_decode_random);
+
+void bench_lzss_decode_zeros(bench::state & state) {
+    decode(state, bytes_t(LZSS_MAX_INPUT, 0));
+}
+BENCHMARK(bench_lzss_decode_zeros);
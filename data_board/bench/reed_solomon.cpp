@@ -0,0 +1,60 @@
+#include "bench.hpp"
+#include "reed_solomon.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+    typedef std::vector<uint8_t> bytes_t;
+
+    bytes_t random_bytes(size_t length, std::mt19937 & rng) {
+        bytes_t bytes(length);
+        for (auto & byte : bytes) {
+            byte = rng();
+        }
+        return bytes;
+    }
+}
+
+/// Parity for a payload of the given length
+void bench_rs_encode(bench::state & state, size_t length) {
+    std::mt19937 rng(5);
+    bytes_t data = random_bytes(length, rng);
+    uint8_t parity[RS_PARITY_LENGTH];
+    while (state.keep_running()) {
+        rs_encode(data.data(), data.size(), parity);
+        bench::do_not_optimize(parity);
+    }
+    state.set_bytes_per_op(length);
+}
+BENCHMARK_ARGS(bench_rs_encode, 16, 64, 128, RS_MAX_DATA_LENGTH);
+
+/// Correcting a full block with the given number of corrupted bytes. The
+/// block is decoded in place, so each trip starts from a copy, which costs
+/// little next to the syndromes.
+void bench_rs_decode(bench::state & state, size_t errors) {
+    std::mt19937 rng(5);
+    bytes_t corrupted = random_bytes(RS_MAX_BLOCK_LENGTH, rng);
+    rs_encode(corrupted.data(), RS_MAX_DATA_LENGTH, corrupted.data() + RS_MAX_DATA_LENGTH);
+
+    std::vector<size_t> positions(corrupted.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        positions[i] = i;
+    }
+    std::shuffle(positions.begin(), positions.end(), rng);
+    std::uniform_int_distribution<int> flips(1, 255);
+    for (size_t i = 0; i < errors; ++i) {
+        corrupted[positions[i]] ^= flips(rng);
+    }
+
+    uint8_t block[RS_MAX_BLOCK_LENGTH];
+    while (state.keep_running()) {
+        std::memcpy(block, corrupted.data(), sizeof(block));
+        int16_t corrected = rs_decode(block, sizeof(block));
+        bench::do_not_optimize(corrected);
+    }
+    state.set_bytes_per_op(RS_MAX_BLOCK_LENGTH);
+}
+BENCHMARK_ARGS(bench_rs_decode, 0, 1, 8, RS_PARITY_LENGTH / 2);
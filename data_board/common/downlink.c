@@ -0,0 +1,106 @@
+#include "downlink.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+void downlink_init(downlink_t * downlink, lithium_pool_t * pool, uint32_t latency, downlink_send_t send, void * context) {
+    downlink->pool = pool;
+    downlink->packet = LITHIUM_HANDLE_NONE;
+    downlink->latency = latency;
+    downlink->deadline = 0;
+    downlink->capacity = LITHIUM_MAX_PAYLOAD_LENGTH;
+    downlink->send = send;
+    downlink->context = context;
+    downlink->stats.records = 0;
+    downlink->stats.frames = 0;
+    downlink->stats.bytes = 0;
+    downlink->stats.dropped = 0;
+}
+
+void downlink_set_capacity(downlink_t * downlink, uint16_t capacity) {
+    downlink->capacity = capacity < LITHIUM_MAX_PAYLOAD_LENGTH ? capacity : LITHIUM_MAX_PAYLOAD_LENGTH;
+}
+
+bool downlink_add(downlink_t * downlink, const uint8_t * record, uint8_t length, uint32_t now) {
+    if (length == 0 || 1 + length > downlink->capacity) {
+        ++downlink->stats.dropped;
+        return false;
+    }
+
+    lithium_packet_t * packet = lithium_pool_get(downlink->pool, downlink->packet);
+    if (packet != NULL && packet->payload_length + 1 + length > downlink->capacity) {
+        downlink_flush(downlink);
+        packet = NULL;
+    }
+
+    // Start a new payload. Its first record sets the deadline.
+    if (packet == NULL) {
+        downlink->packet = lithium_pool_acquire(downlink->pool);
+        packet = lithium_pool_get(downlink->pool, downlink->packet);
+        if (packet == NULL) {
+            ++downlink->stats.dropped;
+            return false;
+        }
+        packet->type = LITHIUM_I_MESSAGE;
+        packet->command = LITHIUM_COMMAND_TRANSMIT_DATA;
+        packet->payload_length = 0;
+        downlink->deadline = now + downlink->latency;
+    }
+
+    packet->payload[packet->payload_length] = length;
+    memcpy(packet->payload + packet->payload_length + 1, record, length);
+    packet->payload_length += 1 + length;
+    ++downlink->stats.records;
+
+    // Not even a one byte record fits any more
+    if (packet->payload_length + 2 > downlink->capacity) {
+        downlink_flush(downlink);
+    }
+    return true;
+}
+
+void downlink_tick(downlink_t * downlink, uint32_t now) {
+    if (downlink->packet != LITHIUM_HANDLE_NONE && (int32_t)(now - downlink->deadline) >= 0) {
+        downlink_flush(downlink);
+    }
+}
+
+void downlink_flush(downlink_t * downlink) {
+    lithium_handle_t handle = downlink->packet;
+    lithium_packet_t * packet = lithium_pool_get(downlink->pool, handle);
+    if (packet == NULL) {
+        return;
+    }
+
+    downlink->packet = LITHIUM_HANDLE_NONE;
+    ++downlink->stats.frames;
+    downlink->stats.bytes += packet->payload_length;
+    downlink->send(handle, downlink->context);
+}
+
+void downlink_reader_init(downlink_reader_t * reader, const uint8_t * payload, uint16_t length) {
+    reader->payload = payload;
+    reader->length = length;
+    reader->offset = 0;
+    reader->malformed = false;
+}
+
+bool downlink_reader_next(downlink_reader_t * reader, const uint8_t ** record, uint8_t * length) {
+    if (reader->malformed || reader->offset >= reader->length) {
+        return false;
+    }
+
+    uint8_t record_length = reader->payload[reader->offset];
+    if (record_length == 0 || reader->offset + 1 + record_length > reader->length) {
+        reader->malformed = true;
+        return false;
+    }
+
+    *record = reader->payload + reader->offset + 1;
+    *length = record_length;
+    reader->offset += 1 + record_length;
+    return true;
+}
@@ -0,0 +1,197 @@
+#ifndef _COMMON_DOWNLINK_H_
+#define _COMMON_DOWNLINK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lithium.h"
+#include "lithium_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup downlink Downlink record aggregation
+ *  Packs small application records in to full TRANSMIT_DATA payloads, so
+ *  each record doesn't pay for its own Lithium header and AX.25 framing.
+ *
+ *  Each record in a payload is a one byte length followed by that many
+ *  bytes. Records are never split across payloads and are never empty, so
+ *  a payload always holds whole records back to back.
+ *  @{
+ */
+
+/// The largest record that fits in a payload after its length byte
+#define DOWNLINK_MAX_RECORD_LENGTH 254
+
+/**
+ * Called with each filled payload
+ *
+ * @param packet A TRANSMIT_DATA I-Message holding the payload. The callee
+ *      takes over the reference.
+ * @param context The context given to downlink_init
+ */
+typedef void (*downlink_send_t)(lithium_handle_t packet, void * context);
+
+/**
+ * Counters describing how well records are being packed
+ */
+typedef struct downlink_stats {
+    /**
+     * Records added to payloads
+     */
+    uint16_t records;
+    /**
+     * Payloads sent
+     */
+    uint16_t frames;
+    /**
+     * Payload bytes sent, including length bytes
+     */
+    uint32_t bytes;
+    /**
+     * Records refused because they were too long or the pool was empty
+     */
+    uint16_t dropped;
+} downlink_stats_t;
+
+/**
+ * The state of an aggregator
+ */
+typedef struct downlink {
+    /**
+     * The pool payloads are built in
+     */
+    lithium_pool_t * pool;
+    /**
+     * The payload being filled, or LITHIUM_HANDLE_NONE if there is none
+     */
+    lithium_handle_t packet;
+    /**
+     * The longest a record may wait before its payload is sent, in the units
+     * of the time given to downlink_add and downlink_tick
+     */
+    uint32_t latency;
+    /**
+     * When the payload being filled must be sent by
+     */
+    uint32_t deadline;
+    /**
+     * The most bytes put in a payload
+     */
+    uint16_t capacity;
+    /**
+     * Called with each filled payload
+     */
+    downlink_send_t send;
+    /**
+     * Passed to send
+     */
+    void * context;
+    /**
+     * Counters describing how well records are being packed
+     */
+    downlink_stats_t stats;
+} downlink_t;
+
+/**
+ * Set up an aggregator
+ *
+ * @param downlink The output aggregator
+ * @param pool The pool to build payloads in
+ * @param latency The longest a record may wait before being sent
+ * @param send Called with each filled payload
+ * @param context Passed to send
+ */
+void downlink_init(downlink_t * downlink, lithium_pool_t * pool, uint32_t latency, downlink_send_t send, void * context);
+
+/**
+ * Limit how much of each payload is filled, for example to LZSS_MAX_INPUT
+ * when payloads are compressed before they are sent. Call it before adding
+ * any records.
+ *
+ * @param downlink The aggregator to limit
+ * @param capacity The most bytes to put in a payload, at most 255
+ */
+void downlink_set_capacity(downlink_t * downlink, uint16_t capacity);
+
+/**
+ * Add a record to the payload being filled. If it doesn't fit, the payload
+ * is sent first and the record starts a new one. A payload that is full is
+ * sent straight away.
+ *
+ * @param downlink The aggregator to add to
+ * @param record The record's bytes
+ * @param length The record's length, from 1 to DOWNLINK_MAX_RECORD_LENGTH,
+ *      or one less than the capacity if that was limited
+ * @param now The current time. May wrap around.
+ *
+ * @return True if and only if the record was added
+ */
+bool downlink_add(downlink_t * downlink, const uint8_t * record, uint8_t length, uint32_t now);
+
+/**
+ * Send the payload being filled if its deadline has passed
+ *
+ * @param downlink The aggregator to check
+ * @param now The current time. May wrap around.
+ */
+void downlink_tick(downlink_t * downlink, uint32_t now);
+
+/**
+ * Send the payload being filled now, if it has any records
+ *
+ * @param downlink The aggregator to flush
+ */
+void downlink_flush(downlink_t * downlink);
+
+/**
+ * Walks the records in a received payload
+ */
+typedef struct downlink_reader {
+    /**
+     * The payload being read
+     */
+    const uint8_t * payload;
+    /**
+     * The length of the payload
+     */
+    uint16_t length;
+    /**
+     * The offset of the next record's length byte
+     */
+    uint16_t offset;
+    /**
+     * True if a record was empty or ran past the end of the payload
+     */
+    bool malformed;
+} downlink_reader_t;
+
+/**
+ * Start reading the records in a payload
+ *
+ * @param reader The output reader
+ * @param payload The payload to read
+ * @param length The length of the payload
+ */
+void downlink_reader_init(downlink_reader_t * reader, const uint8_t * payload, uint16_t length);
+
+/**
+ * Get the next record in a payload
+ *
+ * @param reader The reader to advance
+ * @param record The output start of the record, inside the payload
+ * @param length The output length of the record
+ *
+ * @return True if there was another well formed record. Once this returns
+ *      false, check reader->malformed to tell the end from a bad payload.
+ */
+bool downlink_reader_next(downlink_reader_t * reader, const uint8_t ** record, uint8_t * length);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_DOWNLINK_H_
@@ -0,0 +1,80 @@
+#include "firmware_update.h"
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+bool firmware_update_init(firmware_update_t * update, uint32_t length, firmware_read_t read, void * context) {
+    update->read = read;
+    update->context = context;
+    update->length = length;
+    update->begun = false;
+    update->acknowledged = 0;
+    update->stats.chunks = 0;
+    update->stats.retries = 0;
+
+    md5_ctx_t md5;
+    md5_init(&md5);
+    for (uint32_t offset = 0; offset < length; offset += FIRMWARE_CHUNK_LENGTH) {
+        uint16_t chunk_length = length - offset < FIRMWARE_CHUNK_LENGTH ? length - offset : FIRMWARE_CHUNK_LENGTH;
+        if (!read(offset, update->chunk, chunk_length, context)) {
+            return false;
+        }
+        md5_update(&md5, update->chunk, chunk_length);
+    }
+    md5_final(&md5, update->hash);
+    return true;
+}
+
+lithium_result_t firmware_update_step(firmware_update_t * update, lithium_t * radio) {
+    lithium_result_t err;
+    if (!update->begun) {
+        err = lithium_send_begin_fw_update(radio, update->hash);
+        if (err == LITHIUM_NO_ERROR) {
+            err = lithium_receive_ack(radio, LITHIUM_COMMAND_FIRMWARE_UPDATE);
+        }
+        update->begun = err == LITHIUM_NO_ERROR;
+        return err;
+    }
+    if (firmware_update_done(update)) {
+        return LITHIUM_NO_ERROR;
+    }
+
+    // The chunk is read again on every attempt rather than kept between
+    // them, so a failed read never leaves a stale chunk behind
+    uint32_t remaining = update->length - update->acknowledged;
+    uint16_t chunk_length = remaining < FIRMWARE_CHUNK_LENGTH ? remaining : FIRMWARE_CHUNK_LENGTH;
+    if (!update->read(update->acknowledged, update->chunk, chunk_length, update->context)) {
+        return LITHIUM_BAD_COMMUNICATION;
+    }
+
+    err = lithium_send_stream_fw_update(radio, update->chunk, chunk_length);
+    if (err == LITHIUM_NO_ERROR) {
+        err = lithium_receive_ack(radio, LITHIUM_COMMAND_FIRMWARE_PACKET);
+    }
+    if (err == LITHIUM_NO_ERROR) {
+        update->acknowledged += chunk_length;
+        ++update->stats.chunks;
+    }
+    return err;
+}
+
+lithium_result_t firmware_update_run(firmware_update_t * update, lithium_t * radio, uint8_t attempts) {
+    uint8_t failures = 0;
+    while (!firmware_update_done(update)) {
+        lithium_result_t err = firmware_update_step(update, radio);
+        if (err == LITHIUM_NO_ERROR) {
+            failures = 0;
+            continue;
+        }
+
+        ++update->stats.retries;
+        if (++failures >= attempts) {
+            return err;
+        }
+    }
+    return LITHIUM_NO_ERROR;
+}
+
+bool firmware_update_done(const firmware_update_t * update) {
+    return update->begun && update->acknowledged == update->length;
+}
@@ -0,0 +1,151 @@
+#ifndef _COMMON_FIRMWARE_UPDATE_H_
+#define _COMMON_FIRMWARE_UPDATE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lithium.h"
+#include "md5.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup firmware_update Lithium firmware update
+ *  Streams a firmware image from storage to a Lithium radio. The image's MD5
+ *  is sent with FIRMWARE_UPDATE, then the image follows in FIRMWARE_PACKET
+ *  chunks, each of which has to be acknowledged before the next is sent.
+ *
+ *  The image is read a chunk at a time, once to hash it and once to send
+ *  it, so it never has to fit in memory. The update remembers how much of
+ *  the image the radio has acknowledged, and a failed step is retried from
+ *  there rather than from the start.
+ *
+ *  Like lithium_receive_packet, each step blocks until the radio replies,
+ *  or fails with LITHIUM_TIMEOUT once the radio has been quiet for its
+ *  reply_timeout_ms.
+ *  @{
+ */
+
+/// The largest chunk a FIRMWARE_PACKET can carry
+#define FIRMWARE_CHUNK_LENGTH LITHIUM_MAX_PAYLOAD_LENGTH
+
+/**
+ * Read part of an image from storage
+ *
+ * @param offset Where in the image to start reading
+ * @param buffer The output bytes
+ * @param length The number of bytes to read
+ * @param context The context given to firmware_update_init
+ *
+ * @return True if and only if all of the bytes were read
+ */
+typedef bool (*firmware_read_t)(uint32_t offset, uint8_t * buffer, uint16_t length, void * context);
+
+/**
+ * Counters describing how an update went
+ */
+typedef struct firmware_update_stats {
+    /**
+     * Chunks the radio acknowledged
+     */
+    uint16_t chunks;
+    /**
+     * Steps that failed and had to be tried again
+     */
+    uint16_t retries;
+} firmware_update_stats_t;
+
+/**
+ * The progress of an update
+ */
+typedef struct firmware_update {
+    /**
+     * Reads the image
+     */
+    firmware_read_t read;
+    /**
+     * Passed to read
+     */
+    void * context;
+    /**
+     * The length of the image
+     */
+    uint32_t length;
+    /**
+     * The image's MD5
+     */
+    uint8_t hash[MD5_DIGEST_LENGTH];
+    /**
+     * True once the radio has acknowledged FIRMWARE_UPDATE
+     */
+    bool begun;
+    /**
+     * The number of bytes of the image the radio has acknowledged
+     */
+    uint32_t acknowledged;
+    /**
+     * The chunk being sent
+     */
+    uint8_t chunk[FIRMWARE_CHUNK_LENGTH];
+    /**
+     * Counters describing how the update went
+     */
+    firmware_update_stats_t stats;
+} firmware_update_t;
+
+/**
+ * Prepare to send an image by reading it through once to hash it
+ *
+ * @param update The output update
+ * @param length The length of the image
+ * @param read Reads the image
+ * @param context Passed to read
+ *
+ * @return True if and only if the whole image could be read
+ */
+bool firmware_update_init(firmware_update_t * update, uint32_t length, firmware_read_t read, void * context);
+
+/**
+ * Send the next part of an update, FIRMWARE_UPDATE or a chunk, and wait for
+ * the radio to acknowledge it. The update only moves on if it does.
+ *
+ * @param update The update to continue
+ * @param radio The radio to update
+ *
+ * @return LITHIUM_NO_ERROR if the part was acknowledged or the update was
+ *      already done, LITHIUM_BAD_COMMUNICATION if the image couldn't be read,
+ *      or the result of sending the part and receiving the reply
+ */
+lithium_result_t firmware_update_step(firmware_update_t * update, lithium_t * radio);
+
+/**
+ * Step an update until it is done or a step fails too many times in a row.
+ * Calling this again after a failure resumes from the last acknowledged
+ * chunk.
+ *
+ * @param update The update to continue
+ * @param radio The radio to update
+ * @param attempts How many times each step may be tried
+ *
+ * @return LITHIUM_NO_ERROR if the update is done, or the result of the last
+ *      failed attempt
+ */
+lithium_result_t firmware_update_run(firmware_update_t * update, lithium_t * radio, uint8_t attempts);
+
+/**
+ * Check if the radio has acknowledged the whole image
+ *
+ * @param update The update to inspect
+ *
+ * @return True if and only if the update is done
+ */
+bool firmware_update_done(const firmware_update_t * update);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_FIRMWARE_UPDATE_H_
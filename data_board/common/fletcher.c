@@ -0,0 +1,50 @@
+#include "fletcher.h"
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+void fletcher_init(fletcher_ctx_t * ctx) {
+    ctx->a = 0;
+    ctx->b = 0;
+}
+
+void fletcher_resume(fletcher_ctx_t * ctx, const uint8_t * checksum) {
+    ctx->a = checksum[0];
+    ctx->b = checksum[1];
+}
+
+void fletcher_update(fletcher_ctx_t * ctx, const uint8_t * data, size_t length) {
+    // 65536 is a multiple of 256, so the sums can run in full width registers
+    // and wrap freely. Only the low bytes are kept at the end, which saves
+    // masking every byte on the host.
+    unsigned a = ctx->a;
+    unsigned b = ctx->b;
+
+    // Four bytes a pass to spread the loop overhead. On the MSP430 each byte
+    // is then an auto-increment load and two adds.
+    while (length >= 4) {
+        a += data[0];
+        b += a;
+        a += data[1];
+        b += a;
+        a += data[2];
+        b += a;
+        a += data[3];
+        b += a;
+        data += 4;
+        length -= 4;
+    }
+    while (length > 0) {
+        a += *data++;
+        b += a;
+        --length;
+    }
+
+    ctx->a = (uint8_t) a;
+    ctx->b = (uint8_t) b;
+}
+
+void fletcher_final(const fletcher_ctx_t * ctx, uint8_t * output) {
+    output[0] = ctx->a;
+    output[1] = ctx->b;
+}
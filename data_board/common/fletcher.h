@@ -0,0 +1,72 @@
+#ifndef _COMMON_FLETCHER_H_
+#define _COMMON_FLETCHER_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup fletcher Fletcher checksum
+ *  The 8-bit Fletcher checksum used by the Lithium radio. Both sums are kept
+ *  modulo 256, and the checksum is the two sums with no final step, so a
+ *  finished checksum can be picked up again and extended.
+ *  @{
+ */
+
+/**
+ * The running state of a checksum
+ */
+typedef struct fletcher_ctx {
+    /**
+     * The sum of the bytes so far
+     */
+    uint8_t a;
+    /**
+     * The sum of the running values of a
+     */
+    uint8_t b;
+} fletcher_ctx_t;
+
+/**
+ * Start a new checksum
+ *
+ * @param ctx The checksum to start
+ */
+void fletcher_init(fletcher_ctx_t * ctx);
+
+/**
+ * Continue a checksum from one that was already finished, as if the bytes
+ * that produced it had been summed in to ctx
+ *
+ * @param ctx The checksum to start
+ * @param checksum The 2-byte finished checksum
+ */
+void fletcher_resume(fletcher_ctx_t * ctx, const uint8_t * checksum);
+
+/**
+ * Add bytes to a checksum
+ *
+ * @param ctx The checksum to add to
+ * @param data The bytes to add. May be NULL if length is zero.
+ * @param length The number of bytes to add
+ */
+void fletcher_update(fletcher_ctx_t * ctx, const uint8_t * data, size_t length);
+
+/**
+ * Get the checksum of everything added so far. The context is left as it
+ * was, so more bytes can still be added.
+ *
+ * @param ctx The checksum to finish
+ * @param output The 2-byte checksum output
+ */
+void fletcher_final(const fletcher_ctx_t * ctx, uint8_t * output);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_FLETCHER_H_
@@ -1,15 +1,35 @@
+#include <assert.h>
 #include <string.h>
 #include "lithium.h"
 
+#include "fletcher.h"
 #include "lithium_internal.h"
+#include "lithium_wire.h"
+#include "reed_solomon.h"
 
 /******************************************************************************\
  *  Private support functions                                                 *
 \******************************************************************************/
-void compute_checksum(uint8_t * data, size_t length, uint8_t * output);
-uint16_t encode_header(lithium_command_type_t type, lithium_command_t command, uint16_t payload_length, uint8_t * raw_packet);
-uint16_t encode_body(void * payload, uint16_t length, uint8_t * raw_packet);
-lithium_result_t send_data(lithium_t * radio, uint8_t * raw_packet, uint16_t length);
+bool checksum_matches(const fletcher_ctx_t * checksum, const uint8_t * expected);
+lithium_result_t send_frame(lithium_t * radio, lithium_command_type_t type, lithium_command_t command, const void * payload, uint16_t length);
+static lithium_result_t send_frame_iov(lithium_t * radio, lithium_command_type_t type, lithium_command_t command, const uart_iovec_t * payload, size_t count);
+static void decoder_discard(lithium_decoder_t * decoder, uint16_t count);
+static lithium_result_t decoder_step(lithium_decoder_t * decoder, lithium_packet_t * packet);
+
+/// The most pieces send_frame_iov can send a payload in
+#define SEND_FRAME_MAX_PIECES 2
+
+_Static_assert(HEADER_LENGTH == LITHIUM_HEADER_LENGTH, "HEADER_LENGTH must match LITHIUM_HEADER_LENGTH");
+_Static_assert(CHECKSUM_LENGTH == LITHIUM_CHECKSUM_LENGTH, "CHECKSUM_LENGTH must match LITHIUM_CHECKSUM_LENGTH");
+_Static_assert(MAX_PACKET_LENGTH == LITHIUM_MAX_FRAME_LENGTH, "MAX_PACKET_LENGTH must match LITHIUM_MAX_FRAME_LENGTH");
+_Static_assert(sizeof(((lzss_t *) 0)->frame) <= MAX_PAYLOAD_LENGTH, "An LZSS frame must fit a payload");
+
+/// The UART rate for each radio interface rate
+static const uart_baud_rate_t UART_BAUD_RATES[] = {
+#   define UART_BAUD_OP(E, V) [LITHIUM_BAUD_##E] = BAUD_##E,
+    LITHIUM_BAUD_LIST(UART_BAUD_OP)
+#   undef UART_BAUD_OP
+};
 
 /******************************************************************************\
  *  Pulic interface implementations                                           *
@@ -17,6 +37,8 @@ lithium_result_t send_data(lithium_t * radio, uint8_t * raw_packet, uint16_t len
 
 bool lithium_open(lithium_t * radio, uart_t * uart) {
     radio->uart = *uart;
+    lithium_decoder_init(&radio->decoder);
+    radio->reply_timeout_ms = LITHIUM_REPLY_TIMEOUT_MS;
     return true;
 }
 
@@ -26,24 +48,14 @@ void lithium_close(lithium_t * radio) {
 
 
 lithium_result_t lithium_send_packet(lithium_t * radio, lithium_packet_t * packet) {
-    // Encode the header and payload into a buffer
-    uint8_t raw_packet[MAX_PACKET_LENGTH];
-    uint16_t packet_length = encode_header(packet->type, packet->command, packet->payload_length, raw_packet);
-    if (packet->payload_length > 0) {
-        packet_length += encode_body(packet->payload, packet->payload_length, raw_packet);
-    }
-
-    // Send the buffer
-    return send_data(radio, raw_packet, packet_length);
+    return send_frame(radio, packet->type, packet->command, packet->payload, packet->payload_length);
 }
 
 
 // Generate methods to send header-only packets
 #define EMIT_SEND(name, command) \
     lithium_result_t lithium_send_##name(lithium_t * radio) { \
-        uint8_t raw_packet[HEADER_LENGTH]; \
-        uint16_t packet_length = encode_header(LITHIUM_I_MESSAGE, LITHIUM_COMMAND_##command, 0, raw_packet); \
-        return send_data(radio, raw_packet, packet_length); \
+        return send_frame(radio, LITHIUM_I_MESSAGE, LITHIUM_COMMAND_##command, NULL, 0); \
     }
 
 EMIT_SEND(no_op, NO_OP)
@@ -58,30 +70,18 @@ EMIT_SEND(read_fw_version, READ_FIRMWARE_REVISION)
 // Generate methods to send packets with payloads
 #define EMIT_SEND_PAYLOAD(name, command, data_param, length_param, ...) \
     lithium_result_t lithium_send_##name(lithium_t * radio, __VA_ARGS__) {\
-        uint8_t raw_packet[MAX_PACKET_LENGTH]; \
-        uint16_t packet_length = encode_header(LITHIUM_I_MESSAGE, LITHIUM_COMMAND_##command, length_param, raw_packet); \
-        packet_length +=  encode_body(data_param, length_param, raw_packet); \
-        return send_data(radio, raw_packet, packet_length); \
+        return send_frame(radio, LITHIUM_I_MESSAGE, LITHIUM_COMMAND_##command, data_param, length_param); \
     }
 
 EMIT_SEND_PAYLOAD(transmit, TRANSMIT_DATA,
     data, length,
     uint8_t * data, uint16_t length)
-EMIT_SEND_PAYLOAD(set_config, SET_TRANSCEIVER_CONFIG,
-    config, sizeof(lithium_config_t),
-    lithium_config_t * config)
 EMIT_SEND_PAYLOAD(write_flash, WRITE_FLASH,
     hash, 16,
     uint8_t * hash)
-EMIT_SEND_PAYLOAD(set_rf_config, RF_CONFIG,
-    config, sizeof(lithium_rf_config_t),
-    lithium_rf_config_t * config)
 EMIT_SEND_PAYLOAD(set_beacon, BEACON_DATA,
     data, length,
     uint8_t * data, uint16_t length)
-EMIT_SEND_PAYLOAD(set_beacon_config, BEACON_CONFIG,
-    config, sizeof(lithium_beacon_config_t),
-    lithium_beacon_config_t * config)
 EMIT_SEND_PAYLOAD(write_dio_key, WRITE_OVER_AIR_KEY,
     key, 16,
     uint8_t * key)
@@ -98,36 +98,139 @@ EMIT_SEND_PAYLOAD(set_pa_level, FAST_PA_SET,
 #undef EMIT_SEND_PAYLOAD
 
 
+// Generate methods to send structures, encoded in their wire layout
+#define EMIT_SEND_ENCODED(name, command, codec, type) \
+    lithium_result_t lithium_send_##name(lithium_t * radio, type * config) { \
+        uint8_t payload[sizeof(lithium_##codec##_wire_t)]; \
+        uint16_t length = lithium_encode_##codec(config, payload); \
+        return send_frame(radio, LITHIUM_I_MESSAGE, LITHIUM_COMMAND_##command, payload, length); \
+    }
+
+EMIT_SEND_ENCODED(set_config, SET_TRANSCEIVER_CONFIG, config, lithium_config_t)
+EMIT_SEND_ENCODED(set_rf_config, RF_CONFIG, rf_config, lithium_rf_config_t)
+EMIT_SEND_ENCODED(set_beacon_config, BEACON_CONFIG, beacon_config, lithium_beacon_config_t)
+
+#undef EMIT_SEND_ENCODED
+
+
+lithium_result_t lithium_send_compressed_transmit(lithium_t * radio, lzss_t * lzss, const uint8_t * data, uint16_t length) {
+    // The frame lives in the encoder state rather than on the task's stack
+    uint16_t frame_length = lzss_encode(lzss, data, length, lzss->frame);
+    if (frame_length == 0) {
+        return LITHIUM_INVALID_PACKET;
+    }
+    return send_frame(radio, LITHIUM_I_MESSAGE, LITHIUM_COMMAND_TRANSMIT_DATA, lzss->frame, frame_length);
+}
+
+lithium_result_t lithium_send_protected_transmit(lithium_t * radio, const uint8_t * data, uint16_t length) {
+    if (length > RS_MAX_DATA_LENGTH) {
+        return LITHIUM_INVALID_PACKET;
+    }
+
+    // The block goes out as the caller's data followed by the parity, so
+    // only the parity needs room here
+    uint8_t parity[RS_PARITY_LENGTH];
+    rs_encode(data, length, parity);
+
+    uart_iovec_t block[] = {
+        { data, length },
+        { parity, RS_PARITY_LENGTH },
+    };
+    return send_frame_iov(radio, LITHIUM_I_MESSAGE, LITHIUM_COMMAND_TRANSMIT_DATA, block, 2);
+}
+
+
 lithium_result_t lithium_receive_packet(lithium_t * radio, lithium_packet_t * packet) {
-    // Try to read a header
-    uint16_t raw_packet_length = MAX_PACKET_LENGTH;
-    uint8_t raw_packet[raw_packet_length];
-    uart_error_t uart_err = uart_read_bytes(&radio->uart, raw_packet, HEADER_LENGTH);
-    if (uart_err != UART_NO_ERROR) {
+    // Anything left over from a rejected frame is decoded first. The decoder
+    // holds the frame, so bytes only pass through a small chunk here.
+    uint8_t chunk[HEADER_LENGTH];
+    uint16_t consumed;
+    lithium_result_t err = lithium_decoder_feed(&radio->decoder, NULL, 0, &consumed, packet);
+
+    // Read no further than the end of the frame, so nothing is left buffered
+    // once a packet is returned
+    while (err == LITHIUM_INCOMPLETE) {
+        uint16_t wanted = lithium_decoder_wanted(&radio->decoder);
+        if (wanted > sizeof(chunk)) {
+            wanted = sizeof(chunk);
+        }
+        size_t read;
+        uart_error_t uart_err = uart_read_bytes_timeout(&radio->uart, chunk, wanted, radio->reply_timeout_ms, &read);
+        if (uart_err != UART_NO_ERROR && uart_err != UART_TIMEOUT) {
+            return LITHIUM_BAD_COMMUNICATION;
+        }
+
+        // Keep whatever made it before a timeout, so a late reply still
+        // decodes on the next call
+        err = lithium_decoder_feed(&radio->decoder, chunk, read, &consumed, packet);
+        if (uart_err == UART_TIMEOUT) {
+            return LITHIUM_TIMEOUT;
+        }
+    }
+
+    return err;
+}
+
+
+lithium_result_t lithium_receive_ack(lithium_t * radio, lithium_command_t command) {
+    lithium_packet_t packet;
+    lithium_result_t err = lithium_receive_packet(radio, &packet);
+    if (err != LITHIUM_NO_ERROR) {
+        return err;
+    }
+
+    if (!lithium_is_o_message(&packet) || packet.command != command) {
+        return LITHIUM_INVALID_PACKET;
+    }
+    if (lithium_is_nack(&packet)) {
+        return LITHIUM_NACK;
+    }
+    if (!lithium_is_ack(&packet)) {
+        return LITHIUM_INVALID_PACKET;
+    }
+
+    return LITHIUM_NO_ERROR;
+}
+
+lithium_result_t lithium_negotiate_baud(lithium_t * radio, lithium_config_t * config, lithium_baud_t baud) {
+    if ((size_t)baud >= sizeof(UART_BAUD_RATES) / sizeof(UART_BAUD_RATES[0]) ||
+            !uart_baud_rate_supported(&radio->uart, UART_BAUD_RATES[baud])) {
         return LITHIUM_BAD_COMMUNICATION;
     }
 
-    // Parse the header and see if there's a payload
-    uint16_t remaining_bytes;
-    lithium_result_t err = lithium_parse_header(raw_packet, raw_packet_length, packet, &remaining_bytes);
+    // Ask for the new rate at the old one. Nothing changes unless the radio
+    // agrees.
+    lithium_baud_t old_baud = config->interface_baud_rate;
+    config->interface_baud_rate = baud;
+    lithium_result_t err = lithium_send_set_config(radio, config);
+    if (err == LITHIUM_NO_ERROR) {
+        err = lithium_receive_ack(radio, LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG);
+    }
     if (err != LITHIUM_NO_ERROR) {
+        config->interface_baud_rate = old_baud;
         return err;
     }
 
-    // Try to read a payload
-    if (remaining_bytes > 0) {
-        uart_err = uart_read_bytes(&radio->uart, raw_packet + HEADER_LENGTH, remaining_bytes);
-        if (uart_err != UART_NO_ERROR) {
-            return LITHIUM_BAD_COMMUNICATION;
+    // The ACK was the last thing sent at the old rate, so the line is quiet
+    if (uart_set_baud_rate(&radio->uart, UART_BAUD_RATES[baud]) == UART_NO_ERROR) {
+        err = lithium_send_no_op(radio);
+        if (err == LITHIUM_NO_ERROR) {
+            err = lithium_receive_ack(radio, LITHIUM_COMMAND_NO_OP);
         }
-
-        err = lithium_parse_body(raw_packet, raw_packet_length, packet);
-        if (err != LITHIUM_NO_ERROR) {
-            return err;
+        if (err == LITHIUM_NO_ERROR) {
+            return LITHIUM_NO_ERROR;
         }
     }
 
-    return LITHIUM_NO_ERROR;
+    // The radio took the new rate, so tell it to go back before we do, or
+    // the link stays dead until it is power cycled. Its ACK may not make it
+    // through a line that just failed a no-op, so it only gets one try.
+    config->interface_baud_rate = old_baud;
+    if (lithium_send_set_config(radio, config) == LITHIUM_NO_ERROR) {
+        lithium_receive_ack(radio, LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG);
+    }
+    uart_set_baud_rate(&radio->uart, UART_BAUD_RATES[old_baud]);
+    return LITHIUM_BAD_COMMUNICATION;
 }
 
 
@@ -163,14 +266,11 @@ lithium_result_t lithium_parse_header(uint8_t * raw_packet, uint16_t raw_packet_
         return LITHIUM_INVALID_PACKET;
     }
 
-    uint8_t header_checksum[CHECKSUM_LENGTH];
-    compute_checksum(raw_packet + SYNC_BYTES_LENGTH, HEADER_DATA_LENGTH, header_checksum);
-
     // Validate header checksums
-    bool header_checksums_match = (
-        raw_packet[6] == header_checksum[0] &&
-        raw_packet[7] == header_checksum[1]);
-    if (!header_checksums_match) {
+    fletcher_ctx_t header_checksum;
+    fletcher_init(&header_checksum);
+    fletcher_update(&header_checksum, raw_packet + SYNC_BYTES_LENGTH, HEADER_DATA_LENGTH);
+    if (!checksum_matches(&header_checksum, raw_packet + SYNC_BYTES_LENGTH + HEADER_DATA_LENGTH)) {
         return LITHIUM_INVALID_CHECKSUM;
     }
 
@@ -196,21 +296,19 @@ lithium_result_t lithium_parse_body(uint8_t * raw_packet, uint16_t raw_packet_le
     }
 
     uint16_t payload_length = packet->payload_length;
-    uint8_t payload_checksum[CHECKSUM_LENGTH];
-    compute_checksum(raw_packet + SYNC_BYTES_LENGTH, HEADER_DATA_LENGTH + CHECKSUM_LENGTH + payload_length, payload_checksum);
-
-    // Validate payload checksums
-    bool payload_checksums_match = (
-        raw_packet[HEADER_LENGTH+payload_length] == payload_checksum[0] &&
-        raw_packet[HEADER_LENGTH+payload_length+1] == payload_checksum[1]);
-    if (!payload_checksums_match) {
-        return LITHIUM_INVALID_CHECKSUM;
-    }
-
     if (raw_packet_length < HEADER_LENGTH + payload_length + CHECKSUM_LENGTH) {
         return LITHIUM_INVALID_PACKET;
     }
 
+    // Validate payload checksums. The header checksum is the running checksum
+    // of the header data, so pick up from there rather than summing it again.
+    fletcher_ctx_t payload_checksum;
+    fletcher_resume(&payload_checksum, raw_packet + SYNC_BYTES_LENGTH + HEADER_DATA_LENGTH);
+    fletcher_update(&payload_checksum, raw_packet + SYNC_BYTES_LENGTH + HEADER_DATA_LENGTH, CHECKSUM_LENGTH + payload_length);
+    if (!checksum_matches(&payload_checksum, raw_packet + HEADER_LENGTH + payload_length)) {
+        return LITHIUM_INVALID_CHECKSUM;
+    }
+
     // Copy payload
     memcpy(packet->payload, raw_packet + HEADER_LENGTH, payload_length);
 
@@ -218,6 +316,38 @@ lithium_result_t lithium_parse_body(uint8_t * raw_packet, uint16_t raw_packet_le
 }
 
 
+void lithium_decoder_init(lithium_decoder_t * decoder) {
+    decoder->length = 0;
+    decoder->frame_length = 0;
+    decoder->dropped_bytes = 0;
+}
+
+lithium_result_t lithium_decoder_feed(lithium_decoder_t * decoder, const uint8_t * data, uint16_t length, uint16_t * consumed, lithium_packet_t * packet) {
+    *consumed = 0;
+    lithium_result_t err = decoder_step(decoder, packet);
+    while (err == LITHIUM_INCOMPLETE && *consumed < length) {
+        // Copy in as much of the frame as is available at once
+        uint16_t count = lithium_decoder_wanted(decoder);
+        if (count > length - *consumed) {
+            count = length - *consumed;
+        }
+        memcpy(decoder->raw_packet + decoder->length, data + *consumed, count);
+        decoder->length += count;
+        *consumed += count;
+
+        err = decoder_step(decoder, packet);
+    }
+    return err;
+}
+
+uint16_t lithium_decoder_wanted(lithium_decoder_t * decoder) {
+    if (decoder->frame_length > 0) {
+        return decoder->frame_length - decoder->length;
+    }
+    return HEADER_LENGTH - decoder->length;
+}
+
+
 bool lithium_is_i_message(lithium_packet_t * packet) {
     return packet->type == LITHIUM_I_MESSAGE;
 }
@@ -238,70 +368,175 @@ bool lithium_is_nack(lithium_packet_t * packet) {
  *  Private support function implementations                                  *
 \******************************************************************************/
 /**
- * Calculate the Fletcher-16 checksum of binary data
+ * Check a running checksum against the one received
  *
- * @param data The data to calculate the checksum of
- * @param length The length of the data
- * @param output The 2-byte checksum output
+ * @param checksum The checksum computed over the received bytes
+ * @param expected The 2-byte checksum that was received
+ *
+ * @return True if and only if they match
  */
-void compute_checksum(uint8_t * data, size_t length, uint8_t * output) {
-    uint8_t a = 0;
-    uint8_t b = 0;
-    for (size_t i = 0; i < length; ++i) {
-        a += data[i];
-        b += a;
-    }
-    output[0] = a;
-    output[1] = b;
+bool checksum_matches(const fletcher_ctx_t * checksum, const uint8_t * expected) {
+    uint8_t actual[CHECKSUM_LENGTH];
+    fletcher_final(checksum, actual);
+    return actual[0] == expected[0] && actual[1] == expected[1];
 }
 
 /**
- * Encode a Lithium packet's header
- *
- * @param type The type of the packet
- * @param command The packet's command
- * @param payload_length The length of the packet's payload
- * @param raw_packet The output byte array of at least 8 bytes
+ * Drop bytes from the front of a decoder's buffer, along with anything after
+ * them that can't be the start of a frame, and count them as dropped
  *
- * @return The size of the packet header in bytes
+ * @param decoder The decoder to drop bytes from
+ * @param count The number of bytes to drop
  */
-uint16_t encode_header(lithium_command_type_t type, lithium_command_t command, uint16_t payload_length, uint8_t * raw_packet) {
-    raw_packet[0] = SYNC_1;
-    raw_packet[1] = SYNC_2;
-    raw_packet[2] = type;
-    raw_packet[3] = command;
-    raw_packet[4] = (payload_length >> 8) & 0xFF;
-    raw_packet[5] = payload_length & 0xFF;
-    compute_checksum(raw_packet + 2, 4, raw_packet + 6);
-    return 8;
+static void decoder_discard(lithium_decoder_t * decoder, uint16_t count) {
+    while (count < decoder->length && decoder->raw_packet[count] != SYNC_1) {
+        ++count;
+    }
+    memmove(decoder->raw_packet, decoder->raw_packet + count, decoder->length - count);
+    decoder->length -= count;
+    decoder->frame_length = 0;
+    decoder->dropped_bytes += count;
 }
 
 /**
- * Encode a Lithium packet's body, assuming the header already exists
+ * Decode as far as possible through the bytes a decoder has buffered
  *
- * @param payload The payload to encode
- * @param length The length of the payload
- * @param raw_packet The output byte array of at least 265 bytes
+ * @param decoder The decoder to advance
+ * @param packet The output packet
  *
- * @return The size of the packet body in bytes
+ * @return LITHIUM_NO_ERROR if a frame was completed and removed from the
+ *      buffer, LITHIUM_INCOMPLETE if more bytes are needed, or the reason the
+ *      frame at the front of the buffer was rejected
  */
-uint16_t encode_body(void * payload, uint16_t length, uint8_t * raw_packet) {
-    memcpy(raw_packet + 8, payload, length);
-    compute_checksum(raw_packet + 2, 6 + length, raw_packet + 8 + length);
-    return length + 2;
+static lithium_result_t decoder_step(lithium_decoder_t * decoder, lithium_packet_t * packet) {
+    uint8_t * raw_packet = decoder->raw_packet;
+
+    // Hunt for the sync bytes
+    while (decoder->length > 0 && (raw_packet[0] != SYNC_1 ||
+            (decoder->length > 1 && raw_packet[1] != SYNC_2))) {
+        decoder_discard(decoder, 1);
+    }
+
+    if (decoder->length < HEADER_LENGTH) {
+        return LITHIUM_INCOMPLETE;
+    }
+
+    // Validate the header as soon as it's in, so a corrupt length doesn't
+    // hold up the stream
+    uint16_t remaining_bytes;
+    lithium_result_t err;
+    if (decoder->frame_length == 0) {
+        err = lithium_parse_header(raw_packet, HEADER_LENGTH, packet, &remaining_bytes);
+        if (err != LITHIUM_NO_ERROR) {
+            decoder_discard(decoder, 1);
+            return err;
+        }
+        decoder->frame_length = HEADER_LENGTH + remaining_bytes;
+
+        // The body checksum carries on from the header checksum
+        fletcher_resume(&decoder->checksum, raw_packet + SYNC_BYTES_LENGTH + HEADER_DATA_LENGTH);
+        decoder->summed = SYNC_BYTES_LENGTH + HEADER_DATA_LENGTH;
+    }
+
+    // Sum the body as it arrives, so completing a frame doesn't mean going
+    // back over all of it
+    bool has_body = decoder->frame_length > HEADER_LENGTH;
+    if (has_body) {
+        uint16_t body_end = decoder->frame_length - CHECKSUM_LENGTH;
+        uint16_t sum_to = decoder->length < body_end ? decoder->length : body_end;
+        if (sum_to > decoder->summed) {
+            fletcher_update(&decoder->checksum, raw_packet + decoder->summed, sum_to - decoder->summed);
+            decoder->summed = sum_to;
+        }
+    }
+    if (decoder->length < decoder->frame_length) {
+        return LITHIUM_INCOMPLETE;
+    }
+
+    if (has_body && !checksum_matches(&decoder->checksum, raw_packet + decoder->frame_length - CHECKSUM_LENGTH)) {
+        decoder_discard(decoder, 1);
+        return LITHIUM_INVALID_CHECKSUM;
+    }
+
+    // The header may have been parsed in to a different packet on an earlier
+    // call, and it has already been validated
+    packet->type = raw_packet[2];
+    packet->command = raw_packet[3];
+    packet->payload_length = (raw_packet[4] << 8) | raw_packet[5];
+    if (has_body) {
+        memcpy(packet->payload, raw_packet + HEADER_LENGTH, packet->payload_length);
+    }
+
+    // Keep whatever follows the frame
+    uint16_t frame_length = decoder->frame_length;
+    memmove(raw_packet, raw_packet + frame_length, decoder->length - frame_length);
+    decoder->length -= frame_length;
+    decoder->frame_length = 0;
+    return LITHIUM_NO_ERROR;
 }
 
 /**
- * Send a byte array through the UART channel associated with a radio
+ * Send a packet through the UART channel associated with a radio. The
+ * header, payload and checksum are written straight out of their own buffers
+ * rather than being assembled in to one.
  *
  * @param radio The radio instance owning the UART channel
- * @param raw_packet The data to send
- * @param length The length of the data to send
+ * @param type The type of the packet
+ * @param command The packet's command
+ * @param payload The packet's payload. Not used if length is zero.
+ * @param length The length of the payload. Packets without a payload are
+ *      sent as a bare header.
  *
  * @return The result of the operation
  */
-lithium_result_t send_data(lithium_t * radio, uint8_t * raw_packet, uint16_t length) {
-    uart_error_t err = uart_write_bytes(&radio->uart, raw_packet, length);
+lithium_result_t send_frame(lithium_t * radio, lithium_command_type_t type, lithium_command_t command, const void * payload, uint16_t length) {
+    uart_iovec_t piece = { payload, length };
+    return send_frame_iov(radio, type, command, &piece, 1);
+}
+
+/**
+ * Send a packet whose payload is in several pieces, as if they were one
+ * buffer
+ *
+ * @param radio The radio instance owning the UART channel
+ * @param type The type of the packet
+ * @param command The packet's command
+ * @param payload The pieces of the payload, in order
+ * @param count The number of pieces, at most SEND_FRAME_MAX_PIECES
+ *
+ * @return The result of the operation, or LITHIUM_INVALID_PACKET if the
+ *      pieces add up to more than MAX_PAYLOAD_LENGTH
+ */
+static lithium_result_t send_frame_iov(lithium_t * radio, lithium_command_type_t type, lithium_command_t command, const uart_iovec_t * payload, size_t count) {
+    assert(count <= SEND_FRAME_MAX_PIECES);
+
+    size_t length = 0;
+    for (size_t i = 0; i < count; ++i) {
+        length += payload[i].length;
+    }
+    if (length > MAX_PAYLOAD_LENGTH) {
+        return LITHIUM_INVALID_PACKET;
+    }
+
+    uint8_t header[HEADER_LENGTH];
+    uint8_t checksum[CHECKSUM_LENGTH];
+    fletcher_ctx_t ctx;
+    encode_header(type, command, length, header, &ctx);
+
+    // The header, then every piece of the payload, then the checksum. The
+    // body checksum carries on from the header.
+    uart_iovec_t iov[SEND_FRAME_MAX_PIECES + 2];
+    iov[0].bytes = header;
+    iov[0].length = HEADER_LENGTH;
+    for (size_t i = 0; i < count; ++i) {
+        fletcher_update(&ctx, payload[i].bytes, payload[i].length);
+        iov[i + 1] = payload[i];
+    }
+    fletcher_final(&ctx, checksum);
+    iov[count + 1].bytes = checksum;
+    iov[count + 1].length = CHECKSUM_LENGTH;
+
+    uart_error_t err = uart_write_iov(&radio->uart, iov, length > 0 ? count + 2 : 1);
     if (err != UART_NO_ERROR) {
         return LITHIUM_BAD_COMMUNICATION;
     }
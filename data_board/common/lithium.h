@@ -1,12 +1,76 @@
 #ifndef _COMMON_LITHIUM_H_
 #define _COMMON_LITHIUM_H_
 
+#include "fletcher.h"
+#include "lzss.h"
 #include "uart.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * Length of a frame's header: the sync bytes, type, command, payload length
+ * and header checksum
+ */
+#define LITHIUM_HEADER_LENGTH 8
+
+/**
+ * Length of the largest payload a frame can carry
+ */
+#define LITHIUM_MAX_PAYLOAD_LENGTH 255
+
+/**
+ * Length of the checksum that follows a payload
+ */
+#define LITHIUM_CHECKSUM_LENGTH 2
+
+/**
+ * Length of the longest frame on the wire
+ */
+#define LITHIUM_MAX_FRAME_LENGTH \
+    (LITHIUM_HEADER_LENGTH + LITHIUM_MAX_PAYLOAD_LENGTH + LITHIUM_CHECKSUM_LENGTH)
+
+/**
+ * How long a blocking receive waits for the radio's next byte before giving
+ * up, in milliseconds
+ */
+#ifndef LITHIUM_REPLY_TIMEOUT_MS
+#   define LITHIUM_REPLY_TIMEOUT_MS 1000
+#endif
+
+/**
+ * Incremental decoder for the byte stream coming from a Lithium radio
+ */
+typedef struct lithium_decoder {
+    /**
+     * The bytes of the frame being decoded, starting from its sync bytes
+     */
+    uint8_t raw_packet[LITHIUM_MAX_FRAME_LENGTH];
+    /**
+     * The number of bytes in raw_packet
+     */
+    uint16_t length;
+    /**
+     * The length of the whole frame once its header has been validated, or
+     * zero before then
+     */
+    uint16_t frame_length;
+    /**
+     * The running checksum of the frame's body, once its header has been
+     * validated
+     */
+    fletcher_ctx_t checksum;
+    /**
+     * The number of bytes of raw_packet included in checksum
+     */
+    uint16_t summed;
+    /**
+     * The number of bytes thrown away while hunting for sync bytes
+     */
+    uint32_t dropped_bytes;
+} lithium_decoder_t;
+
 /**
  * The connection to a Lithium radio
  */
@@ -15,6 +79,15 @@ typedef struct lithium {
      * The owned UART channel over which we talk
      */
     uart_t uart;
+    /**
+     * The decoder for bytes received over the UART channel
+     */
+    lithium_decoder_t decoder;
+    /**
+     * How long lithium_receive_packet waits for the radio's next byte, in
+     * milliseconds. Starts out as LITHIUM_REPLY_TIMEOUT_MS.
+     */
+    uint16_t reply_timeout_ms;
 } lithium_t;
 
 
@@ -25,7 +98,10 @@ typedef struct lithium {
     OP(NO_ERROR) \
     OP(BAD_COMMUNICATION) \
     OP(INVALID_PACKET) \
-    OP(INVALID_CHECKSUM)
+    OP(INVALID_CHECKSUM) \
+    OP(NACK) \
+    OP(INCOMPLETE) \
+    OP(TIMEOUT)
 
 /**
  * Enumeration of possible results for trying to communicate with the Lithium
@@ -92,7 +168,8 @@ typedef enum lithium_command {
 #undef LITHIUM_COMMAND_LIST
 
 /**
- * Macro list for UART baud rates
+ * Macro list for UART baud rates: bits per second and setting. Left defined
+ * for the rate tables built from it.
  */
 #define LITHIUM_BAUD_LIST(BAUD) \
     BAUD(9600, 0) \
@@ -110,8 +187,6 @@ typedef enum lithium_baud {
 #   undef STRING_OP
 } lithium_baud_t;
 
-#undef LITHIUM_BAUD_LIST
-
 /**
  * Macro list for the RF baud rates
  */
@@ -171,7 +246,7 @@ typedef struct lithium_packet {
     /**
      * The packet's payload
      */
-    uint8_t payload[255];
+    uint8_t payload[LITHIUM_MAX_PAYLOAD_LENGTH];
 } lithium_packet_t;
 
 
@@ -282,6 +357,37 @@ lithium_result_t lithium_send_reset(lithium_t * radio);
  */
 lithium_result_t lithium_send_transmit(lithium_t * radio, uint8_t * data, uint16_t length);
 
+/**
+ * Compress data with LZSS and send it as a data transmission packet. Data
+ * that doesn't compress is sent raw, behind the LZSS frame flag.
+ *
+ * @param radio The radio to communicate with
+ * @param lzss The encoder state to compress with. The frame is built in its
+ *      frame buffer, so data must not be that buffer.
+ * @param data The transmission payload to send
+ * @param length The length of the transmission payload, at most
+ *      LZSS_MAX_INPUT
+ *
+ * @return The result of the operation, or LITHIUM_INVALID_PACKET if data is
+ *      too long
+ */
+lithium_result_t lithium_send_compressed_transmit(lithium_t * radio, lzss_t * lzss, const uint8_t * data, uint16_t length);
+
+/**
+ * Send a data transmission packet to a Lithium radio with Reed-Solomon
+ * parity after the data, so the ground can correct corrupted bytes rather
+ * than ask for the whole frame again
+ *
+ * @param radio The radio to communicate with
+ * @param data The transmission payload to protect and send
+ * @param length The length of the transmission payload, at most
+ *      RS_MAX_DATA_LENGTH
+ *
+ * @return The result of the operation, or LITHIUM_INVALID_PACKET if data is
+ *      too long
+ */
+lithium_result_t lithium_send_protected_transmit(lithium_t * radio, const uint8_t * data, uint16_t length);
+
 /**
  * Send a radio configuration request packet to a Lithium radio
  *
@@ -404,13 +510,52 @@ lithium_result_t lithium_send_set_pa_level(lithium_t * radio, uint8_t output_lev
 /**
  * Attempt to receive and parse a Lithium packet over the UART channel
  *
+ * Received bytes go through the radio's decoder, so after a rejected frame
+ * the next call picks up at the next sync bytes rather than misaligned.
+ * Bytes received before a timeout stay in the decoder for the next call.
+ *
  * @param radio The radio to communicate with
  * @param packet The output packet parsed from the channel
  *
- * @return The result of the operation
+ * @return The result of the operation, or LITHIUM_TIMEOUT if the radio went
+ *      quiet for reply_timeout_ms before the packet was complete
  */
 lithium_result_t lithium_receive_packet(lithium_t * radio, lithium_packet_t * packet);
 
+/**
+ * Receive the radio's reply to a command and check that it is an ACK
+ *
+ * @param radio The radio to communicate with
+ * @param command The command that should be acknowledged
+ *
+ * @return LITHIUM_NACK if the radio refused the command,
+ *      LITHIUM_INVALID_PACKET if the reply is not an ACK or NACK for command,
+ *      or the result of receiving the reply
+ */
+lithium_result_t lithium_receive_ack(lithium_t * radio, lithium_command_t command);
+
+/**
+ * Switch the radio and the local UART to a new interface baud rate
+ *
+ * The new rate is sent to the radio in a configuration change at the current
+ * rate. Once the radio acknowledges it the local UART is switched, and the
+ * new rate is confirmed with a no-op round trip. If the confirmation fails
+ * the radio is sent another configuration change back to the old rate, at
+ * the new one, and then the local UART switches back to the old rate too.
+ *
+ * Like lithium_receive_packet this blocks until the radio replies or goes
+ * quiet for the radio's reply_timeout_ms.
+ *
+ * @param radio The radio to communicate with
+ * @param config The radio's current configuration. Its interface baud rate
+ *      is updated to the rate the link ends up at.
+ * @param baud The interface baud rate to switch to
+ *
+ * @return LITHIUM_BAD_COMMUNICATION if the UART can't run at baud or the
+ *      confirmation failed, or the result of the configuration change
+ */
+lithium_result_t lithium_negotiate_baud(lithium_t * radio, lithium_config_t * config, lithium_baud_t baud);
+
 /**
  * Parse the header of an encoded Lithium packet
  *
@@ -432,6 +577,45 @@ lithium_result_t lithium_parse_header(uint8_t * raw_packet, uint16_t raw_packet_
  */
 lithium_result_t lithium_parse_body(uint8_t * raw_packet, uint16_t raw_packet_length, lithium_packet_t * packet);
 
+/**
+ * Reset a decoder to start hunting for a new frame
+ *
+ * @param decoder The decoder to reset
+ */
+void lithium_decoder_init(lithium_decoder_t * decoder);
+
+/**
+ * Feed received bytes to a decoder
+ *
+ * Bytes are consumed until a frame is complete or rejected, so that every
+ * packet and every error is reported. When a frame is rejected the decoder
+ * drops its first byte and hunts for the next sync bytes in what it has
+ * already buffered, so one corrupt byte costs at most the frame it landed in.
+ * The bytes left after a rejected frame may hold more complete frames, so
+ * keep calling until everything is consumed and LITHIUM_INCOMPLETE is
+ * returned. Feeding no bytes just checks the buffered ones.
+ *
+ * @param decoder The decoder to feed
+ * @param data The received bytes
+ * @param length The number of received bytes
+ * @param consumed The output number of bytes taken from data
+ * @param packet The output packet, only valid on LITHIUM_NO_ERROR
+ *
+ * @return LITHIUM_NO_ERROR if a packet was decoded, LITHIUM_INCOMPLETE if
+ *      more bytes are needed, or the reason a frame was rejected
+ */
+lithium_result_t lithium_decoder_feed(lithium_decoder_t * decoder, const uint8_t * data, uint16_t length, uint16_t * consumed, lithium_packet_t * packet);
+
+/**
+ * Get the number of bytes a decoder can take without running past the end
+ * of the frame it is decoding, for callers that read ahead in blocks
+ *
+ * @param decoder The decoder to inspect
+ *
+ * @return The number of bytes to read next
+ */
+uint16_t lithium_decoder_wanted(lithium_decoder_t * decoder);
+
 /**
  * Check if a packet is an I-Message
  *
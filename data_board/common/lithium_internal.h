@@ -1,3 +1,15 @@
+#ifndef _COMMON_LITHIUM_INTERNAL_H_
+#define _COMMON_LITHIUM_INTERNAL_H_
+
+#include <stdint.h>
+
+#include "fletcher.h"
+#include "lithium.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * Packet intrinsics
  */
@@ -28,16 +40,32 @@
 // Length of all of the header bytes
 #define HEADER_LENGTH       (SYNC_BYTES_LENGTH + HEADER_DATA_LENGTH + CHECKSUM_LENGTH)
 // Maximum length of the payload
-#define MAX_PAYLOAD_LENGTH  255
+#define MAX_PAYLOAD_LENGTH  LITHIUM_MAX_PAYLOAD_LENGTH
 // Maximum length of the entire packet
 #define MAX_PACKET_LENGTH   (HEADER_LENGTH + MAX_PAYLOAD_LENGTH + CHECKSUM_LENGTH)
 
+// Over-the-air commands are registered in UPLINK_COMMAND_LIST in uplink.h
+
 /**
- * Over-the-air commands
+ * Encoder internals, in lithium_wire.c and shared with the benchmarks
  */
 
-#define TELEMETRY_DUMP_COMMAND  0x30
-#define PING_RETURN_COMMAND     0x31
-#define CODE_UPLOAD_COMMAND     0x32
-#define RADIO_RESET_COMMAND     0x33
-#define PIN_TOGGLE_COMMAND      0x34
+/**
+ * Encode a Lithium packet's header
+ *
+ * @param type The type of the packet
+ * @param command The packet's command
+ * @param payload_length The length of the packet's payload
+ * @param raw_packet The output byte array of at least HEADER_LENGTH bytes
+ * @param checksum The output running checksum of the header, ready to
+ *      continue over the payload
+ *
+ * @return The size of the packet header in bytes
+ */
+uint16_t encode_header(lithium_command_type_t type, lithium_command_t command, uint16_t payload_length, uint8_t * raw_packet, fletcher_ctx_t * checksum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_LITHIUM_INTERNAL_H_
@@ -0,0 +1,92 @@
+#include "lithium_pool.h"
+
+#include "critical.h"
+
+#include <stddef.h>
+
+// Handles are indices, and one value is kept back for LITHIUM_HANDLE_NONE
+#if LITHIUM_POOL_SIZE < 1 || LITHIUM_POOL_SIZE >= 0xFF
+#   error "LITHIUM_POOL_SIZE must be between 1 and 254"
+#endif
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+void lithium_pool_init(lithium_pool_t * pool) {
+    // Hand out the lowest handles first
+    for (uint8_t i = 0; i < LITHIUM_POOL_SIZE; ++i) {
+        pool->references[i] = 0;
+        pool->free[i] = LITHIUM_POOL_SIZE - 1 - i;
+    }
+    pool->free_count = LITHIUM_POOL_SIZE;
+    pool->stats.in_use = 0;
+    pool->stats.high_water = 0;
+    pool->stats.exhausted = 0;
+}
+
+lithium_handle_t lithium_pool_acquire(lithium_pool_t * pool) {
+    lithium_handle_t handle = LITHIUM_HANDLE_NONE;
+
+    critical_state_t state = critical_enter();
+    if (pool->free_count > 0) {
+        handle = pool->free[--pool->free_count];
+        pool->references[handle] = 1;
+        if (++pool->stats.in_use > pool->stats.high_water) {
+            pool->stats.high_water = pool->stats.in_use;
+        }
+    }
+    else {
+        ++pool->stats.exhausted;
+    }
+    critical_exit(state);
+
+    return handle;
+}
+
+bool lithium_pool_retain(lithium_pool_t * pool, lithium_handle_t handle) {
+    if (handle >= LITHIUM_POOL_SIZE) {
+        return false;
+    }
+
+    bool held;
+    critical_state_t state = critical_enter();
+    // Never wrap back round to looking free
+    held = pool->references[handle] > 0 && pool->references[handle] < UINT8_MAX;
+    if (held) {
+        ++pool->references[handle];
+    }
+    critical_exit(state);
+
+    return held;
+}
+
+bool lithium_pool_release(lithium_pool_t * pool, lithium_handle_t handle) {
+    if (handle >= LITHIUM_POOL_SIZE) {
+        return false;
+    }
+
+    bool held;
+    critical_state_t state = critical_enter();
+    held = pool->references[handle] > 0;
+    if (held && --pool->references[handle] == 0) {
+        pool->free[pool->free_count++] = handle;
+        --pool->stats.in_use;
+    }
+    critical_exit(state);
+
+    return held;
+}
+
+lithium_packet_t * lithium_pool_get(lithium_pool_t * pool, lithium_handle_t handle) {
+    if (handle >= LITHIUM_POOL_SIZE) {
+        return NULL;
+    }
+    return &pool->packets[handle];
+}
+
+lithium_pool_stats_t lithium_pool_stats(lithium_pool_t * pool) {
+    critical_state_t state = critical_enter();
+    lithium_pool_stats_t stats = pool->stats;
+    critical_exit(state);
+    return stats;
+}
@@ -0,0 +1,144 @@
+#ifndef _COMMON_LITHIUM_POOL_H_
+#define _COMMON_LITHIUM_POOL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lithium.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup lithium_pool Lithium packet pool
+ *  A fixed set of packet buffers that are shared by reference instead of
+ *  being copied. A packet is acquired once, retained by everything that
+ *  holds on to it, and returns to the pool when the last holder releases it.
+ *  Queues carry the one byte handle rather than the packet.
+ *
+ *  The pool is allocated up front, so nothing is allocated after the tasks
+ *  are initialised. Every operation is safe to call from several tasks and
+ *  from interrupt handlers.
+ *  @{
+ */
+
+#ifndef LITHIUM_POOL_SIZE
+/// The number of packets in a pool
+#   define LITHIUM_POOL_SIZE 8
+#endif
+
+/// The handle to a packet in a pool
+typedef uint8_t lithium_handle_t;
+
+/// The handle that refers to no packet
+#define LITHIUM_HANDLE_NONE ((lithium_handle_t) 0xFF)
+
+/**
+ * Usage statistics of a pool
+ */
+typedef struct lithium_pool_stats {
+    /**
+     * The number of packets held right now
+     */
+    uint8_t in_use;
+    /**
+     * The largest number of packets held at once
+     */
+    uint8_t high_water;
+    /**
+     * The number of times acquiring a packet failed because none were free
+     */
+    uint16_t exhausted;
+} lithium_pool_stats_t;
+
+/**
+ * A pool of packets
+ */
+typedef struct lithium_pool {
+    /**
+     * The packets handed out by the pool
+     */
+    lithium_packet_t packets[LITHIUM_POOL_SIZE];
+    /**
+     * The number of holders of each packet. Zero if the packet is free.
+     */
+    uint8_t references[LITHIUM_POOL_SIZE];
+    /**
+     * A stack of the handles of the free packets
+     */
+    lithium_handle_t free[LITHIUM_POOL_SIZE];
+    /**
+     * The number of handles on the free stack
+     */
+    uint8_t free_count;
+    /**
+     * The pool's usage statistics
+     */
+    lithium_pool_stats_t stats;
+} lithium_pool_t;
+
+/**
+ * Make every packet in a pool free and clear its statistics. Must not race
+ * with any other use of the pool.
+ *
+ * @param pool The pool to initialise
+ */
+void lithium_pool_init(lithium_pool_t * pool);
+
+/**
+ * Take a free packet from a pool. The caller holds the only reference.
+ *
+ * @param pool The pool to take from
+ *
+ * @return The packet's handle, or LITHIUM_HANDLE_NONE if every packet is held
+ */
+lithium_handle_t lithium_pool_acquire(lithium_pool_t * pool);
+
+/**
+ * Add a reference to a held packet, for example before passing it to a
+ * queue while keeping it
+ *
+ * @param pool The pool the packet belongs to
+ * @param handle The packet to reference
+ *
+ * @return True if and only if the handle refers to a held packet
+ */
+bool lithium_pool_retain(lithium_pool_t * pool, lithium_handle_t handle);
+
+/**
+ * Drop a reference to a packet. The packet returns to the pool when the last
+ * reference is dropped, and must not be used after that.
+ *
+ * @param pool The pool the packet belongs to
+ * @param handle The packet to release
+ *
+ * @return True if and only if the handle referred to a held packet
+ */
+bool lithium_pool_release(lithium_pool_t * pool, lithium_handle_t handle);
+
+/**
+ * Get the packet behind a handle
+ *
+ * @param pool The pool the packet belongs to
+ * @param handle The handle to look up
+ *
+ * @return The packet, or NULL if the handle isn't in the pool
+ */
+lithium_packet_t * lithium_pool_get(lithium_pool_t * pool, lithium_handle_t handle);
+
+/**
+ * Get a snapshot of a pool's usage statistics
+ *
+ * @param pool The pool to inspect
+ *
+ * @return The statistics
+ */
+lithium_pool_stats_t lithium_pool_stats(lithium_pool_t * pool);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_LITHIUM_POOL_H_
@@ -0,0 +1,219 @@
+#include "lithium_shadow.h"
+#include "lithium_wire.h"
+#include "fletcher.h"
+
+#include <string.h>
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+
+/**
+ * Compute the checksum of a shadow's contents, over their encoded form so
+ * struct padding never takes part
+ *
+ * @param shadow The shadow to sum
+ * @param checksum The output checksum
+ */
+static void shadow_checksum(const lithium_shadow_t * shadow, uint8_t * checksum);
+
+/**
+ * Record a change to a shadow: bump its version and seal it again
+ *
+ * @param shadow The changed shadow
+ */
+static void shadow_changed(lithium_shadow_t * shadow);
+
+/**
+ * Check if a payload is the encoded form of the configuration a shadow holds
+ *
+ * @param shadow The shadow to compare with
+ * @param payload The payload to compare
+ * @param length The length of payload
+ *
+ * @return True if and only if payload encodes shadow->config
+ */
+static bool config_matches(const lithium_shadow_t * shadow, const uint8_t * payload, uint16_t length);
+
+/**
+ * Check if a payload is the encoded form of the RF configuration a shadow
+ * holds
+ *
+ * @param shadow The shadow to compare with
+ * @param payload The payload to compare
+ * @param length The length of payload
+ *
+ * @return True if and only if payload encodes shadow->rf_config
+ */
+static bool rf_config_matches(const lithium_shadow_t * shadow, const uint8_t * payload, uint16_t length);
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+void lithium_shadow_init(lithium_shadow_t * shadow) {
+    memset(shadow, 0, sizeof(*shadow));
+    shadow_checksum(shadow, shadow->checksum);
+}
+
+bool lithium_shadow_load(lithium_shadow_t * shadow) {
+    uint8_t checksum[2];
+    shadow_checksum(shadow, checksum);
+    if (memcmp(checksum, shadow->checksum, sizeof(checksum)) == 0) {
+        return true;
+    }
+
+    // The version carries on from wherever it was, so readers holding the
+    // old one still see a change
+    uint16_t version = shadow->version;
+    lithium_shadow_init(shadow);
+    shadow->version = version;
+    shadow_changed(shadow);
+    return false;
+}
+
+void lithium_shadow_invalidate(lithium_shadow_t * shadow) {
+    shadow->config_valid = false;
+    shadow->rf_config_valid = false;
+    shadow_changed(shadow);
+}
+
+bool lithium_shadow_unchanged(const lithium_shadow_t * shadow, const lithium_packet_t * request) {
+    if (request->type != LITHIUM_I_MESSAGE) {
+        return false;
+    }
+
+    switch (request->command) {
+        case LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG:
+            return config_matches(shadow, request->payload, request->payload_length);
+        case LITHIUM_COMMAND_RF_CONFIG:
+            return rf_config_matches(shadow, request->payload, request->payload_length);
+        case LITHIUM_COMMAND_FAST_PA_SET:
+            return request->payload_length == 1
+                && shadow->config_valid
+                && shadow->config.tx_power_amp_level == request->payload[0]
+                && (!shadow->rf_config_valid || shadow->rf_config.tx_power_amp_level == request->payload[0]);
+        default:
+            return false;
+    }
+}
+
+void lithium_shadow_acknowledged(lithium_shadow_t * shadow, const lithium_packet_t * request) {
+    if (request->type != LITHIUM_I_MESSAGE) {
+        return;
+    }
+
+    switch (request->command) {
+        case LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG:
+            if (request->payload_length != LITHIUM_CONFIG_WIRE_LENGTH) {
+                return;
+            }
+            lithium_decode_config(request->payload, request->payload_length, &shadow->config);
+            shadow->config_valid = true;
+            break;
+        case LITHIUM_COMMAND_RF_CONFIG:
+            if (request->payload_length != LITHIUM_RF_CONFIG_WIRE_LENGTH) {
+                return;
+            }
+            lithium_decode_rf_config(request->payload, request->payload_length, &shadow->rf_config);
+            shadow->rf_config_valid = true;
+            break;
+        case LITHIUM_COMMAND_FAST_PA_SET:
+            if (request->payload_length != 1) {
+                return;
+            }
+            shadow->config.tx_power_amp_level = request->payload[0];
+            shadow->rf_config.tx_power_amp_level = request->payload[0];
+            break;
+        case LITHIUM_COMMAND_RESET_SYSTEM:
+            // The radio comes back up with whatever it has in flash
+            shadow->config_valid = false;
+            shadow->rf_config_valid = false;
+            break;
+        default:
+            return;
+    }
+    shadow_changed(shadow);
+}
+
+void lithium_shadow_received(lithium_shadow_t * shadow, const lithium_packet_t * response) {
+    // ACKs and NACKs are told apart by their length, so checking it exactly
+    // also keeps them out
+    if (response->type != LITHIUM_O_MESSAGE
+            || response->command != LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG
+            || response->payload_length != LITHIUM_CONFIG_WIRE_LENGTH) {
+        return;
+    }
+
+    lithium_decode_config(response->payload, response->payload_length, &shadow->config);
+    shadow->config_valid = true;
+    shadow_changed(shadow);
+}
+
+lithium_result_t lithium_shadow_send(lithium_shadow_t * shadow, lithium_t * radio, lithium_packet_t * request) {
+    if (lithium_shadow_unchanged(shadow, request)) {
+        return LITHIUM_NO_ERROR;
+    }
+
+    lithium_result_t err = lithium_send_packet(radio, request);
+    if (err == LITHIUM_NO_ERROR) {
+        err = lithium_receive_ack(radio, (lithium_command_t) request->command);
+    }
+    if (err == LITHIUM_NO_ERROR) {
+        lithium_shadow_acknowledged(shadow, request);
+    }
+    return err;
+}
+
+const lithium_config_t * lithium_shadow_config(lithium_shadow_t * shadow, lithium_t * radio) {
+    if (!shadow->config_valid) {
+        lithium_packet_t response;
+        if (lithium_send_get_config(radio) == LITHIUM_NO_ERROR
+                && lithium_receive_packet(radio, &response) == LITHIUM_NO_ERROR) {
+            lithium_shadow_received(shadow, &response);
+        }
+    }
+    return shadow->config_valid ? &shadow->config : NULL;
+}
+
+const lithium_rf_config_t * lithium_shadow_rf_config(const lithium_shadow_t * shadow) {
+    return shadow->rf_config_valid ? &shadow->rf_config : NULL;
+}
+
+/******************************************************************************\
+ *  Private support function implementations                                  *
+\******************************************************************************/
+static void shadow_checksum(const lithium_shadow_t * shadow, uint8_t * checksum) {
+    uint8_t header[3] = {
+        shadow->version >> 8,
+        shadow->version & 0xFF,
+        (shadow->config_valid ? 0x01 : 0x00) | (shadow->rf_config_valid ? 0x02 : 0x00),
+    };
+    uint8_t config[LITHIUM_CONFIG_WIRE_LENGTH];
+    uint8_t rf_config[LITHIUM_RF_CONFIG_WIRE_LENGTH];
+
+    fletcher_ctx_t ctx;
+    fletcher_init(&ctx);
+    fletcher_update(&ctx, header, sizeof(header));
+    fletcher_update(&ctx, config, lithium_encode_config(&shadow->config, config));
+    fletcher_update(&ctx, rf_config, lithium_encode_rf_config(&shadow->rf_config, rf_config));
+    fletcher_final(&ctx, checksum);
+}
+
+static void shadow_changed(lithium_shadow_t * shadow) {
+    ++shadow->version;
+    shadow_checksum(shadow, shadow->checksum);
+}
+
+static bool config_matches(const lithium_shadow_t * shadow, const uint8_t * payload, uint16_t length) {
+    uint8_t encoded[LITHIUM_CONFIG_WIRE_LENGTH];
+    return shadow->config_valid
+        && length == lithium_encode_config(&shadow->config, encoded)
+        && memcmp(payload, encoded, length) == 0;
+}
+
+static bool rf_config_matches(const lithium_shadow_t * shadow, const uint8_t * payload, uint16_t length) {
+    uint8_t encoded[LITHIUM_RF_CONFIG_WIRE_LENGTH];
+    return shadow->rf_config_valid
+        && length == lithium_encode_rf_config(&shadow->rf_config, encoded)
+        && memcmp(payload, encoded, length) == 0;
+}
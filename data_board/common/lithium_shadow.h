@@ -0,0 +1,158 @@
+#ifndef _COMMON_LITHIUM_SHADOW_H_
+#define _COMMON_LITHIUM_SHADOW_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lithium.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup lithium_shadow Lithium configuration shadow
+ *  A copy of the radio's configuration kept on the data board, so reading
+ *  the frequency, PA level or baud rate is a memory access instead of a
+ *  GET_TRANSCEIVER_CONFIG round trip.
+ *
+ *  The copy only changes when the radio acknowledges a command that changes
+ *  its configuration, or replies to GET_TRANSCEIVER_CONFIG. After
+ *  RESET_SYSTEM the copy is dropped, and the configuration is fetched again
+ *  the next time it is read. Every change bumps a version counter, so
+ *  readers can tell when to look again.
+ *
+ *  The shadow is meant to be declared PERSISTENT, so it lives in FRAM and
+ *  survives a reset of the data board. A checksum covers its contents, and
+ *  lithium_shadow_load drops a copy that didn't survive intact.
+ *
+ *  The RF configuration can't be read back from the radio, so it is only
+ *  known once it has been set.
+ *  @{
+ */
+
+/**
+ * The shadow copy of a radio's configuration
+ */
+typedef struct lithium_shadow {
+    /**
+     * Bumped every time the contents change
+     */
+    uint16_t version;
+    /**
+     * True if config matches the radio
+     */
+    bool config_valid;
+    /**
+     * True if rf_config matches the radio
+     */
+    bool rf_config_valid;
+    /**
+     * The radio's front-end configuration
+     */
+    lithium_config_t config;
+    /**
+     * The radio's RF configuration
+     */
+    lithium_rf_config_t rf_config;
+    /**
+     * The Fletcher checksum of everything above
+     */
+    uint8_t checksum[2];
+} lithium_shadow_t;
+
+/**
+ * Start a shadow that knows nothing about the radio
+ *
+ * @param shadow The output shadow
+ */
+void lithium_shadow_init(lithium_shadow_t * shadow);
+
+/**
+ * Check a shadow that survived a reset, starting it again if its checksum
+ * doesn't match
+ *
+ * @param shadow The shadow to check
+ *
+ * @return True if and only if the shadow was intact
+ */
+bool lithium_shadow_load(lithium_shadow_t * shadow);
+
+/**
+ * Forget the radio's configuration, for example because it lost power. It is
+ * fetched again the next time it is read.
+ *
+ * @param shadow The shadow to clear
+ */
+void lithium_shadow_invalidate(lithium_shadow_t * shadow);
+
+/**
+ * Check if sending a command would leave the radio's configuration as it is
+ *
+ * @param shadow The shadow to compare with
+ * @param request The command that would be sent
+ *
+ * @return True if and only if request sets configuration the shadow already
+ *      knows the radio has
+ */
+bool lithium_shadow_unchanged(const lithium_shadow_t * shadow, const lithium_packet_t * request);
+
+/**
+ * Update a shadow for a command the radio acknowledged. Commands that don't
+ * touch the configuration are ignored.
+ *
+ * @param shadow The shadow to update
+ * @param request The acknowledged command
+ */
+void lithium_shadow_acknowledged(lithium_shadow_t * shadow, const lithium_packet_t * request);
+
+/**
+ * Update a shadow from a reply to GET_TRANSCEIVER_CONFIG. Other packets are
+ * ignored.
+ *
+ * @param shadow The shadow to update
+ * @param response The packet received from the radio
+ */
+void lithium_shadow_received(lithium_shadow_t * shadow, const lithium_packet_t * response);
+
+/**
+ * Send a command through a shadow: commands that wouldn't change anything
+ * are skipped, and the shadow is updated once the radio acknowledges.
+ * Blocks until the radio replies.
+ *
+ * @param shadow The shadow to keep up to date
+ * @param radio The radio to communicate with
+ * @param request The command to send
+ *
+ * @return LITHIUM_NO_ERROR if the command was acknowledged or skipped, or
+ *      the result of sending it and receiving the reply
+ */
+lithium_result_t lithium_shadow_send(lithium_shadow_t * shadow, lithium_t * radio, lithium_packet_t * request);
+
+/**
+ * Read the radio's front-end configuration, fetching it only if the shadow
+ * doesn't have it. Blocks until the radio replies if it has to fetch.
+ *
+ * @param shadow The shadow to read
+ * @param radio The radio to fetch from
+ *
+ * @return The configuration, or NULL if it couldn't be fetched
+ */
+const lithium_config_t * lithium_shadow_config(lithium_shadow_t * shadow, lithium_t * radio);
+
+/**
+ * Read the radio's RF configuration
+ *
+ * @param shadow The shadow to read
+ *
+ * @return The configuration, or NULL if it hasn't been set since the radio
+ *      was last reset
+ */
+const lithium_rf_config_t * lithium_shadow_rf_config(const lithium_shadow_t * shadow);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_LITHIUM_SHADOW_H_
@@ -0,0 +1,121 @@
+#include "lithium_wire.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "fletcher.h"
+#include "lithium_internal.h"
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+static void put_be(uint8_t * bytes, uint32_t value, uint8_t width);
+static uint32_t get_be(const uint8_t * bytes, uint8_t width);
+
+// The layouts must not depend on the compiler
+_Static_assert(sizeof(lithium_config_wire_t) == 34, "lithium_config_t must encode to 34 bytes");
+_Static_assert(sizeof(lithium_rf_config_wire_t) == 10, "lithium_rf_config_t must encode to 10 bytes");
+_Static_assert(sizeof(lithium_beacon_config_wire_t) == 1, "lithium_beacon_config_t must encode to 1 byte");
+_Static_assert(sizeof(lithium_telem_wire_t) == 16, "lithium_telem_t must encode to 16 bytes");
+
+/// The bits per second of each interface baud rate
+static const uint32_t BAUD_BPS[] = {
+#   define BAUD_BPS_OP(E, V) [LITHIUM_BAUD_##E] = E,
+    LITHIUM_BAUD_LIST(BAUD_BPS_OP)
+#   undef BAUD_BPS_OP
+};
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+
+// Generate an encoder and decoder for each payload. The field macros expand
+// inside the functions, where wire_t names the payload's layout.
+#define ENCODE_FIELD(name, width) \
+    put_be(payload + offsetof(wire_t, name), (uint32_t) value->name, width);
+#define ENCODE_BYTES(name, width) \
+    memcpy(payload + offsetof(wire_t, name), value->name, width);
+#define DECODE_FIELD(name, width) \
+    value->name = get_be(payload + offsetof(wire_t, name), width);
+#define DECODE_BYTES(name, width) \
+    memcpy(value->name, payload + offsetof(wire_t, name), width);
+
+#define EMIT_CODEC(name, type, LIST) \
+    uint16_t lithium_encode_##name(const type * value, uint8_t * payload) { \
+        typedef lithium_##name##_wire_t wire_t; \
+        LIST(ENCODE_FIELD, ENCODE_BYTES) \
+        return sizeof(wire_t); \
+    } \
+    bool lithium_decode_##name(const uint8_t * payload, uint16_t length, type * value) { \
+        typedef lithium_##name##_wire_t wire_t; \
+        if (length < sizeof(wire_t)) { \
+            return false; \
+        } \
+        LIST(DECODE_FIELD, DECODE_BYTES) \
+        return true; \
+    }
+
+LITHIUM_WIRE_LIST(EMIT_CODEC)
+
+#undef EMIT_CODEC
+#undef DECODE_BYTES
+#undef DECODE_FIELD
+#undef ENCODE_BYTES
+#undef ENCODE_FIELD
+
+uint16_t encode_header(lithium_command_type_t type, lithium_command_t command, uint16_t payload_length, uint8_t * raw_packet, fletcher_ctx_t * checksum) {
+    raw_packet[0] = SYNC_1;
+    raw_packet[1] = SYNC_2;
+    raw_packet[2] = type;
+    raw_packet[3] = command;
+    raw_packet[4] = (payload_length >> 8) & 0xFF;
+    raw_packet[5] = payload_length & 0xFF;
+    fletcher_init(checksum);
+    fletcher_update(checksum, raw_packet + 2, 4);
+    fletcher_final(checksum, raw_packet + 6);
+    fletcher_update(checksum, raw_packet + 6, 2);
+    return 8;
+}
+
+uint16_t lithium_encode_frame(lithium_command_type_t type, lithium_command_t command, uint16_t length, const uint8_t * payload, uint8_t * frame) {
+    fletcher_ctx_t checksum;
+    uint16_t frame_length = encode_header(type, command, length, frame, &checksum);
+    if (payload == NULL || length == 0) {
+        return frame_length;
+    }
+
+    memcpy(frame + frame_length, payload, length);
+    fletcher_update(&checksum, payload, length);
+    frame_length += length;
+    fletcher_final(&checksum, frame + frame_length);
+    return frame_length + CHECKSUM_LENGTH;
+}
+
+uint32_t lithium_baud_bps(lithium_baud_t baud) {
+    return (size_t) baud < sizeof(BAUD_BPS) / sizeof(BAUD_BPS[0]) ? BAUD_BPS[baud] : 0;
+}
+
+/******************************************************************************\
+ *  Private support function implementations                                  *
+\******************************************************************************/
+
+/**
+ * Write the low width bytes of a value, most significant first
+ */
+static void put_be(uint8_t * bytes, uint32_t value, uint8_t width) {
+    for (uint8_t i = width; i > 0; --i) {
+        bytes[i - 1] = (uint8_t) value;
+        value >>= 8;
+    }
+}
+
+/**
+ * Read a width byte value, most significant first
+ */
+static uint32_t get_be(const uint8_t * bytes, uint8_t width) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < width; ++i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
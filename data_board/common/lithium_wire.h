@@ -0,0 +1,163 @@
+#ifndef _COMMON_LITHIUM_WIRE_H_
+#define _COMMON_LITHIUM_WIRE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lithium.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup lithium_wire Lithium payload encoding
+ *  The byte layout of the structured Lithium payloads. The C structs in
+ *  lithium.h have enum fields and padding whose sizes vary between
+ *  compilers, so they are never sent as they are. Each payload is instead
+ *  described once, as a list of fields, and the list generates:
+ *  \li a wire struct of byte arrays that gives every field's offset,
+ *  \li an encoder from the C struct, and
+ *  \li a decoder that reads each field straight out of a received payload.
+ *
+ *  Multi-byte fields are big-endian. FIELD entries are integers of the given
+ *  width; BYTES entries are copied as they are.
+ *  @{
+ */
+
+/**
+ * Field list for lithium_config_t
+ */
+#define LITHIUM_CONFIG_WIRE(FIELD, BYTES) \
+    FIELD(interface_baud_rate, 1) \
+    FIELD(tx_power_amp_level, 1) \
+    FIELD(rx_rf_baud_rate, 1) \
+    FIELD(tx_rf_baud_rate, 1) \
+    FIELD(rx_modulation, 1) \
+    FIELD(tx_modulation, 1) \
+    FIELD(rx_freq, 4) \
+    FIELD(tx_freq, 4) \
+    BYTES(source, 6) \
+    BYTES(destination, 6) \
+    FIELD(tx_preamble, 2) \
+    FIELD(tx_postamble, 2) \
+    FIELD(function_config, 2) \
+    FIELD(function_config2, 2)
+
+/**
+ * Field list for lithium_rf_config_t
+ */
+#define LITHIUM_RF_CONFIG_WIRE(FIELD, BYTES) \
+    FIELD(front_end_level, 1) \
+    FIELD(tx_power_amp_level, 1) \
+    FIELD(tx_frequency_offset, 4) \
+    FIELD(rx_frequency_offset, 4)
+
+/**
+ * Field list for lithium_beacon_config_t
+ */
+#define LITHIUM_BEACON_CONFIG_WIRE(FIELD, BYTES) \
+    FIELD(beacon_interval, 1)
+
+/**
+ * Field list for lithium_telem_t
+ */
+#define LITHIUM_TELEM_WIRE(FIELD, BYTES) \
+    FIELD(op_counter, 2) \
+    FIELD(msp430_temp, 2) \
+    BYTES(time_count, 3) \
+    FIELD(rssi, 1) \
+    FIELD(bytes_received, 4) \
+    FIELD(bytes_transmitted, 4)
+
+/**
+ * Macro list of the encoded payloads: name, C type and field list
+ */
+#define LITHIUM_WIRE_LIST(WIRE) \
+    WIRE(config, lithium_config_t, LITHIUM_CONFIG_WIRE) \
+    WIRE(rf_config, lithium_rf_config_t, LITHIUM_RF_CONFIG_WIRE) \
+    WIRE(beacon_config, lithium_beacon_config_t, LITHIUM_BEACON_CONFIG_WIRE) \
+    WIRE(telem, lithium_telem_t, LITHIUM_TELEM_WIRE)
+
+/**
+ * The wire layout of each payload. Every member is a byte array, so there is
+ * no padding and offsetof gives each field's position in the payload.
+ */
+#define WIRE_MEMBER(name, width) uint8_t name[width];
+#define EMIT_WIRE_STRUCT(name, type, LIST) \
+    typedef struct lithium_##name##_wire { \
+        LIST(WIRE_MEMBER, WIRE_MEMBER) \
+    } lithium_##name##_wire_t;
+
+LITHIUM_WIRE_LIST(EMIT_WIRE_STRUCT)
+
+#undef EMIT_WIRE_STRUCT
+#undef WIRE_MEMBER
+
+/// The encoded length of lithium_config_t
+#define LITHIUM_CONFIG_WIRE_LENGTH sizeof(lithium_config_wire_t)
+/// The encoded length of lithium_rf_config_t
+#define LITHIUM_RF_CONFIG_WIRE_LENGTH sizeof(lithium_rf_config_wire_t)
+/// The encoded length of lithium_beacon_config_t
+#define LITHIUM_BEACON_CONFIG_WIRE_LENGTH sizeof(lithium_beacon_config_wire_t)
+/// The encoded length of lithium_telem_t
+#define LITHIUM_TELEM_WIRE_LENGTH sizeof(lithium_telem_wire_t)
+
+/**
+ * Declare the encoder and decoder of each payload:
+ *
+ * uint16_t lithium_encode_<name>(const <type> * value, uint8_t * payload)
+ *      writes the encoded value and returns its length.
+ *
+ * bool lithium_decode_<name>(const uint8_t * payload, uint16_t length, <type> * value)
+ *      reads a value from a received payload, and returns false without
+ *      touching value if the payload is too short.
+ */
+#define EMIT_CODEC_DECLARATIONS(name, type, LIST) \
+    uint16_t lithium_encode_##name(const type * value, uint8_t * payload); \
+    bool lithium_decode_##name(const uint8_t * payload, uint16_t length, type * value);
+
+LITHIUM_WIRE_LIST(EMIT_CODEC_DECLARATIONS)
+
+#undef EMIT_CODEC_DECLARATIONS
+
+/** @} */
+
+/** @defgroup lithium_frame Lithium frame encoding
+ *  Frames as they cross the radio's UART, for the code that plays the other
+ *  end of it: the tests and the emulator.
+ *  @{
+ */
+
+/**
+ * Encode a whole frame. The payload and its checksum follow the header only
+ * if there is a payload, so ACKs and NACKs, whose lengths are markers, pass
+ * NULL.
+ *
+ * @param type The type of the frame
+ * @param command The frame's command
+ * @param length The length of the payload, at most
+ *      LITHIUM_MAX_PAYLOAD_LENGTH if there is one
+ * @param payload The payload, or NULL for none
+ * @param frame The output byte array of at least LITHIUM_MAX_FRAME_LENGTH
+ *      bytes
+ *
+ * @return The length of the frame in bytes
+ */
+uint16_t lithium_encode_frame(lithium_command_type_t type, lithium_command_t command, uint16_t length, const uint8_t * payload, uint8_t * frame);
+
+/**
+ * Get an interface baud rate in bits per second
+ *
+ * @param baud The interface baud rate setting
+ *
+ * @return The number of bits per second, or 0 if baud is not a setting
+ */
+uint32_t lithium_baud_bps(lithium_baud_t baud);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_LITHIUM_WIRE_H_
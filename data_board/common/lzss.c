@@ -0,0 +1,182 @@
+#include "lzss.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+static uint8_t hash(const uint8_t * bytes);
+static void insert(lzss_t * lzss, const uint8_t * input, uint16_t length, uint16_t position);
+static uint16_t encode_body(lzss_t * lzss, const uint8_t * input, uint16_t length, uint8_t * frame);
+
+#if (LZSS_HASH_SIZE & (LZSS_HASH_SIZE - 1)) != 0 || LZSS_HASH_SIZE > 256
+#   error "LZSS_HASH_SIZE must be a power of two no more than 256"
+#endif
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+uint16_t lzss_encode(lzss_t * lzss, const uint8_t * input, uint16_t length, uint8_t * frame) {
+    if (length > LZSS_MAX_INPUT) {
+        return 0;
+    }
+
+    // Nothing is sent raw, since compressing it still takes the flag byte
+    uint16_t frame_length = length > 0 ? encode_body(lzss, input, length, frame) : 0;
+    if (frame_length != 0) {
+        frame[0] = LZSS_FRAME_COMPRESSED;
+        return frame_length;
+    }
+
+    frame[0] = LZSS_FRAME_RAW;
+    memcpy(frame + 1, input, length);
+    return length + 1;
+}
+
+bool lzss_decode(const uint8_t * frame, uint16_t length, uint8_t * output, uint16_t capacity, uint16_t * output_length) {
+    if (length == 0) {
+        return false;
+    }
+
+    if (frame[0] == LZSS_FRAME_RAW) {
+        if (length - 1 > capacity) {
+            return false;
+        }
+        memcpy(output, frame + 1, length - 1);
+        *output_length = length - 1;
+        return true;
+    }
+    if (frame[0] != LZSS_FRAME_COMPRESSED) {
+        return false;
+    }
+
+    uint16_t in = 1;
+    uint16_t out = 0;
+    while (in < length) {
+        uint8_t flags = frame[in++];
+        for (uint8_t mask = 1; mask != 0 && in < length; mask <<= 1) {
+            if ((flags & mask) == 0) {
+                if (out >= capacity) {
+                    return false;
+                }
+                output[out++] = frame[in++];
+                continue;
+            }
+
+            if (in + 2 > length) {
+                return false;
+            }
+            uint16_t offset = frame[in];
+            uint16_t match = frame[in + 1] + LZSS_MIN_MATCH;
+            in += 2;
+            if (offset == 0 || offset > out || match > capacity - out) {
+                return false;
+            }
+
+            // Byte at a time, since a match may overlap its own output
+            for (uint16_t i = 0; i < match; ++i, ++out) {
+                output[out] = output[out - offset];
+            }
+        }
+    }
+
+    *output_length = out;
+    return true;
+}
+
+/******************************************************************************\
+ *  Private support function implementations                                  *
+\******************************************************************************/
+
+/**
+ * Hash the LZSS_MIN_MATCH bytes starting at bytes
+ */
+static uint8_t hash(const uint8_t * bytes) {
+    return (uint8_t) ((bytes[0] << 4) ^ (bytes[1] << 2) ^ bytes[2]) & (LZSS_HASH_SIZE - 1);
+}
+
+/**
+ * Make a position findable by later matches
+ */
+static void insert(lzss_t * lzss, const uint8_t * input, uint16_t length, uint16_t position) {
+    if (position + LZSS_MIN_MATCH > length) {
+        return;
+    }
+    uint8_t key = hash(input + position);
+    lzss->prev[position] = lzss->head[key];
+    lzss->head[key] = position + 1;
+}
+
+/**
+ * Compress in to frame after its flag byte
+ *
+ * @return The length of the frame, or 0 if it wouldn't be shorter than a raw
+ *      frame
+ */
+static uint16_t encode_body(lzss_t * lzss, const uint8_t * input, uint16_t length, uint8_t * frame) {
+    memset(lzss->head, 0, sizeof(lzss->head));
+
+    // A raw frame is length + 1 bytes, so anything longer than length is a
+    // loss and the encoder gives up as soon as it gets there
+    uint16_t out = 1;
+    uint16_t flags = 0;
+    uint8_t mask = 0;
+    uint16_t position = 0;
+    while (position < length) {
+        if (mask == 0) {
+            if (out + 1 > length) {
+                return 0;
+            }
+            flags = out;
+            frame[out++] = 0;
+            mask = 1;
+        }
+
+        // Walk back through earlier positions with the same hash
+        uint16_t best_length = 0;
+        uint16_t best_offset = 0;
+        if (position + LZSS_MIN_MATCH <= length) {
+            uint16_t longest = length - position;
+            uint8_t candidate = lzss->head[hash(input + position)];
+            for (uint8_t chain = 0; candidate != 0 && chain < LZSS_MAX_CHAIN; ++chain) {
+                uint16_t start = candidate - 1;
+                uint16_t matched = 0;
+                while (matched < longest && input[start + matched] == input[position + matched]) {
+                    ++matched;
+                }
+                if (matched > best_length) {
+                    best_length = matched;
+                    best_offset = position - start;
+                    if (matched == longest) {
+                        break;
+                    }
+                }
+                candidate = lzss->prev[start];
+            }
+        }
+
+        if (best_length >= LZSS_MIN_MATCH) {
+            if (out + 2 > length) {
+                return 0;
+            }
+            frame[flags] |= mask;
+            frame[out++] = (uint8_t) best_offset;
+            frame[out++] = (uint8_t) (best_length - LZSS_MIN_MATCH);
+            for (uint16_t end = position + best_length; position < end; ++position) {
+                insert(lzss, input, length, position);
+            }
+        }
+        else {
+            if (out + 1 > length) {
+                return 0;
+            }
+            frame[out++] = input[position];
+            insert(lzss, input, length, position);
+            ++position;
+        }
+        mask <<= 1;
+    }
+
+    return out;
+}
@@ -0,0 +1,110 @@
+#ifndef _COMMON_LZSS_H_
+#define _COMMON_LZSS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup lzss LZSS frame compression
+ *  A small LZSS compressor for radio payloads. Each frame is compressed on
+ *  its own, with the frame itself as the window, so a lost frame never stops
+ *  the ones after it from decoding. The encoder uses a fixed block of state
+ *  and the decoder none at all, and neither allocates.
+ *
+ *  A frame starts with a flag byte. LZSS_FRAME_RAW frames carry the input
+ *  unchanged, and are sent whenever compressing wouldn't make the frame
+ *  shorter, so a frame is never more than one byte longer than its input.
+ *
+ *  LZSS_FRAME_COMPRESSED frames are groups of up to 8 items, each group led
+ *  by a byte whose bits, least significant first, mark the items that are
+ *  matches. A literal is one byte. A match is two: how far back the match
+ *  starts, and its length less LZSS_MIN_MATCH.
+ *  @{
+ */
+
+/// The longest input that still fits a Lithium payload once it is framed
+#define LZSS_MAX_INPUT 254
+
+/// The shortest match worth encoding
+#define LZSS_MIN_MATCH 3
+
+#ifndef LZSS_HASH_SIZE
+/// The number of hash chains, a power of two
+#   define LZSS_HASH_SIZE 64
+#endif
+
+#ifndef LZSS_MAX_CHAIN
+/// The most earlier positions compared when looking for a match
+#   define LZSS_MAX_CHAIN 16
+#endif
+
+/**
+ * The first byte of a frame
+ */
+typedef enum {
+    /**
+     * The rest of the frame is the input, unchanged
+     */
+    LZSS_FRAME_RAW = 0x00,
+    /**
+     * The rest of the frame is compressed
+     */
+    LZSS_FRAME_COMPRESSED = 0x01
+} lzss_frame_t;
+
+/**
+ * The encoder's working state. Only used during lzss_encode, so one can be
+ * shared by everything that compresses from the same task.
+ */
+typedef struct lzss {
+    /**
+     * The latest position, plus one, with each hash. Zero if there is none.
+     */
+    uint8_t head[LZSS_HASH_SIZE];
+    /**
+     * The previous position, plus one, with the same hash as each position
+     */
+    uint8_t prev[LZSS_MAX_INPUT];
+    /**
+     * Room for one frame, for callers with nowhere else to encode in to.
+     * lzss_encode doesn't use it unless it is passed as the frame.
+     */
+    uint8_t frame[LZSS_MAX_INPUT + 1];
+} lzss_t;
+
+/**
+ * Compress some bytes in to a frame
+ *
+ * @param lzss The encoder state to work in
+ * @param input The bytes to compress
+ * @param length The number of bytes to compress, at most LZSS_MAX_INPUT
+ * @param frame The output frame, with room for length + 1 bytes. Must not
+ *      overlap input.
+ *
+ * @return The length of the frame, or 0 if length was too long
+ */
+uint16_t lzss_encode(lzss_t * lzss, const uint8_t * input, uint16_t length, uint8_t * frame);
+
+/**
+ * Recover the bytes in a frame
+ *
+ * @param frame The frame to decode
+ * @param length The length of the frame
+ * @param output The output bytes
+ * @param capacity The room in output
+ * @param output_length The output number of bytes recovered
+ *
+ * @return True if and only if the frame was well formed and fit in output
+ */
+bool lzss_decode(const uint8_t * frame, uint16_t length, uint8_t * output, uint16_t capacity, uint16_t * output_length);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_LZSS_H_
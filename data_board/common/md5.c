@@ -0,0 +1,161 @@
+#include "md5.h"
+
+#include <string.h>
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+static void transform(uint32_t * state, const uint8_t * block);
+static void store_le32(uint8_t * bytes, uint32_t value);
+
+/// The additive constants for each step, from the sines of 1 to 64
+static const uint32_t K[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+    0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+    0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+    0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+    0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+    0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+/// The left rotation of each step, four per round
+static const uint8_t SHIFTS[16] = {
+    7, 12, 17, 22,
+    5, 9, 14, 20,
+    4, 11, 16, 23,
+    6, 10, 15, 21,
+};
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+void md5_init(md5_ctx_t * ctx) {
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xefcdab89;
+    ctx->state[2] = 0x98badcfe;
+    ctx->state[3] = 0x10325476;
+    ctx->length = 0;
+}
+
+void md5_update(md5_ctx_t * ctx, const uint8_t * data, size_t length) {
+    size_t buffered = ctx->length % MD5_BLOCK_LENGTH;
+    ctx->length += length;
+
+    // Top up a partial block first
+    if (buffered > 0) {
+        size_t wanted = MD5_BLOCK_LENGTH - buffered;
+        if (length < wanted) {
+            memcpy(ctx->buffer + buffered, data, length);
+            return;
+        }
+        memcpy(ctx->buffer + buffered, data, wanted);
+        transform(ctx->state, ctx->buffer);
+        data += wanted;
+        length -= wanted;
+    }
+
+    // Whole blocks are hashed straight from the input
+    for (; length >= MD5_BLOCK_LENGTH; data += MD5_BLOCK_LENGTH, length -= MD5_BLOCK_LENGTH) {
+        transform(ctx->state, data);
+    }
+    if (length > 0) {
+        memcpy(ctx->buffer, data, length);
+    }
+}
+
+void md5_final(md5_ctx_t * ctx, uint8_t * digest) {
+    // Pad with a one bit, then zeros up to the last 8 bytes of a block, which
+    // hold the length in bits
+    uint32_t length = ctx->length;
+    size_t buffered = length % MD5_BLOCK_LENGTH;
+    ctx->buffer[buffered++] = 0x80;
+    if (buffered > MD5_BLOCK_LENGTH - 8) {
+        memset(ctx->buffer + buffered, 0, MD5_BLOCK_LENGTH - buffered);
+        transform(ctx->state, ctx->buffer);
+        buffered = 0;
+    }
+    memset(ctx->buffer + buffered, 0, MD5_BLOCK_LENGTH - 8 - buffered);
+    store_le32(ctx->buffer + MD5_BLOCK_LENGTH - 8, length << 3);
+    store_le32(ctx->buffer + MD5_BLOCK_LENGTH - 4, length >> 29);
+    transform(ctx->state, ctx->buffer);
+
+    for (uint8_t i = 0; i < 4; ++i) {
+        store_le32(digest + 4 * i, ctx->state[i]);
+    }
+}
+
+/******************************************************************************\
+ *  Private support function implementations                                  *
+\******************************************************************************/
+
+/**
+ * Hash one block in to the chaining state
+ */
+static void transform(uint32_t * state, const uint8_t * block) {
+    uint32_t words[16];
+    for (uint8_t i = 0; i < 16; ++i) {
+        words[i] = (uint32_t) block[4 * i]
+            | (uint32_t) block[4 * i + 1] << 8
+            | (uint32_t) block[4 * i + 2] << 16
+            | (uint32_t) block[4 * i + 3] << 24;
+    }
+
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    for (uint8_t i = 0; i < 64; ++i) {
+        uint32_t f;
+        uint8_t g;
+        switch (i / 16) {
+            case 0:
+                f = (b & c) | (~b & d);
+                g = i;
+                break;
+            case 1:
+                f = (d & b) | (~d & c);
+                g = (5 * i + 1) % 16;
+                break;
+            case 2:
+                f = b ^ c ^ d;
+                g = (3 * i + 5) % 16;
+                break;
+            default:
+                f = c ^ (b | ~d);
+                g = (7 * i) % 16;
+                break;
+        }
+
+        uint32_t sum = a + f + K[i] + words[g];
+        uint8_t shift = SHIFTS[(i / 16) * 4 + i % 4];
+        a = d;
+        d = c;
+        c = b;
+        b += (sum << shift) | (sum >> (32 - shift));
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+/**
+ * Write a little-endian 32 bit value
+ */
+static void store_le32(uint8_t * bytes, uint32_t value) {
+    bytes[0] = value;
+    bytes[1] = value >> 8;
+    bytes[2] = value >> 16;
+    bytes[3] = value >> 24;
+}
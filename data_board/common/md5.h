@@ -0,0 +1,72 @@
+#ifndef _COMMON_MD5_H_
+#define _COMMON_MD5_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup md5 MD5 hash
+ *  The MD5 digest the Lithium radio expects with configuration and firmware
+ *  images. Data is hashed incrementally, so an image never has to be in
+ *  memory all at once.
+ *  @{
+ */
+
+/// The length of a digest in bytes
+#define MD5_DIGEST_LENGTH 16
+
+/// The length of the blocks MD5 works on
+#define MD5_BLOCK_LENGTH 64
+
+/**
+ * The running state of a hash
+ */
+typedef struct md5_ctx {
+    /**
+     * The chaining state
+     */
+    uint32_t state[4];
+    /**
+     * The number of bytes hashed so far
+     */
+    uint32_t length;
+    /**
+     * The bytes of an incomplete block
+     */
+    uint8_t buffer[MD5_BLOCK_LENGTH];
+} md5_ctx_t;
+
+/**
+ * Start a new hash
+ *
+ * @param ctx The hash to start
+ */
+void md5_init(md5_ctx_t * ctx);
+
+/**
+ * Add bytes to a hash
+ *
+ * @param ctx The hash to add to
+ * @param data The bytes to add. May be NULL if length is zero.
+ * @param length The number of bytes to add
+ */
+void md5_update(md5_ctx_t * ctx, const uint8_t * data, size_t length);
+
+/**
+ * Finish a hash. The context must be started again before it is reused.
+ *
+ * @param ctx The hash to finish
+ * @param digest The output MD5_DIGEST_LENGTH byte digest
+ */
+void md5_final(md5_ctx_t * ctx, uint8_t * digest);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_MD5_H_
@@ -0,0 +1,218 @@
+#include "radio_manager.h"
+
+#include <stddef.h>
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+static radio_in_flight_t * find_in_flight(radio_manager_t * manager, lithium_command_t command);
+static radio_in_flight_t * find_free_slot(radio_manager_t * manager);
+static void dispatch(radio_manager_t * manager, lithium_handle_t handle);
+static void complete(radio_complete_t on_complete, void * context, lithium_result_t result, lithium_handle_t response);
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+void radio_manager_init(radio_manager_t * manager, lithium_t * radio, lithium_pool_t * pool, radio_receive_t on_receive, void * context) {
+    manager->radio = radio;
+    manager->pool = pool;
+    manager->queued = 0;
+    for (uint8_t i = 0; i < RADIO_MANAGER_MAX_IN_FLIGHT; ++i) {
+        manager->in_flight[i].active = false;
+    }
+    manager->rx_packet = lithium_pool_acquire(pool);
+    manager->now = 0;
+    manager->on_receive = on_receive;
+    manager->receive_context = context;
+    manager->stats.sent = 0;
+    manager->stats.timeouts = 0;
+    manager->stats.unmatched = 0;
+    manager->stats.rejected = 0;
+}
+
+bool radio_manager_submit(radio_manager_t * manager, const radio_request_t * request) {
+    if (manager->queued >= RADIO_MANAGER_QUEUE_LENGTH ||
+            lithium_pool_get(manager->pool, request->packet) == NULL) {
+        return false;
+    }
+
+    manager->queue[manager->queued++] = *request;
+    return true;
+}
+
+uint16_t radio_manager_feed(radio_manager_t * manager, const uint8_t * data, uint16_t length) {
+    uint16_t total = 0;
+    for (;;) {
+        // Without a packet to decode in to, leave the rest for later
+        if (manager->rx_packet == LITHIUM_HANDLE_NONE) {
+            manager->rx_packet = lithium_pool_acquire(manager->pool);
+            if (manager->rx_packet == LITHIUM_HANDLE_NONE) {
+                break;
+            }
+        }
+
+        uint16_t consumed;
+        lithium_packet_t * packet = lithium_pool_get(manager->pool, manager->rx_packet);
+        lithium_result_t err = lithium_decoder_feed(&manager->radio->decoder, data + total, length - total, &consumed, packet);
+        total += consumed;
+
+        if (err == LITHIUM_INCOMPLETE) {
+            break;
+        }
+        else if (err == LITHIUM_NO_ERROR) {
+            lithium_handle_t handle = manager->rx_packet;
+            manager->rx_packet = LITHIUM_HANDLE_NONE;
+            dispatch(manager, handle);
+            lithium_pool_release(manager->pool, handle);
+        }
+        else {
+            ++manager->stats.rejected;
+        }
+    }
+    return total;
+}
+
+void radio_manager_tick(radio_manager_t * manager, uint32_t now) {
+    manager->now = now;
+
+    // Give up on overdue responses
+    for (uint8_t i = 0; i < RADIO_MANAGER_MAX_IN_FLIGHT; ++i) {
+        radio_in_flight_t * slot = &manager->in_flight[i];
+        if (slot->active && (int32_t)(now - slot->deadline) >= 0) {
+            slot->active = false;
+            ++manager->stats.timeouts;
+            complete(slot->on_complete, slot->context, LITHIUM_TIMEOUT, LITHIUM_HANDLE_NONE);
+        }
+    }
+
+    // Send what can go, oldest first. A request whose command is already in
+    // flight stays queued, and so does every later one for that command.
+    uint8_t i = 0;
+    while (i < manager->queued) {
+        radio_request_t request = manager->queue[i];
+        lithium_packet_t * packet = lithium_pool_get(manager->pool, request.packet);
+        if (find_in_flight(manager, packet->command) != NULL) {
+            ++i;
+            continue;
+        }
+        radio_in_flight_t * slot = find_free_slot(manager);
+        if (slot == NULL) {
+            break;
+        }
+
+        for (uint8_t j = i + 1; j < manager->queued; ++j) {
+            manager->queue[j - 1] = manager->queue[j];
+        }
+        --manager->queued;
+
+        lithium_command_t command = packet->command;
+        lithium_result_t err = lithium_send_packet(manager->radio, packet);
+        lithium_pool_release(manager->pool, request.packet);
+        if (err != LITHIUM_NO_ERROR) {
+            complete(request.on_complete, request.context, err, LITHIUM_HANDLE_NONE);
+        }
+        else {
+            ++manager->stats.sent;
+            slot->active = true;
+            slot->command = command;
+            slot->deadline = now + request.timeout;
+            slot->on_complete = request.on_complete;
+            slot->context = request.context;
+        }
+    }
+}
+
+bool radio_manager_idle(radio_manager_t * manager) {
+    if (manager->queued > 0) {
+        return false;
+    }
+    for (uint8_t i = 0; i < RADIO_MANAGER_MAX_IN_FLIGHT; ++i) {
+        if (manager->in_flight[i].active) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/******************************************************************************\
+ *  Private support function implementations                                  *
+\******************************************************************************/
+/**
+ * Find the slot waiting for a command's response
+ *
+ * @param manager The manager to search
+ * @param command The command to look for
+ *
+ * @return The slot, or NULL if the command isn't in flight
+ */
+static radio_in_flight_t * find_in_flight(radio_manager_t * manager, lithium_command_t command) {
+    for (uint8_t i = 0; i < RADIO_MANAGER_MAX_IN_FLIGHT; ++i) {
+        radio_in_flight_t * slot = &manager->in_flight[i];
+        if (slot->active && slot->command == command) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Find a slot that isn't waiting for a response
+ *
+ * @param manager The manager to search
+ *
+ * @return The slot, or NULL if every slot is in use
+ */
+static radio_in_flight_t * find_free_slot(radio_manager_t * manager) {
+    for (uint8_t i = 0; i < RADIO_MANAGER_MAX_IN_FLIGHT; ++i) {
+        if (!manager->in_flight[i].active) {
+            return &manager->in_flight[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Hand a received packet to whoever is waiting for it
+ *
+ * @param manager The manager that received the packet
+ * @param handle The packet. The caller keeps its reference.
+ */
+static void dispatch(radio_manager_t * manager, lithium_handle_t handle) {
+    lithium_packet_t * packet = lithium_pool_get(manager->pool, handle);
+    if (!lithium_is_o_message(packet)) {
+        ++manager->stats.unmatched;
+        return;
+    }
+
+    // Data from the ground isn't a response to anything
+    if (packet->command == LITHIUM_COMMAND_RECEIVE_DATA) {
+        if (manager->on_receive != NULL) {
+            manager->on_receive(handle, manager->receive_context);
+        }
+        return;
+    }
+
+    radio_in_flight_t * slot = find_in_flight(manager, packet->command);
+    if (slot == NULL) {
+        ++manager->stats.unmatched;
+        return;
+    }
+
+    slot->active = false;
+    complete(slot->on_complete, slot->context,
+        lithium_is_nack(packet) ? LITHIUM_NACK : LITHIUM_NO_ERROR, handle);
+}
+
+/**
+ * Report the result of a request to its owner
+ *
+ * @param on_complete The request's completion callback. May be NULL.
+ * @param context Passed to on_complete
+ * @param result The result of the request
+ * @param response The response packet, or LITHIUM_HANDLE_NONE
+ */
+static void complete(radio_complete_t on_complete, void * context, lithium_result_t result, lithium_handle_t response) {
+    if (on_complete != NULL) {
+        on_complete(result, response, context);
+    }
+}
@@ -0,0 +1,241 @@
+#ifndef _COMMON_RADIO_MANAGER_H_
+#define _COMMON_RADIO_MANAGER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lithium.h"
+#include "lithium_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup radio_manager Lithium command engine
+ *  Owns the connection to a Lithium radio and pipelines commands over it.
+ *  Requests are queued, sent as soon as the link allows, and completed when
+ *  the radio's response to the same command arrives or their timeout runs
+ *  out. Data the radio receives over the air is handed off separately.
+ *
+ *  The engine never blocks and knows nothing about the scheduler. Whoever
+ *  runs it feeds it received bytes and the time, and the radio task does so
+ *  from a single task. None of the functions may be called concurrently.
+ *
+ *  The radio tells responses apart only by command, so one command of each
+ *  kind can be in flight at a time. Requests for a command that is already in
+ *  flight wait their turn in order.
+ *  @{
+ */
+
+#ifndef RADIO_MANAGER_QUEUE_LENGTH
+/// The number of requests that can wait to be sent
+#   define RADIO_MANAGER_QUEUE_LENGTH 8
+#endif
+
+#ifndef RADIO_MANAGER_MAX_IN_FLIGHT
+/// The number of commands that can wait for a response at once
+#   define RADIO_MANAGER_MAX_IN_FLIGHT 4
+#endif
+
+/**
+ * Called when a request completes
+ *
+ * @param result LITHIUM_NO_ERROR if the radio acknowledged the command or
+ *      replied with data, LITHIUM_NACK if it refused, LITHIUM_TIMEOUT if
+ *      nothing came back in time, or why the command couldn't be sent
+ * @param response The radio's response, or LITHIUM_HANDLE_NONE if there was
+ *      none. It is released once this returns, so retain it to keep it.
+ * @param context The context of the request
+ */
+typedef void (*radio_complete_t)(lithium_result_t result, lithium_handle_t response, void * context);
+
+/**
+ * Called with each packet the radio received over the air
+ *
+ * @param packet The RECEIVE_DATA packet. It is released once this returns, so
+ *      retain it to keep it.
+ * @param context The context given to radio_manager_init
+ */
+typedef void (*radio_receive_t)(lithium_handle_t packet, void * context);
+
+/**
+ * A command to send to the radio
+ */
+typedef struct radio_request {
+    /**
+     * The I-Message to send. The manager takes over the caller's reference.
+     */
+    lithium_handle_t packet;
+    /**
+     * How long to wait for a response once the command is sent, in the units
+     * of the time given to radio_manager_tick
+     */
+    uint32_t timeout;
+    /**
+     * Called when the request completes. May be NULL.
+     */
+    radio_complete_t on_complete;
+    /**
+     * Passed to on_complete
+     */
+    void * context;
+} radio_request_t;
+
+/**
+ * A command waiting for its response
+ */
+typedef struct radio_in_flight {
+    /**
+     * True if this slot is waiting for a response
+     */
+    bool active;
+    /**
+     * The command that was sent
+     */
+    lithium_command_t command;
+    /**
+     * When to give up waiting
+     */
+    uint32_t deadline;
+    /**
+     * Called when the command completes
+     */
+    radio_complete_t on_complete;
+    /**
+     * Passed to on_complete
+     */
+    void * context;
+} radio_in_flight_t;
+
+/**
+ * Counters describing how the link has behaved
+ */
+typedef struct radio_manager_stats {
+    /**
+     * Commands sent to the radio
+     */
+    uint16_t sent;
+    /**
+     * Commands that got no response in time
+     */
+    uint16_t timeouts;
+    /**
+     * Responses to commands that weren't in flight
+     */
+    uint16_t unmatched;
+    /**
+     * Frames rejected by the decoder
+     */
+    uint16_t rejected;
+} radio_manager_stats_t;
+
+/**
+ * The state of the command engine
+ */
+typedef struct radio_manager {
+    /**
+     * The radio being managed
+     */
+    lithium_t * radio;
+    /**
+     * The pool packets are taken from and returned to
+     */
+    lithium_pool_t * pool;
+    /**
+     * Requests waiting to be sent, oldest first
+     */
+    radio_request_t queue[RADIO_MANAGER_QUEUE_LENGTH];
+    /**
+     * The number of requests in queue
+     */
+    uint8_t queued;
+    /**
+     * Commands waiting for their response
+     */
+    radio_in_flight_t in_flight[RADIO_MANAGER_MAX_IN_FLIGHT];
+    /**
+     * The packet the next received frame is decoded in to, or
+     * LITHIUM_HANDLE_NONE if the pool was empty
+     */
+    lithium_handle_t rx_packet;
+    /**
+     * The time given to the last radio_manager_tick
+     */
+    uint32_t now;
+    /**
+     * Called with data received over the air
+     */
+    radio_receive_t on_receive;
+    /**
+     * Passed to on_receive
+     */
+    void * receive_context;
+    /**
+     * Counters describing how the link has behaved
+     */
+    radio_manager_stats_t stats;
+} radio_manager_t;
+
+/**
+ * Start managing a radio
+ *
+ * @param manager The output manager
+ * @param radio The radio to manage. Nothing else may use it afterwards.
+ * @param pool The pool packets come from. It should have room for every
+ *      queued request plus one packet being received.
+ * @param on_receive Called with data received over the air. May be NULL.
+ * @param context Passed to on_receive
+ */
+void radio_manager_init(radio_manager_t * manager, lithium_t * radio, lithium_pool_t * pool, radio_receive_t on_receive, void * context);
+
+/**
+ * Queue a command to send. It goes out on the next radio_manager_tick that
+ * has room for it.
+ *
+ * @param manager The manager to queue the command on
+ * @param request The command. Copied, so it need not outlive the call.
+ *
+ * @return True if and only if the request was queued. If not, the caller
+ *      keeps its reference to the packet.
+ */
+bool radio_manager_submit(radio_manager_t * manager, const radio_request_t * request);
+
+/**
+ * Feed bytes received from the radio. Responses complete their requests and
+ * received data is handed to the receive callback as soon as each frame is
+ * complete.
+ *
+ * @param manager The manager to feed
+ * @param data The received bytes
+ * @param length The number of received bytes
+ *
+ * @return The number of bytes consumed. Fewer than length only if the pool
+ *      ran out of packets to decode in to; feed the rest again later.
+ */
+uint16_t radio_manager_feed(radio_manager_t * manager, const uint8_t * data, uint16_t length);
+
+/**
+ * Move time forward: time out requests whose response is overdue, then send
+ * any queued requests that can go
+ *
+ * @param manager The manager to advance
+ * @param now The current time. May wrap around.
+ */
+void radio_manager_tick(radio_manager_t * manager, uint32_t now);
+
+/**
+ * Check if the manager has nothing to do
+ *
+ * @param manager The manager to inspect
+ *
+ * @return True if and only if no requests are queued or in flight
+ */
+bool radio_manager_idle(radio_manager_t * manager);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_RADIO_MANAGER_H_
@@ -0,0 +1,268 @@
+#include "reed_solomon.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+static uint8_t gf_mul(uint8_t a, uint8_t b);
+static uint8_t gf_div(uint8_t a, uint8_t b);
+static uint8_t gf_pow(uint16_t exponent);
+static uint8_t evaluate(const uint8_t * polynomial, uint8_t degree, uint8_t x);
+
+/// alpha^i, repeated so that the sum of two logs can index it directly
+static const uint8_t GF_EXP[510] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1d, 0x3a, 0x74, 0xe8,
+    0xcd, 0x87, 0x13, 0x26, 0x4c, 0x98, 0x2d, 0x5a, 0xb4, 0x75, 0xea, 0xc9,
+    0x8f, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x9d, 0x27, 0x4e, 0x9c,
+    0x25, 0x4a, 0x94, 0x35, 0x6a, 0xd4, 0xb5, 0x77, 0xee, 0xc1, 0x9f, 0x23,
+    0x46, 0x8c, 0x05, 0x0a, 0x14, 0x28, 0x50, 0xa0, 0x5d, 0xba, 0x69, 0xd2,
+    0xb9, 0x6f, 0xde, 0xa1, 0x5f, 0xbe, 0x61, 0xc2, 0x99, 0x2f, 0x5e, 0xbc,
+    0x65, 0xca, 0x89, 0x0f, 0x1e, 0x3c, 0x78, 0xf0, 0xfd, 0xe7, 0xd3, 0xbb,
+    0x6b, 0xd6, 0xb1, 0x7f, 0xfe, 0xe1, 0xdf, 0xa3, 0x5b, 0xb6, 0x71, 0xe2,
+    0xd9, 0xaf, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0d, 0x1a, 0x34, 0x68,
+    0xd0, 0xbd, 0x67, 0xce, 0x81, 0x1f, 0x3e, 0x7c, 0xf8, 0xed, 0xc7, 0x93,
+    0x3b, 0x76, 0xec, 0xc5, 0x97, 0x33, 0x66, 0xcc, 0x85, 0x17, 0x2e, 0x5c,
+    0xb8, 0x6d, 0xda, 0xa9, 0x4f, 0x9e, 0x21, 0x42, 0x84, 0x15, 0x2a, 0x54,
+    0xa8, 0x4d, 0x9a, 0x29, 0x52, 0xa4, 0x55, 0xaa, 0x49, 0x92, 0x39, 0x72,
+    0xe4, 0xd5, 0xb7, 0x73, 0xe6, 0xd1, 0xbf, 0x63, 0xc6, 0x91, 0x3f, 0x7e,
+    0xfc, 0xe5, 0xd7, 0xb3, 0x7b, 0xf6, 0xf1, 0xff, 0xe3, 0xdb, 0xab, 0x4b,
+    0x96, 0x31, 0x62, 0xc4, 0x95, 0x37, 0x6e, 0xdc, 0xa5, 0x57, 0xae, 0x41,
+    0x82, 0x19, 0x32, 0x64, 0xc8, 0x8d, 0x07, 0x0e, 0x1c, 0x38, 0x70, 0xe0,
+    0xdd, 0xa7, 0x53, 0xa6, 0x51, 0xa2, 0x59, 0xb2, 0x79, 0xf2, 0xf9, 0xef,
+    0xc3, 0x9b, 0x2b, 0x56, 0xac, 0x45, 0x8a, 0x09, 0x12, 0x24, 0x48, 0x90,
+    0x3d, 0x7a, 0xf4, 0xf5, 0xf7, 0xf3, 0xfb, 0xeb, 0xcb, 0x8b, 0x0b, 0x16,
+    0x2c, 0x58, 0xb0, 0x7d, 0xfa, 0xe9, 0xcf, 0x83, 0x1b, 0x36, 0x6c, 0xd8,
+    0xad, 0x47, 0x8e, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1d,
+    0x3a, 0x74, 0xe8, 0xcd, 0x87, 0x13, 0x26, 0x4c, 0x98, 0x2d, 0x5a, 0xb4,
+    0x75, 0xea, 0xc9, 0x8f, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x9d,
+    0x27, 0x4e, 0x9c, 0x25, 0x4a, 0x94, 0x35, 0x6a, 0xd4, 0xb5, 0x77, 0xee,
+    0xc1, 0x9f, 0x23, 0x46, 0x8c, 0x05, 0x0a, 0x14, 0x28, 0x50, 0xa0, 0x5d,
+    0xba, 0x69, 0xd2, 0xb9, 0x6f, 0xde, 0xa1, 0x5f, 0xbe, 0x61, 0xc2, 0x99,
+    0x2f, 0x5e, 0xbc, 0x65, 0xca, 0x89, 0x0f, 0x1e, 0x3c, 0x78, 0xf0, 0xfd,
+    0xe7, 0xd3, 0xbb, 0x6b, 0xd6, 0xb1, 0x7f, 0xfe, 0xe1, 0xdf, 0xa3, 0x5b,
+    0xb6, 0x71, 0xe2, 0xd9, 0xaf, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0d,
+    0x1a, 0x34, 0x68, 0xd0, 0xbd, 0x67, 0xce, 0x81, 0x1f, 0x3e, 0x7c, 0xf8,
+    0xed, 0xc7, 0x93, 0x3b, 0x76, 0xec, 0xc5, 0x97, 0x33, 0x66, 0xcc, 0x85,
+    0x17, 0x2e, 0x5c, 0xb8, 0x6d, 0xda, 0xa9, 0x4f, 0x9e, 0x21, 0x42, 0x84,
+    0x15, 0x2a, 0x54, 0xa8, 0x4d, 0x9a, 0x29, 0x52, 0xa4, 0x55, 0xaa, 0x49,
+    0x92, 0x39, 0x72, 0xe4, 0xd5, 0xb7, 0x73, 0xe6, 0xd1, 0xbf, 0x63, 0xc6,
+    0x91, 0x3f, 0x7e, 0xfc, 0xe5, 0xd7, 0xb3, 0x7b, 0xf6, 0xf1, 0xff, 0xe3,
+    0xdb, 0xab, 0x4b, 0x96, 0x31, 0x62, 0xc4, 0x95, 0x37, 0x6e, 0xdc, 0xa5,
+    0x57, 0xae, 0x41, 0x82, 0x19, 0x32, 0x64, 0xc8, 0x8d, 0x07, 0x0e, 0x1c,
+    0x38, 0x70, 0xe0, 0xdd, 0xa7, 0x53, 0xa6, 0x51, 0xa2, 0x59, 0xb2, 0x79,
+    0xf2, 0xf9, 0xef, 0xc3, 0x9b, 0x2b, 0x56, 0xac, 0x45, 0x8a, 0x09, 0x12,
+    0x24, 0x48, 0x90, 0x3d, 0x7a, 0xf4, 0xf5, 0xf7, 0xf3, 0xfb, 0xeb, 0xcb,
+    0x8b, 0x0b, 0x16, 0x2c, 0x58, 0xb0, 0x7d, 0xfa, 0xe9, 0xcf, 0x83, 0x1b,
+    0x36, 0x6c, 0xd8, 0xad, 0x47, 0x8e,
+};
+/// The i such that alpha^i is the index. Zero has no log.
+static const uint8_t GF_LOG[256] = {
+    0x00, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1a, 0xc6, 0x03, 0xdf, 0x33, 0xee,
+    0x1b, 0x68, 0xc7, 0x4b, 0x04, 0x64, 0xe0, 0x0e, 0x34, 0x8d, 0xef, 0x81,
+    0x1c, 0xc1, 0x69, 0xf8, 0xc8, 0x08, 0x4c, 0x71, 0x05, 0x8a, 0x65, 0x2f,
+    0xe1, 0x24, 0x0f, 0x21, 0x35, 0x93, 0x8e, 0xda, 0xf0, 0x12, 0x82, 0x45,
+    0x1d, 0xb5, 0xc2, 0x7d, 0x6a, 0x27, 0xf9, 0xb9, 0xc9, 0x9a, 0x09, 0x78,
+    0x4d, 0xe4, 0x72, 0xa6, 0x06, 0xbf, 0x8b, 0x62, 0x66, 0xdd, 0x30, 0xfd,
+    0xe2, 0x98, 0x25, 0xb3, 0x10, 0x91, 0x22, 0x88, 0x36, 0xd0, 0x94, 0xce,
+    0x8f, 0x96, 0xdb, 0xbd, 0xf1, 0xd2, 0x13, 0x5c, 0x83, 0x38, 0x46, 0x40,
+    0x1e, 0x42, 0xb6, 0xa3, 0xc3, 0x48, 0x7e, 0x6e, 0x6b, 0x3a, 0x28, 0x54,
+    0xfa, 0x85, 0xba, 0x3d, 0xca, 0x5e, 0x9b, 0x9f, 0x0a, 0x15, 0x79, 0x2b,
+    0x4e, 0xd4, 0xe5, 0xac, 0x73, 0xf3, 0xa7, 0x57, 0x07, 0x70, 0xc0, 0xf7,
+    0x8c, 0x80, 0x63, 0x0d, 0x67, 0x4a, 0xde, 0xed, 0x31, 0xc5, 0xfe, 0x18,
+    0xe3, 0xa5, 0x99, 0x77, 0x26, 0xb8, 0xb4, 0x7c, 0x11, 0x44, 0x92, 0xd9,
+    0x23, 0x20, 0x89, 0x2e, 0x37, 0x3f, 0xd1, 0x5b, 0x95, 0xbc, 0xcf, 0xcd,
+    0x90, 0x87, 0x97, 0xb2, 0xdc, 0xfc, 0xbe, 0x61, 0xf2, 0x56, 0xd3, 0xab,
+    0x14, 0x2a, 0x5d, 0x9e, 0x84, 0x3c, 0x39, 0x53, 0x47, 0x6d, 0x41, 0xa2,
+    0x1f, 0x2d, 0x43, 0xd8, 0xb7, 0x7b, 0xa4, 0x76, 0xc4, 0x17, 0x49, 0xec,
+    0x7f, 0x0c, 0x6f, 0xf6, 0x6c, 0xa1, 0x3b, 0x52, 0x29, 0x9d, 0x55, 0xaa,
+    0xfb, 0x60, 0x86, 0xb1, 0xbb, 0xcc, 0x3e, 0x5a, 0xcb, 0x59, 0x5f, 0xb0,
+    0x9c, 0xa9, 0xa0, 0x51, 0x0b, 0xf5, 0x16, 0xeb, 0x7a, 0x75, 0x2c, 0xd7,
+    0x4f, 0xae, 0xd5, 0xe9, 0xe6, 0xe7, 0xad, 0xe8, 0x74, 0xd6, 0xf4, 0xea,
+    0xa8, 0x50, 0x58, 0xaf,
+};
+/// The logs of the coefficients of x^0 to x^31 of the generator polynomial.
+/// Its x^32 coefficient is 1, and none of the others are zero.
+static const uint8_t GENERATOR_LOG[32] = {
+    0xf1, 0xdc, 0xb9, 0xfe, 0x34, 0x50, 0xde, 0x1c, 0x3c, 0xab, 0x45, 0x26,
+    0x9c, 0x50, 0xb9, 0x78, 0x1b, 0x59, 0x7b, 0xf2, 0x20, 0x8a, 0x8a, 0xd1,
+    0x43, 0x04, 0xa7, 0xf9, 0xbe, 0x6a, 0x06, 0x0a,
+};
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+void rs_encode(const uint8_t * data, uint16_t length, uint8_t * parity) {
+    // Divide the data by the generator, one byte at a time. parity holds the
+    // remainder, highest power first.
+    memset(parity, 0, RS_PARITY_LENGTH);
+    for (uint16_t i = 0; i < length; ++i) {
+        uint8_t feedback = data[i] ^ parity[0];
+        if (feedback == 0) {
+            memmove(parity, parity + 1, RS_PARITY_LENGTH - 1);
+            parity[RS_PARITY_LENGTH - 1] = 0;
+            continue;
+        }
+
+        uint16_t feedback_log = GF_LOG[feedback];
+        for (uint8_t j = 0; j < RS_PARITY_LENGTH - 1; ++j) {
+            parity[j] = parity[j + 1] ^ GF_EXP[feedback_log + GENERATOR_LOG[RS_PARITY_LENGTH - 1 - j]];
+        }
+        parity[RS_PARITY_LENGTH - 1] = GF_EXP[feedback_log + GENERATOR_LOG[0]];
+    }
+}
+
+int16_t rs_decode(uint8_t * block, uint16_t length) {
+    if (length <= RS_PARITY_LENGTH || length > RS_MAX_BLOCK_LENGTH) {
+        return -1;
+    }
+
+    // The block's value at each root of the generator. All zero if and only
+    // if the block is a codeword.
+    uint8_t syndromes[RS_PARITY_LENGTH];
+    bool clean = true;
+    for (uint8_t j = 0; j < RS_PARITY_LENGTH; ++j) {
+        uint8_t syndrome = 0;
+        for (uint16_t i = 0; i < length; ++i) {
+            syndrome = (syndrome == 0 ? 0 : GF_EXP[GF_LOG[syndrome] + j]) ^ block[i];
+        }
+        syndromes[j] = syndrome;
+        clean = clean && syndrome == 0;
+    }
+    if (clean) {
+        return 0;
+    }
+
+    // Berlekamp-Massey: find the shortest error locator that generates the
+    // syndromes
+    uint8_t locator[RS_PARITY_LENGTH + 1] = { 1 };
+    uint8_t previous[RS_PARITY_LENGTH + 1] = { 1 };
+    uint8_t saved[RS_PARITY_LENGTH + 1];
+    uint8_t errors = 0;
+    uint8_t shift = 1;
+    uint8_t previous_discrepancy = 1;
+    for (uint8_t r = 0; r < RS_PARITY_LENGTH; ++r) {
+        uint8_t discrepancy = syndromes[r];
+        for (uint8_t i = 1; i <= errors; ++i) {
+            discrepancy ^= gf_mul(locator[i], syndromes[r - i]);
+        }
+        if (discrepancy == 0) {
+            ++shift;
+            continue;
+        }
+
+        uint8_t scale = gf_div(discrepancy, previous_discrepancy);
+        bool grow = 2 * errors <= r;
+        if (grow) {
+            memcpy(saved, locator, sizeof(locator));
+        }
+        for (uint8_t i = 0; i + shift <= RS_PARITY_LENGTH; ++i) {
+            locator[i + shift] ^= gf_mul(scale, previous[i]);
+        }
+        if (grow) {
+            errors = r + 1 - errors;
+            memcpy(previous, saved, sizeof(previous));
+            previous_discrepancy = discrepancy;
+            shift = 1;
+        }
+        else {
+            ++shift;
+        }
+    }
+    if (errors > RS_PARITY_LENGTH / 2) {
+        return -1;
+    }
+
+    // Chien search: the errors are where the locator has a root. Every root
+    // has to fall inside the block, or there were too many errors.
+    uint16_t positions[RS_PARITY_LENGTH / 2];
+    uint8_t found = 0;
+    for (uint16_t i = 0; i < length && found <= errors; ++i) {
+        uint16_t power = length - 1 - i;
+        if (evaluate(locator, errors, gf_pow(255 - power)) == 0) {
+            if (found == errors) {
+                return -1;
+            }
+            positions[found++] = i;
+        }
+    }
+    if (found != errors) {
+        return -1;
+    }
+
+    // The error evaluator is the syndromes times the locator, mod x^32
+    uint8_t evaluator[RS_PARITY_LENGTH];
+    for (uint8_t k = 0; k < RS_PARITY_LENGTH; ++k) {
+        uint8_t sum = 0;
+        for (uint8_t i = 0; i <= k && i <= errors; ++i) {
+            sum ^= gf_mul(syndromes[k - i], locator[i]);
+        }
+        evaluator[k] = sum;
+    }
+
+    // Forney: work out every error value before fixing any, so a block that
+    // can't be corrected is left alone
+    uint8_t values[RS_PARITY_LENGTH / 2];
+    for (uint8_t e = 0; e < errors; ++e) {
+        uint16_t power = length - 1 - positions[e];
+        uint8_t inverse = gf_pow(255 - power);
+
+        // The formal derivative of the locator keeps only its odd terms
+        uint8_t derivative = 0;
+        for (uint8_t i = 1; i <= errors; i += 2) {
+            derivative ^= gf_mul(locator[i], gf_pow((uint16_t) GF_LOG[inverse] * (i - 1)));
+        }
+        if (derivative == 0) {
+            return -1;
+        }
+        uint8_t numerator = evaluate(evaluator, RS_PARITY_LENGTH - 1, inverse);
+        values[e] = gf_mul(gf_pow(power), gf_div(numerator, derivative));
+    }
+
+    for (uint8_t e = 0; e < errors; ++e) {
+        block[positions[e]] ^= values[e];
+    }
+    return errors;
+}
+
+/******************************************************************************\
+ *  Private support function implementations                                  *
+\******************************************************************************/
+
+/**
+ * Multiply two field elements
+ */
+static uint8_t gf_mul(uint8_t a, uint8_t b) {
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    return GF_EXP[GF_LOG[a] + GF_LOG[b]];
+}
+
+/**
+ * Divide one field element by another, which must not be zero
+ */
+static uint8_t gf_div(uint8_t a, uint8_t b) {
+    if (a == 0) {
+        return 0;
+    }
+    return GF_EXP[GF_LOG[a] + 255 - GF_LOG[b]];
+}
+
+/**
+ * Raise alpha to a power
+ */
+static uint8_t gf_pow(uint16_t exponent) {
+    return GF_EXP[exponent % 255];
+}
+
+/**
+ * Evaluate a polynomial, lowest power first, at x
+ */
+static uint8_t evaluate(const uint8_t * polynomial, uint8_t degree, uint8_t x) {
+    uint8_t sum = 0;
+    for (int16_t i = degree; i >= 0; --i) {
+        sum = gf_mul(sum, x) ^ polynomial[i];
+    }
+    return sum;
+}
@@ -0,0 +1,62 @@
+#ifndef _COMMON_REED_SOLOMON_H_
+#define _COMMON_REED_SOLOMON_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup reed_solomon Reed-Solomon forward error correction
+ *  A systematic RS(255,223) code over GF(2^8), shortened to fit whatever is
+ *  being protected. A block is the data followed by RS_PARITY_LENGTH parity
+ *  bytes, and up to RS_PARITY_LENGTH / 2 corrupted bytes anywhere in it can
+ *  be corrected.
+ *
+ *  The field uses the polynomial x^8 + x^4 + x^3 + x^2 + 1, and the
+ *  generator's roots are alpha^0 to alpha^31. Field arithmetic goes through
+ *  constant log and antilog tables, which the linker places in FRAM.
+ *
+ *  The flight side only encodes. Decoding is meant for the ground, but has
+ *  no dependencies so it also runs in the host tests.
+ *  @{
+ */
+
+/// The number of parity bytes in a block
+#define RS_PARITY_LENGTH 32
+
+/// The longest a block can be
+#define RS_MAX_BLOCK_LENGTH 255
+
+/// The most data a block can protect
+#define RS_MAX_DATA_LENGTH (RS_MAX_BLOCK_LENGTH - RS_PARITY_LENGTH)
+
+/**
+ * Calculate the parity bytes of a block
+ *
+ * @param data The data to protect
+ * @param length The length of the data, at most RS_MAX_DATA_LENGTH
+ * @param parity The output RS_PARITY_LENGTH parity bytes, sent after the data
+ */
+void rs_encode(const uint8_t * data, uint16_t length, uint8_t * parity);
+
+/**
+ * Correct the errors in a block in place
+ *
+ * @param block The data followed by its parity bytes
+ * @param length The length of the block, from RS_PARITY_LENGTH + 1 to
+ *      RS_MAX_BLOCK_LENGTH
+ *
+ * @return The number of bytes corrected, or -1 if the block has more errors
+ *      than can be corrected or is the wrong length. A block that can't be
+ *      corrected is left as it was.
+ */
+int16_t rs_decode(uint8_t * block, uint16_t length);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_REED_SOLOMON_H_
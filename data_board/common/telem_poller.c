@@ -0,0 +1,161 @@
+#include "telem_poller.h"
+#include "lithium_wire.h"
+#include "critical.h"
+
+#include <string.h>
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+
+/**
+ * Take the reply to a query. A radio_complete_t.
+ *
+ * @param result How the query went
+ * @param response The reply, if any
+ * @param context The poller
+ */
+static void on_reply(lithium_result_t result, lithium_handle_t response, void * context);
+
+/**
+ * Fold a reply in to the statistics and make it the latest
+ *
+ * @param poller The poller to update
+ * @param telem The decoded reply
+ */
+static void record(telem_poller_t * poller, const lithium_telem_t * telem);
+
+/**
+ * Add a sample to a statistic
+ *
+ * @param stat The statistic to update
+ * @param sample The new sample
+ */
+static void stat_add(telem_stat_t * stat, int32_t sample);
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+void telem_poller_init(telem_poller_t * poller, lithium_pool_t * pool, uint32_t period, telem_submit_t submit, void * context) {
+    memset(poller, 0, sizeof(*poller));
+    poller->pool = pool;
+    poller->period = period;
+    poller->ttl = 2 * period;
+    poller->submit = submit;
+    poller->context = context;
+}
+
+void telem_poller_set_ttl(telem_poller_t * poller, uint32_t ttl) {
+    poller->ttl = ttl;
+}
+
+void telem_poller_tick(telem_poller_t * poller, uint32_t now) {
+    // Only this task sets in_flight, and the reply only ever clears it
+    if (poller->in_flight || (int32_t) (now - poller->next_poll) < 0) {
+        return;
+    }
+
+    lithium_handle_t handle = lithium_pool_acquire(poller->pool);
+    if (handle == LITHIUM_HANDLE_NONE) {
+        return;
+    }
+    lithium_packet_t * packet = lithium_pool_get(poller->pool, handle);
+    packet->type = LITHIUM_I_MESSAGE;
+    packet->command = LITHIUM_COMMAND_TELEMETRY_QUERY;
+    packet->payload_length = 0;
+
+    radio_request_t request = { handle, poller->period, on_reply, poller };
+    poller->sent_at = now;
+    poller->in_flight = true;
+    if (!poller->submit(&request, poller->context)) {
+        poller->in_flight = false;
+        lithium_pool_release(poller->pool, handle);
+        return;
+    }
+    // Measured from this query, so late ticks never queue up extra ones
+    poller->next_poll = now + poller->period;
+}
+
+bool telem_poller_latest(const telem_poller_t * poller, uint32_t now, lithium_telem_t * telem, uint32_t * age) {
+    critical_state_t state = critical_enter();
+    bool valid = poller->valid;
+    uint32_t sampled_at = poller->sampled_at;
+    *telem = poller->latest;
+    critical_exit(state);
+
+    uint32_t elapsed = valid ? now - sampled_at : UINT32_MAX;
+    if (age) {
+        *age = elapsed;
+    }
+    return valid && elapsed <= poller->ttl;
+}
+
+void telem_poller_stats(const telem_poller_t * poller, telem_stats_t * stats) {
+    critical_state_t state = critical_enter();
+    *stats = poller->stats;
+    critical_exit(state);
+}
+
+int32_t telem_stat_mean(const telem_stat_t * stat) {
+    return stat->count == 0 ? 0 : (int32_t) (stat->sum / (int64_t) stat->count);
+}
+
+/******************************************************************************\
+ *  Private support function implementations                                  *
+\******************************************************************************/
+static void on_reply(lithium_result_t result, lithium_handle_t response, void * context) {
+    telem_poller_t * poller = (telem_poller_t *) context;
+    poller->in_flight = false;
+
+    // Decoded straight out of the pool packet
+    lithium_telem_t telem;
+    lithium_packet_t * packet = response == LITHIUM_HANDLE_NONE ? NULL : lithium_pool_get(poller->pool, response);
+    if (result != LITHIUM_NO_ERROR || packet == NULL
+            || packet->command != LITHIUM_COMMAND_TELEMETRY_QUERY
+            || packet->payload_length != LITHIUM_TELEM_WIRE_LENGTH
+            || !lithium_decode_telem(packet->payload, packet->payload_length, &telem)) {
+        critical_state_t state = critical_enter();
+        ++poller->stats.failures;
+        critical_exit(state);
+        return;
+    }
+    record(poller, &telem);
+}
+
+static void record(telem_poller_t * poller, const lithium_telem_t * telem) {
+    critical_state_t state = critical_enter();
+    telem_stats_t * stats = &poller->stats;
+
+    stat_add(&stats->rssi, telem->rssi);
+    stat_add(&stats->msp430_temp, telem->msp430_temp);
+
+    // The counters only mean something as the change since the last reply
+    if (poller->valid) {
+        const lithium_telem_t * last = &poller->latest;
+        uint32_t received = telem->bytes_received - last->bytes_received;
+        uint32_t transmitted = telem->bytes_transmitted - last->bytes_transmitted;
+        if (telem->bytes_received < last->bytes_received || telem->bytes_transmitted < last->bytes_transmitted) {
+            ++stats->restarts;
+            received = telem->bytes_received;
+            transmitted = telem->bytes_transmitted;
+        }
+        stat_add(&stats->bytes_received, received > INT32_MAX ? INT32_MAX : (int32_t) received);
+        stat_add(&stats->bytes_transmitted, transmitted > INT32_MAX ? INT32_MAX : (int32_t) transmitted);
+    }
+
+    poller->latest = *telem;
+    poller->sampled_at = poller->sent_at;
+    poller->valid = true;
+    critical_exit(state);
+}
+
+static void stat_add(telem_stat_t * stat, int32_t sample) {
+    if (stat->count == 0 || sample < stat->min) {
+        stat->min = sample;
+    }
+    if (stat->count == 0 || sample > stat->max) {
+        stat->max = sample;
+    }
+    stat->sum += sample;
+    ++stat->count;
+}
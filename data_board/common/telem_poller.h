@@ -0,0 +1,213 @@
+#ifndef _COMMON_TELEM_POLLER_H_
+#define _COMMON_TELEM_POLLER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lithium.h"
+#include "lithium_pool.h"
+#include "radio_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup telem_poller Radio telemetry poller
+ *  Polls the radio for its telemetry at a fixed period and keeps the latest
+ *  reply, so any task can read it without waiting on the radio. Running
+ *  statistics are kept alongside it, without any history.
+ *
+ *  Queries go out through the radio manager like any other command. At most
+ *  one is in flight, and the next is never sent sooner than a period after
+ *  the last, so a slow or missing reply never turns in to a burst of
+ *  queries.
+ *
+ *  The byte counters are kept as the change between polls. A radio that
+ *  restarts resets its counters, and those polls count from zero instead.
+ *  @{
+ */
+
+/**
+ * Called to send each query
+ *
+ * @param request The query. The callee takes over the reference to the
+ *      packet if and only if it returns true.
+ * @param context The context given to telem_poller_init
+ *
+ * @return True if and only if the query was queued
+ */
+typedef bool (*telem_submit_t)(const radio_request_t * request, void * context);
+
+/**
+ * The minimum, maximum and sum of a series of samples
+ */
+typedef struct telem_stat {
+    /**
+     * The smallest sample
+     */
+    int32_t min;
+    /**
+     * The largest sample
+     */
+    int32_t max;
+    /**
+     * The sum of every sample
+     */
+    int64_t sum;
+    /**
+     * The number of samples
+     */
+    uint32_t count;
+} telem_stat_t;
+
+/**
+ * Running statistics over every telemetry reply
+ */
+typedef struct telem_stats {
+    /**
+     * The received signal strength
+     */
+    telem_stat_t rssi;
+    /**
+     * The radio's MSP430 temperature
+     */
+    telem_stat_t msp430_temp;
+    /**
+     * The bytes received between polls
+     */
+    telem_stat_t bytes_received;
+    /**
+     * The bytes transmitted between polls
+     */
+    telem_stat_t bytes_transmitted;
+    /**
+     * Times the radio's counters were seen to go backwards
+     */
+    uint16_t restarts;
+    /**
+     * Queries that failed or got an unusable reply
+     */
+    uint16_t failures;
+} telem_stats_t;
+
+/**
+ * The state of a poller
+ */
+typedef struct telem_poller {
+    /**
+     * The pool queries are built in
+     */
+    lithium_pool_t * pool;
+    /**
+     * How often to poll, in the units of the time given to
+     * telem_poller_tick
+     */
+    uint32_t period;
+    /**
+     * How old the latest reply may be before it is stale
+     */
+    uint32_t ttl;
+    /**
+     * When the next query is due
+     */
+    uint32_t next_poll;
+    /**
+     * When the query in flight was sent
+     */
+    uint32_t sent_at;
+    /**
+     * True if a query is waiting for its reply
+     */
+    bool in_flight;
+    /**
+     * True if latest holds a reply
+     */
+    bool valid;
+    /**
+     * When the query for latest was sent
+     */
+    uint32_t sampled_at;
+    /**
+     * The latest reply
+     */
+    lithium_telem_t latest;
+    /**
+     * Statistics over every reply
+     */
+    telem_stats_t stats;
+    /**
+     * Called to send queries
+     */
+    telem_submit_t submit;
+    /**
+     * Passed to submit
+     */
+    void * context;
+} telem_poller_t;
+
+/**
+ * Start a poller. The first query goes out on the first tick. Replies go
+ * stale after two periods, and queries time out after one.
+ *
+ * @param poller The output poller
+ * @param pool The pool to build queries in
+ * @param period How often to poll
+ * @param submit Called to send each query
+ * @param context Passed to submit
+ */
+void telem_poller_init(telem_poller_t * poller, lithium_pool_t * pool, uint32_t period, telem_submit_t submit, void * context);
+
+/**
+ * Change how old a reply may be before it is stale
+ *
+ * @param poller The poller to change
+ * @param ttl The new limit
+ */
+void telem_poller_set_ttl(telem_poller_t * poller, uint32_t ttl);
+
+/**
+ * Send a query if one is due. Called from the task that runs the radio
+ * manager.
+ *
+ * @param poller The poller to run
+ * @param now The current time
+ */
+void telem_poller_tick(telem_poller_t * poller, uint32_t now);
+
+/**
+ * Read the latest reply. Safe to call from any task.
+ *
+ * @param poller The poller to read
+ * @param now The current time
+ * @param telem The output reply
+ * @param age The output age of the reply. May be NULL.
+ *
+ * @return True if and only if there was a reply no older than the TTL. The
+ *      outputs are set for a stale reply too.
+ */
+bool telem_poller_latest(const telem_poller_t * poller, uint32_t now, lithium_telem_t * telem, uint32_t * age);
+
+/**
+ * Read the running statistics. Safe to call from any task.
+ *
+ * @param poller The poller to read
+ * @param stats The output statistics
+ */
+void telem_poller_stats(const telem_poller_t * poller, telem_stats_t * stats);
+
+/**
+ * Compute the mean of a statistic
+ *
+ * @param stat The statistic
+ *
+ * @return The mean, rounded towards zero, or 0 if there are no samples
+ */
+int32_t telem_stat_mean(const telem_stat_t * stat);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_TELEM_POLLER_H_
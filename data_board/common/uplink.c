@@ -0,0 +1,148 @@
+#include "uplink.h"
+
+#include "critical.h"
+
+#include <stddef.h>
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+static uplink_result_t reject(uplink_t * uplink, uplink_result_t result);
+static bool pop_next(uplink_t * uplink, uplink_pending_t * next);
+
+/// The registration of each command
+static const uplink_spec_t SPECS[UPLINK_COMMAND_count] = {
+#   define SPEC_OP(E, OPCODE, MIN, MAX, PRIORITY) \
+        [UPLINK_COMMAND_ ## E] = { OPCODE, MIN, MAX, UPLINK_PRIORITY_ ## PRIORITY },
+    UPLINK_COMMAND_LIST(SPEC_OP)
+#   undef SPEC_OP
+};
+
+/// The command with each opcode, plus one, or zero if no command has it
+static const uint8_t BY_OPCODE[256] = {
+#   define INDEX_OP(E, OPCODE, MIN, MAX, PRIORITY) [OPCODE] = UPLINK_COMMAND_ ## E + 1,
+    UPLINK_COMMAND_LIST(INDEX_OP)
+#   undef INDEX_OP
+};
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+void uplink_init(uplink_t * uplink, lithium_pool_t * pool, const uplink_handler_t * handlers, void * context) {
+    uplink->pool = pool;
+    uplink->handlers = handlers;
+    uplink->context = context;
+    for (uint8_t i = 0; i < UPLINK_PRIORITY_count; ++i) {
+        uplink->queues[i].head = 0;
+        uplink->queues[i].count = 0;
+    }
+    uplink->stats.dispatched = 0;
+    uplink->stats.rejected = 0;
+}
+
+const uplink_spec_t * uplink_lookup(uint8_t opcode) {
+    uint8_t entry = BY_OPCODE[opcode];
+    return entry == 0 ? NULL : &SPECS[entry - 1];
+}
+
+uplink_result_t uplink_dispatch(uplink_t * uplink, lithium_handle_t packet) {
+    lithium_packet_t * received = lithium_pool_get(uplink->pool, packet);
+    if (received == NULL || received->payload_length == 0) {
+        return reject(uplink, UPLINK_EMPTY);
+    }
+
+    uint8_t entry = BY_OPCODE[received->payload[0]];
+    if (entry == 0) {
+        return reject(uplink, UPLINK_UNKNOWN_COMMAND);
+    }
+    uint8_t command = entry - 1;
+    const uplink_spec_t * spec = &SPECS[command];
+
+    uint16_t length = received->payload_length - 1;
+    if (length < spec->min_length || length > spec->max_length) {
+        return reject(uplink, UPLINK_BAD_LENGTH);
+    }
+    uplink_handler_t handler = uplink->handlers[command];
+    if (handler == NULL) {
+        return reject(uplink, UPLINK_NO_HANDLER);
+    }
+
+    if (spec->priority == UPLINK_PRIORITY_IMMEDIATE) {
+        handler(received->payload + 1, length, uplink->context);
+        critical_state_t state = critical_enter();
+        ++uplink->stats.dispatched;
+        critical_exit(state);
+        return UPLINK_NO_ERROR;
+    }
+
+    // The packet is retained for the queue, so the caller can release its
+    // own reference as soon as this returns
+    uplink_queue_t * queue = &uplink->queues[spec->priority];
+    bool queued = false;
+    critical_state_t state = critical_enter();
+    if (queue->count < UPLINK_QUEUE_LENGTH) {
+        uplink_pending_t * pending = &queue->pending[(queue->head + queue->count) % UPLINK_QUEUE_LENGTH];
+        pending->packet = packet;
+        pending->command = command;
+        ++queue->count;
+        lithium_pool_retain(uplink->pool, packet);
+        queued = true;
+    }
+    critical_exit(state);
+
+    return queued ? UPLINK_NO_ERROR : reject(uplink, UPLINK_QUEUE_FULL);
+}
+
+void uplink_receive(lithium_handle_t packet, void * context) {
+    uplink_dispatch((uplink_t *) context, packet);
+}
+
+uint8_t uplink_run(uplink_t * uplink) {
+    uint8_t run = 0;
+    uplink_pending_t next;
+    while (pop_next(uplink, &next)) {
+        lithium_packet_t * received = lithium_pool_get(uplink->pool, next.packet);
+        uplink->handlers[next.command](received->payload + 1, received->payload_length - 1, uplink->context);
+        lithium_pool_release(uplink->pool, next.packet);
+        ++run;
+    }
+    return run;
+}
+
+/******************************************************************************\
+ *  Private support function implementations                                  *
+\******************************************************************************/
+
+/**
+ * Count a refused payload
+ *
+ * @return result
+ */
+static uplink_result_t reject(uplink_t * uplink, uplink_result_t result) {
+    critical_state_t state = critical_enter();
+    ++uplink->stats.rejected;
+    critical_exit(state);
+    return result;
+}
+
+/**
+ * Take the most urgent queued command
+ *
+ * @return True if and only if there was one
+ */
+static bool pop_next(uplink_t * uplink, uplink_pending_t * next) {
+    bool found = false;
+    critical_state_t state = critical_enter();
+    for (uint8_t priority = 0; priority < UPLINK_PRIORITY_count && !found; ++priority) {
+        uplink_queue_t * queue = &uplink->queues[priority];
+        if (queue->count > 0) {
+            *next = queue->pending[queue->head];
+            queue->head = (queue->head + 1) % UPLINK_QUEUE_LENGTH;
+            --queue->count;
+            ++uplink->stats.dispatched;
+            found = true;
+        }
+    }
+    critical_exit(state);
+    return found;
+}
@@ -0,0 +1,268 @@
+#ifndef _COMMON_UPLINK_H_
+#define _COMMON_UPLINK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lithium_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup uplink Uplink command dispatch
+ *  Routes commands received over the air to their handlers. Each RECEIVE_DATA
+ *  payload is one command: an opcode byte followed by its arguments.
+ *
+ *  Commands are looked up through a constant table indexed by opcode, so
+ *  routing takes the same time whatever arrives. The arguments are never
+ *  copied. The packet is retained until its handler has run, and handlers
+ *  are given a pointer in to its payload.
+ *
+ *  Immediate commands run on the receive path. Everything else is queued by
+ *  priority and run by uplink_run, which may be called from another task.
+ *  @{
+ */
+
+/**
+ * Macro list for the priorities of uplink commands, most urgent first
+ */
+#define UPLINK_PRIORITY_LIST(PRIORITY) \
+    PRIORITY(IMMEDIATE) \
+    PRIORITY(HIGH) \
+    PRIORITY(NORMAL)
+
+/**
+ * Enumeration of the priorities of uplink commands
+ */
+typedef enum uplink_priority {
+#   define STRING_OP(E) UPLINK_PRIORITY_ ## E,
+    UPLINK_PRIORITY_LIST(STRING_OP)
+#   undef STRING_OP
+    UPLINK_PRIORITY_count
+} uplink_priority_t;
+
+#undef UPLINK_PRIORITY_LIST
+
+/**
+ * Macro list for the over-the-air commands: name, opcode, the shortest and
+ * longest arguments accepted, and priority
+ */
+#define UPLINK_COMMAND_LIST(COMMAND) \
+    COMMAND(TELEMETRY_DUMP, 0x30, 0, 0, NORMAL) \
+    COMMAND(PING_RETURN, 0x31, 0, 254, HIGH) \
+    COMMAND(CODE_UPLOAD, 0x32, 1, 254, NORMAL) \
+    COMMAND(RADIO_RESET, 0x33, 0, 0, IMMEDIATE) \
+    COMMAND(PIN_TOGGLE, 0x34, 1, 1, HIGH)
+
+/**
+ * Enumeration of the over-the-air commands, numbered from zero to index
+ * handler tables
+ */
+typedef enum uplink_command {
+#   define STRING_OP(E, OPCODE, MIN, MAX, PRIORITY) UPLINK_COMMAND_ ## E,
+    UPLINK_COMMAND_LIST(STRING_OP)
+#   undef STRING_OP
+    UPLINK_COMMAND_count
+} uplink_command_t;
+
+/**
+ * Enumeration of the opcodes of the over-the-air commands
+ */
+typedef enum uplink_opcode {
+#   define STRING_OP(E, OPCODE, MIN, MAX, PRIORITY) UPLINK_OPCODE_ ## E = OPCODE,
+    UPLINK_COMMAND_LIST(STRING_OP)
+#   undef STRING_OP
+} uplink_opcode_t;
+
+/**
+ * Macro list for results of dispatching a command
+ */
+#define UPLINK_RESULT_LIST(OP) \
+    OP(NO_ERROR) \
+    OP(EMPTY) \
+    OP(UNKNOWN_COMMAND) \
+    OP(BAD_LENGTH) \
+    OP(NO_HANDLER) \
+    OP(QUEUE_FULL)
+
+/**
+ * Enumeration of possible results of dispatching a command
+ */
+typedef enum uplink_result {
+#   define STRING_OP(E) UPLINK_ ## E,
+    UPLINK_RESULT_LIST(STRING_OP)
+#   undef STRING_OP
+    UPLINK_count
+} uplink_result_t;
+
+#undef UPLINK_RESULT_LIST
+
+#ifndef UPLINK_QUEUE_LENGTH
+/// The number of commands of each priority that can wait to run
+#   define UPLINK_QUEUE_LENGTH 4
+#endif
+
+/**
+ * Handles an over-the-air command
+ *
+ * @param arguments The command's arguments, inside the received packet. Only
+ *      valid until the handler returns.
+ * @param length The length of the arguments, within the command's limits
+ * @param context The context given to uplink_init
+ */
+typedef void (*uplink_handler_t)(const uint8_t * arguments, uint8_t length, void * context);
+
+/**
+ * What the registry knows about a command
+ */
+typedef struct uplink_spec {
+    /**
+     * The command's opcode
+     */
+    uint8_t opcode;
+    /**
+     * The shortest arguments accepted
+     */
+    uint8_t min_length;
+    /**
+     * The longest arguments accepted
+     */
+    uint8_t max_length;
+    /**
+     * When the command runs
+     */
+    uplink_priority_t priority;
+} uplink_spec_t;
+
+/**
+ * A command waiting to run
+ */
+typedef struct uplink_pending {
+    /**
+     * The received packet holding the command
+     */
+    lithium_handle_t packet;
+    /**
+     * Which command it is
+     */
+    uint8_t command;
+} uplink_pending_t;
+
+/**
+ * The commands of one priority waiting to run, oldest first
+ */
+typedef struct uplink_queue {
+    /**
+     * A ring of the waiting commands
+     */
+    uplink_pending_t pending[UPLINK_QUEUE_LENGTH];
+    /**
+     * The index of the oldest waiting command
+     */
+    uint8_t head;
+    /**
+     * The number of waiting commands
+     */
+    uint8_t count;
+} uplink_queue_t;
+
+/**
+ * Counters describing the commands received
+ */
+typedef struct uplink_stats {
+    /**
+     * Commands that were run
+     */
+    uint16_t dispatched;
+    /**
+     * Payloads refused, for any reason
+     */
+    uint16_t rejected;
+} uplink_stats_t;
+
+/**
+ * The state of the dispatcher
+ */
+typedef struct uplink {
+    /**
+     * The pool received packets belong to
+     */
+    lithium_pool_t * pool;
+    /**
+     * The handler of each command, indexed by uplink_command_t. A command
+     * with a NULL handler is refused.
+     */
+    const uplink_handler_t * handlers;
+    /**
+     * Passed to the handlers
+     */
+    void * context;
+    /**
+     * The commands waiting to run, by priority. Nothing waits in the
+     * immediate queue.
+     */
+    uplink_queue_t queues[UPLINK_PRIORITY_count];
+    /**
+     * Counters describing the commands received
+     */
+    uplink_stats_t stats;
+} uplink_t;
+
+/**
+ * Set up a dispatcher
+ *
+ * @param uplink The output dispatcher
+ * @param pool The pool received packets belong to
+ * @param handlers The handler of each command, indexed by uplink_command_t,
+ *      usually a constant table. Must outlive the dispatcher.
+ * @param context Passed to the handlers
+ */
+void uplink_init(uplink_t * uplink, lithium_pool_t * pool, const uplink_handler_t * handlers, void * context);
+
+/**
+ * Look up a command by its opcode
+ *
+ * @param opcode The opcode to look up
+ *
+ * @return The command's registration, or NULL if no command has the opcode
+ */
+const uplink_spec_t * uplink_lookup(uint8_t opcode);
+
+/**
+ * Route a received RECEIVE_DATA packet to its command. Immediate commands run
+ * before this returns and the rest are queued. Called from the receive path.
+ *
+ * @param uplink The dispatcher to route through
+ * @param packet The received packet. The caller keeps its reference; the
+ *      dispatcher retains the packet itself if it needs it later.
+ *
+ * @return The result of routing the command
+ */
+uplink_result_t uplink_dispatch(uplink_t * uplink, lithium_handle_t packet);
+
+/**
+ * Route a received packet, matching radio_receive_t so the dispatcher can be
+ * given straight to the radio manager or radio task
+ *
+ * @param packet The received packet
+ * @param context The uplink_t to route through
+ */
+void uplink_receive(lithium_handle_t packet, void * context);
+
+/**
+ * Run every queued command, most urgent first, releasing their packets
+ *
+ * @param uplink The dispatcher to run
+ *
+ * @return The number of commands run
+ */
+uint8_t uplink_run(uplink_t * uplink);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _COMMON_UPLINK_H_
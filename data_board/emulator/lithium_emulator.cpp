@@ -0,0 +1,274 @@
+#include "lithium_emulator.hpp"
+#include "lithium_wire.h"
+#include "lithium_internal.h"
+#include "fletcher.h"
+#include "md5.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+namespace {
+    /// Where the header checksum starts, which the body checksum runs on from
+    const size_t HEADER_CHECKSUM_OFFSET = HEADER_LENGTH - CHECKSUM_LENGTH;
+    /// What READ_FIRMWARE_REVISION reports
+    const uint8_t FIRMWARE_REVISION[4] = { 0x00, 0x00, 0x03, 0x04 };
+    /// What the telemetry reports for the parts of the radio not emulated
+    const int16_t MSP430_TEMP = 25;
+    const uint8_t RSSI = 0x60;
+}
+
+/******************************************************************************\
+ *  lithium_emulator implementation                                           *
+\******************************************************************************/
+lithium_emulator::lithium_emulator(const rf_link_config & link) :
+        _link(link),
+        _rng(link.seed),
+        _config(default_config()),
+        _flash_config(default_config()),
+        _rf_config(),
+        _tx_free_ns(0),
+        _op_counter(0),
+        _bytes_received(0),
+        _bytes_transmitted(0),
+        _refused(),
+        _stats() {}
+
+lithium_config_t lithium_emulator::default_config() {
+    lithium_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.interface_baud_rate = LITHIUM_BAUD_9600;
+    config.tx_power_amp_level = 0x80;
+    config.rx_rf_baud_rate = LITHIUM_RF_BAUD_9600;
+    config.tx_rf_baud_rate = LITHIUM_RF_BAUD_9600;
+    config.rx_modulation = LITHIUM_RF_MOD_GFSK;
+    config.tx_modulation = LITHIUM_RF_MOD_GFSK;
+    config.rx_freq = 437525000;
+    config.tx_freq = 437525000;
+    memcpy(config.source, "NOCALL", 6);
+    memcpy(config.destination, "CQ    ", 6);
+    return config;
+}
+
+void lithium_emulator::receive(const uint8_t * bytes, size_t n, uint64_t now_ns) {
+    advance(now_ns);
+    _input.insert(_input.end(), bytes, bytes + n);
+
+    // Pull out every whole frame, resynchronising on anything malformed
+    size_t start = 0;
+    for (;;) {
+        while (start < _input.size() && !(_input[start] == SYNC_1 &&
+                (start + 1 == _input.size() || _input[start + 1] == SYNC_2))) {
+            ++start;
+            ++_stats.dropped_bytes;
+        }
+        if (_input.size() - start < HEADER_LENGTH) {
+            break;
+        }
+
+        const uint8_t * frame = _input.data() + start;
+        uint8_t checksum[CHECKSUM_LENGTH];
+        fletcher_ctx_t ctx;
+        fletcher_init(&ctx);
+        fletcher_update(&ctx, frame + SYNC_BYTES_LENGTH, HEADER_DATA_LENGTH);
+        fletcher_final(&ctx, checksum);
+        uint16_t length = (frame[4] << 8) | frame[5];
+        if (memcmp(checksum, frame + HEADER_CHECKSUM_OFFSET, CHECKSUM_LENGTH) != 0 || frame[2] != LITHIUM_I_MESSAGE || length > MAX_PAYLOAD_LENGTH) {
+            ++start;
+            ++_stats.dropped_bytes;
+            continue;
+        }
+
+        size_t frame_length = HEADER_LENGTH + (length > 0 ? length + CHECKSUM_LENGTH : 0);
+        if (_input.size() - start < frame_length) {
+            break;
+        }
+        if (length > 0) {
+            fletcher_update(&ctx, frame + HEADER_CHECKSUM_OFFSET, CHECKSUM_LENGTH + length);
+            fletcher_final(&ctx, checksum);
+            if (memcmp(checksum, frame + HEADER_LENGTH + length, CHECKSUM_LENGTH) != 0) {
+                ++start;
+                ++_stats.dropped_bytes;
+                continue;
+            }
+        }
+
+        ++_stats.frames;
+        handle(frame[3], frame + HEADER_LENGTH, length, now_ns);
+        start += frame_length;
+    }
+    _input.erase(_input.begin(), _input.begin() + start);
+}
+
+void lithium_emulator::advance(uint64_t now_ns) {
+    while (!_in_flight.empty() && _in_flight.front().deliver_ns <= now_ns) {
+        rf_frame & frame = _in_flight.front();
+        if (frame.lost) {
+            ++_stats.rf_lost;
+        }
+        else if (_listener) {
+            _listener(frame.payload, frame.deliver_ns);
+            ++_stats.rf_delivered;
+        }
+        else {
+            reply(LITHIUM_COMMAND_RECEIVE_DATA, frame.payload.size(), frame.payload.data());
+            _bytes_received += frame.payload.size();
+            ++_stats.rf_delivered;
+        }
+        _in_flight.pop_front();
+    }
+}
+
+uint64_t lithium_emulator::next_event_ns() const {
+    return _in_flight.empty() ? UINT64_MAX : _in_flight.front().deliver_ns;
+}
+
+void lithium_emulator::listen(std::function<void(const std::vector<uint8_t> &, uint64_t)> listener) {
+    _listener = listener;
+}
+
+std::vector<uint8_t> lithium_emulator::take_output() {
+    std::vector<uint8_t> output;
+    output.swap(_output);
+    return output;
+}
+
+void lithium_emulator::refuse(lithium_command_t command, bool refused) {
+    if (command < LITHIUM_COMMAND_count) {
+        _refused[command] = refused;
+    }
+}
+
+lithium_telem_t lithium_emulator::telemetry(uint64_t now_ns) const {
+    lithium_telem_t telem;
+    memset(&telem, 0, sizeof(telem));
+    uint32_t seconds = now_ns / 1000000000ull;
+    telem.op_counter = _op_counter;
+    telem.msp430_temp = MSP430_TEMP;
+    telem.time_count[0] = seconds >> 16;
+    telem.time_count[1] = seconds >> 8;
+    telem.time_count[2] = seconds;
+    telem.rssi = RSSI;
+    telem.bytes_received = _bytes_received;
+    telem.bytes_transmitted = _bytes_transmitted;
+    return telem;
+}
+
+void lithium_emulator::handle(uint8_t command, const uint8_t * payload, uint16_t length, uint64_t now_ns) {
+    ++_op_counter;
+    if (command < LITHIUM_COMMAND_count && _refused[command]) {
+        nack(command);
+        return;
+    }
+
+    uint8_t encoded[LITHIUM_CONFIG_WIRE_LENGTH];
+    bool ok = true;
+    switch (command) {
+        case LITHIUM_COMMAND_NO_OP:
+        case LITHIUM_COMMAND_BEACON_DATA:
+            break;
+        case LITHIUM_COMMAND_RESET_SYSTEM:
+            // Comes back up from flash, with nothing waiting to go out
+            _config = _flash_config;
+            memset(&_rf_config, 0, sizeof(_rf_config));
+            while (!_in_flight.empty() && _in_flight.back().air_end_ns > now_ns) {
+                _in_flight.pop_back();
+            }
+            _tx_free_ns = now_ns;
+            break;
+        case LITHIUM_COMMAND_TRANSMIT_DATA:
+            ok = length > 0 && transmit(payload, length, now_ns);
+            break;
+        case LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG:
+            reply(command, lithium_encode_config(&_config, encoded), encoded);
+            return;
+        case LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG:
+            ok = length == LITHIUM_CONFIG_WIRE_LENGTH && lithium_decode_config(payload, length, &_config);
+            break;
+        case LITHIUM_COMMAND_TELEMETRY_QUERY: {
+            lithium_telem_t telem = telemetry(now_ns);
+            reply(command, lithium_encode_telem(&telem, encoded), encoded);
+            return;
+        }
+        case LITHIUM_COMMAND_WRITE_FLASH:
+            ok = length == MD5_DIGEST_LENGTH;
+            if (ok) {
+                _flash_config = _config;
+            }
+            break;
+        case LITHIUM_COMMAND_RF_CONFIG:
+            ok = length == LITHIUM_RF_CONFIG_WIRE_LENGTH && lithium_decode_rf_config(payload, length, &_rf_config);
+            break;
+        case LITHIUM_COMMAND_BEACON_CONFIG:
+            ok = length == LITHIUM_BEACON_CONFIG_WIRE_LENGTH;
+            break;
+        case LITHIUM_COMMAND_READ_FIRMWARE_REVISION:
+            reply(command, sizeof(FIRMWARE_REVISION), FIRMWARE_REVISION);
+            return;
+        case LITHIUM_COMMAND_WRITE_OVER_AIR_KEY:
+        case LITHIUM_COMMAND_FIRMWARE_UPDATE:
+            ok = length == MD5_DIGEST_LENGTH;
+            break;
+        case LITHIUM_COMMAND_FIRMWARE_PACKET:
+            ok = length > 0;
+            break;
+        case LITHIUM_COMMAND_FAST_PA_SET:
+            ok = length == 1;
+            if (ok) {
+                _config.tx_power_amp_level = payload[0];
+                _rf_config.tx_power_amp_level = payload[0];
+            }
+            break;
+        default:
+            // Including RECEIVE_DATA, which only ever comes from the radio
+            ok = false;
+            break;
+    }
+
+    if (ok) {
+        ack(command);
+    }
+    else {
+        nack(command);
+    }
+}
+
+bool lithium_emulator::transmit(const uint8_t * payload, uint16_t length, uint64_t now_ns) {
+    size_t waiting = std::count_if(_in_flight.begin(), _in_flight.end(),
+        [now_ns](const rf_frame & f) { return f.air_end_ns > now_ns; });
+    if (waiting >= TX_QUEUE_LENGTH) {
+        return false;
+    }
+
+    rf_frame frame;
+    uint64_t start = std::max(now_ns, _tx_free_ns);
+    frame.air_end_ns = start + (length + RF_OVERHEAD) * 8 * 1000000000ull / _link.baud;
+    frame.deliver_ns = frame.air_end_ns + _link.latency_ns;
+    frame.lost = std::bernoulli_distribution(_link.loss)(_rng);
+    frame.payload.assign(payload, payload + length);
+    _tx_free_ns = frame.air_end_ns;
+    _in_flight.push_back(frame);
+
+    _bytes_transmitted += length;
+    ++_stats.rf_sent;
+    return true;
+}
+
+void lithium_emulator::reply(uint8_t command, uint16_t length, const uint8_t * payload) {
+    size_t start = _output.size();
+    _output.resize(start + LITHIUM_MAX_FRAME_LENGTH);
+    _output.resize(start + lithium_encode_frame(LITHIUM_O_MESSAGE, (lithium_command_t) command, length, payload, _output.data() + start));
+}
+
+void lithium_emulator::ack(uint8_t command) {
+    ++_stats.acks;
+    reply(command, ACK_LENGTH);
+}
+
+void lithium_emulator::nack(uint8_t command) {
+    ++_stats.nacks;
+    reply(command, NACK_LENGTH);
+}
@@ -0,0 +1,141 @@
+#ifndef _EMULATOR_LITHIUM_EMULATOR_HPP_
+#define _EMULATOR_LITHIUM_EMULATOR_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "lithium.h"
+
+/// How the emulated RF link behaves
+struct rf_link_config {
+    /// The over the air rate, in bits per second
+    uint32_t baud;
+    /// The chance each frame is lost, from 0 to 1
+    double loss;
+    /// How long a frame takes to come back once it has been sent, on top
+    /// of its time on the air, in nanoseconds
+    uint64_t latency_ns;
+    /// Seeds the losses, so runs can be repeated
+    uint32_t seed;
+
+    rf_link_config() : baud(9600), loss(0), latency_ns(0), seed(1) {}
+};
+
+/// Counters describing what the emulator has seen
+struct lithium_emulator_stats {
+    /// Well formed frames received from the board
+    uint64_t frames;
+    /// Bytes dropped while looking for a frame
+    uint64_t dropped_bytes;
+    /// Commands acknowledged or answered
+    uint64_t acks;
+    /// Commands refused
+    uint64_t nacks;
+    /// TRANSMIT_DATA frames put on the air
+    uint64_t rf_sent;
+    /// Frames lost on the air
+    uint64_t rf_lost;
+    /// Frames that made it over the air
+    uint64_t rf_delivered;
+};
+
+/// A Lithium radio, as seen from the serial port.
+///
+/// The emulator reads I-Messages the way lithium.c encodes them, and acks,
+/// nacks or answers every command. It keeps a configuration that survives
+/// RESET_SYSTEM once it is written to flash, and reports telemetry from its
+/// own counters.
+///
+/// TRANSMIT_DATA payloads go out over an emulated RF link that loops back
+/// to the same radio, so each one comes back as RECEIVE_DATA after its time
+/// on the air and the link's latency, unless it is lost. Like the radio, it
+/// only buffers a few frames waiting to go on the air, and refuses more.
+/// A listener can take the frames instead, to stand in for a ground station.
+///
+/// Nothing here knows about real time. The caller passes in the time with
+/// every call, so the emulator can run from a test or from a process
+/// serving a pty alike.
+class lithium_emulator {
+    public:
+        /// The most TRANSMIT_DATA frames buffered before the radio refuses more
+        static const size_t TX_QUEUE_LENGTH = 8;
+        /// The bytes of AX.25 framing added to every frame on the air
+        static const size_t RF_OVERHEAD = 20;
+
+        explicit lithium_emulator(const rf_link_config & link = rf_link_config());
+
+        /// Take bytes the board sent. Replies are added to the output.
+        void receive(const uint8_t * bytes, size_t n, uint64_t now_ns);
+
+        /// Deliver every frame whose time has come
+        void advance(uint64_t now_ns);
+
+        /// When the next frame is delivered, or UINT64_MAX if none is waiting
+        uint64_t next_event_ns() const;
+
+        /// Take the bytes waiting to go to the board
+        std::vector<uint8_t> take_output();
+
+        /// Hand frames that make it over the air to a listener, like a ground
+        /// station, instead of looping them back to the radio
+        void listen(std::function<void(const std::vector<uint8_t> & payload, uint64_t now_ns)> listener);
+
+        /// Refuse every command of a kind from now on, or stop refusing
+        void refuse(lithium_command_t command, bool refused = true);
+
+        const lithium_config_t & config() const { return _config; }
+        const lithium_rf_config_t & rf_config() const { return _rf_config; }
+        const rf_link_config & link() const { return _link; }
+        const lithium_emulator_stats & stats() const { return _stats; }
+
+        /// The telemetry the radio would report now
+        lithium_telem_t telemetry(uint64_t now_ns) const;
+
+        /// The configuration a radio comes out of the factory with
+        static lithium_config_t default_config();
+
+    private:
+        struct rf_frame {
+            /// When the frame is off the air
+            uint64_t air_end_ns;
+            /// When the frame comes back to the radio
+            uint64_t deliver_ns;
+            /// True if the frame never comes back
+            bool lost;
+            std::vector<uint8_t> payload;
+        };
+
+        rf_link_config _link;
+        std::mt19937 _rng;
+        lithium_config_t _config;
+        lithium_config_t _flash_config;
+        lithium_rf_config_t _rf_config;
+        std::vector<uint8_t> _input;
+        std::vector<uint8_t> _output;
+        std::deque<rf_frame> _in_flight;
+        std::function<void(const std::vector<uint8_t> &, uint64_t)> _listener;
+        uint64_t _tx_free_ns;
+        uint16_t _op_counter;
+        uint32_t _bytes_received;
+        uint32_t _bytes_transmitted;
+        bool _refused[LITHIUM_COMMAND_count];
+        lithium_emulator_stats _stats;
+
+        /// Carry out one command
+        void handle(uint8_t command, const uint8_t * payload, uint16_t length, uint64_t now_ns);
+
+        /// Put a payload on the air. False if the transmit buffer is full.
+        bool transmit(const uint8_t * payload, uint16_t length, uint64_t now_ns);
+
+        /// Queue an O-Message for the board
+        void reply(uint8_t command, uint16_t length, const uint8_t * payload = nullptr);
+        void ack(uint8_t command);
+        void nack(uint8_t command);
+};
+
+#endif // _EMULATOR_LITHIUM_EMULATOR_HPP_
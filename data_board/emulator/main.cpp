@@ -0,0 +1,168 @@
+#include "lithium_emulator.hpp"
+#include "lithium_wire.h"
+#include "uart_fd.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+/******************************************************************************\
+ *  Private support functions                                                 *
+\******************************************************************************/
+namespace {
+    volatile sig_atomic_t stopping = 0;
+
+    void on_signal(int) {
+        stopping = 1;
+    }
+
+    void usage(const char * name) {
+        fprintf(stderr,
+            "usage: %s [--rf-baud BPS] [--loss P] [--latency-ms MS] [--seed N] [--stdio]\n"
+            "\n"
+            "Emulates a Lithium radio on a new pseudo-terminal, whose path is\n"
+            "printed on stdout, or on stdin and stdout with --stdio. Frames sent\n"
+            "with TRANSMIT_DATA come back as RECEIVE_DATA over an emulated link.\n",
+            name);
+    }
+
+    /// The bits per second of an interface baud rate setting, or of the
+    /// power up rate if it isn't one
+    size_t interface_bps(lithium_baud_t baud) {
+        uint32_t bps = lithium_baud_bps(baud);
+        return bps != 0 ? bps : lithium_baud_bps(LITHIUM_BAUD_9600);
+    }
+
+    uint64_t now_ns() {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// Print the emulator's counters when it stops
+    void report(const lithium_emulator & radio) {
+        const lithium_emulator_stats & s = radio.stats();
+        fprintf(stderr,
+            "frames %llu, dropped bytes %llu, acks %llu, nacks %llu, "
+            "rf sent %llu, lost %llu, delivered %llu\n",
+            (unsigned long long) s.frames, (unsigned long long) s.dropped_bytes,
+            (unsigned long long) s.acks, (unsigned long long) s.nacks,
+            (unsigned long long) s.rf_sent, (unsigned long long) s.rf_lost,
+            (unsigned long long) s.rf_delivered);
+    }
+}
+
+/******************************************************************************\
+ *  Entry point                                                               *
+\******************************************************************************/
+int main(int argc, char ** argv) {
+    rf_link_config link;
+    bool stdio = false;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--rf-baud") == 0 && has_value) {
+            link.baud = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--loss") == 0 && has_value) {
+            link.loss = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(argv[i], "--latency-ms") == 0 && has_value) {
+            link.latency_ns = strtoull(argv[++i], NULL, 10) * 1000000ull;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+            link.seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--stdio") == 0) {
+            stdio = true;
+        }
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (link.baud == 0 || link.loss < 0 || link.loss > 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int fd;
+    int held_slave = -1;
+    if (stdio) {
+        fd = dup(STDIN_FILENO);
+    }
+    else {
+        fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+            perror("posix_openpt");
+            return 1;
+        }
+        // Holding the slave open keeps the master readable until the board
+        // side connects, and between its connections
+        held_slave = open(ptsname(fd), O_RDWR | O_NOCTTY);
+        printf("%s\n", ptsname(fd));
+        fflush(stdout);
+    }
+
+    uart_fd_t port;
+    uart_fd_t out;
+    bool port_ok = uart_fd_open(&port, fd);
+    bool out_ok = uart_fd_open(&out, stdio ? dup(STDOUT_FILENO) : -1);
+    uart_fd_t * writer = stdio ? &out : &port;
+    if (!port_ok || (stdio && !out_ok)) {
+        fprintf(stderr, "can't use the serial descriptor\n");
+        uart_fd_close(&port);
+        uart_fd_close(&out);
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    lithium_emulator radio(link);
+    lithium_baud_t baud = radio.config().interface_baud_rate;
+    const uint64_t epoch = now_ns();
+    uint8_t chunk[512];
+    while (!stopping) {
+        // Sleep until bytes come in or the next frame comes back
+        uint64_t now = now_ns() - epoch;
+        uint64_t next = radio.next_event_ns();
+        int timeout_ms = next == UINT64_MAX ? 100 : (int) std::min<uint64_t>(100, (next > now ? next - now : 0) / 1000000 + 1);
+
+        long count = uart_fd_read(&port, chunk, sizeof(chunk), timeout_ms);
+        if (count < 0) {
+            break;
+        }
+        now = now_ns() - epoch;
+        if (count > 0) {
+            radio.receive(chunk, count, now);
+        }
+        else {
+            radio.advance(now);
+        }
+
+        std::vector<uint8_t> output = radio.take_output();
+        if (!output.empty() && (!uart_fd_write(writer, output.data(), output.size()) || !uart_fd_flush(writer))) {
+            break;
+        }
+
+        // The ACK went out at the old rate, so the new one starts after it
+        if (radio.config().interface_baud_rate != baud) {
+            baud = radio.config().interface_baud_rate;
+            uart_fd_set_baud(&port, interface_bps(baud));
+        }
+    }
+
+    report(radio);
+    uart_fd_close(&out);
+    uart_fd_close(&port);
+    if (held_slave >= 0) {
+        close(held_slave);
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "radio_task.h"
+
+#include "queue.h"
+#include "task.h"
+
+#define PERSISTENT __attribute__((section(".persistent")))
+
+/// Bytes are moved from the UART to the engine this many at a time
+#define RADIO_TASK_READ_CHUNK 16
+
+/******************************************************************************\
+ *  Static variables                                                          *
+\******************************************************************************/
+static radio_manager_t manager;
+
+static QueueHandle_t PERSISTENT request_queue_handle;
+static StaticQueue_t PERSISTENT request_queue;
+static uint8_t PERSISTENT request_queue_storage[RADIO_TASK_QUEUE_LENGTH * sizeof(radio_request_t)];
+
+static TaskHandle_t PERSISTENT radio_task_handle;
+static StaticTask_t PERSISTENT radio_task_buffer;
+static StackType_t PERSISTENT radio_task_stack[configMINIMAL_STACK_SIZE * 2];
+
+static void task_radio(void * params);
+static void radio_task_on_receive(uart_t * channel, void * context);
+static void radio_task_wait(uart_t * channel, void * context);
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+bool radio_task_start(lithium_t * radio, lithium_pool_t * pool, radio_receive_t on_receive, void * context, UBaseType_t priority) {
+    radio_manager_init(&manager, radio, pool, on_receive, context);
+
+    request_queue_handle = xQueueCreateStatic(
+        RADIO_TASK_QUEUE_LENGTH,
+        sizeof(radio_request_t),
+        request_queue_storage,
+        &request_queue);
+    if (request_queue_handle == NULL) {
+        return false;
+    }
+
+    radio_task_handle = xTaskCreateStatic(
+        task_radio,
+        "radio",
+        configMINIMAL_STACK_SIZE * 2,
+        NULL,
+        priority,
+        radio_task_stack,
+        &radio_task_buffer
+    );
+    if (radio_task_handle == NULL) {
+        return false;
+    }
+
+    uart_set_receive_callback(&radio->uart, radio_task_on_receive, NULL);
+    uart_set_async_waiter(&radio->uart, radio_task_wait, radio_task_on_receive, NULL);
+    return true;
+}
+
+bool radio_task_submit(const radio_request_t * request, TickType_t wait) {
+    return xQueueSend(request_queue_handle, request, wait) == pdPASS;
+}
+
+/******************************************************************************\
+ *  task_radio implementation                                                 *
+\******************************************************************************/
+static void task_radio(void * params) {
+    uint8_t chunk[RADIO_TASK_READ_CHUNK];
+    size_t length = 0;
+    size_t offset = 0;
+
+    for (;;) {
+        // Move requests over while the engine has room for them. A request
+        // that doesn't fit stays in the queue.
+        radio_request_t request;
+        while (manager.queued < RADIO_MANAGER_QUEUE_LENGTH &&
+                xQueueReceive(request_queue_handle, &request, 0) == pdPASS) {
+            if (!radio_manager_submit(&manager, &request)) {
+                // There was room, so the packet handle was bad. The
+                // submitter has already let go of it, so finish it here.
+                lithium_pool_release(manager.pool, request.packet);
+                if (request.on_complete) {
+                    request.on_complete(LITHIUM_INVALID_PACKET, LITHIUM_HANDLE_NONE, request.context);
+                }
+            }
+        }
+
+        // Decode everything received so far. If the pool runs dry the rest
+        // of the chunk waits for the next pass.
+        for (;;) {
+            if (offset == length) {
+                offset = 0;
+                if (uart_read_available(&manager.radio->uart, chunk, sizeof(chunk), &length) != UART_NO_ERROR) {
+                    length = 0;
+                }
+                if (length == 0) {
+                    break;
+                }
+            }
+            uint16_t consumed = radio_manager_feed(&manager, chunk + offset, length - offset);
+            offset += consumed;
+            if (offset < length) {
+                break;
+            }
+        }
+
+        radio_manager_tick(&manager, xTaskGetTickCount());
+
+        // Sleep until the next tick, or until the receive ring starts to
+        // fill, whichever comes first
+        ulTaskNotifyTake(pdTRUE, 1);
+    }
+}
+
+/**
+ * Wake the radio task, before the UART receive ring overflows or when an
+ * asynchronous write finishes. Runs in the UART interrupts.
+ */
+static void radio_task_on_receive(uart_t * channel, void * context) {
+    (void) channel;
+    (void) context;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(radio_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * Block the radio task in uart_wait_async until radio_task_on_receive wakes
+ * it, so other tasks run while the write finishes
+ */
+static void radio_task_wait(uart_t * channel, void * context) {
+    (void) channel;
+    (void) context;
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
@@ -0,0 +1,49 @@
+#ifndef _NATIVE_RADIO_TASK_H_
+#define _NATIVE_RADIO_TASK_H_
+
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+#include "radio_manager.h"
+
+/**
+ * The radio task owns the Lithium radio and runs its command engine. Other
+ * tasks hand it commands through a queue; their completion callbacks and the
+ * receive callback run on the radio task, so keep them short and hand work
+ * off with a queue or a task notification.
+ *
+ * The task drains the UART once a tick, and the UART receive interrupt wakes
+ * it early once the receive ring is UART_RX_WAKE_LEVEL bytes full, so the
+ * rest of the ring only has to cover the time the task takes to wake up.
+ */
+
+/// The number of commands other tasks can queue for the radio task
+#define RADIO_TASK_QUEUE_LENGTH 4
+
+/**
+ * Start the radio task
+ *
+ * @param radio The radio to manage. Nothing else may use it afterwards.
+ * @param pool The pool packets come from
+ * @param on_receive Called with data received over the air. May be NULL.
+ * @param context Passed to on_receive
+ * @param priority The priority of the task
+ *
+ * @return True if and only if the task started
+ */
+bool radio_task_start(lithium_t * radio, lithium_pool_t * pool, radio_receive_t on_receive, void * context, UBaseType_t priority);
+
+/**
+ * Queue a command for the radio task to send
+ *
+ * @param request The command. The task takes over the caller's reference to
+ *      its packet only if this succeeds. A command whose packet the manager
+ *      refuses completes with LITHIUM_INVALID_PACKET.
+ * @param wait How long to wait for room in the queue
+ *
+ * @return True if and only if the command was queued
+ */
+bool radio_task_submit(const radio_request_t * request, TickType_t wait);
+
+#endif // _NATIVE_RADIO_TASK_H_
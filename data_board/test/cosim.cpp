@@ -0,0 +1,133 @@
+#include "scenario_test.hpp"
+
+#include <catch/catch.hpp>
+
+#include <vector>
+
+namespace {
+    const uint64_t MS = SCENARIO_MS;
+}
+
+TEST_CASE("Sensor samples reach the ground through every board", "[data_board][cosim]") {
+    scenario s;
+    s.sim.run_until(5000 * MS);
+
+    // Every sample polled, in order, bar the ones still on their way
+    REQUIRE(s.arrivals.size() > 450);
+    for (size_t i = 0; i < s.arrivals.size(); ++i) {
+        REQUIRE(s.arrivals[i].sequence == i + 1);
+        REQUIRE(s.arrivals[i].value == s.sensor.samples[i + 1].second);
+    }
+    REQUIRE(s.data.bad_reads == 0);
+    REQUIRE(s.data.failed == 0);
+    REQUIRE(s.data.acked > 0);
+    REQUIRE(s.radio.write_errors == 0);
+    REQUIRE(s.malformed == 0);
+
+    // Batched for up to the downlink latency, then a frame of about ten
+    // records crosses the serial line and the air
+    REQUIRE(s.max_latency_ns() < 300 * MS);
+    REQUIRE(s.mean_latency_ns() > 100 * MS);
+    const lithium_emulator_stats & stats = s.radio.emulator.stats();
+    REQUIRE(stats.rf_delivered == stats.rf_sent);
+    REQUIRE(stats.dropped_bytes == 0);
+
+    // Five bytes a sample, a hundred samples a second
+    REQUIRE(s.ground_bytes * 1000 / 5000 >= 450);
+}
+
+TEST_CASE("Co-simulated runs repeat exactly", "[data_board][cosim]") {
+    scenario_config config;
+    config.uart_faults.flip = 0.001;
+    config.uart_faults.seed = 3;
+    config.rf.loss = 0.1;
+    scenario first(config);
+    scenario second(config);
+    first.sim.run_until(3000 * MS);
+    second.sim.run_until(3000 * MS);
+
+    REQUIRE(first.arrivals.size() == second.arrivals.size());
+    for (size_t i = 0; i < first.arrivals.size(); ++i) {
+        REQUIRE(first.arrivals[i].sequence == second.arrivals[i].sequence);
+        REQUIRE(first.arrivals[i].latency_ns == second.arrivals[i].latency_ns);
+    }
+    REQUIRE(first.radio.emulator.stats().rf_lost == second.radio.emulator.stats().rf_lost);
+}
+
+TEST_CASE("Link faults cost samples but never corrupt them", "[data_board][cosim]") {
+    scenario_config config;
+
+    SECTION("Bit errors on the serial line") {
+        config.uart_faults.flip = 0.002;
+        config.uart_faults.seed = 5;
+        scenario s(config);
+        s.sim.run_until(10000 * MS);
+
+        // Corrupt frames are dropped by whichever end receives them
+        REQUIRE(s.sim.wire_to_b(0).stats().corrupted > 0);
+        REQUIRE(s.radio.emulator.stats().dropped_bytes > 0);
+        REQUIRE(s.data.failed > 0);
+        REQUIRE(s.arrivals.size() > 500);
+        REQUIRE(s.arrivals.size() < s.sensor.samples.size());
+        for (const auto & a : s.arrivals) {
+            REQUIRE(a.value == s.sensor.samples[a.sequence].second);
+        }
+        REQUIRE(s.malformed == 0);
+    }
+
+    SECTION("Bit errors on the SPI bus") {
+        config.spi_faults.flip = 0.01;
+        config.spi_faults.seed = 6;
+        scenario s(config);
+        s.sim.run_until(5000 * MS);
+
+        REQUIRE(s.data.bad_reads > 0);
+        REQUIRE(s.sim.spi_stats(0).corrupted >= s.data.bad_reads);
+        for (const auto & a : s.arrivals) {
+            REQUIRE(a.value == s.sensor.samples[a.sequence].second);
+        }
+        REQUIRE(s.malformed == 0);
+    }
+
+    SECTION("Frames lost on the air") {
+        config.rf.loss = 0.2;
+        config.rf.seed = 7;
+        scenario s(config);
+        s.sim.run_until(5000 * MS);
+
+        const lithium_emulator_stats & stats = s.radio.emulator.stats();
+        REQUIRE(stats.rf_lost > 0);
+        REQUIRE(stats.rf_delivered + stats.rf_lost <= stats.rf_sent);
+        for (size_t i = 1; i < s.arrivals.size(); ++i) {
+            REQUIRE(s.arrivals[i].sequence > s.arrivals[i - 1].sequence);
+        }
+    }
+}
+
+TEST_CASE("Radio bytes wait for a packet when the pool runs dry", "[data_board][cosim]") {
+    scenario s;
+
+    // Until every packet is held, and the radio's next response has nowhere
+    // to be decoded
+    s.data.hold_responses = true;
+    while (s.data.stalls == 0) {
+        REQUIRE(s.sim.now_ns() < 10000 * MS);
+        s.sim.run_for(MS);
+    }
+    size_t acked = s.data.acked;
+    REQUIRE_FALSE(s.data.unfed.empty());
+
+    s.data.hold_responses = false;
+    for (lithium_handle_t response : s.data.held_responses) {
+        lithium_pool_release(&s.data.pool, response);
+    }
+    s.sim.run_for(1000 * MS);
+
+    // The response was decoded once a packet came free, and nothing was
+    // lost on the way
+    REQUIRE(s.data.unfed.empty());
+    REQUIRE(s.data.acked > acked);
+    REQUIRE(s.data.failed == 0);
+    REQUIRE(s.data.manager.stats.timeouts == 0);
+    REQUIRE(s.data.manager.stats.rejected == 0);
+}
@@ -0,0 +1,241 @@
+#include "downlink.h"
+#include "lithium_test.hpp"
+
+#include <catch/catch.hpp>
+
+#include <random>
+#include <vector>
+
+namespace {
+    typedef std::vector<uint8_t> record_t;
+
+    struct fixture {
+        lithium_pool_t pool;
+        downlink_t downlink;
+        std::vector<lithium_handle_t> sent;
+
+        fixture(uint32_t latency = 10) {
+            lithium_pool_init(&pool);
+            downlink_init(&downlink, &pool, latency, on_send, this);
+        }
+
+        static void on_send(lithium_handle_t packet, void * context) {
+            static_cast<fixture *>(context)->sent.push_back(packet);
+        }
+
+        bool add(const record_t & record, uint32_t now = 0) {
+            return downlink_add(&downlink, record.data(), record.size(), now);
+        }
+
+        /// The records in a sent payload, releasing it
+        std::vector<record_t> unpack(size_t i) {
+            lithium_packet_t * packet = lithium_pool_get(&pool, sent[i]);
+            std::vector<record_t> records = read(packet->payload, packet->payload_length);
+            lithium_pool_release(&pool, sent[i]);
+            return records;
+        }
+
+        static std::vector<record_t> read(const uint8_t * payload, uint16_t length) {
+            std::vector<record_t> records;
+            downlink_reader_t reader;
+            downlink_reader_init(&reader, payload, length);
+            const uint8_t * record;
+            uint8_t record_length;
+            while (downlink_reader_next(&reader, &record, &record_length)) {
+                records.emplace_back(record, record + record_length);
+            }
+            REQUIRE_FALSE(reader.malformed);
+            return records;
+        }
+    };
+}
+
+TEST_CASE("Downlink records are packed until the payload is full", "[data_board][downlink]") {
+    fixture f;
+
+    SECTION("A record that doesn't fit starts the next payload") {
+        record_t record(100, 0xAA);
+        REQUIRE(f.add(record));
+        REQUIRE(f.add(record));
+        REQUIRE(f.sent.empty());
+
+        // 2 * 101 + 101 > 255
+        REQUIRE(f.add(record_t(100, 0xBB)));
+        REQUIRE(f.sent.size() == 1);
+        REQUIRE(f.unpack(0) == std::vector<record_t>({ record, record }));
+
+        downlink_flush(&f.downlink);
+        REQUIRE(f.sent.size() == 2);
+        REQUIRE(f.unpack(1) == std::vector<record_t>({ record_t(100, 0xBB) }));
+    }
+
+    SECTION("A payload with no room left goes straight away") {
+        REQUIRE(f.add(record_t(200, 1)));
+        REQUIRE(f.sent.empty());
+        // 201 + 53 = 254, so a one byte record no longer fits
+        REQUIRE(f.add(record_t(52, 2)));
+        REQUIRE(f.sent.size() == 1);
+        REQUIRE(f.downlink.packet == LITHIUM_HANDLE_NONE);
+        REQUIRE(f.unpack(0) == std::vector<record_t>({ record_t(200, 1), record_t(52, 2) }));
+    }
+
+    SECTION("The largest record fills a payload by itself") {
+        REQUIRE(f.add(record_t(DOWNLINK_MAX_RECORD_LENGTH, 7)));
+        REQUIRE(f.sent.size() == 1);
+
+        lithium_packet_t * packet = lithium_pool_get(&f.pool, f.sent[0]);
+        REQUIRE(packet->type == LITHIUM_I_MESSAGE);
+        REQUIRE(packet->command == LITHIUM_COMMAND_TRANSMIT_DATA);
+        REQUIRE(packet->payload_length == 255);
+        REQUIRE(f.unpack(0).size() == 1);
+    }
+
+    SECTION("Empty and oversized records are refused") {
+        uint8_t byte = 0;
+        REQUIRE_FALSE(downlink_add(&f.downlink, &byte, 0, 0));
+        REQUIRE_FALSE(downlink_add(&f.downlink, record_t(255).data(), 255, 0));
+        REQUIRE(f.downlink.stats.dropped == 2);
+        REQUIRE(f.downlink.packet == LITHIUM_HANDLE_NONE);
+    }
+
+    REQUIRE(lithium_pool_stats(&f.pool).in_use <= 1);
+}
+
+TEST_CASE("Downlink payloads go out by their deadline", "[data_board][downlink]") {
+    fixture f(10);
+
+    SECTION("Measured from the first record") {
+        REQUIRE(f.add({ 1 }, 100));
+        REQUIRE(f.add({ 2 }, 105));
+        downlink_tick(&f.downlink, 109);
+        REQUIRE(f.sent.empty());
+
+        downlink_tick(&f.downlink, 110);
+        REQUIRE(f.sent.size() == 1);
+        REQUIRE(f.unpack(0) == std::vector<record_t>({ { 1 }, { 2 } }));
+
+        // Nothing to send
+        downlink_tick(&f.downlink, 200);
+        downlink_flush(&f.downlink);
+        REQUIRE(f.sent.size() == 1);
+    }
+
+    SECTION("Across the clock wrapping") {
+        REQUIRE(f.add({ 1 }, UINT32_MAX - 2));
+        downlink_tick(&f.downlink, 6);
+        REQUIRE(f.sent.empty());
+        downlink_tick(&f.downlink, 7);
+        REQUIRE(f.sent.size() == 1);
+    }
+
+    SECTION("A new payload gets a new deadline") {
+        REQUIRE(f.add(record_t(254), 0));
+        REQUIRE(f.sent.size() == 1);
+        REQUIRE(f.add({ 1 }, 8));
+        downlink_tick(&f.downlink, 10);
+        REQUIRE(f.sent.size() == 1);
+        downlink_tick(&f.downlink, 18);
+        REQUIRE(f.sent.size() == 2);
+    }
+}
+
+TEST_CASE("Downlink records are dropped when the pool is empty", "[data_board][downlink]") {
+    fixture f;
+    std::vector<lithium_handle_t> held;
+    lithium_handle_t handle;
+    while ((handle = lithium_pool_acquire(&f.pool)) != LITHIUM_HANDLE_NONE) {
+        held.push_back(handle);
+    }
+
+    REQUIRE_FALSE(f.add({ 1, 2, 3 }));
+    REQUIRE(f.downlink.stats.dropped == 1);
+
+    lithium_pool_release(&f.pool, held.back());
+    REQUIRE(f.add({ 1, 2, 3 }));
+}
+
+TEST_CASE("Downlink payloads unpack after a trip through the radio", "[data_board][downlink]") {
+    fixture f;
+    mock_radio radio;
+
+    // Random telemetry sized records
+    std::mt19937 rng(13);
+    std::uniform_int_distribution<int> lengths(1, 40);
+    std::vector<record_t> records;
+    size_t frames = 0;
+    for (int i = 0; i < 100; ++i) {
+        record_t record(lengths(rng));
+        for (auto & byte : record) {
+            byte = rng();
+        }
+        records.push_back(record);
+        REQUIRE(f.add(record));
+        if (i == 99) {
+            downlink_flush(&f.downlink);
+        }
+
+        // Send payloads as they fill so the pool never runs dry
+        for (lithium_handle_t packet : f.sent) {
+            REQUIRE(lithium_send_packet(&radio.radio, lithium_pool_get(&f.pool, packet)) == LITHIUM_NO_ERROR);
+            lithium_pool_release(&f.pool, packet);
+            ++frames;
+        }
+        f.sent.clear();
+    }
+
+    // Unpack each frame that went over the wire
+    std::vector<record_t> received;
+    for (const auto & packet : radio.sent()) {
+        std::vector<record_t> unpacked = fixture::read(packet.payload, packet.payload_length);
+        received.insert(received.end(), unpacked.begin(), unpacked.end());
+    }
+
+    REQUIRE(received == records);
+    // Most of each payload is used
+    REQUIRE(f.downlink.stats.frames == frames);
+    REQUIRE(f.downlink.stats.bytes / f.downlink.stats.frames > 230);
+}
+
+TEST_CASE("Malformed downlink payloads are detected", "[data_board][downlink]") {
+    downlink_reader_t reader;
+    const uint8_t * record;
+    uint8_t length;
+
+    SECTION("A record running off the end") {
+        uint8_t payload[] = { 2, 0xAA, 0xBB, 3, 0xCC };
+        downlink_reader_init(&reader, payload, sizeof(payload));
+        REQUIRE(downlink_reader_next(&reader, &record, &length));
+        REQUIRE(length == 2);
+        REQUIRE_FALSE(downlink_reader_next(&reader, &record, &length));
+        REQUIRE(reader.malformed);
+    }
+
+    SECTION("An empty record") {
+        uint8_t payload[] = { 0, 1 };
+        downlink_reader_init(&reader, payload, sizeof(payload));
+        REQUIRE_FALSE(downlink_reader_next(&reader, &record, &length));
+        REQUIRE(reader.malformed);
+    }
+
+    SECTION("An empty payload") {
+        downlink_reader_init(&reader, NULL, 0);
+        REQUIRE_FALSE(downlink_reader_next(&reader, &record, &length));
+        REQUIRE_FALSE(reader.malformed);
+    }
+}
+
+TEST_CASE("Downlink payloads can be limited to leave room for compression", "[data_board][downlink]") {
+    fixture f;
+    downlink_set_capacity(&f.downlink, LZSS_MAX_INPUT);
+
+    REQUIRE_FALSE(f.add(record_t(LZSS_MAX_INPUT)));
+    REQUIRE(f.add(record_t(LZSS_MAX_INPUT - 1)));
+    REQUIRE(f.sent.size() == 1);
+
+    lithium_packet_t * packet = lithium_pool_get(&f.pool, f.sent[0]);
+    REQUIRE(packet->payload_length == LZSS_MAX_INPUT);
+
+    lzss_t lzss;
+    uint8_t frame[LZSS_MAX_INPUT + 1];
+    REQUIRE(lzss_encode(&lzss, packet->payload, packet->payload_length, frame) > 0);
+}
@@ -0,0 +1,152 @@
+#include "firmware_update.h"
+#include "lithium_test.hpp"
+
+#include <catch/catch.hpp>
+
+#include <random>
+#include <vector>
+
+namespace {
+    struct fixture : mock_radio {
+        std::vector<uint8_t> image;
+        /// The offset and length of every read of the image
+        std::vector<std::pair<uint32_t, uint16_t>> reads;
+        bool storage_fails = false;
+        firmware_update_t update;
+
+        fixture(size_t length) : image(length) {
+            std::mt19937 rng(16);
+            for (auto & byte : image) {
+                byte = rng();
+            }
+
+            REQUIRE(firmware_update_init(&update, image.size(), read, this));
+        }
+
+        static bool read(uint32_t offset, uint8_t * buffer, uint16_t length, void * context) {
+            fixture * f = static_cast<fixture *>(context);
+            if (f->storage_fails || offset + length > f->image.size()) {
+                return false;
+            }
+            f->reads.emplace_back(offset, length);
+            std::copy(f->image.begin() + offset, f->image.begin() + offset + length, buffer);
+            return true;
+        }
+
+        /// Queue the radio's replies, in order
+        void replies(std::initializer_list<std::pair<lithium_command_t, uint16_t>> list) {
+            for (const auto & r : list) {
+                reply(lithium_o_message(r.first, r.second));
+            }
+        }
+
+        /// The image reassembled from the chunks the radio was sent
+        std::vector<uint8_t> streamed() {
+            std::vector<uint8_t> bytes;
+            for (const auto & packet : sent()) {
+                if (packet.command == LITHIUM_COMMAND_FIRMWARE_PACKET) {
+                    bytes.insert(bytes.end(), packet.payload, packet.payload + packet.payload_length);
+                }
+            }
+            return bytes;
+        }
+    };
+
+    const auto BEGIN = LITHIUM_COMMAND_FIRMWARE_UPDATE;
+    const auto CHUNK = LITHIUM_COMMAND_FIRMWARE_PACKET;
+}
+
+TEST_CASE("Firmware images are hashed then streamed in full chunks", "[data_board][firmware_update]") {
+    // Two full chunks and a partial one
+    fixture f(2 * FIRMWARE_CHUNK_LENGTH + 100);
+    f.replies({ { BEGIN, ACK_LENGTH }, { CHUNK, ACK_LENGTH }, { CHUNK, ACK_LENGTH }, { CHUNK, ACK_LENGTH } });
+
+    REQUIRE(firmware_update_run(&f.update, &f.radio, 3) == LITHIUM_NO_ERROR);
+    REQUIRE(firmware_update_done(&f.update));
+    REQUIRE(f.update.stats.chunks == 3);
+    REQUIRE(f.update.stats.retries == 0);
+
+    std::vector<lithium_packet_t> sent = f.sent();
+    REQUIRE(sent.size() == 4);
+    REQUIRE(sent[0].command == BEGIN);
+    REQUIRE(sent[0].payload_length == MD5_DIGEST_LENGTH);
+
+    md5_ctx_t md5;
+    md5_init(&md5);
+    md5_update(&md5, f.image.data(), f.image.size());
+    uint8_t digest[MD5_DIGEST_LENGTH];
+    md5_final(&md5, digest);
+    REQUIRE(std::vector<uint8_t>(sent[0].payload, sent[0].payload + 16) == std::vector<uint8_t>(digest, digest + 16));
+
+    REQUIRE(sent[1].payload_length == FIRMWARE_CHUNK_LENGTH);
+    REQUIRE(sent[2].payload_length == FIRMWARE_CHUNK_LENGTH);
+    REQUIRE(sent[3].payload_length == 100);
+    REQUIRE(f.streamed() == f.image);
+
+    // Nothing left to do
+    REQUIRE(firmware_update_step(&f.update, &f.radio) == LITHIUM_NO_ERROR);
+    REQUIRE(f.sent().size() == 4);
+}
+
+TEST_CASE("Firmware updates resume from the last acknowledged chunk", "[data_board][firmware_update]") {
+    fixture f(3 * FIRMWARE_CHUNK_LENGTH);
+
+    SECTION("After a NACK") {
+        f.replies({ { BEGIN, ACK_LENGTH }, { CHUNK, ACK_LENGTH }, { CHUNK, NACK_LENGTH }, { CHUNK, ACK_LENGTH }, { CHUNK, ACK_LENGTH } });
+        REQUIRE(firmware_update_run(&f.update, &f.radio, 3) == LITHIUM_NO_ERROR);
+        REQUIRE(f.update.stats.retries == 1);
+
+        // The second chunk went twice, and the first never went again
+        std::vector<lithium_packet_t> sent = f.sent();
+        REQUIRE(sent.size() == 5);
+        REQUIRE(std::equal(sent[2].payload, sent[2].payload + FIRMWARE_CHUNK_LENGTH, sent[3].payload));
+        REQUIRE(f.reads.back() == std::make_pair((uint32_t) 2 * FIRMWARE_CHUNK_LENGTH, (uint16_t) FIRMWARE_CHUNK_LENGTH));
+    }
+
+    SECTION("After the radio stops replying") {
+        f.replies({ { BEGIN, ACK_LENGTH }, { CHUNK, ACK_LENGTH } });
+        uint64_t start = f.radio.uart._impl->now_ns;
+        REQUIRE(firmware_update_run(&f.update, &f.radio, 2) == LITHIUM_TIMEOUT);
+        // Each unanswered attempt waited out the reply timeout, and no more
+        REQUIRE(f.radio.uart._impl->now_ns - start >= 2 * LITHIUM_REPLY_TIMEOUT_MS * 1000000ull);
+        REQUIRE(f.radio.uart._impl->now_ns - start < 3 * LITHIUM_REPLY_TIMEOUT_MS * 1000000ull);
+        REQUIRE_FALSE(firmware_update_done(&f.update));
+        REQUIRE(f.update.acknowledged == FIRMWARE_CHUNK_LENGTH);
+
+        // The link comes back. The hash isn't sent again.
+        f.replies({ { CHUNK, ACK_LENGTH }, { CHUNK, ACK_LENGTH } });
+        REQUIRE(firmware_update_run(&f.update, &f.radio, 2) == LITHIUM_NO_ERROR);
+
+        std::vector<lithium_packet_t> sent = f.sent();
+        size_t begins = 0;
+        for (const auto & packet : sent) {
+            begins += packet.command == BEGIN;
+        }
+        REQUIRE(begins == 1);
+        // One chunk, two unanswered attempts, then the last two
+        REQUIRE(sent.size() == 1 + 1 + 2 + 2);
+    }
+
+    SECTION("When the radio refuses the hash") {
+        f.replies({ { BEGIN, NACK_LENGTH }, { BEGIN, NACK_LENGTH } });
+        REQUIRE(firmware_update_run(&f.update, &f.radio, 2) == LITHIUM_NACK);
+        REQUIRE_FALSE(f.update.begun);
+        REQUIRE(f.streamed().empty());
+    }
+
+    SECTION("When storage can't be read") {
+        f.replies({ { BEGIN, ACK_LENGTH } });
+        f.storage_fails = true;
+        REQUIRE(firmware_update_run(&f.update, &f.radio, 2) == LITHIUM_BAD_COMMUNICATION);
+        REQUIRE(f.update.begun);
+        REQUIRE(f.update.acknowledged == 0);
+        REQUIRE(f.sent().size() == 1);
+    }
+}
+
+TEST_CASE("Firmware images that can't be read aren't started", "[data_board][firmware_update]") {
+    fixture f(10);
+    firmware_update_t update;
+    f.storage_fails = true;
+    REQUIRE_FALSE(firmware_update_init(&update, f.image.size(), fixture::read, &f));
+}
@@ -0,0 +1,98 @@
+#include "fletcher.h"
+
+#include <catch/catch.hpp>
+
+#include <random>
+#include <vector>
+
+namespace {
+    /// The original byte at a time checksum from lithium.c
+    void reference_checksum(const uint8_t * data, size_t length, uint8_t * output) {
+        uint8_t a = 0;
+        uint8_t b = 0;
+        for (size_t i = 0; i < length; ++i) {
+            a += data[i];
+            b += a;
+        }
+        output[0] = a;
+        output[1] = b;
+    }
+
+    std::vector<uint8_t> random_bytes(size_t length, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::vector<uint8_t> bytes(length);
+        for (auto & byte : bytes) {
+            byte = rng();
+        }
+        return bytes;
+    }
+}
+
+TEST_CASE("Fletcher checksums match the byte at a time implementation", "[data_board][fletcher]") {
+    // Long enough for the sums to wrap many times over
+    std::vector<uint8_t> data = random_bytes(8 + 255 + 2, 1);
+    data.insert(data.end(), 64, 0xFF);
+
+    for (size_t length = 0; length <= data.size(); ++length) {
+        INFO("length " << length);
+        uint8_t expected[2];
+        reference_checksum(data.data(), length, expected);
+
+        fletcher_ctx_t ctx;
+        fletcher_init(&ctx);
+        fletcher_update(&ctx, data.data(), length);
+        uint8_t actual[2];
+        fletcher_final(&ctx, actual);
+
+        REQUIRE(actual[0] == expected[0]);
+        REQUIRE(actual[1] == expected[1]);
+    }
+}
+
+TEST_CASE("Fletcher checksums can be built up in pieces", "[data_board][fletcher]") {
+    std::vector<uint8_t> data = random_bytes(40, 2);
+    uint8_t expected[2];
+    reference_checksum(data.data(), data.size(), expected);
+
+    SECTION("Split anywhere") {
+        for (size_t split = 0; split <= data.size(); ++split) {
+            INFO("split " << split);
+            fletcher_ctx_t ctx;
+            fletcher_init(&ctx);
+            fletcher_update(&ctx, data.data(), split);
+            fletcher_update(&ctx, data.data() + split, data.size() - split);
+
+            uint8_t actual[2];
+            fletcher_final(&ctx, actual);
+            REQUIRE(actual[0] == expected[0]);
+            REQUIRE(actual[1] == expected[1]);
+        }
+    }
+
+    SECTION("A byte at a time") {
+        fletcher_ctx_t ctx;
+        fletcher_init(&ctx);
+        for (uint8_t byte : data) {
+            fletcher_update(&ctx, &byte, 1);
+        }
+
+        uint8_t actual[2];
+        fletcher_final(&ctx, actual);
+        REQUIRE(actual[0] == expected[0]);
+        REQUIRE(actual[1] == expected[1]);
+    }
+
+    SECTION("Resumed from a finished checksum") {
+        uint8_t partial[2];
+        reference_checksum(data.data(), 6, partial);
+
+        fletcher_ctx_t ctx;
+        fletcher_resume(&ctx, partial);
+        fletcher_update(&ctx, data.data() + 6, data.size() - 6);
+
+        uint8_t actual[2];
+        fletcher_final(&ctx, actual);
+        REQUIRE(actual[0] == expected[0]);
+        REQUIRE(actual[1] == expected[1]);
+    }
+}
@@ -0,0 +1,50 @@
+#include "lithium_test.hpp"
+#include "lithium_wire.h"
+#include "uart.h"
+
+#include <catch/catch.hpp>
+
+/******************************************************************************\
+ *  mock_radio implementation                                                 *
+\******************************************************************************/
+mock_radio::mock_radio() {
+    uart_t uart;
+    uart_open(&uart, 9600);
+    lithium_open(&radio, &uart);
+}
+
+mock_radio::~mock_radio() {
+    lithium_close(&radio);
+}
+
+void mock_radio::reply(const std::vector<uint8_t> & bytes) {
+    radio.uart._impl->push_bytes(bytes.begin(), bytes.end());
+}
+
+std::vector<uint8_t> & mock_radio::written() {
+    return radio.uart._impl->output;
+}
+
+std::vector<lithium_packet_t> mock_radio::sent() {
+    std::vector<uint8_t> & wire = written();
+    std::vector<lithium_packet_t> packets;
+    size_t offset = 0;
+    while (offset < wire.size()) {
+        lithium_packet_t packet;
+        uint16_t remaining;
+        REQUIRE(lithium_parse_header(wire.data() + offset, wire.size() - offset, &packet, &remaining) == LITHIUM_NO_ERROR);
+        REQUIRE(lithium_parse_body(wire.data() + offset, wire.size() - offset, &packet) == LITHIUM_NO_ERROR);
+        offset += HEADER_LENGTH + remaining;
+        packets.push_back(packet);
+    }
+    return packets;
+}
+
+/******************************************************************************\
+ *  Frame encoding                                                            *
+\******************************************************************************/
+std::vector<uint8_t> lithium_o_message(lithium_command_t command, uint16_t length, const std::vector<uint8_t> & payload) {
+    std::vector<uint8_t> frame(LITHIUM_MAX_FRAME_LENGTH);
+    frame.resize(lithium_encode_frame(LITHIUM_O_MESSAGE, command, length, payload.empty() ? nullptr : payload.data(), frame.data()));
+    return frame;
+}
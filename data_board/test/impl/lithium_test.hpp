@@ -0,0 +1,34 @@
+#ifndef _TEST_LITHIUM_HPP_
+#define _TEST_LITHIUM_HPP_
+
+#include "lithium.h"
+#include "lithium_internal.h"
+
+#include <vector>
+
+/// The flight code's Lithium driver on a mock UART channel. Test fixtures
+/// that talk to a radio derive from this.
+struct mock_radio {
+    lithium_t radio;
+
+    mock_radio();
+    ~mock_radio();
+
+    mock_radio(const mock_radio &) = delete;
+    mock_radio & operator=(const mock_radio &) = delete;
+
+    /// Queue bytes from the radio for the driver to read
+    void reply(const std::vector<uint8_t> & bytes);
+
+    /// Everything the driver has sent the radio so far
+    std::vector<uint8_t> & written();
+
+    /// Every frame the driver has sent the radio so far, parsed
+    std::vector<lithium_packet_t> sent();
+};
+
+/// Encode an O-Message as the radio would send it. If the payload is empty
+/// only the header is sent, as for ACKs (ACK_LENGTH) and NACKs (NACK_LENGTH).
+std::vector<uint8_t> lithium_o_message(lithium_command_t command, uint16_t length, const std::vector<uint8_t> & payload = {});
+
+#endif // _TEST_LITHIUM_HPP_
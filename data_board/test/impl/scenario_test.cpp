@@ -0,0 +1,217 @@
+#include "scenario_test.hpp"
+
+#include <algorithm>
+
+namespace {
+    /// The sensor board's SPI command to read the latest sample
+    const uint8_t READ_SAMPLE = 0x52;
+    /// A sample as it crosses the bus: sequence number, value, check byte
+    const size_t SAMPLE_LENGTH = 5;
+    /// A sample as it is downlinked: sequence number and value
+    const uint8_t RECORD_LENGTH = 4;
+
+    uint8_t sample_check(const uint8_t * sample) {
+        return sample[0] ^ sample[1] ^ sample[2] ^ sample[3] ^ 0xA5;
+    }
+}
+
+/******************************************************************************\
+ *  sensor_board implementation                                               *
+\******************************************************************************/
+void sensor_board::step(uint64_t now_ns) {
+    while (next_sample_ns <= now_ns) {
+        ++sequence;
+        samples[sequence] = std::make_pair(next_sample_ns, (uint16_t) (1000 + sequence * 7));
+        next_sample_ns += period_ns;
+    }
+}
+
+uint8_t sensor_board::transfer(uint8_t mosi) {
+    if (replied < reply.size()) {
+        return reply[replied++];
+    }
+    if (mosi == READ_SAMPLE && !samples.empty()) {
+        uint16_t value = samples[sequence].second;
+        reply = { (uint8_t) (sequence >> 8), (uint8_t) sequence, (uint8_t) (value >> 8), (uint8_t) value, 0 };
+        reply[4] = sample_check(reply.data());
+        replied = 0;
+    }
+    return 0x00;
+}
+
+/******************************************************************************\
+ *  data_board implementation                                                 *
+\******************************************************************************/
+data_board::data_board(uint64_t poll_ns, uint32_t downlink_latency_ms) : poll_ns(poll_ns) {
+    spi_open(&spi);
+    uart_t uart;
+    uart_open(&uart, 9600);
+    lithium_open(&radio, &uart);
+    lithium_pool_init(&pool);
+    radio_manager_init(&manager, &radio, &pool, nullptr, nullptr);
+    downlink_init(&downlink, &pool, downlink_latency_ms, send, this);
+}
+
+data_board::~data_board() {
+    lithium_close(&radio);
+    spi_close(&spi);
+}
+
+void data_board::step(uint64_t now_ns) {
+    uint32_t now = now_ns / SCENARIO_MS;
+    receive();
+
+    if (now_ns >= next_poll_ns) {
+        poll(now);
+        next_poll_ns += poll_ns;
+    }
+    downlink_tick(&downlink, now);
+    radio_manager_tick(&manager, now);
+    next_tick_ns = (now + 1) * SCENARIO_MS;
+}
+
+uint64_t data_board::next_event_ns() const {
+    return std::min(next_poll_ns, next_tick_ns);
+}
+
+void data_board::receive() {
+    for (;;) {
+        if (unfed.empty()) {
+            uint8_t bytes[64];
+            size_t read;
+            if (uart_read_available(&radio.uart, bytes, sizeof(bytes), &read) != UART_NO_ERROR || read == 0) {
+                return;
+            }
+            unfed.assign(bytes, bytes + read);
+        }
+
+        uint16_t consumed = radio_manager_feed(&manager, unfed.data(), unfed.size());
+        unfed.erase(unfed.begin(), unfed.begin() + consumed);
+        if (!unfed.empty()) {
+            ++stalls;
+            return;
+        }
+    }
+}
+
+void data_board::poll(uint32_t now) {
+    uint8_t command[1 + SAMPLE_LENGTH] = { READ_SAMPLE };
+    uint8_t reply[1 + SAMPLE_LENGTH];
+    if (spi_transfer_bytes(&spi, command, reply, sizeof(command)) != SPI_NO_ERROR) {
+        ++bad_reads;
+        return;
+    }
+    const uint8_t * sample = reply + 1;
+    if (sample_check(sample) != sample[4]) {
+        ++bad_reads;
+        return;
+    }
+    uint16_t sequence = (sample[0] << 8) | sample[1];
+    if (sequence != last_sequence) {
+        last_sequence = sequence;
+        downlink_add(&downlink, sample, RECORD_LENGTH, now);
+    }
+}
+
+void data_board::send(lithium_handle_t packet, void * context) {
+    data_board * board = static_cast<data_board *>(context);
+    radio_request_t request = { packet, 1000, on_complete, board };
+    if (!radio_manager_submit(&board->manager, &request)) {
+        lithium_pool_release(&board->pool, packet);
+        ++board->failed;
+    }
+}
+
+void data_board::on_complete(lithium_result_t result, lithium_handle_t response, void * context) {
+    data_board * board = static_cast<data_board *>(context);
+    if (result == LITHIUM_NO_ERROR) {
+        ++board->acked;
+    }
+    else {
+        ++board->failed;
+    }
+    if (board->hold_responses && response != LITHIUM_HANDLE_NONE) {
+        lithium_pool_retain(&board->pool, response);
+        board->held_responses.push_back(response);
+    }
+}
+
+/******************************************************************************\
+ *  radio_board implementation                                                *
+\******************************************************************************/
+radio_board::radio_board(const rf_link_config & link) : emulator(link) {
+    uart_open(&uart, 9600);
+}
+
+radio_board::~radio_board() {
+    uart_close(&uart);
+}
+
+void radio_board::step(uint64_t now_ns) {
+    uint8_t bytes[64];
+    size_t read;
+    while (uart_read_available(&uart, bytes, sizeof(bytes), &read) == UART_NO_ERROR && read > 0) {
+        emulator.receive(bytes, read, now_ns);
+    }
+    emulator.advance(now_ns);
+    std::vector<uint8_t> output = emulator.take_output();
+    if (uart_write_bytes(&uart, output.data(), output.size()) != UART_NO_ERROR) {
+        ++write_errors;
+    }
+}
+
+/******************************************************************************\
+ *  scenario implementation                                                   *
+\******************************************************************************/
+scenario::scenario(const scenario_config & config) :
+    sensor(config.sample_ns), data(config.poll_ns, config.downlink_latency_ms), radio(config.rf) {
+    sim.add(&sensor);
+    sim.add(&data);
+    sim.add(&radio);
+    sim.connect(&data.radio.uart, &radio.uart, config.uart_baud, config.uart_faults);
+    sim.connect(&data.spi, [this](uint8_t mosi) { return sensor.transfer(mosi); }, 1000000, config.spi_faults);
+    radio.emulator.listen([this](const std::vector<uint8_t> & payload, uint64_t now_ns) {
+        ground(payload, now_ns);
+    });
+}
+
+void scenario::ground(const std::vector<uint8_t> & payload, uint64_t now_ns) {
+    ground_bytes += payload.size();
+    downlink_reader_t reader;
+    downlink_reader_init(&reader, payload.data(), payload.size());
+    const uint8_t * record;
+    uint8_t length;
+    while (downlink_reader_next(&reader, &record, &length)) {
+        if (length != RECORD_LENGTH) {
+            ++malformed;
+            continue;
+        }
+        uint16_t sequence = (record[0] << 8) | record[1];
+        if (sensor.samples.count(sequence) != 1) {
+            ++malformed;
+            continue;
+        }
+        arrivals.push_back({
+            sequence, (uint16_t) ((record[2] << 8) | record[3]), now_ns - sensor.samples[sequence].first,
+        });
+    }
+    if (reader.malformed) {
+        ++malformed;
+    }
+}
+
+uint64_t scenario::max_latency_ns() const {
+    uint64_t latency = 0;
+    for (const auto & a : arrivals) {
+        latency = std::max(latency, a.latency_ns);
+    }
+    return latency;
+}
+
+double scenario::mean_latency_ns() const {
+    double total = 0;
+    for (const auto & a : arrivals) {
+        total += a.latency_ns;
+    }
+    return arrivals.empty() ? 0 : total / arrivals.size();
+}
@@ -0,0 +1,142 @@
+#ifndef _TEST_SCENARIO_HPP_
+#define _TEST_SCENARIO_HPP_
+
+#include "cosim.hpp"
+#include "downlink.h"
+#include "lithium_emulator.hpp"
+#include "radio_manager.h"
+
+#include <map>
+#include <vector>
+
+/// A millisecond of virtual time
+const uint64_t SCENARIO_MS = 1000000;
+
+/// The sensor board, which has no firmware of its own yet: it takes a sample
+/// every period and hands the latest to whoever reads it over SPI
+struct sensor_board : cosim_board {
+    uint64_t period_ns;
+    uint64_t next_sample_ns = 0;
+    uint16_t sequence = 0;
+    /// When each sample was taken, and its value
+    std::map<uint16_t, std::pair<uint64_t, uint16_t>> samples;
+    std::vector<uint8_t> reply;
+    size_t replied = 0;
+
+    explicit sensor_board(uint64_t period_ns) : period_ns(period_ns) {}
+
+    void step(uint64_t now_ns) override;
+
+    uint64_t next_event_ns() const override { return next_sample_ns; }
+
+    /// One byte of an SPI transfer
+    uint8_t transfer(uint8_t mosi);
+};
+
+/// The data board: polls the sensor, packs samples in to downlink payloads
+/// and sends them through the radio manager
+struct data_board : cosim_board {
+    uint64_t poll_ns;
+    uint64_t next_poll_ns = 0;
+    uint64_t next_tick_ns = 0;
+    spi_t spi;
+    lithium_t radio;
+    lithium_pool_t pool;
+    radio_manager_t manager;
+    downlink_t downlink;
+    uint16_t last_sequence = 0;
+    /// Reads that failed or failed their check
+    size_t bad_reads = 0;
+    /// Payloads the radio acknowledged, refused or never answered
+    size_t acked = 0;
+    size_t failed = 0;
+    /// Bytes from the radio the manager had no packet for, fed again before
+    /// anything newer is read
+    std::vector<uint8_t> unfed;
+    /// Steps that ended with bytes left unfed
+    size_t stalls = 0;
+    /// Responses held on to, as a slow consumer would, while hold_responses
+    /// is set
+    bool hold_responses = false;
+    std::vector<lithium_handle_t> held_responses;
+
+    data_board(uint64_t poll_ns, uint32_t downlink_latency_ms);
+    ~data_board();
+
+    void step(uint64_t now_ns) override;
+
+    uint64_t next_event_ns() const override;
+
+    /// Feed the manager what the radio sent. If the pool runs dry the rest
+    /// stays unfed, and anything newer stays in the UART, until a packet is
+    /// released.
+    void receive();
+
+    /// Read the latest sample and queue it for the downlink if it's new
+    void poll(uint32_t now);
+
+    static void send(lithium_handle_t packet, void * context);
+
+    static void on_complete(lithium_result_t result, lithium_handle_t response, void * context);
+};
+
+/// The Lithium, on the other end of the data board's UART
+struct radio_board : cosim_board {
+    uart_t uart;
+    lithium_emulator emulator;
+    /// Replies the UART refused
+    size_t write_errors = 0;
+
+    explicit radio_board(const rf_link_config & link);
+    ~radio_board();
+
+    void step(uint64_t now_ns) override;
+
+    uint64_t next_event_ns() const override { return emulator.next_event_ns(); }
+};
+
+struct scenario_config {
+    uint64_t sample_ns = 10 * SCENARIO_MS;
+    uint64_t poll_ns = 10 * SCENARIO_MS;
+    uint32_t downlink_latency_ms = 100;
+    size_t uart_baud = 9600;
+    link_faults uart_faults;
+    link_faults spi_faults;
+    rf_link_config rf;
+};
+
+/// A sample as it reached the ground
+struct arrival {
+    uint16_t sequence;
+    uint16_t value;
+    /// From the sample being taken to its frame arriving
+    uint64_t latency_ns;
+};
+
+/// The sensor, data and radio boards wired together, with a ground station
+/// listening to the radio. Shared by the co-simulation tests and benchmarks.
+struct scenario {
+    sensor_board sensor;
+    data_board data;
+    radio_board radio;
+    cosim sim;
+    std::vector<arrival> arrivals;
+    uint64_t ground_bytes = 0;
+    /// Payloads that reached the ground malformed, or with records that
+    /// aren't samples the sensor took
+    size_t malformed = 0;
+
+    explicit scenario(const scenario_config & config = scenario_config());
+
+    scenario(const scenario &) = delete;
+    scenario & operator=(const scenario &) = delete;
+
+    /// Unpack a payload the ground station heard
+    void ground(const std::vector<uint8_t> & payload, uint64_t now_ns);
+
+    uint64_t max_latency_ns() const;
+
+    double mean_latency_ns() const;
+};
+
+#endif // _TEST_SCENARIO_HPP_
@@ -0,0 +1,34 @@
+#include "telemetry_test.hpp"
+
+#include <random>
+
+std::vector<uint8_t> telemetry_records(size_t length, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> drift(-2, 2);
+    uint32_t time = 86400;
+    int16_t temperature[4] = { 250, 243, 301, -120 };
+    uint16_t voltage[3] = { 3300, 5010, 7820 };
+    uint8_t flags = 0x81;
+
+    std::vector<uint8_t> bytes;
+    while (bytes.size() + 21 <= length) {
+        bytes.push_back(20);
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            bytes.push_back(time >> shift);
+        }
+        for (auto & t : temperature) {
+            t += drift(rng);
+            bytes.push_back(t >> 8);
+            bytes.push_back(t);
+        }
+        for (auto & v : voltage) {
+            v += drift(rng);
+            bytes.push_back(v >> 8);
+            bytes.push_back(v);
+        }
+        bytes.push_back(flags);
+        bytes.push_back(0);
+        time += 10;
+    }
+    return bytes;
+}
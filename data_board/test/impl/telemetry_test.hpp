@@ -0,0 +1,14 @@
+#ifndef _TEST_TELEMETRY_HPP_
+#define _TEST_TELEMETRY_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+/// Downlink records shaped like housekeeping telemetry: a length byte, a
+/// big-endian timestamp, then slowly drifting sensor readings and flags.
+/// As many whole records as fit in length, the same for the same seed.
+std::vector<uint8_t> telemetry_records(size_t length, unsigned seed);
+
+#endif // _TEST_TELEMETRY_HPP_
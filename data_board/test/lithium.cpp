@@ -1,13 +1,18 @@
 #include "uart.h"
 #include "lithium.h"
+#include "lithium_wire.h"
+#include "lithium_test.hpp"
 
 #include <catch/catch.hpp>
 
+#include <sys/socket.h>
+#include <unistd.h>
+
 // Set the input of the mock UART
 #define SET_UART_INPUT(t, ...) \
     do { \
-        t.uart._impl->input = { __VA_ARGS__ }; \
-        std::reverse(t.uart._impl->input.begin(), t.uart._impl->input.end()); \
+        t.uart._impl->input.clear(); \
+        t.uart._impl->push_bytes({ __VA_ARGS__ }); \
     } while (0)
 
 // Check if a packet's payload has matching bytes
@@ -213,3 +218,303 @@ TEST_CASE("The radio interface can handle transmissions", "[data_board][lithium]
 
     lithium_close(&t);
 }
+
+TEST_CASE("The radio interface can renegotiate its baud rate", "[data_board][lithium]") {
+    lithium_t t;
+    uart_t uart;
+    uart_open(&uart, 9600);
+    lithium_open(&t, &uart);
+
+    lithium_config_t config = {};
+    config.interface_baud_rate = LITHIUM_BAUD_9600;
+
+    SECTION("Switches once the radio confirms") {
+        SET_UART_INPUT(t,
+            // ACK the configuration change
+            0x48, 0x65, 0x20, 0x06, 0x0a, 0x0a, 0x3a, 0xb0,
+            // ACK the no-op at the new rate
+            0x48, 0x65, 0x20, 0x01, 0x0a, 0x0a, 0x35, 0xa1,
+        );
+
+        REQUIRE(lithium_negotiate_baud(&t, &config, LITHIUM_BAUD_115200) == LITHIUM_NO_ERROR);
+        REQUIRE(config.interface_baud_rate == LITHIUM_BAUD_115200);
+        REQUIRE(t.uart._impl->baud_rate == 115200);
+
+        // The configuration went out at 9600 and the no-op at 115200
+        REQUIRE(t.uart._impl->baud_changes == std::vector<size_t>({ 115200 }));
+        size_t switched_at = t.uart._impl->baud_change_offsets[0];
+        REQUIRE(switched_at == 8 + 34 + 2);
+        REQUIRE(t.uart._impl->output.size() == switched_at + 8);
+        REQUIRE_THAT(t.uart, HasWrittenBytes({
+            0x48, 0x65, 0x10, 0x01, 0x00, 0x00, 0x11, 0x43,
+        }));
+    }
+
+    SECTION("Keeps the old rate if the radio refuses") {
+        SET_UART_INPUT(t,
+            0x48, 0x65, 0x20, 0x06, 0xff, 0xff, 0x24, 0x8f,
+        );
+
+        REQUIRE(lithium_negotiate_baud(&t, &config, LITHIUM_BAUD_38400) == LITHIUM_NACK);
+        REQUIRE(config.interface_baud_rate == LITHIUM_BAUD_9600);
+        REQUIRE(t.uart._impl->baud_changes.empty());
+        REQUIRE(t.uart._impl->baud_rate == 9600);
+    }
+
+    SECTION("Falls back to 9600 if the confirmation fails") {
+        SET_UART_INPUT(t,
+            0x48, 0x65, 0x20, 0x06, 0x0a, 0x0a, 0x3a, 0xb0,
+            // Garbage at the new rate
+            0x00, 0x13, 0x37, 0x00, 0x00, 0x00, 0x00, 0x00,
+        );
+
+        REQUIRE(lithium_negotiate_baud(&t, &config, LITHIUM_BAUD_76800) == LITHIUM_BAD_COMMUNICATION);
+        REQUIRE(config.interface_baud_rate == LITHIUM_BAUD_9600);
+        REQUIRE(t.uart._impl->baud_changes == std::vector<size_t>({ 76800, 9600 }));
+        REQUIRE(t.uart._impl->baud_rate == 9600);
+
+        // The radio is told to go back at the rate it is on, before the
+        // local UART follows it
+        const std::vector<uint8_t> & output = t.uart._impl->output;
+        size_t revert = t.uart._impl->baud_change_offsets[0] + HEADER_LENGTH;
+        REQUIRE(t.uart._impl->baud_change_offsets[1] == output.size());
+        REQUIRE(output.size() == revert + HEADER_LENGTH + LITHIUM_CONFIG_WIRE_LENGTH + CHECKSUM_LENGTH);
+        REQUIRE(output[revert + 2] == LITHIUM_I_MESSAGE);
+        REQUIRE(output[revert + 3] == LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG);
+        REQUIRE(output[revert + HEADER_LENGTH] == LITHIUM_BAUD_9600);
+    }
+
+    SECTION("Falls back to the rate it was on, not the radio's default") {
+        config.interface_baud_rate = LITHIUM_BAUD_19200;
+        REQUIRE(uart_set_baud_rate(&t.uart, BAUD_19200) == UART_NO_ERROR);
+        SET_UART_INPUT(t,
+            0x48, 0x65, 0x20, 0x06, 0x0a, 0x0a, 0x3a, 0xb0,
+        );
+
+        REQUIRE(lithium_negotiate_baud(&t, &config, LITHIUM_BAUD_115200) == LITHIUM_BAD_COMMUNICATION);
+        REQUIRE(config.interface_baud_rate == LITHIUM_BAUD_19200);
+        REQUIRE(t.uart._impl->baud_changes == std::vector<size_t>({ 19200, 115200, 19200 }));
+
+        const std::vector<uint8_t> & output = t.uart._impl->output;
+        size_t revert = output.size() - (LITHIUM_CONFIG_WIRE_LENGTH + CHECKSUM_LENGTH);
+        REQUIRE(output[revert - HEADER_LENGTH + 3] == LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG);
+        REQUIRE(output[revert] == LITHIUM_BAUD_19200);
+    }
+
+    SECTION("Falls back to 9600 if the radio goes quiet") {
+        SET_UART_INPUT(t,
+            0x48, 0x65, 0x20, 0x06, 0x0a, 0x0a, 0x3a, 0xb0,
+        );
+
+        REQUIRE(lithium_negotiate_baud(&t, &config, LITHIUM_BAUD_19200) == LITHIUM_BAD_COMMUNICATION);
+        REQUIRE(t.uart._impl->baud_rate == 9600);
+    }
+
+    SECTION("Rejects a reply to the wrong command") {
+        SET_UART_INPUT(t,
+            0x48, 0x65, 0x20, 0x01, 0x0a, 0x0a, 0x35, 0xa1,
+        );
+
+        REQUIRE(lithium_negotiate_baud(&t, &config, LITHIUM_BAUD_19200) == LITHIUM_INVALID_PACKET);
+        REQUIRE(t.uart._impl->baud_changes.empty());
+    }
+
+    lithium_close(&t);
+}
+
+TEST_CASE("The radio decoder recovers from corrupt bytes", "[data_board][lithium]") {
+    const std::vector<uint8_t> transmit = {
+        0x48, 0x65, 0x10, 0x03, 0x00, 0x0a, 0x1d, 0x53,
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+        0xba, 0x41,
+    };
+    const std::vector<uint8_t> ack = {
+        0x48, 0x65, 0x20, 0x03, 0x0a, 0x0a, 0x37, 0xa7,
+    };
+
+    lithium_decoder_t decoder;
+    lithium_decoder_init(&decoder);
+
+    // Feed a stream in chunks and collect every result but LITHIUM_INCOMPLETE
+    auto feed = [&decoder](const std::vector<uint8_t> & stream, size_t chunk) {
+        std::vector<lithium_result_t> results;
+        lithium_packet_t packet;
+        for (size_t offset = 0; offset < stream.size(); offset += chunk) {
+            const uint8_t * data = stream.data() + offset;
+            uint16_t length = std::min(chunk, stream.size() - offset);
+            uint16_t consumed;
+            lithium_result_t result;
+            do {
+                result = lithium_decoder_feed(&decoder, data, length, &consumed, &packet);
+                if (result != LITHIUM_INCOMPLETE) {
+                    results.push_back(result);
+                }
+                data += consumed;
+                length -= consumed;
+            } while (result != LITHIUM_INCOMPLETE);
+        }
+        return results;
+    };
+
+    using results_t = std::vector<lithium_result_t>;
+
+    SECTION("Decodes a frame a byte at a time") {
+        lithium_packet_t packet;
+        uint16_t consumed;
+        for (size_t i = 0; i < transmit.size() - 1; ++i) {
+            REQUIRE(lithium_decoder_feed(&decoder, &transmit[i], 1, &consumed, &packet) == LITHIUM_INCOMPLETE);
+            REQUIRE(consumed == 1);
+        }
+        REQUIRE(lithium_decoder_feed(&decoder, &transmit.back(), 1, &consumed, &packet) == LITHIUM_NO_ERROR);
+        REQUIRE(packet.command == LITHIUM_COMMAND_TRANSMIT_DATA);
+        REQUIRE_PAYLOAD_HAS_BYTES(packet,
+            0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+        );
+        REQUIRE(decoder.dropped_bytes == 0);
+    }
+
+    SECTION("Stops at the end of each frame") {
+        std::vector<uint8_t> stream = transmit;
+        stream.insert(stream.end(), ack.begin(), ack.end());
+
+        lithium_packet_t packet;
+        uint16_t consumed;
+        REQUIRE(lithium_decoder_feed(&decoder, stream.data(), stream.size(), &consumed, &packet) == LITHIUM_NO_ERROR);
+        REQUIRE(consumed == transmit.size());
+        REQUIRE(packet.command == LITHIUM_COMMAND_TRANSMIT_DATA);
+
+        REQUIRE(lithium_decoder_feed(&decoder, stream.data() + consumed, ack.size(), &consumed, &packet) == LITHIUM_NO_ERROR);
+        REQUIRE(consumed == ack.size());
+        REQUIRE(lithium_is_ack(&packet));
+    }
+
+    SECTION("Skips noise before the sync bytes") {
+        std::vector<uint8_t> stream = { 0x00, 0x48, 0x48, 0x13 };
+        stream.insert(stream.end(), transmit.begin(), transmit.end());
+        stream.insert(stream.end(), ack.begin(), ack.end());
+
+        for (size_t chunk : { 1, 3, 7, 64 }) {
+            INFO("chunk " << chunk);
+            lithium_decoder_init(&decoder);
+            REQUIRE(feed(stream, chunk) == results_t({ LITHIUM_NO_ERROR, LITHIUM_NO_ERROR }));
+            REQUIRE(decoder.dropped_bytes == 4);
+            REQUIRE(decoder.length == 0);
+        }
+    }
+
+    SECTION("Reports a corrupt header and finds the next frame") {
+        std::vector<uint8_t> stream = transmit;
+        stream[7] ^= 0x01;
+        stream.insert(stream.end(), ack.begin(), ack.end());
+
+        REQUIRE(feed(stream, 5) == results_t({ LITHIUM_INVALID_CHECKSUM, LITHIUM_NO_ERROR }));
+    }
+
+    SECTION("Finds a frame inside a truncated one") {
+        // The transmit frame is cut off after its header, so the ACK and
+        // the start of the next frame get read as its payload
+        std::vector<uint8_t> stream(transmit.begin(), transmit.begin() + 8);
+        stream.insert(stream.end(), ack.begin(), ack.end());
+        stream.insert(stream.end(), transmit.begin(), transmit.end());
+
+        REQUIRE(feed(stream, 64) == results_t({
+            LITHIUM_INVALID_CHECKSUM, LITHIUM_NO_ERROR, LITHIUM_NO_ERROR,
+        }));
+        REQUIRE(decoder.length == 0);
+    }
+
+    SECTION("Receiving packets resynchronises too") {
+        lithium_t t;
+        uart_t uart;
+        uart_open(&uart, 9600);
+        lithium_open(&t, &uart);
+
+        std::vector<uint8_t> stream = { 0x65, 0x00 };
+        stream.insert(stream.end(), ack.begin(), ack.end());
+        stream.insert(stream.end(), transmit.begin(), transmit.end());
+        t.uart._impl->push_bytes(stream.begin(), stream.end());
+
+        lithium_packet_t packet;
+        REQUIRE(lithium_receive_packet(&t, &packet) == LITHIUM_NO_ERROR);
+        REQUIRE(lithium_is_ack(&packet));
+        REQUIRE(lithium_receive_packet(&t, &packet) == LITHIUM_NO_ERROR);
+        REQUIRE(packet.command == LITHIUM_COMMAND_TRANSMIT_DATA);
+        REQUIRE(t.uart._impl->input.empty());
+
+        lithium_close(&t);
+    }
+}
+
+TEST_CASE("The radio interface writes frames without staging them", "[data_board][lithium]") {
+    lithium_t t;
+    uart_t uart;
+    uart_open(&uart, 9600);
+    lithium_open(&t, &uart);
+
+    SECTION("A full payload") {
+        lithium_packet_t packet;
+        packet.type = LITHIUM_I_MESSAGE;
+        packet.command = LITHIUM_COMMAND_TRANSMIT_DATA;
+        packet.payload_length = 255;
+        for (int i = 0; i < 255; ++i) {
+            packet.payload[i] = i;
+        }
+        REQUIRE(lithium_send_packet(&t, &packet) == LITHIUM_NO_ERROR);
+        REQUIRE(t.uart._impl->output.size() == 8 + 255 + 2);
+
+        // What goes out decodes to what went in
+        lithium_decoder_t decoder;
+        lithium_decoder_init(&decoder);
+        lithium_packet_t decoded;
+        uint16_t consumed;
+        REQUIRE(lithium_decoder_feed(&decoder, t.uart._impl->output.data(),
+            t.uart._impl->output.size(), &consumed, &decoded) == LITHIUM_NO_ERROR);
+        REQUIRE(decoded.payload_length == 255);
+        REQUIRE(std::equal(packet.payload, packet.payload + 255, decoded.payload));
+    }
+
+    SECTION("An empty payload is a bare header") {
+        REQUIRE(lithium_send_transmit(&t, NULL, 0) == LITHIUM_NO_ERROR);
+        REQUIRE(t.uart._impl->output == std::vector<uint8_t>({
+            0x48, 0x65, 0x10, 0x03, 0x00, 0x00, 0x13, 0x49,
+        }));
+    }
+
+    SECTION("A closed channel fails the send") {
+        uart_close(&t.uart);
+        uint8_t data[] = { 1, 2, 3 };
+        REQUIRE(lithium_send_transmit(&t, data, 3) == LITHIUM_BAD_COMMUNICATION);
+    }
+
+    lithium_close(&t);
+}
+
+TEST_CASE("The radio interface runs over a descriptor", "[data_board][lithium][posix]") {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    uart_t uart;
+    REQUIRE(uart_open_fd(&uart, fds[0], 9600));
+    lithium_t t;
+    lithium_open(&t, &uart);
+    t.uart._impl->read_timeout_ms = 20;
+
+    // The far end answers before it is asked; the socket holds the reply
+    const uint8_t ack[] = { 0x48, 0x65, 0x20, 0x01, 0x0a, 0x0a, 0x35, 0xa1 };
+    REQUIRE(write(fds[1], ack, sizeof(ack)) == sizeof(ack));
+
+    REQUIRE(lithium_send_no_op(&t) == LITHIUM_NO_ERROR);
+    REQUIRE(lithium_receive_ack(&t, LITHIUM_COMMAND_NO_OP) == LITHIUM_NO_ERROR);
+
+    uint8_t sent[8];
+    REQUIRE(read(fds[1], sent, sizeof(sent)) == sizeof(sent));
+    REQUIRE(std::vector<uint8_t>(sent, sent + 8) == std::vector<uint8_t>({
+        0x48, 0x65, 0x10, 0x01, 0x00, 0x00, 0x11, 0x43,
+    }));
+
+    // Nothing more comes, so the next receive gives up
+    t.reply_timeout_ms = 50;
+    REQUIRE(lithium_receive_ack(&t, LITHIUM_COMMAND_NO_OP) == LITHIUM_TIMEOUT);
+
+    lithium_close(&t);
+    close(fds[1]);
+}
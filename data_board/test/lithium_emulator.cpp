@@ -0,0 +1,226 @@
+#include "lithium_emulator.hpp"
+#include "lithium_wire.h"
+#include "lithium_test.hpp"
+
+#include <catch/catch.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+    /// The flight code's Lithium driver on the mock UART, wired to an
+    /// emulated radio
+    struct fixture : mock_radio {
+        lithium_emulator emulator;
+        size_t forwarded = 0;
+        uint64_t now = 0;
+
+        fixture(const rf_link_config & link = rf_link_config()) : emulator(link) {}
+
+        /// Hand what the driver wrote to the emulator, and its replies back
+        void exchange() {
+            std::vector<uint8_t> & output = written();
+            emulator.receive(output.data() + forwarded, output.size() - forwarded, now);
+            forwarded = output.size();
+            deliver();
+        }
+
+        /// Let time pass on the RF link
+        void wait(uint64_t ns) {
+            now += ns;
+            emulator.advance(now);
+            deliver();
+        }
+
+        void deliver() {
+            std::vector<uint8_t> replies = emulator.take_output();
+            reply(replies);
+        }
+
+        lithium_result_t command(lithium_command_t command, const std::vector<uint8_t> & payload = {}) {
+            lithium_packet_t packet;
+            packet.type = LITHIUM_I_MESSAGE;
+            packet.command = command;
+            packet.payload_length = payload.size();
+            std::copy(payload.begin(), payload.end(), packet.payload);
+            REQUIRE(lithium_send_packet(&radio, &packet) == LITHIUM_NO_ERROR);
+            exchange();
+            return lithium_receive_ack(&radio, command);
+        }
+
+        /// Send a query and return the payload of the reply
+        std::vector<uint8_t> query(lithium_command_t command) {
+            lithium_packet_t packet;
+            packet.type = LITHIUM_I_MESSAGE;
+            packet.command = command;
+            packet.payload_length = 0;
+            REQUIRE(lithium_send_packet(&radio, &packet) == LITHIUM_NO_ERROR);
+            exchange();
+            REQUIRE(lithium_receive_packet(&radio, &packet) == LITHIUM_NO_ERROR);
+            REQUIRE(packet.command == command);
+            REQUIRE_FALSE(lithium_is_ack(&packet));
+            REQUIRE_FALSE(lithium_is_nack(&packet));
+            return std::vector<uint8_t>(packet.payload, packet.payload + packet.payload_length);
+        }
+
+        lithium_config_t config() {
+            std::vector<uint8_t> payload = query(LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG);
+            lithium_config_t config;
+            REQUIRE(lithium_decode_config(payload.data(), payload.size(), &config));
+            return config;
+        }
+    };
+
+    std::vector<uint8_t> encode(const lithium_config_t & config) {
+        std::vector<uint8_t> payload(LITHIUM_CONFIG_WIRE_LENGTH);
+        lithium_encode_config(&config, payload.data());
+        return payload;
+    }
+}
+
+TEST_CASE("The emulator answers every Lithium command", "[data_board][lithium_emulator]") {
+    fixture f;
+    const std::vector<uint8_t> hash(16, 0x5A);
+
+    REQUIRE(f.command(LITHIUM_COMMAND_NO_OP) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_RESET_SYSTEM) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_TRANSMIT_DATA, { 1, 2, 3 }) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG, encode(lithium_emulator::default_config())) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_WRITE_FLASH, hash) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_RF_CONFIG, std::vector<uint8_t>(LITHIUM_RF_CONFIG_WIRE_LENGTH)) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_BEACON_DATA, { 'h', 'i' }) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_BEACON_CONFIG, { 4 }) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_WRITE_OVER_AIR_KEY, hash) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_FIRMWARE_UPDATE, hash) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_FIRMWARE_PACKET, { 1 }) == LITHIUM_NO_ERROR);
+    REQUIRE(f.command(LITHIUM_COMMAND_FAST_PA_SET, { 0x40 }) == LITHIUM_NO_ERROR);
+
+    REQUIRE(f.query(LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG).size() == LITHIUM_CONFIG_WIRE_LENGTH);
+    REQUIRE(f.query(LITHIUM_COMMAND_TELEMETRY_QUERY).size() == LITHIUM_TELEM_WIRE_LENGTH);
+    REQUIRE(f.query(LITHIUM_COMMAND_READ_FIRMWARE_REVISION).size() == 4);
+
+    SECTION("Commands with the wrong payload are refused") {
+        REQUIRE(f.command(LITHIUM_COMMAND_TRANSMIT_DATA) == LITHIUM_NACK);
+        REQUIRE(f.command(LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG, { 1, 2 }) == LITHIUM_NACK);
+        REQUIRE(f.command(LITHIUM_COMMAND_WRITE_FLASH, { 1 }) == LITHIUM_NACK);
+        REQUIRE(f.command(LITHIUM_COMMAND_FAST_PA_SET) == LITHIUM_NACK);
+        REQUIRE(f.command(LITHIUM_COMMAND_RECEIVE_DATA) == LITHIUM_NACK);
+    }
+
+    SECTION("Commands can be made to fail") {
+        f.emulator.refuse(LITHIUM_COMMAND_NO_OP);
+        REQUIRE(f.command(LITHIUM_COMMAND_NO_OP) == LITHIUM_NACK);
+        f.emulator.refuse(LITHIUM_COMMAND_NO_OP, false);
+        REQUIRE(f.command(LITHIUM_COMMAND_NO_OP) == LITHIUM_NO_ERROR);
+    }
+
+    REQUIRE(f.emulator.stats().dropped_bytes == 0);
+}
+
+TEST_CASE("The emulator keeps its configuration like the radio", "[data_board][lithium_emulator]") {
+    fixture f;
+    lithium_config_t config = f.config();
+    config.tx_freq = 145825000;
+    REQUIRE(f.command(LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG, encode(config)) == LITHIUM_NO_ERROR);
+    REQUIRE(f.config().tx_freq == 145825000);
+
+    REQUIRE(f.command(LITHIUM_COMMAND_FAST_PA_SET, { 0x11 }) == LITHIUM_NO_ERROR);
+    REQUIRE(f.config().tx_power_amp_level == 0x11);
+
+    SECTION("A reset loses what wasn't written to flash") {
+        REQUIRE(f.command(LITHIUM_COMMAND_RESET_SYSTEM) == LITHIUM_NO_ERROR);
+        REQUIRE(f.config().tx_freq == 437525000);
+    }
+
+    SECTION("Written to flash, it survives a reset") {
+        REQUIRE(f.command(LITHIUM_COMMAND_WRITE_FLASH, std::vector<uint8_t>(16)) == LITHIUM_NO_ERROR);
+        REQUIRE(f.command(LITHIUM_COMMAND_RESET_SYSTEM) == LITHIUM_NO_ERROR);
+        REQUIRE(f.config().tx_freq == 145825000);
+    }
+}
+
+TEST_CASE("Transmitted frames come back over the emulated link", "[data_board][lithium_emulator]") {
+    rf_link_config link;
+    link.baud = 9600;
+    link.latency_ns = 50000000;
+    fixture f(link);
+    // 10 bytes plus framing, at 9600 bits per second, then the latency
+    const uint64_t arrival = (10 + lithium_emulator::RF_OVERHEAD) * 8 * 1000000000ull / 9600 + link.latency_ns;
+
+    std::vector<uint8_t> data(10, 0xC3);
+    REQUIRE(f.command(LITHIUM_COMMAND_TRANSMIT_DATA, data) == LITHIUM_NO_ERROR);
+    REQUIRE(f.emulator.next_event_ns() == arrival);
+
+    f.wait(arrival - 1);
+    lithium_packet_t packet;
+    REQUIRE(lithium_receive_packet(&f.radio, &packet) == LITHIUM_TIMEOUT);
+    f.wait(1);
+    REQUIRE(lithium_receive_packet(&f.radio, &packet) == LITHIUM_NO_ERROR);
+    REQUIRE(packet.type == LITHIUM_O_MESSAGE);
+    REQUIRE(packet.command == LITHIUM_COMMAND_RECEIVE_DATA);
+    REQUIRE(std::vector<uint8_t>(packet.payload, packet.payload + packet.payload_length) == data);
+    REQUIRE(f.emulator.next_event_ns() == UINT64_MAX);
+
+    // Counted in the telemetry
+    std::vector<uint8_t> payload = f.query(LITHIUM_COMMAND_TELEMETRY_QUERY);
+    lithium_telem_t telem;
+    REQUIRE(lithium_decode_telem(payload.data(), payload.size(), &telem));
+    REQUIRE(telem.bytes_transmitted == 10);
+    REQUIRE(telem.bytes_received == 10);
+
+    SECTION("The transmit buffer fills up") {
+        for (size_t i = 0; i < lithium_emulator::TX_QUEUE_LENGTH; ++i) {
+            REQUIRE(f.command(LITHIUM_COMMAND_TRANSMIT_DATA, data) == LITHIUM_NO_ERROR);
+        }
+        REQUIRE(f.command(LITHIUM_COMMAND_TRANSMIT_DATA, data) == LITHIUM_NACK);
+
+        // Room again once a frame is off the air
+        f.wait(arrival - link.latency_ns);
+        REQUIRE(f.command(LITHIUM_COMMAND_TRANSMIT_DATA, data) == LITHIUM_NO_ERROR);
+    }
+}
+
+TEST_CASE("The emulated link loses frames", "[data_board][lithium_emulator]") {
+    rf_link_config link;
+    link.loss = 0.25;
+    link.seed = 22;
+    fixture f(link);
+    const int frames = 400;
+    int received = 0;
+
+    for (int i = 0; i < frames; ++i) {
+        REQUIRE(f.command(LITHIUM_COMMAND_TRANSMIT_DATA, { (uint8_t) i }) == LITHIUM_NO_ERROR);
+        f.wait(1000000000);
+
+        lithium_packet_t packet;
+        if (lithium_receive_packet(&f.radio, &packet) == LITHIUM_NO_ERROR) {
+            REQUIRE(packet.payload[0] == (uint8_t) i);
+            ++received;
+        }
+    }
+    const lithium_emulator_stats & stats = f.emulator.stats();
+    REQUIRE(stats.rf_sent == frames);
+    REQUIRE(stats.rf_delivered == received);
+    REQUIRE(stats.rf_lost + stats.rf_delivered == frames);
+    REQUIRE(stats.rf_lost > frames / 8);
+    REQUIRE(stats.rf_lost < frames * 3 / 8);
+}
+
+TEST_CASE("The emulator skips anything that isn't a frame", "[data_board][lithium_emulator]") {
+    lithium_emulator emulator;
+    const std::vector<uint8_t> no_op = { 0x48, 0x65, 0x10, 0x01, 0x00, 0x00, 0x11, 0x43 };
+    std::vector<uint8_t> stream = { 0x00, 'H', 0x48 };
+    stream.insert(stream.end(), no_op.begin(), no_op.end());
+    // A corrupt header
+    stream.insert(stream.end(), { 0x48, 0x65, 0x10, 0x01, 0x00, 0x00, 0x11, 0x44 });
+    stream.insert(stream.end(), no_op.begin(), no_op.end());
+
+    // A byte at a time, so frames straddle every boundary
+    for (uint8_t byte : stream) {
+        emulator.receive(&byte, 1, 0);
+    }
+    REQUIRE(emulator.stats().frames == 2);
+    REQUIRE(emulator.stats().acks == 2);
+    REQUIRE(emulator.stats().dropped_bytes == 3 + 8);
+    REQUIRE(emulator.take_output().size() == 16);
+}
@@ -0,0 +1,123 @@
+#include "lithium_pool.h"
+
+#include <catch/catch.hpp>
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Packet pools hand out every packet once", "[data_board][lithium_pool]") {
+    static lithium_pool_t pool;
+    lithium_pool_init(&pool);
+
+    std::set<lithium_handle_t> handles;
+    for (int i = 0; i < LITHIUM_POOL_SIZE; ++i) {
+        lithium_handle_t handle = lithium_pool_acquire(&pool);
+        REQUIRE(handle != LITHIUM_HANDLE_NONE);
+        REQUIRE(lithium_pool_get(&pool, handle) != NULL);
+        handles.insert(handle);
+    }
+    REQUIRE(handles.size() == LITHIUM_POOL_SIZE);
+
+    SECTION("An empty pool refuses and counts it") {
+        REQUIRE(lithium_pool_acquire(&pool) == LITHIUM_HANDLE_NONE);
+        REQUIRE(lithium_pool_acquire(&pool) == LITHIUM_HANDLE_NONE);
+
+        lithium_pool_stats_t stats = lithium_pool_stats(&pool);
+        REQUIRE(stats.in_use == LITHIUM_POOL_SIZE);
+        REQUIRE(stats.high_water == LITHIUM_POOL_SIZE);
+        REQUIRE(stats.exhausted == 2);
+    }
+
+    SECTION("Released packets come back") {
+        for (lithium_handle_t handle : handles) {
+            REQUIRE(lithium_pool_release(&pool, handle));
+        }
+
+        lithium_pool_stats_t stats = lithium_pool_stats(&pool);
+        REQUIRE(stats.in_use == 0);
+        REQUIRE(stats.high_water == LITHIUM_POOL_SIZE);
+        REQUIRE(lithium_pool_acquire(&pool) != LITHIUM_HANDLE_NONE);
+    }
+}
+
+TEST_CASE("Packet pools count references", "[data_board][lithium_pool]") {
+    static lithium_pool_t pool;
+    lithium_pool_init(&pool);
+
+    lithium_handle_t handle = lithium_pool_acquire(&pool);
+    lithium_packet_t * packet = lithium_pool_get(&pool, handle);
+    packet->payload_length = 3;
+
+    SECTION("A packet stays held until its last reference goes") {
+        REQUIRE(lithium_pool_retain(&pool, handle));
+        REQUIRE(lithium_pool_retain(&pool, handle));
+
+        REQUIRE(lithium_pool_release(&pool, handle));
+        REQUIRE(lithium_pool_release(&pool, handle));
+        REQUIRE(lithium_pool_stats(&pool).in_use == 1);
+        REQUIRE(lithium_pool_get(&pool, handle)->payload_length == 3);
+
+        REQUIRE(lithium_pool_release(&pool, handle));
+        REQUIRE(lithium_pool_stats(&pool).in_use == 0);
+    }
+
+    SECTION("Free packets can't be retained or released") {
+        REQUIRE(lithium_pool_release(&pool, handle));
+        REQUIRE_FALSE(lithium_pool_retain(&pool, handle));
+        REQUIRE_FALSE(lithium_pool_release(&pool, handle));
+        REQUIRE(lithium_pool_stats(&pool).in_use == 0);
+    }
+
+    SECTION("Handles outside the pool are refused") {
+        REQUIRE_FALSE(lithium_pool_retain(&pool, LITHIUM_HANDLE_NONE));
+        REQUIRE_FALSE(lithium_pool_release(&pool, LITHIUM_POOL_SIZE));
+        REQUIRE(lithium_pool_get(&pool, LITHIUM_HANDLE_NONE) == NULL);
+    }
+}
+
+TEST_CASE("Packet pools never share a packet between threads", "[data_board][lithium_pool][threads]") {
+    static lithium_pool_t pool;
+    lithium_pool_init(&pool);
+
+    const int threads = LITHIUM_POOL_SIZE + 4;
+    const int rounds = 2000;
+    std::atomic<int> collisions(0);
+    std::atomic<int> exhausted(0);
+
+    std::vector<std::thread> workers;
+    for (int id = 0; id < threads; ++id) {
+        workers.emplace_back([id, &collisions, &exhausted]() {
+            for (int i = 0; i < rounds; ++i) {
+                lithium_handle_t handle = lithium_pool_acquire(&pool);
+                if (handle == LITHIUM_HANDLE_NONE) {
+                    ++exhausted;
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                // Stamp the packet, share it, and check nobody else wrote it
+                lithium_packet_t * packet = lithium_pool_get(&pool, handle);
+                packet->payload[0] = id;
+                lithium_pool_retain(&pool, handle);
+                std::this_thread::yield();
+                if (packet->payload[0] != id) {
+                    ++collisions;
+                }
+                lithium_pool_release(&pool, handle);
+                lithium_pool_release(&pool, handle);
+            }
+        });
+    }
+    for (auto & worker : workers) {
+        worker.join();
+    }
+
+    lithium_pool_stats_t stats = lithium_pool_stats(&pool);
+    REQUIRE(collisions == 0);
+    REQUIRE(stats.in_use == 0);
+    REQUIRE(stats.high_water <= LITHIUM_POOL_SIZE);
+    REQUIRE(stats.exhausted == (uint16_t) exhausted);
+    REQUIRE(pool.free_count == LITHIUM_POOL_SIZE);
+}
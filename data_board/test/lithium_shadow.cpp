@@ -0,0 +1,238 @@
+#include "lithium_shadow.h"
+#include "lithium_wire.h"
+#include "lithium_test.hpp"
+
+#include <catch/catch.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+    lithium_config_t sample_config() {
+        lithium_config_t config = {};
+        config.interface_baud_rate = LITHIUM_BAUD_9600;
+        config.tx_power_amp_level = 0x80;
+        config.rx_freq = 437525000;
+        config.tx_freq = 437525000;
+        std::memcpy(config.source, "NOCALL", 6);
+        std::memcpy(config.destination, "CQ    ", 6);
+        config.function_config = 0x0041;
+        return config;
+    }
+
+    lithium_rf_config_t sample_rf_config() {
+        lithium_rf_config_t config = {};
+        config.front_end_level = 40;
+        config.tx_power_amp_level = 0x80;
+        config.tx_frequency_offset = 1200;
+        config.rx_frequency_offset = 800;
+        return config;
+    }
+
+    lithium_packet_t request(lithium_command_t command, const uint8_t * payload = nullptr, uint16_t length = 0) {
+        lithium_packet_t packet;
+        packet.type = LITHIUM_I_MESSAGE;
+        packet.command = command;
+        packet.payload_length = length;
+        if (length > 0) {
+            std::memcpy(packet.payload, payload, length);
+        }
+        return packet;
+    }
+
+    lithium_packet_t set_config(const lithium_config_t & config) {
+        uint8_t payload[LITHIUM_CONFIG_WIRE_LENGTH];
+        return request(LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG, payload, lithium_encode_config(&config, payload));
+    }
+
+    lithium_packet_t set_rf_config(const lithium_rf_config_t & config) {
+        uint8_t payload[LITHIUM_RF_CONFIG_WIRE_LENGTH];
+        return request(LITHIUM_COMMAND_RF_CONFIG, payload, lithium_encode_rf_config(&config, payload));
+    }
+
+    lithium_packet_t set_pa_level(uint8_t level) {
+        return request(LITHIUM_COMMAND_FAST_PA_SET, &level, 1);
+    }
+
+    bool same(const lithium_config_t * a, const lithium_config_t & b) {
+        uint8_t encoded_a[LITHIUM_CONFIG_WIRE_LENGTH];
+        uint8_t encoded_b[LITHIUM_CONFIG_WIRE_LENGTH];
+        lithium_encode_config(a, encoded_a);
+        lithium_encode_config(&b, encoded_b);
+        return std::memcmp(encoded_a, encoded_b, sizeof(encoded_a)) == 0;
+    }
+
+    struct fixture : mock_radio {
+        lithium_shadow_t shadow;
+
+        fixture() {
+            lithium_shadow_init(&shadow);
+        }
+    };
+}
+
+TEST_CASE("Radio configuration is fetched once and then read from the shadow", "[data_board][lithium_shadow]") {
+    fixture f;
+    lithium_config_t config = sample_config();
+    uint8_t payload[LITHIUM_CONFIG_WIRE_LENGTH];
+    lithium_encode_config(&config, payload);
+
+    f.reply(lithium_o_message(LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG, sizeof(payload),
+        std::vector<uint8_t>(payload, payload + sizeof(payload))));
+    const lithium_config_t * read = lithium_shadow_config(&f.shadow, &f.radio);
+    REQUIRE(read != nullptr);
+    REQUIRE(same(read, config));
+    REQUIRE(f.written().size() == 8);
+
+    // Nothing more goes to the radio
+    uint16_t version = f.shadow.version;
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(lithium_shadow_config(&f.shadow, &f.radio) == read);
+    }
+    REQUIRE(f.written().size() == 8);
+    REQUIRE(f.shadow.version == version);
+
+    SECTION("A fetch that fails leaves nothing behind") {
+        lithium_shadow_invalidate(&f.shadow);
+        f.reply(lithium_o_message(LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG, NACK_LENGTH));
+        REQUIRE(lithium_shadow_config(&f.shadow, &f.radio) == nullptr);
+        // Nothing left to read
+        REQUIRE(lithium_shadow_config(&f.shadow, &f.radio) == nullptr);
+        REQUIRE_FALSE(f.shadow.config_valid);
+    }
+}
+
+TEST_CASE("Configuration commands that change nothing are skipped", "[data_board][lithium_shadow]") {
+    fixture f;
+    lithium_config_t config = sample_config();
+    lithium_rf_config_t rf_config = sample_rf_config();
+
+    // Unknown configuration is always sent
+    lithium_packet_t packet = set_config(config);
+    REQUIRE_FALSE(lithium_shadow_unchanged(&f.shadow, &packet));
+    f.reply(lithium_o_message(LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG, ACK_LENGTH));
+    REQUIRE(lithium_shadow_send(&f.shadow, &f.radio, &packet) == LITHIUM_NO_ERROR);
+
+    packet = set_rf_config(rf_config);
+    f.reply(lithium_o_message(LITHIUM_COMMAND_RF_CONFIG, ACK_LENGTH));
+    REQUIRE(lithium_shadow_send(&f.shadow, &f.radio, &packet) == LITHIUM_NO_ERROR);
+    size_t written = f.written().size();
+
+    SECTION("The same configuration again") {
+        packet = set_config(config);
+        REQUIRE(lithium_shadow_send(&f.shadow, &f.radio, &packet) == LITHIUM_NO_ERROR);
+        packet = set_rf_config(rf_config);
+        REQUIRE(lithium_shadow_send(&f.shadow, &f.radio, &packet) == LITHIUM_NO_ERROR);
+        packet = set_pa_level(config.tx_power_amp_level);
+        REQUIRE(lithium_shadow_send(&f.shadow, &f.radio, &packet) == LITHIUM_NO_ERROR);
+        REQUIRE(f.written().size() == written);
+    }
+
+    SECTION("A changed field is sent") {
+        config.tx_freq += 25000;
+        packet = set_config(config);
+        REQUIRE_FALSE(lithium_shadow_unchanged(&f.shadow, &packet));
+
+        rf_config.front_end_level = 41;
+        packet = set_rf_config(rf_config);
+        REQUIRE_FALSE(lithium_shadow_unchanged(&f.shadow, &packet));
+
+        packet = set_pa_level(config.tx_power_amp_level + 1);
+        REQUIRE_FALSE(lithium_shadow_unchanged(&f.shadow, &packet));
+    }
+
+    SECTION("Commands that don't configure anything are never skipped") {
+        packet = request(LITHIUM_COMMAND_NO_OP);
+        REQUIRE_FALSE(lithium_shadow_unchanged(&f.shadow, &packet));
+        packet = request(LITHIUM_COMMAND_RESET_SYSTEM);
+        REQUIRE_FALSE(lithium_shadow_unchanged(&f.shadow, &packet));
+    }
+}
+
+TEST_CASE("The shadow only changes when the radio acknowledges", "[data_board][lithium_shadow]") {
+    fixture f;
+    lithium_config_t config = sample_config();
+    lithium_packet_t packet = set_config(config);
+
+    SECTION("A NACK") {
+        f.reply(lithium_o_message(LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG, NACK_LENGTH));
+        REQUIRE(lithium_shadow_send(&f.shadow, &f.radio, &packet) == LITHIUM_NACK);
+        REQUIRE(f.shadow.version == 0);
+        REQUIRE_FALSE(f.shadow.config_valid);
+    }
+
+    SECTION("No reply") {
+        REQUIRE(lithium_shadow_send(&f.shadow, &f.radio, &packet) == LITHIUM_TIMEOUT);
+        REQUIRE(f.shadow.version == 0);
+    }
+
+    SECTION("An ACK") {
+        f.reply(lithium_o_message(LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG, ACK_LENGTH));
+        REQUIRE(lithium_shadow_send(&f.shadow, &f.radio, &packet) == LITHIUM_NO_ERROR);
+        REQUIRE(f.shadow.version == 1);
+        REQUIRE(same(lithium_shadow_config(&f.shadow, &f.radio), config));
+
+        // FAST_PA_SET moves the PA level of both configurations
+        lithium_packet_t rf = set_rf_config(sample_rf_config());
+        lithium_shadow_acknowledged(&f.shadow, &rf);
+        packet = set_pa_level(0x20);
+        f.reply(lithium_o_message(LITHIUM_COMMAND_FAST_PA_SET, ACK_LENGTH));
+        REQUIRE(lithium_shadow_send(&f.shadow, &f.radio, &packet) == LITHIUM_NO_ERROR);
+        REQUIRE(f.shadow.version == 3);
+        REQUIRE(lithium_shadow_config(&f.shadow, &f.radio)->tx_power_amp_level == 0x20);
+        REQUIRE(lithium_shadow_rf_config(&f.shadow)->tx_power_amp_level == 0x20);
+    }
+}
+
+TEST_CASE("The shadow is fetched again after the radio resets", "[data_board][lithium_shadow]") {
+    fixture f;
+    lithium_config_t config = sample_config();
+    lithium_packet_t packet = set_config(config);
+    lithium_shadow_acknowledged(&f.shadow, &packet);
+    packet = set_rf_config(sample_rf_config());
+    lithium_shadow_acknowledged(&f.shadow, &packet);
+    REQUIRE(lithium_shadow_rf_config(&f.shadow) != nullptr);
+
+    packet = request(LITHIUM_COMMAND_RESET_SYSTEM);
+    f.reply(lithium_o_message(LITHIUM_COMMAND_RESET_SYSTEM, ACK_LENGTH));
+    REQUIRE(lithium_shadow_send(&f.shadow, &f.radio, &packet) == LITHIUM_NO_ERROR);
+    REQUIRE(lithium_shadow_rf_config(&f.shadow) == nullptr);
+    REQUIRE(f.written().size() == 8);
+
+    // Nothing is fetched until it is read
+    config.tx_power_amp_level = 0x10;
+    uint8_t payload[LITHIUM_CONFIG_WIRE_LENGTH];
+    lithium_encode_config(&config, payload);
+    f.reply(lithium_o_message(LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG, sizeof(payload),
+        std::vector<uint8_t>(payload, payload + sizeof(payload))));
+    REQUIRE(f.written().size() == 8);
+    REQUIRE(same(lithium_shadow_config(&f.shadow, &f.radio), config));
+    REQUIRE(f.written().size() == 16);
+}
+
+TEST_CASE("A shadow that didn't survive in FRAM is dropped", "[data_board][lithium_shadow]") {
+    fixture f;
+    lithium_packet_t packet = set_config(sample_config());
+    lithium_shadow_acknowledged(&f.shadow, &packet);
+    REQUIRE(lithium_shadow_load(&f.shadow));
+    REQUIRE(f.shadow.config_valid);
+
+    SECTION("A changed field") {
+        f.shadow.config.rx_freq ^= 1;
+    }
+
+    SECTION("A changed flag") {
+        f.shadow.rf_config_valid = true;
+    }
+
+    SECTION("A changed version") {
+        f.shadow.version ^= 0x100;
+    }
+
+    uint16_t version = f.shadow.version;
+    REQUIRE_FALSE(lithium_shadow_load(&f.shadow));
+    REQUIRE_FALSE(f.shadow.config_valid);
+    REQUIRE_FALSE(f.shadow.rf_config_valid);
+    REQUIRE(f.shadow.version != version);
+    REQUIRE(lithium_shadow_load(&f.shadow));
+}
@@ -0,0 +1,162 @@
+#include "lithium_wire.h"
+#include "fletcher.h"
+#include "lithium_test.hpp"
+
+#include <catch/catch.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+    lithium_config_t example_config() {
+        lithium_config_t config = {};
+        config.interface_baud_rate = LITHIUM_BAUD_38400;
+        config.tx_power_amp_level = 0x80;
+        config.rx_rf_baud_rate = LITHIUM_RF_BAUD_9600;
+        config.tx_rf_baud_rate = LITHIUM_RF_BAUD_19200;
+        config.rx_modulation = LITHIUM_RF_MOD_GFSK;
+        config.tx_modulation = LITHIUM_RF_MOD_BPSK;
+        config.rx_freq = 437525000;
+        config.tx_freq = 0x01020304;
+        std::memcpy(config.source, "VT3SAT", 6);
+        std::memcpy(config.destination, "CQ    ", 6);
+        config.tx_preamble = 0x0005;
+        config.tx_postamble = 0x0a0b;
+        config.function_config = 0xBEEF;
+        config.function_config2 = 0x0001;
+        return config;
+    }
+}
+
+TEST_CASE("Lithium payloads have the same layout everywhere", "[data_board][lithium_wire]") {
+    REQUIRE(LITHIUM_CONFIG_WIRE_LENGTH == 34);
+    REQUIRE(LITHIUM_RF_CONFIG_WIRE_LENGTH == 10);
+    REQUIRE(LITHIUM_BEACON_CONFIG_WIRE_LENGTH == 1);
+    REQUIRE(LITHIUM_TELEM_WIRE_LENGTH == 16);
+}
+
+TEST_CASE("Lithium configurations encode big-endian", "[data_board][lithium_wire]") {
+    SECTION("Front-end configuration") {
+        lithium_config_t config = example_config();
+        uint8_t payload[LITHIUM_CONFIG_WIRE_LENGTH];
+        REQUIRE(lithium_encode_config(&config, payload) == 34);
+        REQUIRE(std::vector<uint8_t>(payload, payload + 34) == std::vector<uint8_t>({
+            0x02, 0x80, 0x01, 0x02, 0x00, 0x02,
+            0x1a, 0x14, 0x1a, 0x08,
+            0x01, 0x02, 0x03, 0x04,
+            'V', 'T', '3', 'S', 'A', 'T',
+            'C', 'Q', ' ', ' ', ' ', ' ',
+            0x00, 0x05, 0x0a, 0x0b, 0xbe, 0xef, 0x00, 0x01,
+        }));
+
+        lithium_config_t decoded = {};
+        REQUIRE(lithium_decode_config(payload, sizeof(payload), &decoded));
+        REQUIRE(std::memcmp(&decoded, &config, sizeof(config)) == 0);
+    }
+
+    SECTION("RF configuration") {
+        lithium_rf_config_t config = { 63, 0xFF, 20000, 0x00ABCDEF };
+        uint8_t payload[LITHIUM_RF_CONFIG_WIRE_LENGTH];
+        REQUIRE(lithium_encode_rf_config(&config, payload) == 10);
+        REQUIRE(std::vector<uint8_t>(payload, payload + 10) == std::vector<uint8_t>({
+            0x3f, 0xff, 0x00, 0x00, 0x4e, 0x20, 0x00, 0xab, 0xcd, 0xef,
+        }));
+
+        lithium_rf_config_t decoded = {};
+        REQUIRE(lithium_decode_rf_config(payload, sizeof(payload), &decoded));
+        REQUIRE(decoded.front_end_level == 63);
+        REQUIRE(decoded.tx_power_amp_level == 0xFF);
+        REQUIRE(decoded.tx_frequency_offset == 20000);
+        REQUIRE(decoded.rx_frequency_offset == 0x00ABCDEF);
+    }
+
+    SECTION("Beacon configuration") {
+        lithium_beacon_config_t config = { 12 };
+        uint8_t payload[LITHIUM_BEACON_CONFIG_WIRE_LENGTH];
+        REQUIRE(lithium_encode_beacon_config(&config, payload) == 1);
+        REQUIRE(payload[0] == 12);
+    }
+}
+
+TEST_CASE("Lithium telemetry decodes straight from the payload", "[data_board][lithium_wire]") {
+    const uint8_t payload[] = {
+        0x12, 0x34,             // op_counter
+        0xff, 0xf6,             // msp430_temp, -10
+        0x01, 0x02, 0x03,       // time_count
+        0x9c,                   // rssi
+        0x00, 0x01, 0x00, 0x00, // bytes_received
+        0xde, 0xad, 0xbe, 0xef, // bytes_transmitted
+    };
+
+    lithium_telem_t telem = {};
+    REQUIRE(lithium_decode_telem(payload, sizeof(payload), &telem));
+    REQUIRE(telem.op_counter == 0x1234);
+    REQUIRE(telem.msp430_temp == -10);
+    REQUIRE(telem.time_count[0] == 1);
+    REQUIRE(telem.time_count[2] == 3);
+    REQUIRE(telem.rssi == 0x9c);
+    REQUIRE(telem.bytes_received == 0x10000);
+    REQUIRE(telem.bytes_transmitted == 0xdeadbeef);
+
+    uint8_t encoded[LITHIUM_TELEM_WIRE_LENGTH];
+    REQUIRE(lithium_encode_telem(&telem, encoded) == sizeof(payload));
+    REQUIRE(std::memcmp(encoded, payload, sizeof(payload)) == 0);
+
+    SECTION("Short payloads are refused") {
+        lithium_telem_t untouched = {};
+        untouched.rssi = 7;
+        REQUIRE_FALSE(lithium_decode_telem(payload, sizeof(payload) - 1, &untouched));
+        REQUIRE(untouched.rssi == 7);
+        REQUIRE(untouched.op_counter == 0);
+    }
+}
+
+TEST_CASE("Lithium configurations go to the radio encoded", "[data_board][lithium_wire]") {
+    mock_radio radio;
+
+    lithium_config_t config = example_config();
+    REQUIRE(lithium_send_set_config(&radio.radio, &config) == LITHIUM_NO_ERROR);
+    lithium_rf_config_t rf_config = { 1, 2, 3, 4 };
+    REQUIRE(lithium_send_set_rf_config(&radio.radio, &rf_config) == LITHIUM_NO_ERROR);
+    lithium_beacon_config_t beacon_config = { 5 };
+    REQUIRE(lithium_send_set_beacon_config(&radio.radio, &beacon_config) == LITHIUM_NO_ERROR);
+
+    std::vector<lithium_packet_t> sent = radio.sent();
+    REQUIRE(sent.size() == 3);
+    REQUIRE(sent[0].command == LITHIUM_COMMAND_SET_TRANSCEIVER_CONFIG);
+    REQUIRE(sent[0].payload_length == LITHIUM_CONFIG_WIRE_LENGTH);
+    REQUIRE(sent[1].command == LITHIUM_COMMAND_RF_CONFIG);
+    REQUIRE(sent[1].payload_length == LITHIUM_RF_CONFIG_WIRE_LENGTH);
+    REQUIRE(sent[2].command == LITHIUM_COMMAND_BEACON_CONFIG);
+    REQUIRE(sent[2].payload_length == LITHIUM_BEACON_CONFIG_WIRE_LENGTH);
+
+    lithium_config_t decoded = {};
+    REQUIRE(lithium_decode_config(sent[0].payload, sent[0].payload_length, &decoded));
+    REQUIRE(std::memcmp(&decoded, &config, sizeof(config)) == 0);
+}
+
+TEST_CASE("Lithium frames encode as the driver sends them", "[data_board][lithium_wire]") {
+    mock_radio radio;
+    uint8_t frame[LITHIUM_MAX_FRAME_LENGTH];
+
+    SECTION("With a payload") {
+        uint8_t payload[] = { 1, 2, 3, 4, 5 };
+        REQUIRE(lithium_send_transmit(&radio.radio, payload, sizeof(payload)) == LITHIUM_NO_ERROR);
+        uint16_t length = lithium_encode_frame(LITHIUM_I_MESSAGE, LITHIUM_COMMAND_TRANSMIT_DATA, sizeof(payload), payload, frame);
+        REQUIRE(length == HEADER_LENGTH + sizeof(payload) + CHECKSUM_LENGTH);
+        REQUIRE(radio.written() == std::vector<uint8_t>(frame, frame + length));
+    }
+
+    SECTION("Without one") {
+        REQUIRE(lithium_send_no_op(&radio.radio) == LITHIUM_NO_ERROR);
+        uint16_t length = lithium_encode_frame(LITHIUM_I_MESSAGE, LITHIUM_COMMAND_NO_OP, 0, NULL, frame);
+        REQUIRE(length == HEADER_LENGTH);
+        REQUIRE(radio.written() == std::vector<uint8_t>(frame, frame + length));
+    }
+}
+
+TEST_CASE("Lithium interface baud rates convert to bits per second", "[data_board][lithium_wire]") {
+    REQUIRE(lithium_baud_bps(LITHIUM_BAUD_9600) == 9600);
+    REQUIRE(lithium_baud_bps(LITHIUM_BAUD_115200) == 115200);
+    REQUIRE(lithium_baud_bps((lithium_baud_t) (LITHIUM_BAUD_115200 + 1)) == 0);
+}
@@ -0,0 +1,141 @@
+#include "lzss.h"
+#include "lithium_test.hpp"
+#include "telemetry_test.hpp"
+
+#include <catch/catch.hpp>
+
+#include <random>
+#include <vector>
+
+namespace {
+    typedef std::vector<uint8_t> bytes_t;
+
+    bytes_t random_bytes(size_t length, unsigned seed) {
+        std::mt19937 rng(seed);
+        bytes_t bytes(length);
+        for (auto & byte : bytes) {
+            byte = rng();
+        }
+        return bytes;
+    }
+
+    bytes_t encode(const bytes_t & input) {
+        lzss_t lzss;
+        bytes_t frame(input.size() + 1);
+        uint16_t length = lzss_encode(&lzss, input.data(), input.size(), frame.data());
+        REQUIRE(length > 0);
+        REQUIRE(length <= input.size() + 1);
+        frame.resize(length);
+        return frame;
+    }
+
+    bytes_t decode(const bytes_t & frame) {
+        bytes_t output(LZSS_MAX_INPUT);
+        uint16_t length;
+        REQUIRE(lzss_decode(frame.data(), frame.size(), output.data(), output.size(), &length));
+        output.resize(length);
+        return output;
+    }
+
+    bool rejected(const bytes_t & frame, uint16_t capacity = LZSS_MAX_INPUT) {
+        bytes_t output(capacity);
+        uint16_t length;
+        return !lzss_decode(frame.data(), frame.size(), output.data(), capacity, &length);
+    }
+}
+
+TEST_CASE("LZSS frames decode to their input", "[data_board][lzss]") {
+    std::vector<bytes_t> inputs = {
+        random_bytes(LZSS_MAX_INPUT, 1),
+        telemetry_records(LZSS_MAX_INPUT, 2),
+        bytes_t(LZSS_MAX_INPUT, 0),
+    };
+    const char * text = "the quick brown fox jumps over the lazy dog; the quick brown fox jumps again";
+    inputs.emplace_back(text, text + 76);
+
+    for (const auto & input : inputs) {
+        for (size_t length = 0; length <= input.size(); ++length) {
+            INFO("length " << length);
+            bytes_t prefix(input.begin(), input.begin() + length);
+            REQUIRE(decode(encode(prefix)) == prefix);
+        }
+    }
+}
+
+TEST_CASE("LZSS frames are only compressed when that makes them shorter", "[data_board][lzss]") {
+    SECTION("Random bytes are sent raw") {
+        bytes_t input = random_bytes(200, 3);
+        bytes_t frame = encode(input);
+        REQUIRE(frame[0] == LZSS_FRAME_RAW);
+        REQUIRE(frame.size() == input.size() + 1);
+        REQUIRE(bytes_t(frame.begin() + 1, frame.end()) == input);
+    }
+
+    SECTION("Nothing is sent raw") {
+        REQUIRE(encode({}) == bytes_t({ LZSS_FRAME_RAW }));
+    }
+
+    SECTION("A run collapses to a few matches") {
+        bytes_t frame = encode(bytes_t(LZSS_MAX_INPUT, 'A'));
+        REQUIRE(frame[0] == LZSS_FRAME_COMPRESSED);
+        // A literal then one overlapping match
+        REQUIRE(frame == bytes_t({ LZSS_FRAME_COMPRESSED, 0x02, 'A', 1, LZSS_MAX_INPUT - 1 - LZSS_MIN_MATCH }));
+    }
+
+    SECTION("Telemetry compresses") {
+        bytes_t input = telemetry_records(LZSS_MAX_INPUT, 4);
+        bytes_t frame = encode(input);
+        REQUIRE(frame[0] == LZSS_FRAME_COMPRESSED);
+        REQUIRE(frame.size() < input.size() * 4 / 5);
+    }
+
+    SECTION("Input longer than a payload allows is refused") {
+        lzss_t lzss;
+        bytes_t input(LZSS_MAX_INPUT + 1);
+        bytes_t frame(input.size() + 1);
+        REQUIRE(lzss_encode(&lzss, input.data(), input.size(), frame.data()) == 0);
+    }
+}
+
+TEST_CASE("Malformed LZSS frames are rejected", "[data_board][lzss]") {
+    SECTION("An empty frame") {
+        REQUIRE(rejected({}));
+    }
+
+    SECTION("An unknown flag") {
+        REQUIRE(rejected({ 0x02, 1, 2, 3 }));
+    }
+
+    SECTION("A match before the start of the output") {
+        REQUIRE(rejected({ LZSS_FRAME_COMPRESSED, 0x02, 'A', 2, 0 }));
+        REQUIRE(rejected({ LZSS_FRAME_COMPRESSED, 0x01, 0, 0 }));
+    }
+
+    SECTION("A truncated match") {
+        REQUIRE(rejected({ LZSS_FRAME_COMPRESSED, 0x02, 'A', 1 }));
+    }
+
+    SECTION("Output that doesn't fit") {
+        REQUIRE(rejected({ LZSS_FRAME_COMPRESSED, 0x02, 'A', 1, 10 }, 8));
+        REQUIRE(rejected({ LZSS_FRAME_RAW, 1, 2, 3 }, 2));
+        REQUIRE_FALSE(rejected({ LZSS_FRAME_COMPRESSED, 0x02, 'A', 1, 10 }, 14));
+    }
+}
+
+TEST_CASE("Compressed transmissions reach the radio as LZSS frames", "[data_board][lzss]") {
+    mock_radio radio;
+    lzss_t lzss;
+
+    bytes_t input = telemetry_records(LZSS_MAX_INPUT, 5);
+    REQUIRE(lithium_send_compressed_transmit(&radio.radio, &lzss, input.data(), input.size()) == LITHIUM_NO_ERROR);
+
+    std::vector<lithium_packet_t> sent = radio.sent();
+    REQUIRE(sent.size() == 1);
+    const lithium_packet_t & packet = sent[0];
+    REQUIRE(packet.command == LITHIUM_COMMAND_TRANSMIT_DATA);
+    REQUIRE(packet.payload_length < input.size());
+    REQUIRE(decode(bytes_t(packet.payload, packet.payload + packet.payload_length)) == input);
+
+    bytes_t too_long(LZSS_MAX_INPUT + 1);
+    REQUIRE(lithium_send_compressed_transmit(&radio.radio, &lzss, too_long.data(), too_long.size()) == LITHIUM_INVALID_PACKET);
+}
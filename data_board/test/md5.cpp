@@ -0,0 +1,62 @@
+#include "md5.h"
+
+#include <catch/catch.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string hex(const uint8_t * digest) {
+        static const char DIGITS[] = "0123456789abcdef";
+        std::string text;
+        for (int i = 0; i < MD5_DIGEST_LENGTH; ++i) {
+            text += DIGITS[digest[i] >> 4];
+            text += DIGITS[digest[i] & 0xF];
+        }
+        return text;
+    }
+
+    std::string md5(const std::string & message) {
+        md5_ctx_t ctx;
+        md5_init(&ctx);
+        md5_update(&ctx, (const uint8_t *) message.data(), message.size());
+        uint8_t digest[MD5_DIGEST_LENGTH];
+        md5_final(&ctx, digest);
+        return hex(digest);
+    }
+}
+
+TEST_CASE("MD5 matches the RFC 1321 test suite", "[data_board][md5]") {
+    REQUIRE(md5("") == "d41d8cd98f00b204e9800998ecf8427e");
+    REQUIRE(md5("a") == "0cc175b9c0f1b6a831c399e269772661");
+    REQUIRE(md5("abc") == "900150983cd24fb0d6963f7d28e17f72");
+    REQUIRE(md5("message digest") == "f96b697d7cb7938d525a2f31aaf161d0");
+    REQUIRE(md5("abcdefghijklmnopqrstuvwxyz") == "c3fcd3d76192e4007dfb496cca67e13b");
+    REQUIRE(md5("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789") ==
+        "d174ab98d277d9f5a5611c2c9f419d9f");
+    REQUIRE(md5("12345678901234567890123456789012345678901234567890123456789012345678901234567890") ==
+        "57edf4a22be3c955ac49da2e2107b67a");
+}
+
+TEST_CASE("MD5 hashes can be built up in pieces", "[data_board][md5]") {
+    // Lengths either side of the block and padding boundaries
+    std::string message;
+    for (int i = 0; i < 200; ++i) {
+        message += (char) ('a' + i % 26);
+    }
+
+    for (size_t length : { 55, 56, 63, 64, 65, 119, 120, 128, 200 }) {
+        std::string expected = md5(message.substr(0, length));
+        for (size_t split = 0; split <= length; split += 7) {
+            INFO("length " << length << ", split " << split);
+            md5_ctx_t ctx;
+            md5_init(&ctx);
+            md5_update(&ctx, (const uint8_t *) message.data(), split);
+            md5_update(&ctx, (const uint8_t *) message.data() + split, length - split);
+            uint8_t digest[MD5_DIGEST_LENGTH];
+            md5_final(&ctx, digest);
+            REQUIRE(hex(digest) == expected);
+        }
+    }
+}
@@ -0,0 +1,264 @@
+#include "radio_manager.h"
+#include "lithium_test.hpp"
+
+#include <catch/catch.hpp>
+
+#include <vector>
+
+namespace {
+    struct completion {
+        lithium_command_t command;
+        lithium_result_t result;
+        std::vector<uint8_t> response;
+    };
+
+    struct fixture : mock_radio {
+        lithium_pool_t pool;
+        radio_manager_t manager;
+        std::vector<completion> completions;
+        std::vector<std::vector<uint8_t>> received;
+        /// Received packets held on to, like a downlink queue would
+        std::vector<lithium_handle_t> kept;
+        bool keep_received = false;
+
+        fixture() {
+            lithium_pool_init(&pool);
+            radio_manager_init(&manager, &radio, &pool, on_receive, this);
+        }
+
+        static void on_receive(lithium_handle_t handle, void * context) {
+            fixture * f = static_cast<fixture *>(context);
+            lithium_packet_t * packet = lithium_pool_get(&f->pool, handle);
+            f->received.emplace_back(packet->payload, packet->payload + packet->payload_length);
+            if (f->keep_received) {
+                lithium_pool_retain(&f->pool, handle);
+                f->kept.push_back(handle);
+            }
+        }
+
+        /// Queue a header-only command. The completion records the command
+        /// through its context.
+        bool submit(lithium_command_t command, uint32_t timeout = 10) {
+            lithium_handle_t handle = lithium_pool_acquire(&pool);
+            REQUIRE(handle != LITHIUM_HANDLE_NONE);
+            lithium_packet_t * packet = lithium_pool_get(&pool, handle);
+            packet->type = LITHIUM_I_MESSAGE;
+            packet->command = command;
+            packet->payload_length = 0;
+
+            radio_request_t request = { handle, timeout, on_complete, this };
+            if (!radio_manager_submit(&manager, &request)) {
+                lithium_pool_release(&pool, handle);
+                return false;
+            }
+            return true;
+        }
+
+        static void on_complete(lithium_result_t result, lithium_handle_t response, void * context) {
+            fixture * f = static_cast<fixture *>(context);
+            completion c = { LITHIUM_COMMAND_count, result, {} };
+            if (response != LITHIUM_HANDLE_NONE) {
+                lithium_packet_t * packet = lithium_pool_get(&f->pool, response);
+                c.command = packet->command;
+                if (!lithium_is_ack(packet) && !lithium_is_nack(packet)) {
+                    c.response.assign(packet->payload, packet->payload + packet->payload_length);
+                }
+            }
+            f->completions.push_back(c);
+        }
+
+        uint16_t feed(const std::vector<uint8_t> & bytes) {
+            return radio_manager_feed(&manager, bytes.data(), bytes.size());
+        }
+
+        /// The commands sent so far, read back out of the UART output
+        std::vector<lithium_command_t> sent() {
+            std::vector<lithium_command_t> commands;
+            std::vector<uint8_t> & output = written();
+            for (size_t i = 0; i + 8 <= output.size(); i += 8) {
+                commands.push_back((lithium_command_t) output[i + 3]);
+            }
+            return commands;
+        }
+    };
+
+    using commands_t = std::vector<lithium_command_t>;
+}
+
+TEST_CASE("The radio manager pipelines different commands", "[data_board][radio_manager]") {
+    fixture f;
+    REQUIRE(f.submit(LITHIUM_COMMAND_NO_OP));
+    REQUIRE(f.submit(LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG));
+    REQUIRE(f.completions.empty());
+    REQUIRE(f.sent().empty());
+
+    radio_manager_tick(&f.manager, 0);
+    REQUIRE(f.sent() == commands_t({ LITHIUM_COMMAND_NO_OP, LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG }));
+
+    // The responses come back in the other order
+    f.feed(lithium_o_message(LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG, 3, { 7, 8, 9 }));
+    f.feed(lithium_o_message(LITHIUM_COMMAND_NO_OP, ACK_LENGTH));
+
+    REQUIRE(f.completions.size() == 2);
+    REQUIRE(f.completions[0].command == LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG);
+    REQUIRE(f.completions[0].result == LITHIUM_NO_ERROR);
+    REQUIRE(f.completions[0].response == std::vector<uint8_t>({ 7, 8, 9 }));
+    REQUIRE(f.completions[1].command == LITHIUM_COMMAND_NO_OP);
+    REQUIRE(f.completions[1].result == LITHIUM_NO_ERROR);
+
+    REQUIRE(radio_manager_idle(&f.manager));
+    REQUIRE(f.manager.stats.sent == 2);
+    // Only the packet waiting for the next frame is still held
+    REQUIRE(lithium_pool_stats(&f.pool).in_use == 1);
+}
+
+TEST_CASE("The radio manager sends one of each command at a time", "[data_board][radio_manager]") {
+    fixture f;
+    REQUIRE(f.submit(LITHIUM_COMMAND_NO_OP));
+    REQUIRE(f.submit(LITHIUM_COMMAND_NO_OP));
+    REQUIRE(f.submit(LITHIUM_COMMAND_TELEMETRY_QUERY));
+
+    radio_manager_tick(&f.manager, 0);
+    REQUIRE(f.sent() == commands_t({ LITHIUM_COMMAND_NO_OP, LITHIUM_COMMAND_TELEMETRY_QUERY }));
+
+    f.feed(lithium_o_message(LITHIUM_COMMAND_NO_OP, NACK_LENGTH));
+    REQUIRE(f.completions.size() == 1);
+    REQUIRE(f.completions[0].result == LITHIUM_NACK);
+
+    radio_manager_tick(&f.manager, 1);
+    REQUIRE(f.sent() == commands_t({
+        LITHIUM_COMMAND_NO_OP, LITHIUM_COMMAND_TELEMETRY_QUERY, LITHIUM_COMMAND_NO_OP,
+    }));
+    REQUIRE_FALSE(radio_manager_idle(&f.manager));
+}
+
+TEST_CASE("The radio manager limits the commands in flight", "[data_board][radio_manager]") {
+    fixture f;
+    const commands_t commands = {
+        LITHIUM_COMMAND_NO_OP,
+        LITHIUM_COMMAND_GET_TRANSCEIVER_CONFIG,
+        LITHIUM_COMMAND_TELEMETRY_QUERY,
+        LITHIUM_COMMAND_READ_FIRMWARE_REVISION,
+        LITHIUM_COMMAND_RESET_SYSTEM,
+    };
+    REQUIRE(commands.size() > RADIO_MANAGER_MAX_IN_FLIGHT);
+    for (lithium_command_t command : commands) {
+        REQUIRE(f.submit(command));
+    }
+
+    radio_manager_tick(&f.manager, 0);
+    REQUIRE(f.sent() == commands_t(commands.begin(), commands.begin() + RADIO_MANAGER_MAX_IN_FLIGHT));
+
+    f.feed(lithium_o_message(LITHIUM_COMMAND_TELEMETRY_QUERY, ACK_LENGTH));
+    radio_manager_tick(&f.manager, 1);
+    REQUIRE(f.sent().back() == LITHIUM_COMMAND_RESET_SYSTEM);
+}
+
+TEST_CASE("The radio manager times out silent commands", "[data_board][radio_manager]") {
+    fixture f;
+    REQUIRE(f.submit(LITHIUM_COMMAND_NO_OP, 5));
+
+    SECTION("At the deadline") {
+        radio_manager_tick(&f.manager, 100);
+        radio_manager_tick(&f.manager, 104);
+        REQUIRE(f.completions.empty());
+
+        radio_manager_tick(&f.manager, 105);
+        REQUIRE(f.completions.size() == 1);
+        REQUIRE(f.completions[0].result == LITHIUM_TIMEOUT);
+        REQUIRE(f.manager.stats.timeouts == 1);
+
+        // A late response doesn't complete anything twice
+        f.feed(lithium_o_message(LITHIUM_COMMAND_NO_OP, ACK_LENGTH));
+        REQUIRE(f.completions.size() == 1);
+        REQUIRE(f.manager.stats.unmatched == 1);
+    }
+
+    SECTION("Across the clock wrapping") {
+        radio_manager_tick(&f.manager, UINT32_MAX - 1);
+        radio_manager_tick(&f.manager, 2);
+        REQUIRE(f.completions.empty());
+        radio_manager_tick(&f.manager, 3);
+        REQUIRE(f.completions.size() == 1);
+        REQUIRE(f.completions[0].result == LITHIUM_TIMEOUT);
+    }
+}
+
+TEST_CASE("The radio manager hands off received data", "[data_board][radio_manager]") {
+    fixture f;
+    REQUIRE(f.submit(LITHIUM_COMMAND_NO_OP));
+    radio_manager_tick(&f.manager, 0);
+
+    // Received data arrives between a command and its response, with some
+    // line noise for good measure
+    std::vector<uint8_t> stream = { 0x00 };
+    std::vector<uint8_t> data = lithium_o_message(LITHIUM_COMMAND_RECEIVE_DATA, 4, { 1, 2, 3, 4 });
+    std::vector<uint8_t> ack = lithium_o_message(LITHIUM_COMMAND_NO_OP, ACK_LENGTH);
+    stream.insert(stream.end(), data.begin(), data.end());
+    stream.insert(stream.end(), ack.begin(), ack.end());
+
+    // Byte by byte, like an interrupt handler would
+    for (uint8_t byte : stream) {
+        REQUIRE(radio_manager_feed(&f.manager, &byte, 1) == 1);
+    }
+
+    REQUIRE(f.received == std::vector<std::vector<uint8_t>>({ { 1, 2, 3, 4 } }));
+    REQUIRE(f.completions.size() == 1);
+    REQUIRE(f.completions[0].command == LITHIUM_COMMAND_NO_OP);
+    REQUIRE(f.manager.stats.unmatched == 0);
+}
+
+TEST_CASE("The radio manager copes with running out of room", "[data_board][radio_manager]") {
+    fixture f;
+
+    SECTION("The queue is full") {
+        // One packet queued many times over, so the pool doesn't run out
+        lithium_handle_t handle = lithium_pool_acquire(&f.pool);
+        lithium_pool_get(&f.pool, handle)->command = LITHIUM_COMMAND_NO_OP;
+        radio_request_t request = { handle, 10, NULL, NULL };
+        for (int i = 0; i < RADIO_MANAGER_QUEUE_LENGTH; ++i) {
+            REQUIRE(radio_manager_submit(&f.manager, &request));
+            lithium_pool_retain(&f.pool, handle);
+        }
+        REQUIRE_FALSE(radio_manager_submit(&f.manager, &request));
+        lithium_pool_release(&f.pool, handle);
+    }
+
+    SECTION("The pool is empty") {
+        // Everything but the manager's receive packet is held elsewhere
+        std::vector<lithium_handle_t> held;
+        lithium_handle_t handle;
+        while ((handle = lithium_pool_acquire(&f.pool)) != LITHIUM_HANDLE_NONE) {
+            held.push_back(handle);
+        }
+        f.keep_received = true;
+
+        // The first frame fits, and is kept, so the second has to wait
+        std::vector<uint8_t> stream = lithium_o_message(LITHIUM_COMMAND_RECEIVE_DATA, 1, { 1 });
+        std::vector<uint8_t> second = lithium_o_message(LITHIUM_COMMAND_RECEIVE_DATA, 1, { 2 });
+        size_t first_length = stream.size();
+        stream.insert(stream.end(), second.begin(), second.end());
+
+        REQUIRE(f.feed(stream) == first_length);
+        REQUIRE(f.received.size() == 1);
+        REQUIRE(lithium_pool_stats(&f.pool).exhausted == 2);
+
+        lithium_pool_release(&f.pool, f.kept[0]);
+        REQUIRE(radio_manager_feed(&f.manager, stream.data() + first_length, second.size()) == second.size());
+        REQUIRE(f.received == std::vector<std::vector<uint8_t>>({ { 1 }, { 2 } }));
+
+        for (lithium_handle_t h : held) {
+            lithium_pool_release(&f.pool, h);
+        }
+    }
+
+    SECTION("The radio can't be written to") {
+        REQUIRE(f.submit(LITHIUM_COMMAND_NO_OP));
+        uart_close(&f.radio.uart);
+        radio_manager_tick(&f.manager, 0);
+
+        REQUIRE(f.completions.size() == 1);
+        REQUIRE(f.completions[0].result == LITHIUM_BAD_COMMUNICATION);
+        REQUIRE(radio_manager_idle(&f.manager));
+    }
+}
@@ -0,0 +1,159 @@
+#include "reed_solomon.h"
+#include "lithium_test.hpp"
+
+#include <catch/catch.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+    typedef std::vector<uint8_t> bytes_t;
+
+    /// Multiply in GF(2^8) the long way, without the tables under test
+    uint8_t slow_mul(uint8_t a, uint8_t b) {
+        uint8_t product = 0;
+        while (b != 0) {
+            if (b & 1) {
+                product ^= a;
+            }
+            a = (a << 1) ^ ((a & 0x80) ? 0x1d : 0);
+            b >>= 1;
+        }
+        return product;
+    }
+
+    /// Check a block vanishes at every root of the generator
+    bool is_codeword(const bytes_t & block) {
+        uint8_t root = 1;
+        for (int j = 0; j < RS_PARITY_LENGTH; ++j) {
+            uint8_t value = 0;
+            for (uint8_t byte : block) {
+                value = slow_mul(value, root) ^ byte;
+            }
+            if (value != 0) {
+                return false;
+            }
+            root = slow_mul(root, 2);
+        }
+        return true;
+    }
+
+    bytes_t random_bytes(size_t length, std::mt19937 & rng) {
+        bytes_t bytes(length);
+        for (auto & byte : bytes) {
+            byte = rng();
+        }
+        return bytes;
+    }
+
+    bytes_t encode(const bytes_t & data) {
+        bytes_t block(data);
+        block.resize(data.size() + RS_PARITY_LENGTH);
+        rs_encode(data.data(), data.size(), block.data() + data.size());
+        return block;
+    }
+
+    /// Corrupt count distinct bytes of a block
+    void corrupt(bytes_t & block, size_t count, std::mt19937 & rng) {
+        std::vector<size_t> positions(block.size());
+        for (size_t i = 0; i < positions.size(); ++i) {
+            positions[i] = i;
+        }
+        std::shuffle(positions.begin(), positions.end(), rng);
+        std::uniform_int_distribution<int> flips(1, 255);
+        for (size_t i = 0; i < count; ++i) {
+            block[positions[i]] ^= flips(rng);
+        }
+    }
+}
+
+TEST_CASE("Reed-Solomon blocks are codewords", "[data_board][reed_solomon]") {
+    std::mt19937 rng(1);
+    for (size_t length : { 1, 2, 17, 100, 222, RS_MAX_DATA_LENGTH }) {
+        INFO("length " << length);
+        bytes_t data = random_bytes(length, rng);
+        bytes_t block = encode(data);
+        REQUIRE(is_codeword(block));
+        REQUIRE(std::equal(data.begin(), data.end(), block.begin()));
+
+        REQUIRE(rs_decode(block.data(), block.size()) == 0);
+        REQUIRE(block == encode(data));
+    }
+
+    SECTION("All zero data has all zero parity") {
+        REQUIRE(encode(bytes_t(50)) == bytes_t(50 + RS_PARITY_LENGTH));
+    }
+}
+
+TEST_CASE("Reed-Solomon corrects up to half as many errors as parity bytes", "[data_board][reed_solomon]") {
+    std::mt19937 rng(2);
+    for (size_t length : { 1, 40, RS_MAX_DATA_LENGTH }) {
+        for (size_t errors = 1; errors <= RS_PARITY_LENGTH / 2; ++errors) {
+            for (int trial = 0; trial < 4; ++trial) {
+                INFO("length " << length << ", " << errors << " errors, trial " << trial);
+                bytes_t original = encode(random_bytes(length, rng));
+                bytes_t block = original;
+                corrupt(block, errors, rng);
+
+                REQUIRE(rs_decode(block.data(), block.size()) == (int16_t) errors);
+                REQUIRE(block == original);
+            }
+        }
+    }
+
+    SECTION("Errors in the parity bytes") {
+        bytes_t original = encode(random_bytes(10, rng));
+        bytes_t block = original;
+        for (size_t i = 10; i < block.size(); i += 2) {
+            block[i] ^= 0xFF;
+        }
+        REQUIRE(rs_decode(block.data(), block.size()) == RS_PARITY_LENGTH / 2);
+        REQUIRE(block == original);
+    }
+}
+
+TEST_CASE("Reed-Solomon leaves blocks it can't correct alone", "[data_board][reed_solomon]") {
+    std::mt19937 rng(3);
+
+    SECTION("Too many errors") {
+        for (int trial = 0; trial < 50; ++trial) {
+            INFO("trial " << trial);
+            bytes_t block = encode(random_bytes(RS_MAX_DATA_LENGTH, rng));
+            corrupt(block, RS_PARITY_LENGTH / 2 + 1 + trial % 8, rng);
+            bytes_t corrupted = block;
+
+            REQUIRE(rs_decode(block.data(), block.size()) == -1);
+            REQUIRE(block == corrupted);
+        }
+    }
+
+    SECTION("Blocks of the wrong length") {
+        bytes_t block(RS_MAX_BLOCK_LENGTH + 1);
+        REQUIRE(rs_decode(block.data(), RS_PARITY_LENGTH) == -1);
+        REQUIRE(rs_decode(block.data(), block.size()) == -1);
+    }
+}
+
+TEST_CASE("Protected transmissions carry correctable payloads", "[data_board][reed_solomon]") {
+    mock_radio radio;
+
+    std::mt19937 rng(4);
+    bytes_t data = random_bytes(RS_MAX_DATA_LENGTH, rng);
+    REQUIRE(lithium_send_protected_transmit(&radio.radio, data.data(), data.size()) == LITHIUM_NO_ERROR);
+
+    std::vector<lithium_packet_t> sent = radio.sent();
+    REQUIRE(sent.size() == 1);
+    const lithium_packet_t & packet = sent[0];
+    REQUIRE(packet.command == LITHIUM_COMMAND_TRANSMIT_DATA);
+    REQUIRE(packet.payload_length == 255);
+
+    // As if the frame was hit on its way down
+    bytes_t block(packet.payload, packet.payload + packet.payload_length);
+    corrupt(block, 12, rng);
+    REQUIRE(rs_decode(block.data(), block.size()) == 12);
+    REQUIRE(bytes_t(block.begin(), block.begin() + data.size()) == data);
+
+    bytes_t too_long(RS_MAX_DATA_LENGTH + 1);
+    REQUIRE(lithium_send_protected_transmit(&radio.radio, too_long.data(), too_long.size()) == LITHIUM_INVALID_PACKET);
+}
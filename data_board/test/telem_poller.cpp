@@ -0,0 +1,215 @@
+#include "telem_poller.h"
+#include "lithium_wire.h"
+#include "lithium_test.hpp"
+
+#include <catch/catch.hpp>
+
+#include <vector>
+
+namespace {
+    lithium_telem_t telem(uint8_t rssi, int16_t temp, uint32_t received, uint32_t transmitted) {
+        lithium_telem_t t = {};
+        t.op_counter = 1;
+        t.msp430_temp = temp;
+        t.rssi = rssi;
+        t.bytes_received = received;
+        t.bytes_transmitted = transmitted;
+        return t;
+    }
+
+    struct fixture : mock_radio {
+        lithium_pool_t pool;
+        radio_manager_t manager;
+        telem_poller_t poller;
+        bool refuse = false;
+
+        fixture(uint32_t period = 100) {
+            lithium_pool_init(&pool);
+            radio_manager_init(&manager, &radio, &pool, nullptr, nullptr);
+            telem_poller_init(&poller, &pool, period, submit, this);
+        }
+
+        static bool submit(const radio_request_t * request, void * context) {
+            fixture * f = static_cast<fixture *>(context);
+            return !f->refuse && radio_manager_submit(&f->manager, request);
+        }
+
+        /// Run the poller and the manager, as the radio task would
+        void tick(uint32_t now) {
+            telem_poller_tick(&poller, now);
+            radio_manager_tick(&manager, now);
+        }
+
+        /// The number of queries sent so far
+        size_t queries() {
+            return written().size() / 8;
+        }
+
+        void reply(const lithium_telem_t & t) {
+            std::vector<uint8_t> payload(LITHIUM_TELEM_WIRE_LENGTH);
+            lithium_encode_telem(&t, payload.data());
+            feed(lithium_o_message(LITHIUM_COMMAND_TELEMETRY_QUERY, payload.size(), payload));
+        }
+
+        void feed(const std::vector<uint8_t> & frame) {
+            REQUIRE(radio_manager_feed(&manager, frame.data(), frame.size()) == frame.size());
+        }
+
+        /// Poll at now and answer straight away
+        void poll(uint32_t now, const lithium_telem_t & t) {
+            size_t sent = queries();
+            tick(now);
+            REQUIRE(queries() == sent + 1);
+            reply(t);
+        }
+    };
+}
+
+TEST_CASE("Telemetry is read from the latest reply", "[data_board][telem_poller]") {
+    fixture f;
+    lithium_telem_t t;
+    uint32_t age;
+
+    REQUIRE_FALSE(telem_poller_latest(&f.poller, 0, &t, &age));
+    REQUIRE(age == UINT32_MAX);
+
+    f.poll(1000, telem(42, -15, 300, 200));
+    REQUIRE(telem_poller_latest(&f.poller, 1050, &t, &age));
+    REQUIRE(age == 50);
+    REQUIRE(t.rssi == 42);
+    REQUIRE(t.msp430_temp == -15);
+    REQUIRE(t.bytes_received == 300);
+    REQUIRE(t.bytes_transmitted == 200);
+
+    // Reading never touches the radio
+    size_t sent = f.queries();
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(telem_poller_latest(&f.poller, 1050, &t, nullptr));
+    }
+    REQUIRE(f.queries() == sent);
+
+    SECTION("Replies go stale after the TTL") {
+        REQUIRE(telem_poller_latest(&f.poller, 1200, &t, &age));
+        REQUIRE_FALSE(telem_poller_latest(&f.poller, 1201, &t, &age));
+        REQUIRE(age == 201);
+        // Stale telemetry is still handed out
+        REQUIRE(t.rssi == 42);
+
+        telem_poller_set_ttl(&f.poller, 500);
+        REQUIRE(telem_poller_latest(&f.poller, 1201, &t, &age));
+    }
+
+    SECTION("A failed poll leaves the last reply in place") {
+        f.tick(1100);
+        f.feed(lithium_o_message(LITHIUM_COMMAND_TELEMETRY_QUERY, NACK_LENGTH));
+        REQUIRE(telem_poller_latest(&f.poller, 1150, &t, &age));
+        REQUIRE(age == 150);
+
+        telem_stats_t stats;
+        telem_poller_stats(&f.poller, &stats);
+        REQUIRE(stats.failures == 1);
+    }
+}
+
+TEST_CASE("Telemetry queries are rate limited", "[data_board][telem_poller]") {
+    fixture f(100);
+
+    f.tick(0);
+    REQUIRE(f.queries() == 1);
+
+    SECTION("Never more than one in flight") {
+        // Timed out after a period, but not due again until then either
+        f.tick(99);
+        REQUIRE(f.queries() == 1);
+        f.tick(100);
+        f.tick(100);
+        REQUIRE(f.queries() == 2);
+
+        telem_stats_t stats;
+        telem_poller_stats(&f.poller, &stats);
+        REQUIRE(stats.failures == 1);
+    }
+
+    SECTION("Late ticks don't catch up") {
+        f.reply(telem(1, 1, 1, 1));
+        f.tick(550);
+        REQUIRE(f.queries() == 2);
+        f.reply(telem(1, 1, 1, 1));
+        f.tick(600);
+        f.tick(649);
+        REQUIRE(f.queries() == 2);
+        f.tick(650);
+        REQUIRE(f.queries() == 3);
+    }
+
+    SECTION("A refused query is tried again on the next tick") {
+        f.reply(telem(1, 1, 1, 1));
+        f.refuse = true;
+        f.tick(100);
+        REQUIRE(f.queries() == 1);
+        REQUIRE(lithium_pool_stats(&f.pool).in_use <= 1);
+        f.refuse = false;
+        f.tick(101);
+        REQUIRE(f.queries() == 2);
+    }
+
+    SECTION("Across the clock wrapping") {
+        fixture g(100);
+        g.poller.next_poll = UINT32_MAX - 10;
+        g.tick(UINT32_MAX - 10);
+        g.reply(telem(1, 1, 1, 1));
+        g.tick(88);
+        REQUIRE(g.queries() == 1);
+        g.tick(89);
+        REQUIRE(g.queries() == 2);
+    }
+}
+
+TEST_CASE("Telemetry statistics run over every reply", "[data_board][telem_poller]") {
+    fixture f(10);
+    f.poll(0, telem(10, 250, 1000, 500));
+    f.poll(10, telem(30, 260, 1150, 520));
+    f.poll(20, telem(20, -30, 1400, 540));
+
+    telem_stats_t stats;
+    telem_poller_stats(&f.poller, &stats);
+    REQUIRE(stats.rssi.count == 3);
+    REQUIRE(stats.rssi.min == 10);
+    REQUIRE(stats.rssi.max == 30);
+    REQUIRE(telem_stat_mean(&stats.rssi) == 20);
+    REQUIRE(stats.msp430_temp.min == -30);
+    REQUIRE(stats.msp430_temp.max == 260);
+    REQUIRE(telem_stat_mean(&stats.msp430_temp) == 160);
+
+    // The counters are sampled as the change between polls
+    REQUIRE(stats.bytes_received.count == 2);
+    REQUIRE(stats.bytes_received.min == 150);
+    REQUIRE(stats.bytes_received.max == 250);
+    REQUIRE(stats.bytes_received.sum == 400);
+    REQUIRE(stats.bytes_transmitted.sum == 40);
+    REQUIRE(stats.restarts == 0);
+
+    SECTION("A radio that restarted counts from zero") {
+        f.poll(30, telem(20, 20, 70, 5));
+        telem_poller_stats(&f.poller, &stats);
+        REQUIRE(stats.restarts == 1);
+        REQUIRE(stats.bytes_received.min == 70);
+        REQUIRE(stats.bytes_received.sum == 470);
+        REQUIRE(stats.bytes_transmitted.min == 5);
+    }
+
+    SECTION("Counters near their limit") {
+        fixture g(10);
+        g.poll(0, telem(1, 1, UINT32_MAX - 9, 0));
+        g.poll(10, telem(1, 1, UINT32_MAX, 0));
+        telem_poller_stats(&g.poller, &stats);
+        REQUIRE(stats.bytes_received.sum == 9);
+    }
+
+    SECTION("Nothing to average") {
+        telem_stat_t empty = {};
+        REQUIRE(telem_stat_mean(&empty) == 0);
+    }
+
+    REQUIRE(lithium_pool_stats(&f.pool).in_use <= 1);
+}
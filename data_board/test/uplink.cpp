@@ -0,0 +1,209 @@
+#include "uplink.h"
+
+#include <catch/catch.hpp>
+
+#include <vector>
+
+namespace {
+    struct call {
+        uplink_command_t command;
+        const uint8_t * arguments;
+        uint8_t length;
+    };
+
+    std::vector<call> calls;
+
+    template<uplink_command_t C>
+    void record(const uint8_t * arguments, uint8_t length, void * context) {
+        calls.push_back({ C, arguments, length });
+        (void) context;
+    }
+
+    const uplink_handler_t HANDLERS[UPLINK_COMMAND_count] = {
+#       define HANDLER_OP(E, OPCODE, MIN, MAX, PRIORITY) record<UPLINK_COMMAND_ ## E>,
+        UPLINK_COMMAND_LIST(HANDLER_OP)
+#       undef HANDLER_OP
+    };
+
+    const uint8_t OPCODES[UPLINK_COMMAND_count] = {
+#       define OPCODE_OP(E, OPCODE, MIN, MAX, PRIORITY) OPCODE,
+        UPLINK_COMMAND_LIST(OPCODE_OP)
+#       undef OPCODE_OP
+    };
+
+    struct fixture {
+        lithium_pool_t pool;
+        uplink_t uplink;
+
+        fixture(const uplink_handler_t * handlers = HANDLERS) {
+            calls.clear();
+            lithium_pool_init(&pool);
+            uplink_init(&uplink, &pool, handlers, this);
+        }
+
+        /// Receive a payload and dispatch it, releasing the receive path's
+        /// reference afterwards like the radio manager does
+        uplink_result_t receive(const std::vector<uint8_t> & payload, const uint8_t ** arguments = nullptr) {
+            lithium_handle_t handle = lithium_pool_acquire(&pool);
+            REQUIRE(handle != LITHIUM_HANDLE_NONE);
+            lithium_packet_t * packet = lithium_pool_get(&pool, handle);
+            packet->type = LITHIUM_O_MESSAGE;
+            packet->command = LITHIUM_COMMAND_RECEIVE_DATA;
+            packet->payload_length = payload.size();
+            std::copy(payload.begin(), payload.end(), packet->payload);
+            if (arguments) {
+                *arguments = packet->payload + 1;
+            }
+
+            uplink_result_t result = uplink_dispatch(&uplink, handle);
+            lithium_pool_release(&pool, handle);
+            return result;
+        }
+
+        /// A payload for a command with arguments of the given length
+        static std::vector<uint8_t> command(uint8_t opcode, size_t length) {
+            std::vector<uint8_t> payload(1 + length, 0xA5);
+            payload[0] = opcode;
+            return payload;
+        }
+    };
+}
+
+TEST_CASE("Every opcode is routed to its command or refused", "[data_board][uplink]") {
+    fixture f;
+    size_t registered = 0;
+
+    for (int opcode = 0; opcode <= 0xFF; ++opcode) {
+        INFO("opcode " << opcode);
+        const uplink_spec_t * spec = uplink_lookup(opcode);
+        if (spec == nullptr) {
+            REQUIRE(f.receive(fixture::command(opcode, 0)) == UPLINK_UNKNOWN_COMMAND);
+            REQUIRE(f.receive(fixture::command(opcode, 10)) == UPLINK_UNKNOWN_COMMAND);
+            REQUIRE(calls.empty());
+            continue;
+        }
+
+        ++registered;
+        REQUIRE(spec->opcode == opcode);
+        REQUIRE(spec->min_length <= spec->max_length);
+        REQUIRE(spec->max_length <= 254);
+
+        REQUIRE(f.receive(fixture::command(opcode, spec->min_length)) == UPLINK_NO_ERROR);
+        uplink_run(&f.uplink);
+        REQUIRE(calls.size() == 1);
+        REQUIRE(OPCODES[calls[0].command] == opcode);
+        calls.clear();
+    }
+
+    // Every registered command owns a distinct opcode
+    REQUIRE(registered == UPLINK_COMMAND_count);
+    REQUIRE(f.uplink.stats.dispatched == UPLINK_COMMAND_count);
+    REQUIRE(lithium_pool_stats(&f.pool).in_use == 0);
+}
+
+TEST_CASE("Uplink commands are refused outside their argument lengths", "[data_board][uplink]") {
+    fixture f;
+
+    for (int command = 0; command < UPLINK_COMMAND_count; ++command) {
+        const uplink_spec_t * spec = uplink_lookup(OPCODES[command]);
+        REQUIRE(spec != nullptr);
+
+        for (size_t length = 0; length <= 254; ++length) {
+            INFO("command " << command << ", length " << length);
+            bool fits = length >= spec->min_length && length <= spec->max_length;
+            const uint8_t * arguments;
+            REQUIRE(f.receive(fixture::command(spec->opcode, length), &arguments) == (fits ? UPLINK_NO_ERROR : UPLINK_BAD_LENGTH));
+            uplink_run(&f.uplink);
+
+            if (fits) {
+                // Handed the arguments in place
+                REQUIRE(calls.size() == 1);
+                REQUIRE(calls[0].arguments == arguments);
+                REQUIRE(calls[0].length == length);
+            }
+            else {
+                REQUIRE(calls.empty());
+            }
+            calls.clear();
+        }
+    }
+    REQUIRE(lithium_pool_stats(&f.pool).in_use == 0);
+}
+
+TEST_CASE("Uplink commands run in priority order", "[data_board][uplink]") {
+    fixture f;
+
+    SECTION("Immediate commands run on the receive path") {
+        REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_RADIO_RESET, 0)) == UPLINK_NO_ERROR);
+        REQUIRE(calls.size() == 1);
+        REQUIRE(calls[0].command == UPLINK_COMMAND_RADIO_RESET);
+        REQUIRE(uplink_run(&f.uplink) == 0);
+    }
+
+    SECTION("As the radio manager's receive callback") {
+        lithium_handle_t handle = lithium_pool_acquire(&f.pool);
+        lithium_packet_t * packet = lithium_pool_get(&f.pool, handle);
+        packet->payload_length = 1;
+        packet->payload[0] = UPLINK_OPCODE_RADIO_RESET;
+        uplink_receive(handle, &f.uplink);
+        lithium_pool_release(&f.pool, handle);
+        REQUIRE(calls.size() == 1);
+    }
+
+    SECTION("More urgent commands jump the queue") {
+        REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_TELEMETRY_DUMP, 0)) == UPLINK_NO_ERROR);
+        REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_CODE_UPLOAD, 3)) == UPLINK_NO_ERROR);
+        REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_PING_RETURN, 0)) == UPLINK_NO_ERROR);
+        REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_PIN_TOGGLE, 1)) == UPLINK_NO_ERROR);
+        REQUIRE(calls.empty());
+
+        // Queued packets are held until they have run
+        REQUIRE(lithium_pool_stats(&f.pool).in_use == 4);
+        REQUIRE(uplink_run(&f.uplink) == 4);
+        REQUIRE(lithium_pool_stats(&f.pool).in_use == 0);
+
+        std::vector<uplink_command_t> order;
+        for (const auto & c : calls) {
+            order.push_back(c.command);
+        }
+        REQUIRE(order == std::vector<uplink_command_t>({
+            UPLINK_COMMAND_PING_RETURN,
+            UPLINK_COMMAND_PIN_TOGGLE,
+            UPLINK_COMMAND_TELEMETRY_DUMP,
+            UPLINK_COMMAND_CODE_UPLOAD,
+        }));
+    }
+
+    SECTION("A full queue refuses more of its priority only") {
+        for (int i = 0; i < UPLINK_QUEUE_LENGTH; ++i) {
+            REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_TELEMETRY_DUMP, 0)) == UPLINK_NO_ERROR);
+        }
+        REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_TELEMETRY_DUMP, 0)) == UPLINK_QUEUE_FULL);
+        REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_PING_RETURN, 0)) == UPLINK_NO_ERROR);
+        REQUIRE(f.uplink.stats.rejected == 1);
+
+        REQUIRE(uplink_run(&f.uplink) == UPLINK_QUEUE_LENGTH + 1);
+        REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_TELEMETRY_DUMP, 0)) == UPLINK_NO_ERROR);
+        REQUIRE(uplink_run(&f.uplink) == 1);
+    }
+}
+
+TEST_CASE("Uplink payloads without a command are refused", "[data_board][uplink]") {
+    SECTION("An empty payload") {
+        fixture f;
+        REQUIRE(f.receive({}) == UPLINK_EMPTY);
+        REQUIRE(uplink_dispatch(&f.uplink, LITHIUM_HANDLE_NONE) == UPLINK_EMPTY);
+        REQUIRE(f.uplink.stats.rejected == 2);
+    }
+
+    SECTION("A command without a handler") {
+        uplink_handler_t handlers[UPLINK_COMMAND_count] = {};
+        handlers[UPLINK_COMMAND_PING_RETURN] = record<UPLINK_COMMAND_PING_RETURN>;
+        fixture f(handlers);
+
+        REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_PIN_TOGGLE, 1)) == UPLINK_NO_HANDLER);
+        REQUIRE(f.receive(fixture::command(UPLINK_OPCODE_PING_RETURN, 1)) == UPLINK_NO_ERROR);
+        REQUIRE(uplink_run(&f.uplink) == 1);
+        REQUIRE(lithium_pool_stats(&f.pool).in_use == 0);
+    }
+}
@@ -0,0 +1,191 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "uart.h"
+#include "dev_tasks.h"
+#include "register_file.h"
+
+/*
+ * Runs the development board's task set as a Linux process, on the Posix
+ * port, for a set time. The board's UART goes to standard output or a file
+ * given on the command line, such as a pty. Afterwards a profile of the run
+ * goes to standard error: run time and context switches per task, every
+ * change each task made to the GPIO registers, and how often tasks blocked
+ * on a queue.
+ *
+ * usage: dev_board_host [seconds] [uart device]
+ */
+
+/******************************************************************************\
+ *  Static variables                                                          *
+\******************************************************************************/
+
+/// Standard UART output
+static uart_t standard_output;
+
+/// Ends the run
+static TimerHandle_t end_timer;
+static StaticTimer_t end_timer_buffer;
+
+/// The most tasks the profile has room for
+#define MAX_PROFILED_TASKS 8
+
+/// The tasks as the run ended, taken from the timer task before it ends the
+/// scheduler
+static TaskStatus_t task_status[MAX_PROFILED_TASKS];
+static UBaseType_t task_count;
+static uint32_t total_run_time;
+
+/// Context switches away from each task, by handle
+static struct {
+    TaskHandle_t task;
+    uint32_t count;
+} switches[MAX_PROFILED_TASKS];
+
+/// Times a task blocked to send to or receive from a queue
+static uint32_t queue_send_blocks;
+static uint32_t queue_receive_blocks;
+
+/******************************************************************************\
+ *  Private functions                                                         *
+\******************************************************************************/
+/// Timer callback that takes the profile and stops the scheduler
+static void end_run(TimerHandle_t timer);
+
+/// Write the profile to standard error
+static void report(void);
+
+/// Context switches counted for a task
+static uint32_t switch_count(TaskHandle_t task);
+
+/* Hooks the host configuration of FreeRTOS calls out to. */
+void vApplicationTaskSwitchedOut( void );
+void vApplicationQueueBlocked( void *pvQueue, long xSending );
+void vAssertCalled( const char *pcFile, unsigned long ulLine );
+
+/******************************************************************************\
+ *  Function implementations                                                  *
+\******************************************************************************/
+int main(int argc, char ** argv) {
+    double seconds = argc > 1 ? strtod(argv[1], NULL) : 5;
+    // The channel takes over its descriptor, so standard output goes through
+    // a copy
+    int fd = argc > 2 ? open(argv[2], O_RDWR | O_NOCTTY) : dup(STDOUT_FILENO);
+    if (fd < 0) {
+        perror(argc > 2 ? argv[2] : "dup");
+        return 1;
+    }
+
+    TickType_t ticks = (TickType_t) (seconds * configTICK_RATE_HZ);
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    if (!uart_open_fd(&standard_output, fd, 9600)) {
+        fprintf(stderr, "can't run the UART at 9600 baud\n");
+        return 1;
+    }
+
+    dev_tasks_start(&standard_output);
+
+    end_timer = xTimerCreateStatic("end_run", ticks, pdFALSE, NULL, end_run, &end_timer_buffer);
+    xTimerStart(end_timer, 0);
+
+    uart_write_string(&standard_output, "Tasks initialized, starting scheduler\n");
+
+    vTaskStartScheduler();
+
+    // Send whatever is still batched
+    uart_close(&standard_output);
+    report();
+
+    // A run where nothing was scheduled or nothing touched a pin means the
+    // port is broken
+    const register_change_t * changes;
+    return task_count > 0 && register_file_log(&changes, NULL) > 0 ? 0 : 1;
+}
+
+static void end_run(TimerHandle_t timer) {
+    (void) timer;
+    task_count = uxTaskGetSystemState(task_status, MAX_PROFILED_TASKS, &total_run_time);
+    vTaskEndScheduler();
+}
+
+static void report(void) {
+    // Stack high water marks mean nothing here, since each task runs on its
+    // thread's stack rather than the one it was given
+    fprintf(stderr, "\n%-22s %4s %12s %6s %9s\n", "task", "prio", "run us", "run %", "switches");
+    for (UBaseType_t i = 0; i < task_count; ++i) {
+        const TaskStatus_t * status = &task_status[i];
+        fprintf(stderr, "%-22s %4lu %12lu %6.1f %9lu\n",
+            status->pcTaskName,
+            (unsigned long) status->uxCurrentPriority,
+            (unsigned long) status->ulRunTimeCounter,
+            total_run_time ? 100.0 * status->ulRunTimeCounter / total_run_time : 0.0,
+            (unsigned long) switch_count(status->xHandle));
+    }
+
+    const register_change_t * changes;
+    uint32_t dropped;
+    size_t count = register_file_log(&changes, &dropped);
+    fprintf(stderr, "\n%6s %-22s %-6s %6s %6s\n", "tick", "task", "reg", "before", "after");
+    for (size_t i = 0; i < count; ++i) {
+        fprintf(stderr, "%6lu %-22s %-6s 0x%04x 0x%04x\n",
+            (unsigned long) changes[i].tick,
+            changes[i].task,
+            register_name(changes[i].reg),
+            changes[i].before,
+            changes[i].after);
+    }
+    if (dropped) {
+        fprintf(stderr, "%lu more changes not logged\n", (unsigned long) dropped);
+    }
+
+    fprintf(stderr, "\nqueue blocks: %lu sending, %lu receiving\n",
+        (unsigned long) queue_send_blocks,
+        (unsigned long) queue_receive_blocks);
+}
+
+static uint32_t switch_count(TaskHandle_t task) {
+    for (int i = 0; i < MAX_PROFILED_TASKS; ++i) {
+        if (switches[i].task == task) {
+            return switches[i].count;
+        }
+    }
+    return 0;
+}
+
+void vApplicationTaskSwitchedOut( void ) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    register_file_check(xTaskGetTickCountFromISR(), pcTaskGetName(task));
+
+    for (int i = 0; i < MAX_PROFILED_TASKS; ++i) {
+        if (switches[i].task == task || switches[i].task == NULL) {
+            switches[i].task = task;
+            ++switches[i].count;
+            break;
+        }
+    }
+}
+
+void vApplicationQueueBlocked( void *pvQueue, long xSending ) {
+    (void) pvQueue;
+    if (xSending) {
+        ++queue_send_blocks;
+    }
+    else {
+        ++queue_receive_blocks;
+    }
+}
+
+void vAssertCalled( const char *pcFile, unsigned long ulLine ) {
+    fprintf(stderr, "FreeRTOS assertion failed at %s:%lu\n", pcFile, ulLine);
+    abort();
+}
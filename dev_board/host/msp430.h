@@ -0,0 +1,16 @@
+#ifndef _DEV_BOARD_HOST_MSP430_H_
+#define _DEV_BOARD_HOST_MSP430_H_
+
+/*
+ * Takes the place of the device header when the development board's tasks
+ * run as a host process. Registers are slots in the virtual register file.
+ */
+#include "register_file.h"
+
+#define P1OUT register_file[REGISTER_P1OUT]
+#define P2OUT register_file[REGISTER_P2OUT]
+#define P3OUT register_file[REGISTER_P3OUT]
+#define P4OUT register_file[REGISTER_P4OUT]
+#define PJOUT register_file[REGISTER_PJOUT]
+
+#endif // _DEV_BOARD_HOST_MSP430_H_
@@ -0,0 +1,57 @@
+#include "register_file.h"
+
+/******************************************************************************\
+ *  Static variables                                                          *
+\******************************************************************************/
+volatile uint16_t register_file[REGISTER_count];
+
+/// The registers at the last check
+static uint16_t snapshot[REGISTER_count];
+
+/// The changes seen so far
+static register_change_t changes_log[REGISTER_FILE_LOG_LENGTH];
+static size_t log_length;
+static uint32_t log_dropped;
+
+/******************************************************************************\
+ *  Public interface implementations                                          *
+\******************************************************************************/
+void register_file_check(uint32_t tick, const char * task) {
+    for (int reg = 0; reg < REGISTER_count; ++reg) {
+        uint16_t value = register_file[reg];
+        if (value == snapshot[reg]) {
+            continue;
+        }
+
+        if (log_length < REGISTER_FILE_LOG_LENGTH) {
+            register_change_t * change = &changes_log[log_length++];
+            change->tick = tick;
+            change->task = task;
+            change->reg = (register_id_t) reg;
+            change->before = snapshot[reg];
+            change->after = value;
+        }
+        else {
+            ++log_dropped;
+        }
+        snapshot[reg] = value;
+    }
+}
+
+size_t register_file_log(const register_change_t ** changes, uint32_t * dropped) {
+    *changes = changes_log;
+    if (dropped) {
+        *dropped = log_dropped;
+    }
+    return log_length;
+}
+
+const char * register_name(register_id_t reg) {
+    switch (reg) {
+#       define STRING_OP(R) case REGISTER_ ## R: return #R;
+        REGISTER_LIST(STRING_OP)
+#       undef STRING_OP
+        default:
+            return "unknown register";
+    }
+}
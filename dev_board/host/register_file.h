@@ -0,0 +1,92 @@
+#ifndef _DEV_BOARD_HOST_REGISTER_FILE_H_
+#define _DEV_BOARD_HOST_REGISTER_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup register_file Virtual register file
+ *  Stand-ins for the MSP430 registers the development board's tasks write,
+ *  for running the task set as a host process. The msp430.h next to this
+ *  maps each register's name to its slot here.
+ *
+ *  The file is checked each time a task is switched out, and every register
+ *  that changed since the last check is logged against that task. Several
+ *  writes between two switches show up as one change.
+ *  @{
+ */
+
+/******************************************************************************\
+ *  Macro list of the registers                                               *
+\******************************************************************************/
+/// The registers that are backed by the file
+#define REGISTER_LIST(OP) \
+    OP(P1OUT) \
+    OP(P2OUT) \
+    OP(P3OUT) \
+    OP(P4OUT) \
+    OP(PJOUT)
+
+typedef enum register_id {
+#   define ENUM_OP(R) REGISTER_ ## R,
+    REGISTER_LIST(ENUM_OP)
+#   undef ENUM_OP
+    REGISTER_count
+} register_id_t;
+
+/// Changes kept before more are only counted
+#define REGISTER_FILE_LOG_LENGTH 1024
+
+/// One register changing while a task ran
+typedef struct register_change {
+    /// The tick count when the task was switched out
+    uint32_t tick;
+    /// The name of the task
+    const char * task;
+    /// The register that changed
+    register_id_t reg;
+    /// The value at the previous check
+    uint16_t before;
+    /// The value when the task was switched out
+    uint16_t after;
+} register_change_t;
+
+/**
+ * The registers. Everything starts at zero.
+ */
+extern volatile uint16_t register_file[REGISTER_count];
+
+/**
+ * Log the registers that changed since the last check. Called as a task is
+ * switched out, with the tick blocked.
+ *
+ * @param tick The current tick count
+ * @param task The name of the task being switched out
+ */
+void register_file_check(uint32_t tick, const char * task);
+
+/**
+ * Get the log of changes, oldest first
+ *
+ * @param changes Set to the first change in the log
+ * @param dropped If not NULL, set to the number of changes that didn't fit
+ *      in the log
+ * @return The number of changes in the log
+ */
+size_t register_file_log(const register_change_t ** changes, uint32_t * dropped);
+
+/**
+ * Get the name of a register
+ */
+const char * register_name(register_id_t reg);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _DEV_BOARD_HOST_REGISTER_FILE_H_
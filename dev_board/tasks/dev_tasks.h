@@ -0,0 +1,31 @@
+#ifndef _DEV_BOARD_TASKS_DEV_TASKS_H_
+#define _DEV_BOARD_TASKS_DEV_TASKS_H_
+
+#include "uart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup dev_tasks Development board task set
+ *  The tasks the development board runs, separate from the hardware bring-up
+ *  so the same set can run on target or, through the Posix port, as a host
+ *  process.
+ *  @{
+ */
+
+/**
+ * Create the blink queue and the tasks. Call before vTaskStartScheduler.
+ *
+ * @param output An open channel the tasks report on. It must outlive the
+ *      scheduler.
+ */
+void dev_tasks_start(uart_t * output);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _DEV_BOARD_TASKS_DEV_TASKS_H_